@@ -0,0 +1,488 @@
+/**
+ * Copyright 2019 Sergei A. Fedorov
+ * baseline_benchmarks.cpp
+ *
+ *  Created on: Feb 5, 2019
+ *      Author: ser-fedorov
+ */
+
+#include "make_test_data.hpp"
+#include <psst/math/colors.hpp>
+#include <psst/math/matrix.hpp>
+#include <psst/math/quaternion.hpp>
+#include <psst/math/vector.hpp>
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+/**
+ * Every operation is run over the same data by the library code and by a
+ * hand-written loop over raw scalar arrays. The benchmarks are named
+ * Operation<implementation>, after the run a table of psst/raw time ratios
+ * is printed. A ratio close to 1 means the expression templates cost nothing.
+ */
+namespace psst {
+namespace math {
+namespace bench {
+
+using vector3f    = vector<float, 3>;
+using vector4f    = vector<float, 4>;
+using matrix4x4f  = matrix<float, 4, 4>;
+using quaternionf = quaternion<float>;
+using rgbf        = color::rgb<float>;
+using hslf        = color::hsl<float>;
+
+static_assert(sizeof(vector3f) == 3 * sizeof(float), "Vector layout must match an array");
+static_assert(sizeof(vector4f) == 4 * sizeof(float), "Vector layout must match an array");
+static_assert(sizeof(matrix4x4f) == 16 * sizeof(float), "Matrix layout must match an array");
+
+// Number of elements processed in a benchmark iteration, the data fits L2
+constexpr std::size_t element_count = 1024;
+
+//----------------------------------------------------------------------------
+//  psst::math implementation
+//----------------------------------------------------------------------------
+struct psst_impl {
+    static void
+    add(vector3f const* a, vector3f const* b, vector3f* c, std::size_t n)
+    {
+        for (std::size_t i = 0; i < n; ++i) {
+            c[i] = a[i] + b[i];
+        }
+    }
+    static float
+    dot(vector4f const* a, vector4f const* b, std::size_t n)
+    {
+        float sum = 0;
+        for (std::size_t i = 0; i < n; ++i) {
+            sum += dot_product(a[i], b[i]);
+        }
+        return sum;
+    }
+    static void
+    cross(vector3f const* a, vector3f const* b, vector3f* c, std::size_t n)
+    {
+        for (std::size_t i = 0; i < n; ++i) {
+            c[i] = a[i] * b[i];
+        }
+    }
+    static void
+    normalize(vector3f const* a, vector3f* c, std::size_t n)
+    {
+        for (std::size_t i = 0; i < n; ++i) {
+            c[i] = expr::normalize(a[i]);
+        }
+    }
+    static void
+    matrix_multiply(matrix4x4f const* a, matrix4x4f const* b, matrix4x4f* c, std::size_t n)
+    {
+        for (std::size_t i = 0; i < n; ++i) {
+            c[i] = a[i] * b[i];
+        }
+    }
+    static void
+    transform(matrix4x4f const& m, vector4f const* a, vector4f* c, std::size_t n)
+    {
+        for (std::size_t i = 0; i < n; ++i) {
+            c[i] = as_vector(m * a[i]);
+        }
+    }
+    static void
+    transpose(matrix4x4f const* a, matrix4x4f* c, std::size_t n)
+    {
+        for (std::size_t i = 0; i < n; ++i) {
+            c[i] = expr::transpose(a[i]);
+        }
+    }
+    static void
+    quaternion_multiply(quaternionf const* a, quaternionf const* b, quaternionf* c, std::size_t n)
+    {
+        for (std::size_t i = 0; i < n; ++i) {
+            c[i] = a[i] * b[i];
+        }
+    }
+    static void
+    rgb_to_hsl(rgbf const* a, hslf* c, std::size_t n)
+    {
+        for (std::size_t i = 0; i < n; ++i) {
+            c[i] = convert<hslf>(a[i]);
+        }
+    }
+};
+
+//----------------------------------------------------------------------------
+//  Hand-written implementation on raw scalar arrays
+//----------------------------------------------------------------------------
+struct raw_impl {
+    static void
+    add(vector3f const* a, vector3f const* b, vector3f* c, std::size_t n)
+    {
+        float const* pa = a->data();
+        float const* pb = b->data();
+        float*       pc = c->data();
+        for (std::size_t i = 0; i < n * 3; ++i) {
+            pc[i] = pa[i] + pb[i];
+        }
+    }
+    static float
+    dot(vector4f const* a, vector4f const* b, std::size_t n)
+    {
+        float const* pa  = a->data();
+        float const* pb  = b->data();
+        float        sum = 0;
+        for (std::size_t i = 0; i < n; ++i, pa += 4, pb += 4) {
+            sum += pa[0] * pb[0] + pa[1] * pb[1] + pa[2] * pb[2] + pa[3] * pb[3];
+        }
+        return sum;
+    }
+    static void
+    cross(vector3f const* a, vector3f const* b, vector3f* c, std::size_t n)
+    {
+        float const* pa = a->data();
+        float const* pb = b->data();
+        float*       pc = c->data();
+        for (std::size_t i = 0; i < n; ++i, pa += 3, pb += 3, pc += 3) {
+            pc[0] = pa[1] * pb[2] - pa[2] * pb[1];
+            pc[1] = pa[2] * pb[0] - pa[0] * pb[2];
+            pc[2] = pa[0] * pb[1] - pa[1] * pb[0];
+        }
+    }
+    static void
+    normalize(vector3f const* a, vector3f* c, std::size_t n)
+    {
+        float const* pa = a->data();
+        float*       pc = c->data();
+        for (std::size_t i = 0; i < n; ++i, pa += 3, pc += 3) {
+            float mag = std::sqrt(pa[0] * pa[0] + pa[1] * pa[1] + pa[2] * pa[2]);
+            pc[0]     = pa[0] / mag;
+            pc[1]     = pa[1] / mag;
+            pc[2]     = pa[2] / mag;
+        }
+    }
+    static void
+    matrix_multiply(matrix4x4f const* a, matrix4x4f const* b, matrix4x4f* c, std::size_t n)
+    {
+        for (std::size_t i = 0; i < n; ++i) {
+            float const* pa = a[i].data();
+            float const* pb = b[i].data();
+            float*       pc = c[i].data();
+            for (std::size_t r = 0; r < 4; ++r) {
+                for (std::size_t k = 0; k < 4; ++k) {
+                    pc[r * 4 + k] = pa[r * 4 + 0] * pb[0 * 4 + k] + pa[r * 4 + 1] * pb[1 * 4 + k]
+                                    + pa[r * 4 + 2] * pb[2 * 4 + k]
+                                    + pa[r * 4 + 3] * pb[3 * 4 + k];
+                }
+            }
+        }
+    }
+    static void
+    transform(matrix4x4f const& m, vector4f const* a, vector4f* c, std::size_t n)
+    {
+        float const* pm = m.data();
+        float const* pa = a->data();
+        float*       pc = c->data();
+        for (std::size_t i = 0; i < n; ++i, pa += 4, pc += 4) {
+            for (std::size_t r = 0; r < 4; ++r) {
+                pc[r] = pm[r * 4 + 0] * pa[0] + pm[r * 4 + 1] * pa[1] + pm[r * 4 + 2] * pa[2]
+                        + pm[r * 4 + 3] * pa[3];
+            }
+        }
+    }
+    static void
+    transpose(matrix4x4f const* a, matrix4x4f* c, std::size_t n)
+    {
+        for (std::size_t i = 0; i < n; ++i) {
+            float const* pa = a[i].data();
+            float*       pc = c[i].data();
+            for (std::size_t r = 0; r < 4; ++r) {
+                for (std::size_t k = 0; k < 4; ++k) {
+                    pc[k * 4 + r] = pa[r * 4 + k];
+                }
+            }
+        }
+    }
+    static void
+    quaternion_multiply(quaternionf const* a, quaternionf const* b, quaternionf* c, std::size_t n)
+    {
+        float const* pa = a->data();
+        float const* pb = b->data();
+        float*       pc = c->data();
+        for (std::size_t i = 0; i < n; ++i, pa += 4, pb += 4, pc += 4) {
+            pc[0] = pa[0] * pb[0] - pa[1] * pb[1] - pa[2] * pb[2] - pa[3] * pb[3];
+            pc[1] = pa[0] * pb[1] + pa[1] * pb[0] + pa[2] * pb[3] - pa[3] * pb[2];
+            pc[2] = pa[0] * pb[2] - pa[1] * pb[3] + pa[2] * pb[0] + pa[3] * pb[1];
+            pc[3] = pa[0] * pb[3] + pa[1] * pb[2] - pa[2] * pb[1] + pa[3] * pb[0];
+        }
+    }
+    static void
+    rgb_to_hsl(rgbf const* a, hslf* c, std::size_t n)
+    {
+        float const sector = pi<float>::value / 3;
+
+        float const* pa = a->data();
+        float*       pc = c->data();
+        for (std::size_t i = 0; i < n; ++i, pa += 3, pc += 3) {
+            float r = pa[0], g = pa[1], b = pa[2];
+            float cmax = std::max(r, std::max(g, b));
+            float cmin = std::min(r, std::min(g, b));
+            float d    = cmax - cmin;
+            float l    = (cmax + cmin) / 2;
+            float s    = (l != 0 && l != 1) ? d / (1 - std::abs(2 * l - 1)) : 0;
+            float h    = 0;
+            if (d == 0) {
+                h = 0;
+            } else if (cmax == r) {
+                h = sector * std::fmod((g - b) / d, 6.0f);
+            } else if (cmax == g) {
+                h = sector * ((b - r) / d + 2);
+            } else {
+                h = sector * ((r - g) / d + 4);
+            }
+            pc[0] = h;
+            pc[1] = s;
+            pc[2] = l;
+        }
+    }
+};
+
+//----------------------------------------------------------------------------
+//  Test data
+//----------------------------------------------------------------------------
+template <typename T>
+std::vector<T>
+make_data(std::size_t count, float scale)
+{
+    std::vector<T> res(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        float* p = res[i].data();
+        for (std::size_t j = 0; j < sizeof(T) / sizeof(float); ++j) {
+            p[j] = std::sin(scale * (i + 1) + j) * 0.5f + 0.5f;
+        }
+    }
+    return res;
+}
+
+void
+set_processed(benchmark::State& state, std::size_t item_bytes)
+{
+    auto const items = static_cast<std::int64_t>(state.iterations() * element_count);
+    state.SetItemsProcessed(items);
+    state.SetBytesProcessed(items * static_cast<std::int64_t>(item_bytes));
+}
+
+//----------------------------------------------------------------------------
+//  Benchmarks
+//----------------------------------------------------------------------------
+template <typename Impl>
+void
+VectorAdd(benchmark::State& state)
+{
+    auto a = make_data<vector3f>(element_count, 0.1f);
+    auto b = make_data<vector3f>(element_count, 0.2f);
+    auto c = make_data<vector3f>(element_count, 0.3f);
+    while (state.KeepRunning()) {
+        Impl::add(a.data(), b.data(), c.data(), element_count);
+        benchmark::ClobberMemory();
+    }
+    set_processed(state, 3 * sizeof(vector3f));
+}
+
+template <typename Impl>
+void
+VectorDot(benchmark::State& state)
+{
+    auto a = make_data<vector4f>(element_count, 0.1f);
+    auto b = make_data<vector4f>(element_count, 0.2f);
+    while (state.KeepRunning()) {
+        benchmark::DoNotOptimize(Impl::dot(a.data(), b.data(), element_count));
+    }
+    set_processed(state, 2 * sizeof(vector4f));
+}
+
+template <typename Impl>
+void
+VectorCross(benchmark::State& state)
+{
+    auto a = make_data<vector3f>(element_count, 0.1f);
+    auto b = make_data<vector3f>(element_count, 0.2f);
+    auto c = make_data<vector3f>(element_count, 0.3f);
+    while (state.KeepRunning()) {
+        Impl::cross(a.data(), b.data(), c.data(), element_count);
+        benchmark::ClobberMemory();
+    }
+    set_processed(state, 3 * sizeof(vector3f));
+}
+
+template <typename Impl>
+void
+VectorNormalize(benchmark::State& state)
+{
+    auto a = make_data<vector3f>(element_count, 0.1f);
+    auto c = make_data<vector3f>(element_count, 0.3f);
+    while (state.KeepRunning()) {
+        Impl::normalize(a.data(), c.data(), element_count);
+        benchmark::ClobberMemory();
+    }
+    set_processed(state, 2 * sizeof(vector3f));
+}
+
+template <typename Impl>
+void
+MatrixMultiply(benchmark::State& state)
+{
+    auto a = make_data<matrix4x4f>(element_count, 0.1f);
+    auto b = make_data<matrix4x4f>(element_count, 0.2f);
+    auto c = make_data<matrix4x4f>(element_count, 0.3f);
+    while (state.KeepRunning()) {
+        Impl::matrix_multiply(a.data(), b.data(), c.data(), element_count);
+        benchmark::ClobberMemory();
+    }
+    set_processed(state, 3 * sizeof(matrix4x4f));
+}
+
+template <typename Impl>
+void
+MatrixTransform(benchmark::State& state)
+{
+    auto m = make_data<matrix4x4f>(1, 0.5f);
+    auto a = make_data<vector4f>(element_count, 0.1f);
+    auto c = make_data<vector4f>(element_count, 0.3f);
+    while (state.KeepRunning()) {
+        Impl::transform(m.front(), a.data(), c.data(), element_count);
+        benchmark::ClobberMemory();
+    }
+    set_processed(state, 2 * sizeof(vector4f));
+}
+
+template <typename Impl>
+void
+MatrixTranspose(benchmark::State& state)
+{
+    auto a = make_data<matrix4x4f>(element_count, 0.1f);
+    auto c = make_data<matrix4x4f>(element_count, 0.3f);
+    while (state.KeepRunning()) {
+        Impl::transpose(a.data(), c.data(), element_count);
+        benchmark::ClobberMemory();
+    }
+    set_processed(state, 2 * sizeof(matrix4x4f));
+}
+
+template <typename Impl>
+void
+QuaternionMultiply(benchmark::State& state)
+{
+    auto a = make_data<quaternionf>(element_count, 0.1f);
+    auto b = make_data<quaternionf>(element_count, 0.2f);
+    auto c = make_data<quaternionf>(element_count, 0.3f);
+    while (state.KeepRunning()) {
+        Impl::quaternion_multiply(a.data(), b.data(), c.data(), element_count);
+        benchmark::ClobberMemory();
+    }
+    set_processed(state, 3 * sizeof(quaternionf));
+}
+
+template <typename Impl>
+void
+ColorRgbToHsl(benchmark::State& state)
+{
+    auto a = make_data<rgbf>(element_count, 0.1f);
+    auto c = make_data<hslf>(element_count, 0.3f);
+    while (state.KeepRunning()) {
+        Impl::rgb_to_hsl(a.data(), c.data(), element_count);
+        benchmark::ClobberMemory();
+    }
+    set_processed(state, sizeof(rgbf) + sizeof(hslf));
+}
+
+//----------------------------------------------------------------------------
+// clang-format off
+BENCHMARK_TEMPLATE(VectorAdd,           psst_impl);
+BENCHMARK_TEMPLATE(VectorAdd,           raw_impl);
+BENCHMARK_TEMPLATE(VectorDot,           psst_impl);
+BENCHMARK_TEMPLATE(VectorDot,           raw_impl);
+BENCHMARK_TEMPLATE(VectorCross,         psst_impl);
+BENCHMARK_TEMPLATE(VectorCross,         raw_impl);
+BENCHMARK_TEMPLATE(VectorNormalize,     psst_impl);
+BENCHMARK_TEMPLATE(VectorNormalize,     raw_impl);
+BENCHMARK_TEMPLATE(MatrixMultiply,      psst_impl);
+BENCHMARK_TEMPLATE(MatrixMultiply,      raw_impl);
+BENCHMARK_TEMPLATE(MatrixTransform,     psst_impl);
+BENCHMARK_TEMPLATE(MatrixTransform,     raw_impl);
+BENCHMARK_TEMPLATE(MatrixTranspose,     psst_impl);
+BENCHMARK_TEMPLATE(MatrixTranspose,     raw_impl);
+BENCHMARK_TEMPLATE(QuaternionMultiply,  psst_impl);
+BENCHMARK_TEMPLATE(QuaternionMultiply,  raw_impl);
+BENCHMARK_TEMPLATE(ColorRgbToHsl,       psst_impl);
+BENCHMARK_TEMPLATE(ColorRgbToHsl,       raw_impl);
+// clang-format on
+
+//----------------------------------------------------------------------------
+/**
+ * Console reporter that additionally prints psst/raw time ratio per operation
+ */
+class ratio_reporter : public benchmark::ConsoleReporter {
+public:
+    void
+    ReportRuns(std::vector<Run> const& reports) override
+    {
+        ConsoleReporter::ReportRuns(reports);
+        for (auto const& run : reports) {
+            if (run.error_occurred || run.iterations == 0)
+                continue;
+            // Take the mean when repetitions are requested, skip other aggregates
+            if (run.run_type == Run::RT_Aggregate && run.aggregate_name != "mean")
+                continue;
+            auto name  = run.run_name.function_name;
+            auto start = name.find('<');
+            if (start == std::string::npos)
+                continue;
+            auto op   = name.substr(0, start);
+            auto impl = name.substr(start + 1, name.find('>', start) - start - 1);
+            times_[op][impl] = run.GetAdjustedCPUTime();
+        }
+    }
+
+    void
+    Finalize() override
+    {
+        ConsoleReporter::Finalize();
+        auto& os = GetOutputStream();
+        os << "\n"
+           << std::left << std::setw(24) << "Operation" << std::right << std::setw(14)
+           << "psst/raw" << "\n"
+           << std::string(38, '-') << "\n";
+        for (auto const& op : times_) {
+            auto psst = op.second.find("psst_impl");
+            auto raw  = op.second.find("raw_impl");
+            if (psst == op.second.end() || raw == op.second.end() || raw->second == 0)
+                continue;
+            os << std::left << std::setw(24) << op.first << std::right << std::setw(14)
+               << std::fixed << std::setprecision(3) << psst->second / raw->second << "\n";
+        }
+    }
+
+private:
+    std::map<std::string, std::map<std::string, double>> times_;
+};
+
+} /* namespace bench */
+} /* namespace math */
+} /* namespace psst */
+
+int
+main(int argc, char* argv[])
+{
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv))
+        return 1;
+    psst::math::bench::ratio_reporter reporter;
+    benchmark::RunSpecifiedBenchmarks(&reporter);
+    return 0;
+}
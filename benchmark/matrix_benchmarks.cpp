@@ -135,6 +135,7 @@ MatrixColMultiply(benchmark::State& state)
 
         benchmark::DoNotOptimize(m * v);
     }
+    state.SetComplexityN(traits_type::size);
 }
 template <typename Matrix>
 void
@@ -149,6 +150,7 @@ MatrixRowMultiply(benchmark::State& state)
 
         benchmark::DoNotOptimize(v * m);
     }
+    state.SetComplexityN(traits_type::size);
 }
 
 template <typename LMatrix, typename RMatrix = LMatrix>
@@ -0,0 +1,1408 @@
+/**
+ * Copyright 2019 Sergei A. Fedorov
+ * throughput_benchmarks.cpp
+ *
+ *  Created on: Feb 4, 2019
+ *      Author: ser-fedorov
+ */
+
+#include "make_test_data.hpp"
+#include <psst/math/aabb.hpp>
+#include <psst/math/affine_transform.hpp>
+#include <psst/math/bvh.hpp>
+#include <psst/math/dual_quaternion.hpp>
+#include <psst/math/dynamic_matrix.hpp>
+#include <psst/math/frustum.hpp>
+#include <psst/math/kd_tree.hpp>
+#include <psst/math/matrix.hpp>
+#include <psst/math/matrix3_decomposition.hpp>
+#include <psst/math/matrix_batch.hpp>
+#include <psst/math/matrix_decomposition.hpp>
+#include <psst/math/quaternion.hpp>
+#include <psst/math/radix_sort.hpp>
+#include <psst/math/ray.hpp>
+#include <psst/math/rotation.hpp>
+#include <psst/math/space_filling_curve.hpp>
+#include <psst/math/sparse_matrix.hpp>
+#include <psst/math/spatial_hash_grid.hpp>
+#include <psst/math/transform_hierarchy.hpp>
+#include <psst/math/vector.hpp>
+#include <psst/math/vector_view.hpp>
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+namespace psst {
+namespace math {
+namespace bench {
+
+//----------------------------------------------------------------------------
+//  Working set sizes. All the data touched by a kernel run fits into the
+//  corresponding cache level, the last one is way larger than any cache.
+//----------------------------------------------------------------------------
+constexpr std::int64_t l1_working_set   = 16 << 10;
+constexpr std::int64_t l2_working_set   = 128 << 10;
+constexpr std::int64_t l3_working_set   = 4 << 20;
+constexpr std::int64_t dram_working_set = 64 << 20;
+
+void
+working_sets(benchmark::internal::Benchmark* b)
+{
+    b->ArgName("bytes");
+    for (auto s : {l1_working_set, l2_working_set, l3_working_set, dram_working_set}) {
+        b->Arg(s);
+    }
+}
+
+/**
+ * Number of items to process so that the kernel touches state.range(0) bytes
+ * @param item_bytes number of bytes read and written per item
+ */
+std::size_t
+item_count(benchmark::State const& state, std::size_t item_bytes)
+{
+    auto count = static_cast<std::size_t>(state.range(0)) / item_bytes;
+    return count > 0 ? count : 1;
+}
+
+void
+set_processed(benchmark::State& state, std::size_t count, std::size_t item_bytes)
+{
+    auto const items = static_cast<std::int64_t>(state.iterations() * count);
+    state.SetItemsProcessed(items);
+    state.SetBytesProcessed(items * static_cast<std::int64_t>(item_bytes));
+}
+
+template <typename Vector>
+Vector
+make_nth_vector(std::size_t n)
+{
+    using value_type = typename Vector::value_type;
+    return make_test_vector<value_type>(dimension_count<Vector::size>{})
+           * static_cast<value_type>(n % 7 + 1);
+}
+
+//----------------------------------------------------------------------------
+//  Data layouts
+//----------------------------------------------------------------------------
+/**
+ * Array of vector structures
+ */
+template <typename Vector>
+struct aos_buffer {
+    using vector_type = Vector;
+
+    explicit aos_buffer(std::size_t count) : data_(count)
+    {
+        for (std::size_t i = 0; i < count; ++i) {
+            data_[i] = make_nth_vector<Vector>(i);
+        }
+    }
+
+    std::size_t
+    size() const
+    {
+        return data_.size();
+    }
+
+    vector_type& operator[](std::size_t index) { return data_[index]; }
+
+private:
+    std::vector<vector_type> data_;
+};
+
+/**
+ * A flat buffer of scalars accessed via a memory_vector_view
+ */
+template <typename Vector>
+struct view_buffer {
+    using vector_type = Vector;
+    using value_type  = typename vector_type::value_type;
+    using view_type   = memory_vector_view<value_type*, vector_type::size,
+                                         traits::component_names_t<vector_type>>;
+
+    explicit view_buffer(std::size_t count)
+        : data_(count * vector_type::size), view_{data_.data(), data_.size()}
+    {
+        for (std::size_t i = 0; i < count; ++i) {
+            view_[i] = make_nth_vector<Vector>(i);
+        }
+    }
+    view_buffer(view_buffer const&) = delete;
+    view_buffer&
+    operator=(view_buffer const&)
+        = delete;
+
+    std::size_t
+    size() const
+    {
+        return view_.size();
+    }
+
+    auto operator[](std::size_t index) { return view_[index]; }
+
+private:
+    std::vector<value_type> data_;
+    view_type               view_;
+};
+
+//----------------------------------------------------------------------------
+//  Vector kernels
+//----------------------------------------------------------------------------
+template <template <typename> class Buffer, typename Vector>
+void
+ThroughputAdd(benchmark::State& state)
+{
+    constexpr std::size_t item_bytes = 3 * sizeof(Vector);
+    auto const            count      = item_count(state, item_bytes);
+    Buffer<Vector>        a(count), b(count), c(count);
+
+    while (state.KeepRunning()) {
+        for (std::size_t i = 0; i < count; ++i) {
+            c[i] = a[i] + b[i];
+        }
+        benchmark::ClobberMemory();
+    }
+    set_processed(state, count, item_bytes);
+}
+
+template <template <typename> class Buffer, typename Vector>
+void
+ThroughputScalarMul(benchmark::State& state)
+{
+    using value_type                 = typename Vector::value_type;
+    constexpr std::size_t item_bytes = 2 * sizeof(Vector);
+    auto const            count      = item_count(state, item_bytes);
+    Buffer<Vector>        a(count), c(count);
+    value_type            s{3};
+    benchmark::DoNotOptimize(s);
+
+    while (state.KeepRunning()) {
+        for (std::size_t i = 0; i < count; ++i) {
+            c[i] = a[i] * s;
+        }
+        benchmark::ClobberMemory();
+    }
+    set_processed(state, count, item_bytes);
+}
+
+template <template <typename> class Buffer, typename Vector>
+void
+ThroughputDot(benchmark::State& state)
+{
+    using value_type                 = typename Vector::value_type;
+    constexpr std::size_t item_bytes = 2 * sizeof(Vector);
+    auto const            count      = item_count(state, item_bytes);
+    Buffer<Vector>        a(count), b(count);
+
+    while (state.KeepRunning()) {
+        value_type sum{0};
+        for (std::size_t i = 0; i < count; ++i) {
+            sum += dot_product(a[i], b[i]);
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    set_processed(state, count, item_bytes);
+}
+
+template <template <typename> class Buffer, typename Vector>
+void
+ThroughputCross(benchmark::State& state)
+{
+    constexpr std::size_t item_bytes = 3 * sizeof(Vector);
+    auto const            count      = item_count(state, item_bytes);
+    Buffer<Vector>        a(count), b(count), c(count);
+
+    while (state.KeepRunning()) {
+        for (std::size_t i = 0; i < count; ++i) {
+            c[i] = a[i] * b[i];
+        }
+        benchmark::ClobberMemory();
+    }
+    set_processed(state, count, item_bytes);
+}
+
+template <template <typename> class Buffer, typename Vector>
+void
+ThroughputNormalize(benchmark::State& state)
+{
+    constexpr std::size_t item_bytes = 2 * sizeof(Vector);
+    auto const            count      = item_count(state, item_bytes);
+    Buffer<Vector>        a(count), c(count);
+
+    while (state.KeepRunning()) {
+        for (std::size_t i = 0; i < count; ++i) {
+            c[i] = normalize(a[i]);
+        }
+        benchmark::ClobberMemory();
+    }
+    set_processed(state, count, item_bytes);
+}
+
+template <template <typename> class Buffer, typename Vector>
+void
+ThroughputLerp(benchmark::State& state)
+{
+    using value_type                 = typename Vector::value_type;
+    constexpr std::size_t item_bytes = 3 * sizeof(Vector);
+    auto const            count      = item_count(state, item_bytes);
+    Buffer<Vector>        a(count), b(count), c(count);
+    value_type            t{0.25};
+    benchmark::DoNotOptimize(t);
+
+    while (state.KeepRunning()) {
+        for (std::size_t i = 0; i < count; ++i) {
+            c[i] = lerp(a[i], b[i], t);
+        }
+        benchmark::ClobberMemory();
+    }
+    set_processed(state, count, item_bytes);
+}
+
+//----------------------------------------------------------------------------
+//  Matrix kernels
+//----------------------------------------------------------------------------
+/**
+ * Transform an array of vectors by a single matrix
+ */
+template <template <typename> class Buffer, typename Vector>
+void
+ThroughputTransform(benchmark::State& state)
+{
+    using value_type                 = typename Vector::value_type;
+    using matrix_type                = matrix<value_type, Vector::size, Vector::size>;
+    using traits_type                = traits::matrix_traits<matrix_type>;
+    constexpr std::size_t item_bytes = 2 * sizeof(Vector);
+    auto const            count      = item_count(state, item_bytes);
+    Buffer<Vector>        a(count), c(count);
+    matrix_type           m = make_test_matrix<value_type>(typename traits_type::size_type{});
+    benchmark::DoNotOptimize(m);
+
+    while (state.KeepRunning()) {
+        for (std::size_t i = 0; i < count; ++i) {
+            c[i] = as_vector(m * a[i]);
+        }
+        benchmark::ClobberMemory();
+    }
+    set_processed(state, count, item_bytes);
+}
+
+/**
+ * Multiply arrays of matrices pairwise
+ */
+template <typename Matrix>
+void
+ThroughputMatrixMul(benchmark::State& state)
+{
+    using traits_type                = traits::matrix_traits<Matrix>;
+    using value_type                 = typename traits_type::value_type;
+    constexpr std::size_t item_bytes = 3 * sizeof(Matrix);
+    auto const            count      = item_count(state, item_bytes);
+    Matrix const m = make_test_matrix<value_type>(typename traits_type::size_type{});
+    std::vector<Matrix> a(count, m), b(count, m * value_type{2}), c(count);
+
+    while (state.KeepRunning()) {
+        for (std::size_t i = 0; i < count; ++i) {
+            c[i] = a[i] * b[i];
+        }
+        benchmark::ClobberMemory();
+    }
+    set_processed(state, count, item_bytes);
+}
+
+/**
+ * Compose arrays of affine transforms pairwise, compare with
+ * ThroughputMatrixMul for 4x4 matrices. A 3x4 transform is 25% smaller.
+ */
+template <bool Bulk, typename T>
+void
+ThroughputAffineCompose(benchmark::State& state)
+{
+    using affine_type                = affine_transform<T>;
+    constexpr std::size_t item_bytes = 3 * sizeof(affine_type);
+    auto const            count      = item_count(state, item_bytes);
+    affine_type const m = make_affine_transform(quaternion<T>{0.5, 0.5, -0.5, 0.5},
+                                                vector<T, 3>{1, 2, 3}, vector<T, 3>{2, 2, 2});
+    std::vector<affine_type> a(count, m), b(count, m), c(count);
+
+    while (state.KeepRunning()) {
+        if constexpr (Bulk) {
+            compose(a.data(), b.data(), count, c.data());
+        } else {
+            for (std::size_t i = 0; i < count; ++i) {
+                c[i] = compose(a[i], b[i]);
+            }
+        }
+        benchmark::ClobberMemory();
+    }
+    set_processed(state, count, item_bytes);
+}
+
+/**
+ * Recompute all world transforms of a forest of trees with 64 nodes each.
+ * Threads == 1 is the single pass update, otherwise the trees are split
+ * between threads.
+ */
+template <typename Transform, std::size_t Threads>
+void
+ThroughputHierarchyUpdate(benchmark::State& state)
+{
+    using value_type = typename Transform::value_type;
+    constexpr std::size_t item_bytes
+        = 2 * sizeof(Transform) + sizeof(std::size_t) + sizeof(std::uint8_t);
+    auto const      count = item_count(state, item_bytes);
+    Transform const m     = convert<Transform>(make_affine_transform(
+        quaternion<value_type>{0.5, 0.5, -0.5, 0.5}, vector<value_type, 3>{1, 2, 3}));
+
+    transform_hierarchy<Transform> h;
+    h.reserve(count);
+    std::vector<std::size_t> roots;
+    for (std::size_t i = 0; i < count; ++i) {
+        if (i % 64 == 0) {
+            roots.push_back(h.add_node(m));
+        } else {
+            h.add_node(i - 1 - (i % 3 == 0 && i % 64 > 1), m);
+        }
+    }
+
+    while (state.KeepRunning()) {
+        for (auto r : roots) {
+            h.mark_dirty(r);
+        }
+        h.update(Threads);
+        benchmark::ClobberMemory();
+    }
+    set_processed(state, count, item_bytes);
+}
+
+/**
+ * Bounds of an array of points, growing a box point by point or by the bulk
+ * builder, sequential or parallel
+ */
+enum class bounds { expand, bulk, parallel };
+
+template <bounds Method, typename T>
+void
+ThroughputAabbBuild(benchmark::State& state)
+{
+    using vector_type                = vector<T, 3>;
+    constexpr std::size_t item_bytes = sizeof(vector_type);
+    auto const            count      = item_count(state, item_bytes);
+
+    std::vector<vector_type> a(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        a[i] = make_nth_vector<vector_type>(i);
+    }
+
+    while (state.KeepRunning()) {
+        aabb<T, 3> box;
+        if constexpr (Method == bounds::expand) {
+            for (auto const& p : a) {
+                box.expand(p);
+            }
+        } else {
+            box = make_aabb(a.data(), a.size(), Method == bounds::bulk ? 1 : 0);
+        }
+        benchmark::DoNotOptimize(box);
+    }
+    set_processed(state, count, item_bytes);
+}
+
+/**
+ * Cull an array of bounding spheres, testing them one by one or with the
+ * batch kernel writing a visibility mask
+ */
+template <bool Batch, std::size_t Threads>
+void
+ThroughputCullSpheres(benchmark::State& state)
+{
+    using vector_type                = vector<float, 3>;
+    constexpr std::size_t item_bytes = sizeof(vector_type) + sizeof(float);
+    auto const            count      = item_count(state, item_bytes);
+
+    // Random positions around the camera, so that the visibility of
+    // neighbour spheres is not predictable
+    std::mt19937                          gen{42};
+    std::uniform_real_distribution<float> pos(-100, 100);
+    std::uniform_real_distribution<float> radius(0, 5);
+    std::vector<vector_type>              centers(count);
+    std::vector<float>                    radii(count);
+    std::vector<std::uint64_t>            mask((count + 63) / 64);
+    for (std::size_t i = 0; i < count; ++i) {
+        centers[i] = vector_type{pos(gen), pos(gen), pos(gen)};
+        radii[i]   = radius(gen);
+    }
+    // Perspective projection with the camera looking along -z
+    matrix<float, 4, 4> const projection{
+        {1, 0, 0, 0}, {0, 1, 0, 0}, {0, 0, -1.02f, -2.02f}, {0, 0, -1, 0}};
+    auto const f = make_frustum(projection);
+
+    while (state.KeepRunning()) {
+        if constexpr (Batch) {
+            benchmark::DoNotOptimize(
+                cull_spheres(f, centers.data(), radii.data(), count, mask.data(), Threads));
+        } else {
+            std::fill(mask.begin(), mask.end(), 0);
+            for (std::size_t i = 0; i < count; ++i) {
+                mask[i / 64] |= std::uint64_t{intersects(f, centers[i], radii[i])} << (i % 64);
+            }
+        }
+        benchmark::ClobberMemory();
+    }
+    set_processed(state, count, item_bytes);
+}
+
+/**
+ * Test an array of rays against a triangle, one ray at a time if
+ * PacketSize == 1, otherwise by packets of rays in SoA layout
+ */
+template <std::size_t PacketSize>
+void
+ThroughputRayTriangle(benchmark::State& state)
+{
+    using vector_type                = vector<float, 3>;
+    constexpr std::size_t item_bytes = sizeof(ray<float>);
+    auto const            count      = item_count(state, item_bytes) / 16 * 16;
+
+    std::mt19937                          gen{42};
+    std::uniform_real_distribution<float> pos(-1, 1);
+    std::vector<ray<float>>               rays;
+    for (std::size_t i = 0; i < count; ++i) {
+        rays.emplace_back(vector_type{pos(gen), pos(gen), 5},
+                          vector_type{pos(gen) / 10, pos(gen) / 10, -1});
+    }
+    vector_type const v0{-0.5, -0.5, 0}, v1{0.5, -0.5, 0}, v2{0, 0.5, 0};
+
+    if constexpr (PacketSize == 1) {
+        std::vector<triangle_hit<float>> hits(count);
+        while (state.KeepRunning()) {
+            for (std::size_t i = 0; i < count; ++i) {
+                hits[i].t = 10;
+                benchmark::DoNotOptimize(intersect(rays[i], v0, v1, v2, hits[i]));
+            }
+            benchmark::ClobberMemory();
+        }
+    } else {
+        std::vector<ray_packet<float, PacketSize>> packets;
+        for (std::size_t i = 0; i < count; i += PacketSize) {
+            packets.emplace_back(rays.data() + i);
+        }
+        std::vector<triangle_hit_packet<float, PacketSize>> hits(packets.size());
+        while (state.KeepRunning()) {
+            for (std::size_t i = 0; i < packets.size(); ++i) {
+                hits[i].reset(10);
+                benchmark::DoNotOptimize(intersect(packets[i], v0, v1, v2, hits[i]));
+            }
+            benchmark::ClobberMemory();
+        }
+    }
+    set_processed(state, count, item_bytes);
+}
+
+/**
+ * Binned SAH build of a hierarchy over the bounds of random triangles,
+ * sequential or parallel, and the refit of a built hierarchy
+ */
+enum class bvh_update { build, refit };
+
+template <bvh_update Method, std::size_t Threads>
+void
+ThroughputBvh(benchmark::State& state)
+{
+    using box_type                   = aabb<float, 3>;
+    constexpr std::size_t item_bytes = sizeof(box_type);
+    auto const            count      = item_count(state, item_bytes);
+
+    std::mt19937                          gen{42};
+    std::uniform_real_distribution<float> pos(-100, 100);
+    std::uniform_real_distribution<float> size(0, 1);
+    std::vector<box_type>                 boxes;
+    for (std::size_t i = 0; i < count; ++i) {
+        vector<float, 3> const min{pos(gen), pos(gen), pos(gen)};
+        boxes.emplace_back(min, min + vector<float, 3>{size(gen), size(gen), size(gen)});
+    }
+
+    if constexpr (Method == bvh_update::build) {
+        while (state.KeepRunning()) {
+            bvh<float> tree{boxes.data(), boxes.size(), Threads};
+            benchmark::DoNotOptimize(tree.nodes().data());
+        }
+    } else {
+        bvh<float> tree{boxes.data(), boxes.size(), Threads};
+        while (state.KeepRunning()) {
+            tree.refit(boxes.data(), Threads);
+            benchmark::ClobberMemory();
+        }
+    }
+    set_processed(state, count, item_bytes);
+}
+
+/**
+ * Closest hits of random rays with a mesh of random triangles, traversing a
+ * binary or a wide hierarchy. The working set is the size of the mesh.
+ */
+template <typename Tree>
+void
+ThroughputBvhRays(benchmark::State& state)
+{
+    using vector_type                = vector<float, 3>;
+    constexpr std::size_t item_bytes = sizeof(vector_type) * 3;
+    constexpr std::size_t ray_count  = 1024;
+    auto const            count      = item_count(state, item_bytes);
+
+    std::mt19937                          gen{42};
+    std::uniform_real_distribution<float> pos(-100, 100);
+    std::uniform_real_distribution<float> offset(-1, 1);
+    std::vector<float>                    mesh;
+    for (std::size_t i = 0; i < count; ++i) {
+        float const c[3] = {pos(gen), pos(gen), pos(gen)};
+        for (std::size_t n = 0; n < 9; ++n) {
+            mesh.push_back(c[n % 3] + offset(gen));
+        }
+    }
+    auto const vertices = make_memory_vector_view<vector_type>(mesh.data(), mesh.size());
+    Tree const tree{make_bvh(vertices)};
+
+    std::vector<ray<float>> rays;
+    for (std::size_t i = 0; i < ray_count; ++i) {
+        vector_type const origin{pos(gen), pos(gen), pos(gen)};
+        vector_type const target{pos(gen) / 2, pos(gen) / 2, pos(gen) / 2};
+        rays.emplace_back(origin, target - origin);
+    }
+
+    while (state.KeepRunning()) {
+        for (auto const& r : rays) {
+            triangle_hit<float> hit;
+            std::size_t         triangle = 0;
+            benchmark::DoNotOptimize(intersect(tree, vertices, r, hit, triangle));
+        }
+    }
+    state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations() * ray_count));
+}
+
+/**
+ * Build of a k-d tree over random points
+ */
+template <std::size_t Threads>
+void
+ThroughputKdTree(benchmark::State& state)
+{
+    constexpr std::size_t item_bytes = sizeof(float) * 3;
+    auto const            count      = item_count(state, item_bytes);
+
+    std::mt19937                          gen{42};
+    std::uniform_real_distribution<float> pos(-100, 100);
+    std::vector<float>                    buffer(count * 3);
+    for (auto& v : buffer) {
+        v = pos(gen);
+    }
+    auto const points = make_memory_vector_view<vector<float, 3>>(buffer.data(), buffer.size());
+
+    while (state.KeepRunning()) {
+        auto const tree = make_kd_tree(points, Threads);
+        benchmark::DoNotOptimize(tree.nodes().data());
+    }
+    set_processed(state, count, item_bytes);
+}
+
+/**
+ * Batch search of the K nearest points of random query points in a k-d tree.
+ * The working set is the size of the point cloud.
+ */
+template <std::size_t K, std::size_t Threads>
+void
+ThroughputKdTreeNearest(benchmark::State& state)
+{
+    constexpr std::size_t item_bytes  = sizeof(float) * 3;
+    constexpr std::size_t query_count = 4096;
+    auto const            count       = item_count(state, item_bytes);
+
+    std::mt19937                          gen{42};
+    std::uniform_real_distribution<float> pos(-100, 100);
+    std::vector<float>                    buffer(count * 3);
+    std::vector<float>                    query_buffer(query_count * 3);
+    for (auto& v : buffer) {
+        v = pos(gen);
+    }
+    for (auto& v : query_buffer) {
+        v = pos(gen);
+    }
+    auto const points  = make_memory_vector_view<vector<float, 3>>(buffer.data(), buffer.size());
+    auto const queries = make_memory_vector_view<vector<float, 3>>(query_buffer.data(),
+                                                                   query_buffer.size());
+    auto const tree    = make_kd_tree(points);
+
+    using tree_type = std::decay_t<decltype(tree)>;
+    std::vector<tree_type::neighbour> res(query_count * K);
+    while (state.KeepRunning()) {
+        tree.nearest(queries, K, res.data(), Threads);
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations() * query_count));
+}
+
+/** Interaction radius of the particles, the cell size of a grid */
+constexpr float particle_radius = 1;
+
+/**
+ * Random particles in a cube, the density gives about 30 particles within
+ * the interaction radius of a particle
+ */
+std::vector<vector<float, 3>>
+make_particles(std::size_t count)
+{
+    float const                           size = std::cbrt(count / 7.0f);
+    std::mt19937                          gen{42};
+    std::uniform_real_distribution<float> pos(0, size);
+    std::vector<vector<float, 3>>         res;
+    res.reserve(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        res.push_back(vector<float, 3>{pos(gen), pos(gen), pos(gen)});
+    }
+    return res;
+}
+
+/**
+ * Sort of random particles to the cells of a spatial hash grid, the grid
+ * memory is reused as in a simulation step
+ */
+template <std::size_t Threads>
+void
+ThroughputSpatialHashGrid(benchmark::State& state)
+{
+    using vector_type                = vector<float, 3>;
+    constexpr std::size_t item_bytes = sizeof(vector_type);
+    auto const            count      = item_count(state, item_bytes);
+    auto const            particles  = make_particles(count);
+
+    spatial_hash_grid<float> grid{particle_radius};
+    while (state.KeepRunning()) {
+        grid.build(particles.data(), particles.size(), Threads);
+        benchmark::ClobberMemory();
+    }
+    set_processed(state, count, item_bytes);
+}
+
+/**
+ * Search of all the pairs of particles within the cell size. The density of
+ * the particles is about 30 neighbours per particle.
+ */
+template <std::size_t Threads>
+void
+ThroughputSpatialHashGridPairs(benchmark::State& state)
+{
+    using vector_type                = vector<float, 3>;
+    constexpr std::size_t item_bytes = sizeof(vector_type);
+    auto const            count      = item_count(state, item_bytes);
+    auto const            particles  = make_particles(count);
+
+    spatial_hash_grid<float> const grid{particles.data(), particles.size(), particle_radius};
+    std::vector<float>             density(count);
+    while (state.KeepRunning()) {
+        // Each pair is added to the density of the first particle only, so
+        // that the threads don't write the same values
+        grid.for_each_pair(
+            particle_radius,
+            [&density](std::uint32_t i, std::uint32_t, float d) { density[i] += d; }, Threads);
+        benchmark::ClobberMemory();
+    }
+    set_processed(state, count, item_bytes);
+}
+
+/**
+ * Codes of random particles on a space filling curve in the bounds of the
+ * particles
+ */
+enum class curve { morton, hilbert };
+
+template <curve Curve, typename Key, std::size_t Threads>
+void
+ThroughputCurveCodes(benchmark::State& state)
+{
+    using vector_type                = vector<float, 3>;
+    constexpr std::size_t item_bytes = sizeof(vector_type) + sizeof(Key);
+    auto const            count      = item_count(state, item_bytes);
+    auto const            particles  = make_particles(count);
+    auto const            box        = make_aabb(particles.data(), count);
+
+    std::vector<Key> codes(count);
+    while (state.KeepRunning()) {
+        if constexpr (Curve == curve::morton) {
+            morton_codes(particles.data(), count, box, codes.data(), Threads);
+        } else {
+            hilbert_codes(particles.data(), count, box, codes.data(), Threads);
+        }
+        benchmark::DoNotOptimize(codes.data());
+        benchmark::ClobberMemory();
+    }
+    set_processed(state, count, item_bytes);
+}
+
+/**
+ * Sort of random particles by their Morton codes, the positions and the
+ * velocities of the particles are reordered by the codes
+ */
+template <std::size_t Threads>
+void
+ThroughputSortByKeys(benchmark::State& state)
+{
+    using vector_type                = vector<float, 3>;
+    constexpr std::size_t item_bytes = 2 * sizeof(vector_type) + sizeof(std::uint32_t);
+    auto const            count      = item_count(state, item_bytes);
+    auto const            particles  = make_particles(count);
+    auto const            box        = make_aabb(particles.data(), count);
+
+    std::vector<std::uint32_t> codes(count);
+    std::vector<vector_type>   positions(count), velocities(count);
+    while (state.KeepRunning()) {
+        state.PauseTiming();
+        positions  = particles;
+        velocities = particles;
+        morton_codes(particles.data(), count, box, codes.data());
+        state.ResumeTiming();
+        sort_by_keys(codes.data(), count, Threads, positions.data(), velocities.data());
+        benchmark::ClobberMemory();
+    }
+    set_processed(state, count, item_bytes);
+}
+
+/**
+ * Product of two square dynamic matrices, the three matrices fit into the
+ * working set. An item is a multiply-add.
+ */
+template <typename T>
+void
+ThroughputDynamicMatrixMul(benchmark::State& state)
+{
+    auto const size = static_cast<std::size_t>(std::sqrt(item_count(state, 3 * sizeof(T))));
+    std::mt19937                      gen{42};
+    std::uniform_real_distribution<T> dist{-1, 1};
+    dynamic_matrix<T>                 lhs(size, size), rhs(size, size), res;
+    std::generate(lhs.begin(), lhs.end(), [&]() { return dist(gen); });
+    std::generate(rhs.begin(), rhs.end(), [&]() { return dist(gen); });
+    while (state.KeepRunning()) {
+        res = lhs * rhs;
+        benchmark::DoNotOptimize(res.data());
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations() * size * size * size));
+}
+
+/**
+ * Product of a square dynamic matrix and a dynamic vector, the matrix fills
+ * the working set. An item is a value of the matrix.
+ */
+template <typename T>
+void
+ThroughputDynamicMatrixVector(benchmark::State& state)
+{
+    auto const size = static_cast<std::size_t>(std::sqrt(item_count(state, sizeof(T))));
+    std::mt19937                      gen{42};
+    std::uniform_real_distribution<T> dist{-1, 1};
+    dynamic_matrix<T>                 mtx(size, size);
+    dynamic_vector<T>                 vec(size), res;
+    std::generate(mtx.begin(), mtx.end(), [&]() { return dist(gen); });
+    std::generate(vec.begin(), vec.end(), [&]() { return dist(gen); });
+    while (state.KeepRunning()) {
+        res = mtx * vec;
+        benchmark::DoNotOptimize(res.data());
+        benchmark::ClobberMemory();
+    }
+    set_processed(state, size * size, sizeof(T));
+}
+
+/**
+ * Products of arrays of small dynamic matrices, assigned directly to the
+ * existing storage or through a temporary, as the assignment did before the
+ * alias check. An item is a product.
+ */
+template <typename T, bool Temporary>
+void
+ThroughputDynamicAssign(benchmark::State& state)
+{
+    constexpr std::size_t size       = 6;
+    constexpr std::size_t item_bytes = 3 * size * size * sizeof(T);
+    auto const            count      = item_count(state, item_bytes);
+    std::mt19937                      gen{42};
+    std::uniform_real_distribution<T> dist{-1, 1};
+    std::vector<dynamic_matrix<T>>    a(count, dynamic_matrix<T>(size, size)), b(a), c(a);
+    for (std::size_t i = 0; i < count; ++i) {
+        std::generate(a[i].begin(), a[i].end(), [&]() { return dist(gen); });
+        std::generate(b[i].begin(), b[i].end(), [&]() { return dist(gen); });
+    }
+    while (state.KeepRunning()) {
+        for (std::size_t i = 0; i < count; ++i) {
+            if constexpr (Temporary) {
+                c[i] = dynamic_matrix<T>(a[i] * b[i]);
+            } else {
+                c[i] = a[i] * b[i];
+            }
+        }
+        benchmark::ClobberMemory();
+    }
+    set_processed(state, count, item_bytes);
+}
+
+/**
+ * Product of a sparse matrix with a band of blocks per row, as of a mesh, and
+ * a dynamic vector, the matrix fills the working set. An item is a stored
+ * block.
+ */
+template <typename T, std::size_t B, bool Transposed>
+void
+ThroughputSparseMatrixVector(benchmark::State& state)
+{
+    using matrix_type = sparse_matrix<T, B>;
+    using entry_type  = typename matrix_type::entry_type;
+    constexpr std::size_t item_bytes = sizeof(typename matrix_type::block_type)
+                                       + sizeof(typename matrix_type::index_type);
+    constexpr std::size_t band       = 7;
+    auto const            rows       = std::max(item_count(state, item_bytes) / band, band);
+
+    std::mt19937                      gen{42};
+    std::uniform_real_distribution<T> dist{-1, 1};
+    std::vector<entry_type>           entries;
+    for (std::size_t r = 0; r < rows; ++r) {
+        for (std::size_t i = 0; i < band; ++i) {
+            entry_type e{r, (r + i * 31) % rows, {}};
+            if constexpr (B == 1) {
+                e.value = dist(gen);
+            } else {
+                std::generate(e.value.begin(), e.value.end(), [&]() { return dist(gen); });
+            }
+            entries.push_back(e);
+        }
+    }
+    matrix_type const a{rows, rows, std::move(entries)};
+    dynamic_vector<T> vec(a.cols()), res;
+    std::generate(vec.begin(), vec.end(), [&]() { return dist(gen); });
+    while (state.KeepRunning()) {
+        if constexpr (Transposed) {
+            multiply_transposed(a, vec, res);
+        } else {
+            multiply(a, vec, res);
+        }
+        benchmark::DoNotOptimize(res.data());
+        benchmark::ClobberMemory();
+    }
+    set_processed(state, a.non_zeros(), item_bytes);
+}
+
+/**
+ * Product of two fixed size square matrices evaluated by the packed kernel.
+ * An item is a multiply-add.
+ */
+template <typename T, std::size_t N>
+void
+ThroughputPackedMatrixMul(benchmark::State& state)
+{
+    using matrix_type = matrix<T, N, N>;
+    std::mt19937                      gen{42};
+    std::uniform_real_distribution<T> dist{-1, 1};
+    std::vector<matrix_type>          mtx(3);
+    std::generate(mtx[0].begin(), mtx[0].end(), [&]() { return dist(gen); });
+    std::generate(mtx[1].begin(), mtx[1].end(), [&]() { return dist(gen); });
+    while (state.KeepRunning()) {
+        mtx[2] = mtx[0] * mtx[1];
+        benchmark::DoNotOptimize(mtx[2].data());
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations() * N * N * N));
+}
+
+/**
+ * Operations on arrays of independent small matrices. The single method
+ * processes a matrix at a time, the packet method processes packets of
+ * config::batch_lanes matrices in SoA layout, the parallel method splits the
+ * packets between the hardware threads. The soa method keeps the matrices in
+ * packets and doesn't pay for the transposition.
+ */
+enum class batch { single, packet, parallel, soa };
+
+template <typename T, std::size_t N>
+std::vector<matrix<T, N, N>>
+make_batch_matrices(std::size_t count)
+{
+    std::mt19937                      gen{42};
+    std::uniform_real_distribution<T> dist{-1, 1};
+    std::vector<matrix<T, N, N>>      res(count);
+    for (auto& m : res) {
+        std::generate(m.begin(), m.end(), [&]() { return dist(gen); });
+        for (std::size_t i = 0; i < N; ++i) {
+            m[i][i] += N;
+        }
+    }
+    return res;
+}
+
+template <batch Method, typename T, std::size_t N>
+void
+ThroughputBatchMultiply(benchmark::State& state)
+{
+    using matrix_type                = matrix<T, N, N>;
+    constexpr std::size_t item_bytes = 3 * sizeof(matrix_type);
+    auto const            count      = item_count(state, item_bytes);
+    auto const            lhs        = make_batch_matrices<T, N>(count);
+    auto const            rhs        = make_batch_matrices<T, N>(count);
+
+    std::vector<matrix_type> res(count);
+    while (state.KeepRunning()) {
+        if constexpr (Method == batch::single) {
+            for (std::size_t i = 0; i < count; ++i) {
+                res[i] = lhs[i] * rhs[i];
+            }
+        } else {
+            multiply(lhs.data(), rhs.data(), count, res.data(), Method == batch::packet ? 1 : 0);
+        }
+        benchmark::DoNotOptimize(res.data());
+        benchmark::ClobberMemory();
+    }
+    set_processed(state, count, item_bytes);
+}
+
+template <batch Method, typename T, std::size_t N>
+void
+ThroughputBatchInverse(benchmark::State& state)
+{
+    using matrix_type                = matrix<T, N, N>;
+    constexpr std::size_t item_bytes = 2 * sizeof(matrix_type);
+    auto const            count      = item_count(state, item_bytes);
+    auto const            src        = make_batch_matrices<T, N>(count);
+
+    constexpr std::size_t               L = config::batch_lanes;
+    std::vector<matrix_packet<T, N, L>> packets(Method == batch::soa ? count / L : 0);
+    for (std::size_t p = 0; p < packets.size(); ++p) {
+        packets[p].load(src.data() + p * L, L);
+    }
+
+    std::vector<matrix_type> res(Method == batch::soa ? 0 : count);
+    while (state.KeepRunning()) {
+        if constexpr (Method == batch::single) {
+            // The same kernel with a single lane
+            matrix_packet<T, N, 1> m;
+            for (std::size_t i = 0; i < count; ++i) {
+                m.load(src.data() + i, 1);
+                inverse(m, m);
+                m.store(res.data() + i, 1);
+            }
+        } else if constexpr (Method == batch::soa) {
+            inverse(packets.data(), packets.size(), packets.data());
+        } else {
+            inverse(src.data(), count, res.data(), Method == batch::packet ? 1 : 0);
+        }
+        benchmark::DoNotOptimize(res.data());
+        benchmark::DoNotOptimize(packets.data());
+        benchmark::ClobberMemory();
+    }
+    set_processed(state, count, item_bytes);
+}
+
+/**
+ * Decompose a symmetric positive definite system and solve it, a system per
+ * iteration
+ */
+enum class decomposition { lu, cholesky, qr };
+
+template <decomposition Method, typename T, std::size_t N>
+void
+ThroughputMatrixSolve(benchmark::State& state)
+{
+    using matrix_type = matrix<T, N, N>;
+    std::mt19937                      gen{42};
+    std::uniform_real_distribution<T> dist{-1, 1};
+    matrix_type                       m;
+    vector<T, N>                      b, x;
+    std::generate(m.begin(), m.end(), [&]() { return dist(gen); });
+    std::generate(b.begin(), b.end(), [&]() { return dist(gen); });
+    matrix_type const a = m * transpose(m) + matrix_type::identity();
+    while (state.KeepRunning()) {
+        if constexpr (Method == decomposition::lu) {
+            x = lu_decomposition{a}.solve(b);
+        } else if constexpr (Method == decomposition::cholesky) {
+            x = cholesky_decomposition{a}.solve(b);
+        } else {
+            x = qr_decomposition{a}.solve(b);
+        }
+        benchmark::DoNotOptimize(x.data());
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations()));
+}
+
+/**
+ * Singular value decomposition of an array of 3x3 matrices, a matrix at a
+ * time or by packets
+ */
+template <batch Method, typename T>
+void
+ThroughputSVD3(benchmark::State& state)
+{
+    constexpr std::size_t item_bytes = sizeof(matrix<T, 3, 3>) + sizeof(svd3<T>);
+    auto const            count      = item_count(state, item_bytes);
+    auto const            src        = make_batch_matrices<T, 3>(count);
+
+    std::vector<svd3<T>> res(count);
+    while (state.KeepRunning()) {
+        if constexpr (Method == batch::single) {
+            for (std::size_t i = 0; i < count; ++i) {
+                res[i] = svd(src[i]);
+            }
+        } else {
+            svd(src.data(), count, res.data(), Method == batch::packet ? 1 : 0);
+        }
+        benchmark::DoNotOptimize(res.data());
+        benchmark::ClobberMemory();
+    }
+    set_processed(state, count, item_bytes);
+}
+
+template <batch Method, typename T>
+void
+ThroughputSymmetricEigen3(benchmark::State& state)
+{
+    constexpr std::size_t item_bytes = sizeof(matrix<T, 3, 3>) + sizeof(symmetric_eigen3<T>);
+    auto const            count      = item_count(state, item_bytes);
+    auto const            src        = make_batch_matrices<T, 3>(count);
+
+    std::vector<symmetric_eigen3<T>> res(count);
+    while (state.KeepRunning()) {
+        if constexpr (Method == batch::single) {
+            for (std::size_t i = 0; i < count; ++i) {
+                res[i] = symmetric_eigen(src[i]);
+            }
+        } else {
+            symmetric_eigen(src.data(), count, res.data(), Method == batch::packet ? 1 : 0);
+        }
+        benchmark::DoNotOptimize(res.data());
+        benchmark::ClobberMemory();
+    }
+    set_processed(state, count, item_bytes);
+}
+
+/**
+ * Rotate an array of vectors by a single unit quaternion
+ */
+enum class rotation { sandwich, expression, bulk };
+
+template <rotation Method, typename T>
+void
+ThroughputRotate(benchmark::State& state)
+{
+    using vector_type                = vector<T, 3>;
+    constexpr std::size_t item_bytes = 2 * sizeof(vector_type);
+    auto const            count      = item_count(state, item_bytes);
+
+    std::vector<vector_type> a(count), c(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        a[i] = make_nth_vector<vector_type>(i);
+    }
+    quaternion<T> q = normalize(quaternion<T>{1, 2, 3, 4});
+    benchmark::DoNotOptimize(q);
+
+    while (state.KeepRunning()) {
+        if constexpr (Method == rotation::sandwich) {
+            auto const inv = inverse(q);
+            for (std::size_t i = 0; i < count; ++i) {
+                quaternion<T> r = q * quaternion<T>{0, a[i][0], a[i][1], a[i][2]} * inv;
+                c[i]            = r.vector_part();
+            }
+        } else if constexpr (Method == rotation::expression) {
+            for (std::size_t i = 0; i < count; ++i) {
+                c[i] = rotate(q, a[i]);
+            }
+        } else {
+            rotate(q, a.data(), count, c.data());
+        }
+        benchmark::ClobberMemory();
+    }
+    set_processed(state, count, item_bytes);
+}
+
+/**
+ * Convert an array of orientations to rotation matrices
+ */
+template <bool Bulk, typename Matrix>
+void
+ThroughputQuaternionToMatrix(benchmark::State& state)
+{
+    using value_type                 = typename Matrix::value_type;
+    using quaternion_type            = quaternion<value_type>;
+    constexpr std::size_t item_bytes = sizeof(quaternion_type) + sizeof(Matrix);
+    auto const            count      = item_count(state, item_bytes);
+
+    std::vector<quaternion_type> a(count);
+    std::vector<Matrix>          c(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        a[i] = normalize(quaternion_type{1, value_type(i % 7), 2, 3});
+    }
+
+    while (state.KeepRunning()) {
+        if constexpr (Bulk) {
+            convert(a.data(), count, c.data());
+        } else {
+            for (std::size_t i = 0; i < count; ++i) {
+                c[i] = convert<Matrix>(a[i]);
+            }
+        }
+        benchmark::ClobberMemory();
+    }
+    set_processed(state, count, item_bytes);
+}
+
+/**
+ * Blend two arrays of orientations
+ */
+enum class blend { slerp, nlerp, fast_slerp };
+
+template <blend Method, typename T>
+void
+ThroughputQuaternionBlend(benchmark::State& state)
+{
+    using quaternion_type            = quaternion<T>;
+    constexpr std::size_t item_bytes = 3 * sizeof(quaternion_type);
+    auto const            count      = item_count(state, item_bytes);
+
+    std::vector<quaternion_type> a(count), b(count), c(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        a[i] = normalize(quaternion_type{1, T(i % 7), 2, 3});
+        b[i] = normalize(quaternion_type{T(i % 5), 1, -2, 1});
+    }
+    T percent = T(0.3);
+    benchmark::DoNotOptimize(percent);
+
+    while (state.KeepRunning()) {
+        if constexpr (Method == blend::slerp) {
+            for (std::size_t i = 0; i < count; ++i) {
+                c[i] = slerp(a[i], b[i], percent);
+            }
+        } else if constexpr (Method == blend::nlerp) {
+            nlerp(a.data(), b.data(), percent, count, c.data());
+        } else {
+            fast_slerp(a.data(), b.data(), percent, count, c.data());
+        }
+        benchmark::ClobberMemory();
+    }
+    set_processed(state, count, item_bytes);
+}
+
+/**
+ * Skin vertices with 4 influences by a palette of bones, linear blending of
+ * 4x4 matrices against dual quaternion blending
+ */
+template <bool DualQuaternion>
+void
+ThroughputSkin(benchmark::State& state)
+{
+    using vector_type                  = vector<float, 3>;
+    using index_type                   = std::uint16_t;
+    constexpr std::size_t influences   = 4;
+    constexpr std::size_t palette_size = 64;
+    constexpr std::size_t item_bytes
+        = 2 * sizeof(vector_type) + influences * (sizeof(index_type) + sizeof(float));
+    auto const count = item_count(state, item_bytes);
+
+    std::vector<vector_type> src(count), dst(count);
+    std::vector<index_type>  bones(count * influences);
+    std::vector<float>       weights(count * influences);
+    for (std::size_t i = 0; i < count; ++i) {
+        src[i] = make_nth_vector<vector_type>(i);
+        for (std::size_t j = 0; j < influences; ++j) {
+            bones[i * influences + j]   = static_cast<index_type>((i * 7 + j * 13) % palette_size);
+            weights[i * influences + j] = 0.25f;
+        }
+    }
+    std::vector<dual_quaternion<float>> dqs(palette_size);
+    std::vector<matrix<float, 4, 4>>    matrices(palette_size);
+    for (std::size_t i = 0; i < palette_size; ++i) {
+        dqs[i] = make_dual_quaternion(normalize(quaternion<float>{1, float(i % 7), 2, 3}),
+                                      vector_type{float(i), 1, 2});
+        matrices[i] = convert<matrix<float, 4, 4>>(dqs[i]);
+    }
+
+    while (state.KeepRunning()) {
+        if constexpr (DualQuaternion) {
+            skin<influences>(dqs.data(), bones.data(), weights.data(), src.data(), count,
+                             dst.data());
+        } else {
+            for (std::size_t i = 0; i < count; ++i) {
+                float m[12]{};
+                for (std::size_t j = 0; j < influences; ++j) {
+                    float const* b = matrices[bones[i * influences + j]].data();
+                    float const  w = weights[i * influences + j];
+                    for (std::size_t k = 0; k < 12; ++k) {
+                        m[k] += b[k] * w;
+                    }
+                }
+                float const x = src[i][0], y = src[i][1], z = src[i][2];
+                dst[i][0] = m[0] * x + m[1] * y + m[2] * z + m[3];
+                dst[i][1] = m[4] * x + m[5] * y + m[6] * z + m[7];
+                dst[i][2] = m[8] * x + m[9] * y + m[10] * z + m[11];
+            }
+        }
+        benchmark::ClobberMemory();
+    }
+    set_processed(state, count, item_bytes);
+}
+
+//----------------------------------------------------------------------------
+// clang-format off
+BENCHMARK_TEMPLATE(ThroughputAdd,       aos_buffer,     vector<float,   3>)->Apply(working_sets);
+BENCHMARK_TEMPLATE(ThroughputAdd,       view_buffer,    vector<float,   3>)->Apply(working_sets);
+BENCHMARK_TEMPLATE(ThroughputAdd,       aos_buffer,     vector<float,   4>)->Apply(working_sets);
+BENCHMARK_TEMPLATE(ThroughputAdd,       view_buffer,    vector<float,   4>)->Apply(working_sets);
+BENCHMARK_TEMPLATE(ThroughputAdd,       aos_buffer,     vector<double,  4>)->Apply(working_sets);
+BENCHMARK_TEMPLATE(ThroughputAdd,       view_buffer,    vector<double,  4>)->Apply(working_sets);
+
+BENCHMARK_TEMPLATE(ThroughputScalarMul, aos_buffer,     vector<float,   3>)->Apply(working_sets);
+BENCHMARK_TEMPLATE(ThroughputScalarMul, view_buffer,    vector<float,   3>)->Apply(working_sets);
+BENCHMARK_TEMPLATE(ThroughputScalarMul, aos_buffer,     vector<float,   4>)->Apply(working_sets);
+BENCHMARK_TEMPLATE(ThroughputScalarMul, view_buffer,    vector<float,   4>)->Apply(working_sets);
+
+BENCHMARK_TEMPLATE(ThroughputDot,       aos_buffer,     vector<float,   3>)->Apply(working_sets);
+BENCHMARK_TEMPLATE(ThroughputDot,       view_buffer,    vector<float,   3>)->Apply(working_sets);
+BENCHMARK_TEMPLATE(ThroughputDot,       aos_buffer,     vector<float,   4>)->Apply(working_sets);
+BENCHMARK_TEMPLATE(ThroughputDot,       view_buffer,    vector<float,   4>)->Apply(working_sets);
+BENCHMARK_TEMPLATE(ThroughputDot,       aos_buffer,     vector<double,  4>)->Apply(working_sets);
+BENCHMARK_TEMPLATE(ThroughputDot,       view_buffer,    vector<double,  4>)->Apply(working_sets);
+
+BENCHMARK_TEMPLATE(ThroughputCross,     aos_buffer,     vector<float,   3>)->Apply(working_sets);
+BENCHMARK_TEMPLATE(ThroughputCross,     view_buffer,    vector<float,   3>)->Apply(working_sets);
+BENCHMARK_TEMPLATE(ThroughputCross,     aos_buffer,     vector<double,  3>)->Apply(working_sets);
+BENCHMARK_TEMPLATE(ThroughputCross,     view_buffer,    vector<double,  3>)->Apply(working_sets);
+
+BENCHMARK_TEMPLATE(ThroughputNormalize, aos_buffer,     vector<float,   3>)->Apply(working_sets);
+BENCHMARK_TEMPLATE(ThroughputNormalize, view_buffer,    vector<float,   3>)->Apply(working_sets);
+BENCHMARK_TEMPLATE(ThroughputNormalize, aos_buffer,     vector<float,   4>)->Apply(working_sets);
+BENCHMARK_TEMPLATE(ThroughputNormalize, view_buffer,    vector<float,   4>)->Apply(working_sets);
+
+BENCHMARK_TEMPLATE(ThroughputLerp,      aos_buffer,     vector<float,   3>)->Apply(working_sets);
+BENCHMARK_TEMPLATE(ThroughputLerp,      view_buffer,    vector<float,   3>)->Apply(working_sets);
+BENCHMARK_TEMPLATE(ThroughputLerp,      aos_buffer,     vector<float,   4>)->Apply(working_sets);
+BENCHMARK_TEMPLATE(ThroughputLerp,      view_buffer,    vector<float,   4>)->Apply(working_sets);
+
+BENCHMARK_TEMPLATE(ThroughputTransform, aos_buffer,     vector<float,   3>)->Apply(working_sets);
+BENCHMARK_TEMPLATE(ThroughputTransform, view_buffer,    vector<float,   3>)->Apply(working_sets);
+BENCHMARK_TEMPLATE(ThroughputTransform, aos_buffer,     vector<float,   4>)->Apply(working_sets);
+BENCHMARK_TEMPLATE(ThroughputTransform, view_buffer,    vector<float,   4>)->Apply(working_sets);
+BENCHMARK_TEMPLATE(ThroughputTransform, aos_buffer,     vector<double,  4>)->Apply(working_sets);
+BENCHMARK_TEMPLATE(ThroughputTransform, view_buffer,    vector<double,  4>)->Apply(working_sets);
+
+BENCHMARK_TEMPLATE(ThroughputMatrixMul, matrix<float,   3, 3>)->Apply(working_sets);
+BENCHMARK_TEMPLATE(ThroughputMatrixMul, matrix<float,   4, 4>)->Apply(working_sets);
+BENCHMARK_TEMPLATE(ThroughputMatrixMul, matrix<double,  4, 4>)->Apply(working_sets);
+BENCHMARK_TEMPLATE(ThroughputAffineCompose, false,  float)->Apply(working_sets);
+BENCHMARK_TEMPLATE(ThroughputAffineCompose, true,   float)->Apply(working_sets);
+BENCHMARK_TEMPLATE(ThroughputAffineCompose, true,   double)->Apply(working_sets);
+
+BENCHMARK_TEMPLATE(ThroughputHierarchyUpdate, matrix<float, 4, 4>,     1)->Apply(working_sets);
+BENCHMARK_TEMPLATE(ThroughputHierarchyUpdate, matrix<float, 4, 4>,     0)->Apply(working_sets);
+BENCHMARK_TEMPLATE(ThroughputHierarchyUpdate, affine_transform<float>, 1)->Apply(working_sets);
+BENCHMARK_TEMPLATE(ThroughputHierarchyUpdate, affine_transform<float>, 0)->Apply(working_sets);
+
+BENCHMARK_TEMPLATE(ThroughputAabbBuild, bounds::expand,   float)->Apply(working_sets);
+BENCHMARK_TEMPLATE(ThroughputAabbBuild, bounds::bulk,     float)->Apply(working_sets);
+BENCHMARK_TEMPLATE(ThroughputAabbBuild, bounds::parallel, float)->Apply(working_sets);
+BENCHMARK_TEMPLATE(ThroughputAabbBuild, bounds::bulk,     double)->Apply(working_sets);
+
+BENCHMARK_TEMPLATE(ThroughputCullSpheres, false, 1)->Apply(working_sets);
+BENCHMARK_TEMPLATE(ThroughputCullSpheres, true,  1)->Apply(working_sets);
+BENCHMARK_TEMPLATE(ThroughputCullSpheres, true,  0)->Apply(working_sets);
+
+BENCHMARK_TEMPLATE(ThroughputRayTriangle, 1)->Apply(working_sets);
+BENCHMARK_TEMPLATE(ThroughputRayTriangle, 4)->Apply(working_sets);
+BENCHMARK_TEMPLATE(ThroughputRayTriangle, 8)->Apply(working_sets);
+BENCHMARK_TEMPLATE(ThroughputRayTriangle, 16)->Apply(working_sets);
+
+BENCHMARK_TEMPLATE(ThroughputBvh, bvh_update::build, 1)->Apply(working_sets);
+BENCHMARK_TEMPLATE(ThroughputBvh, bvh_update::build, 0)->Apply(working_sets);
+BENCHMARK_TEMPLATE(ThroughputBvh, bvh_update::refit, 1)->Apply(working_sets);
+BENCHMARK_TEMPLATE(ThroughputBvh, bvh_update::refit, 0)->Apply(working_sets);
+
+BENCHMARK_TEMPLATE(ThroughputBvhRays, bvh<float>)->Apply(working_sets);
+BENCHMARK_TEMPLATE(ThroughputBvhRays, bvh4<float>)->Apply(working_sets);
+BENCHMARK_TEMPLATE(ThroughputBvhRays, bvh8<float>)->Apply(working_sets);
+
+BENCHMARK_TEMPLATE(ThroughputKdTree, 1)->Apply(working_sets);
+BENCHMARK_TEMPLATE(ThroughputKdTree, 0)->Apply(working_sets);
+BENCHMARK_TEMPLATE(ThroughputKdTreeNearest, 1, 1)->Apply(working_sets);
+BENCHMARK_TEMPLATE(ThroughputKdTreeNearest, 8, 1)->Apply(working_sets);
+BENCHMARK_TEMPLATE(ThroughputKdTreeNearest, 8, 0)->Apply(working_sets);
+
+BENCHMARK_TEMPLATE(ThroughputSpatialHashGrid, 1)->Apply(working_sets);
+BENCHMARK_TEMPLATE(ThroughputSpatialHashGrid, 0)->Apply(working_sets);
+BENCHMARK_TEMPLATE(ThroughputSpatialHashGridPairs, 1)->Apply(working_sets);
+
+BENCHMARK_TEMPLATE(ThroughputCurveCodes, curve::morton,  std::uint32_t, 1)->Apply(working_sets);
+BENCHMARK_TEMPLATE(ThroughputCurveCodes, curve::morton,  std::uint64_t, 1)->Apply(working_sets);
+BENCHMARK_TEMPLATE(ThroughputCurveCodes, curve::hilbert, std::uint32_t, 1)->Apply(working_sets);
+BENCHMARK_TEMPLATE(ThroughputCurveCodes, curve::hilbert, std::uint32_t, 0)->Apply(working_sets);
+BENCHMARK_TEMPLATE(ThroughputSortByKeys, 1)->Apply(working_sets);
+BENCHMARK_TEMPLATE(ThroughputSortByKeys, 0)->Apply(working_sets);
+
+BENCHMARK_TEMPLATE(ThroughputDynamicMatrixMul,    float)->Apply(working_sets);
+BENCHMARK_TEMPLATE(ThroughputDynamicMatrixMul,    double)->Apply(working_sets);
+BENCHMARK_TEMPLATE(ThroughputDynamicMatrixVector, float)->Apply(working_sets);
+BENCHMARK_TEMPLATE(ThroughputDynamicMatrixVector, double)->Apply(working_sets);
+BENCHMARK_TEMPLATE(ThroughputDynamicAssign,       float,  true)->Apply(working_sets);
+BENCHMARK_TEMPLATE(ThroughputDynamicAssign,       float,  false)->Apply(working_sets);
+BENCHMARK_TEMPLATE(ThroughputSparseMatrixVector,  float,  1, false)->Apply(working_sets);
+BENCHMARK_TEMPLATE(ThroughputSparseMatrixVector,  float,  3, false)->Apply(working_sets);
+BENCHMARK_TEMPLATE(ThroughputSparseMatrixVector,  float,  3, true)->Apply(working_sets);
+BENCHMARK_TEMPLATE(ThroughputSparseMatrixVector,  double, 3, false)->Apply(working_sets);
+BENCHMARK_TEMPLATE(ThroughputPackedMatrixMul,     float,  64);
+BENCHMARK_TEMPLATE(ThroughputPackedMatrixMul,     float,  128);
+BENCHMARK_TEMPLATE(ThroughputPackedMatrixMul,     double, 64);
+
+BENCHMARK_TEMPLATE(ThroughputBatchMultiply, batch::single,   float,  3)->Apply(working_sets);
+BENCHMARK_TEMPLATE(ThroughputBatchMultiply, batch::packet,   float,  3)->Apply(working_sets);
+BENCHMARK_TEMPLATE(ThroughputBatchMultiply, batch::single,   float,  4)->Apply(working_sets);
+BENCHMARK_TEMPLATE(ThroughputBatchMultiply, batch::packet,   float,  4)->Apply(working_sets);
+BENCHMARK_TEMPLATE(ThroughputBatchMultiply, batch::parallel, float,  4)->Apply(working_sets);
+BENCHMARK_TEMPLATE(ThroughputBatchInverse,  batch::single,   float,  3)->Apply(working_sets);
+BENCHMARK_TEMPLATE(ThroughputBatchInverse,  batch::packet,   float,  3)->Apply(working_sets);
+BENCHMARK_TEMPLATE(ThroughputBatchInverse,  batch::parallel, float,  3)->Apply(working_sets);
+BENCHMARK_TEMPLATE(ThroughputBatchInverse,  batch::soa,      float,  3)->Apply(working_sets);
+BENCHMARK_TEMPLATE(ThroughputBatchInverse,  batch::single,   float,  4)->Apply(working_sets);
+BENCHMARK_TEMPLATE(ThroughputBatchInverse,  batch::packet,   float,  4)->Apply(working_sets);
+BENCHMARK_TEMPLATE(ThroughputBatchInverse,  batch::soa,      float,  4)->Apply(working_sets);
+BENCHMARK_TEMPLATE(ThroughputBatchInverse,  batch::packet,   double, 4)->Apply(working_sets);
+
+BENCHMARK_TEMPLATE(ThroughputMatrixSolve, decomposition::lu,       double, 6);
+BENCHMARK_TEMPLATE(ThroughputMatrixSolve, decomposition::cholesky, double, 6);
+BENCHMARK_TEMPLATE(ThroughputMatrixSolve, decomposition::qr,       double, 6);
+BENCHMARK_TEMPLATE(ThroughputMatrixSolve, decomposition::lu,       double, 7);
+BENCHMARK_TEMPLATE(ThroughputMatrixSolve, decomposition::cholesky, double, 7);
+
+BENCHMARK_TEMPLATE(ThroughputSymmetricEigen3, batch::single,   float)->Apply(working_sets);
+BENCHMARK_TEMPLATE(ThroughputSymmetricEigen3, batch::packet,   float)->Apply(working_sets);
+BENCHMARK_TEMPLATE(ThroughputSVD3,            batch::single,   float)->Apply(working_sets);
+BENCHMARK_TEMPLATE(ThroughputSVD3,            batch::packet,   float)->Apply(working_sets);
+BENCHMARK_TEMPLATE(ThroughputSVD3,            batch::parallel, float)->Apply(working_sets);
+BENCHMARK_TEMPLATE(ThroughputSVD3,            batch::packet,   double)->Apply(working_sets);
+
+BENCHMARK_TEMPLATE(ThroughputRotate,    rotation::sandwich,     float)->Apply(working_sets);
+BENCHMARK_TEMPLATE(ThroughputRotate,    rotation::expression,   float)->Apply(working_sets);
+BENCHMARK_TEMPLATE(ThroughputRotate,    rotation::bulk,         float)->Apply(working_sets);
+BENCHMARK_TEMPLATE(ThroughputRotate,    rotation::expression,   double)->Apply(working_sets);
+BENCHMARK_TEMPLATE(ThroughputRotate,    rotation::bulk,         double)->Apply(working_sets);
+
+BENCHMARK_TEMPLATE(ThroughputQuaternionToMatrix, false, matrix<float, 3, 3>)->Apply(working_sets);
+BENCHMARK_TEMPLATE(ThroughputQuaternionToMatrix, true,  matrix<float, 3, 3>)->Apply(working_sets);
+BENCHMARK_TEMPLATE(ThroughputQuaternionToMatrix, false, matrix<float, 4, 4>)->Apply(working_sets);
+BENCHMARK_TEMPLATE(ThroughputQuaternionToMatrix, true,  matrix<float, 4, 4>)->Apply(working_sets);
+
+BENCHMARK_TEMPLATE(ThroughputQuaternionBlend, blend::slerp,      float)->Apply(working_sets);
+BENCHMARK_TEMPLATE(ThroughputQuaternionBlend, blend::nlerp,      float)->Apply(working_sets);
+BENCHMARK_TEMPLATE(ThroughputQuaternionBlend, blend::fast_slerp, float)->Apply(working_sets);
+
+BENCHMARK_TEMPLATE(ThroughputSkin, false)->Apply(working_sets);
+BENCHMARK_TEMPLATE(ThroughputSkin, true)->Apply(working_sets);
+// clang-format on
+
+} /* namespace bench */
+} /* namespace math */
+} /* namespace psst */
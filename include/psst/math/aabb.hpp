@@ -0,0 +1,416 @@
+/**
+ * Copyright 2019 Sergei A. Fedorov
+ * aabb.hpp
+ *
+ *  Created on: Feb 25, 2019
+ *      Author: ser-fedorov
+ */
+
+#ifndef PSST_MATH_AABB_HPP_
+#define PSST_MATH_AABB_HPP_
+
+#include <psst/math/config.hpp>
+#include <psst/math/detail/parallel.hpp>
+#include <psst/math/matrix.hpp>
+#include <psst/math/vector.hpp>
+#include <psst/math/vector_view.hpp>
+
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+namespace psst {
+namespace math {
+
+/**
+ * Axis-aligned bounding box, defined by the minimal and the maximal corners.
+ * The bounds are inclusive, a box with min == max contains a single point.
+ *
+ * A default constructed box is empty, its min is the largest value and max
+ * is the lowest one, so merging anything into it gives the bounds of the
+ * merged object.
+ */
+template <typename T, std::size_t N, typename Components = components::default_components_t<N>>
+struct aabb {
+    static_assert(std::is_arithmetic_v<T>, "Bounding box values must be arithmetic");
+
+    using value_type  = T;
+    using vector_type = vector<T, N, Components>;
+
+    static constexpr std::size_t size = N;
+
+    constexpr aabb()
+        : min_(std::numeric_limits<T>::max()), max_(std::numeric_limits<T>::lowest())
+    {}
+    constexpr aabb(vector_type const& min, vector_type const& max) : min_{min}, max_{max} {}
+    /** A box containing a single point */
+    constexpr explicit aabb(vector_type const& point) : min_{point}, max_{point} {}
+
+    constexpr vector_type const&
+    min() const
+    {
+        return min_;
+    }
+
+    constexpr vector_type const&
+    max() const
+    {
+        return max_;
+    }
+
+    /**
+     * The box contains no points, min is greater than max for some axis
+     */
+    bool
+    empty() const
+    {
+        for (std::size_t i = 0; i < N; ++i) {
+            if (max_[i] < min_[i])
+                return true;
+        }
+        return false;
+    }
+
+    vector_type
+    center() const
+    {
+        return (min_ + max_) / 2;
+    }
+
+    /**
+     * Size of the box along each of the axes
+     */
+    vector_type
+    extents() const
+    {
+        return max_ - min_;
+    }
+
+    //@{
+    /** @name Growing the box */
+    aabb&
+    expand(vector_type const& point)
+    {
+        for (std::size_t i = 0; i < N; ++i) {
+            min_[i] = std::min(min_[i], point[i]);
+            max_[i] = std::max(max_[i], point[i]);
+        }
+        return *this;
+    }
+
+    aabb&
+    expand(aabb const& rhs)
+    {
+        for (std::size_t i = 0; i < N; ++i) {
+            min_[i] = std::min(min_[i], rhs.min_[i]);
+            max_[i] = std::max(max_[i], rhs.max_[i]);
+        }
+        return *this;
+    }
+    //@}
+
+    bool
+    operator==(aabb const& rhs) const
+    {
+        return min_ == rhs.min_ && max_ == rhs.max_;
+    }
+
+    bool
+    operator!=(aabb const& rhs) const
+    {
+        return !(*this == rhs);
+    }
+
+private:
+    vector_type min_;
+    vector_type max_;
+};
+
+//@{
+/** @name Operations on boxes */
+/**
+ * The smallest box containing both boxes
+ */
+template <typename T, std::size_t N, typename Components>
+aabb<T, N, Components>
+merge(aabb<T, N, Components> lhs, aabb<T, N, Components> const& rhs)
+{
+    return lhs.expand(rhs);
+}
+
+/**
+ * The smallest box containing the box and the point
+ */
+template <typename T, std::size_t N, typename Components>
+aabb<T, N, Components>
+merge(aabb<T, N, Components> lhs, vector<T, N, Components> const& point)
+{
+    return lhs.expand(point);
+}
+
+/**
+ * The common part of two boxes, empty if the boxes don't intersect
+ */
+template <typename T, std::size_t N, typename Components>
+aabb<T, N, Components>
+intersection(aabb<T, N, Components> const& lhs, aabb<T, N, Components> const& rhs)
+{
+    vector<T, N, Components> min, max;
+    for (std::size_t i = 0; i < N; ++i) {
+        min[i] = std::max(lhs.min()[i], rhs.min()[i]);
+        max[i] = std::min(lhs.max()[i], rhs.max()[i]);
+    }
+    return {min, max};
+}
+
+/**
+ * The boxes have at least one common point, touching boxes intersect
+ */
+template <typename T, std::size_t N, typename Components>
+bool
+intersects(aabb<T, N, Components> const& lhs, aabb<T, N, Components> const& rhs)
+{
+    for (std::size_t i = 0; i < N; ++i) {
+        if (lhs.max()[i] < rhs.min()[i] || rhs.max()[i] < lhs.min()[i])
+            return false;
+    }
+    return true;
+}
+
+template <typename T, std::size_t N, typename Components>
+bool
+contains(aabb<T, N, Components> const& box, vector<T, N, Components> const& point)
+{
+    for (std::size_t i = 0; i < N; ++i) {
+        if (point[i] < box.min()[i] || box.max()[i] < point[i])
+            return false;
+    }
+    return true;
+}
+
+/**
+ * The inner box is completely inside the outer one. An empty box is inside
+ * any non-empty box.
+ */
+template <typename T, std::size_t N, typename Components>
+bool
+contains(aabb<T, N, Components> const& outer, aabb<T, N, Components> const& inner)
+{
+    if (inner.empty())
+        return !outer.empty();
+    for (std::size_t i = 0; i < N; ++i) {
+        if (inner.min()[i] < outer.min()[i] || outer.max()[i] < inner.max()[i])
+            return false;
+    }
+    return true;
+}
+//@}
+
+namespace detail {
+
+/**
+ * Bounds of a box transformed by the upper 3x4 part of a row-major matrix,
+ * computed from the box center and extents instead of transforming the
+ * eight corners (J. Arvo, Transforming Axis-Aligned Bounding Boxes).
+ */
+template <typename U, typename T, typename Components>
+aabb<T, 3, Components>
+transform_bounds(U const* m, aabb<T, 3, Components> const& box)
+{
+    if (box.empty())
+        return box;
+    vector<T, 3, Components> min, max;
+    for (std::size_t i = 0; i < 3; ++i) {
+        T lo = m[i * 4 + 3];
+        T hi = lo;
+        for (std::size_t j = 0; j < 3; ++j) {
+            T const a = m[i * 4 + j] * box.min()[j];
+            T const b = m[i * 4 + j] * box.max()[j];
+            lo += std::min(a, b);
+            hi += std::max(a, b);
+        }
+        min[i] = lo;
+        max[i] = hi;
+    }
+    return {min, max};
+}
+
+/**
+ * Component-wise minimum and maximum of count records of Stride scalars.
+ * The minimum is taken of the first N scalars of a record, the maximum of
+ * the N scalars starting at Offset. The records are processed by groups of
+ * several at once, the inner loops run over contiguous memory and are
+ * vectorized by the compiler.
+ */
+template <std::size_t N, std::size_t Stride, std::size_t Offset, typename T>
+void
+reduce_bounds(T const* p, std::size_t count, T* lo, T* hi)
+{
+    constexpr std::size_t group = 4;
+    constexpr std::size_t width = Stride * group;
+
+    T group_lo[width];
+    T group_hi[width];
+    std::fill(group_lo, group_lo + width, std::numeric_limits<T>::max());
+    std::fill(group_hi, group_hi + width, std::numeric_limits<T>::lowest());
+    std::size_t i = 0;
+    for (; i + group <= count; i += group, p += width) {
+        for (std::size_t j = 0; j < width; ++j) {
+            group_lo[j] = p[j] < group_lo[j] ? p[j] : group_lo[j];
+            group_hi[j] = group_hi[j] < p[j] ? p[j] : group_hi[j];
+        }
+    }
+    for (; i < count; ++i, p += Stride) {
+        for (std::size_t j = 0; j < Stride; ++j) {
+            group_lo[j] = p[j] < group_lo[j] ? p[j] : group_lo[j];
+            group_hi[j] = group_hi[j] < p[j] ? p[j] : group_hi[j];
+        }
+    }
+    for (std::size_t g = 0; g < group; ++g) {
+        for (std::size_t k = 0; k < N; ++k) {
+            lo[k] = std::min(lo[k], group_lo[g * Stride + k]);
+            hi[k] = std::max(hi[k], group_hi[g * Stride + Offset + k]);
+        }
+    }
+}
+
+/**
+ * Bounds of count records, split between threads if there are enough of
+ * them.
+ */
+template <std::size_t N, std::size_t Stride, std::size_t Offset, typename T>
+void
+parallel_reduce_bounds(T const* p, std::size_t count, std::size_t threads, T* lo, T* hi)
+{
+    if (threads == 0)
+        threads = default_thread_count();
+    std::size_t const parts = std::min(threads, count / config::parallel_min_items);
+    if (parts <= 1) {
+        reduce_bounds<N, Stride, Offset>(p, count, lo, hi);
+        return;
+    }
+    std::vector<T> part_bounds(parts * 2 * N);
+    for (std::size_t i = 0; i < parts; ++i) {
+        std::fill_n(part_bounds.data() + i * 2 * N, N, std::numeric_limits<T>::max());
+        std::fill_n(part_bounds.data() + i * 2 * N + N, N, std::numeric_limits<T>::lowest());
+    }
+    parallel_for(parts, 1, parts, [&](std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end; ++i) {
+            std::size_t const first = count * i / parts;
+            std::size_t const last  = count * (i + 1) / parts;
+            T*                b     = part_bounds.data() + i * 2 * N;
+            reduce_bounds<N, Stride, Offset>(p + first * Stride, last - first, b, b + N);
+        }
+    });
+    for (std::size_t i = 0; i < parts; ++i) {
+        T const* b = part_bounds.data() + i * 2 * N;
+        for (std::size_t k = 0; k < N; ++k) {
+            lo[k] = std::min(lo[k], b[k]);
+            hi[k] = std::max(hi[k], b[N + k]);
+        }
+    }
+}
+
+}    // namespace detail
+
+//@{
+/** @name Transformed bounds */
+/**
+ * Bounds of a box transformed by an affine 4x4 matrix, the last row of the
+ * matrix is not used.
+ */
+template <typename U, typename MComponents, typename T, typename Components>
+aabb<T, 3, Components>
+transform_bounds(matrix<U, 4, 4, MComponents> const& m, aabb<T, 3, Components> const& box)
+{
+    return detail::transform_bounds(m.data(), box);
+}
+
+template <typename U, typename MComponents, typename T, typename Components>
+aabb<T, 3, Components>
+transform_bounds(matrix<U, 3, 4, MComponents> const& m, aabb<T, 3, Components> const& box)
+{
+    return detail::transform_bounds(m.data(), box);
+}
+
+/**
+ * Transform a contiguous range of boxes. The source and the destination may
+ * be the same range.
+ */
+template <typename U, std::size_t R, typename MComponents, typename T, typename Components>
+void
+transform_bounds(matrix<U, R, 4, MComponents> const& m, aabb<T, 3, Components> const* src,
+                 std::size_t count, aabb<T, 3, Components>* dst)
+{
+    static_assert(R == 3 || R == 4, "Transform must be a 4x4 matrix or a 3x4 affine transform");
+    for (std::size_t i = 0; i < count; ++i) {
+        dst[i] = detail::transform_bounds(m.data(), src[i]);
+    }
+}
+//@}
+
+//@{
+/** @name Bulk construction */
+/**
+ * Bounds of a contiguous range of points
+ * @param threads maximum number of threads, 0 means the hardware concurrency
+ */
+template <typename T, std::size_t N, typename Components>
+aabb<T, N, Components>
+make_aabb(vector<T, N, Components> const* points, std::size_t count, std::size_t threads = 1)
+{
+    static_assert(sizeof(vector<T, N, Components>) == sizeof(T) * N,
+                  "Vector components must be contiguous");
+    if (count == 0)
+        return {};
+    vector<T, N, Components> min(std::numeric_limits<T>::max());
+    vector<T, N, Components> max(std::numeric_limits<T>::lowest());
+    detail::parallel_reduce_bounds<N, N, 0>(points->data(), count, threads, min.data(),
+                                            max.data());
+    return {min, max};
+}
+
+/**
+ * Bounds of points in a memory buffer
+ * @param threads maximum number of threads, 0 means the hardware concurrency
+ */
+template <typename T, std::size_t N, typename Components, component_order Order>
+auto
+make_aabb(memory_vector_view<T*, N, Components, Order> const& points, std::size_t threads = 1)
+{
+    using value_type = std::remove_const_t<T>;
+    vector<value_type, N, Components> min(std::numeric_limits<value_type>::max());
+    vector<value_type, N, Components> max(std::numeric_limits<value_type>::lowest());
+    detail::parallel_reduce_bounds<N, N, 0>(points.data(), points.size(), threads, min.data(),
+                                            max.data());
+    if constexpr (Order == component_order::reverse) {
+        std::reverse(min.begin(), min.end());
+        std::reverse(max.begin(), max.end());
+    }
+    return aabb<value_type, N, Components>{min, max};
+}
+
+/**
+ * Bounds of a contiguous range of boxes
+ * @param threads maximum number of threads, 0 means the hardware concurrency
+ */
+template <typename T, std::size_t N, typename Components>
+aabb<T, N, Components>
+make_aabb(aabb<T, N, Components> const* boxes, std::size_t count, std::size_t threads = 1)
+{
+    static_assert(sizeof(aabb<T, N, Components>) == sizeof(T) * N * 2,
+                  "Box corners must be contiguous");
+    if (count == 0)
+        return {};
+    vector<T, N, Components> min(std::numeric_limits<T>::max());
+    vector<T, N, Components> max(std::numeric_limits<T>::lowest());
+    detail::parallel_reduce_bounds<N, N * 2, N>(boxes->min().data(), count, threads, min.data(),
+                                                max.data());
+    return {min, max};
+}
+//@}
+
+}    // namespace math
+}    // namespace psst
+
+#endif /* PSST_MATH_AABB_HPP_ */
@@ -0,0 +1,483 @@
+/**
+ * Copyright 2019 Sergei A. Fedorov
+ * affine_transform.hpp
+ *
+ *  Created on: Feb 22, 2019
+ *      Author: ser-fedorov
+ */
+
+#ifndef PSST_MATH_AFFINE_TRANSFORM_HPP_
+#define PSST_MATH_AFFINE_TRANSFORM_HPP_
+
+#include <psst/math/detail/conversion.hpp>
+#include <psst/math/matrix.hpp>
+#include <psst/math/rotation.hpp>
+#include <psst/math/vector.hpp>
+
+#include <stdexcept>
+
+namespace psst {
+namespace math {
+
+/**
+ * Affine transform stored as the upper 3x4 part of a 4x4 matrix, the last
+ * row is implicitly 0 0 0 1. The linear part is in the first three columns,
+ * the translation is in the last column. Vectors are transformed as columns,
+ * the same way as by a 4x4 matrix.
+ */
+template <typename T>
+using affine_transform = matrix<T, 3, 4>;
+
+namespace expr {
+inline namespace m {
+
+//@{
+/** @name Composition of affine transforms */
+template <typename LHS, typename RHS>
+struct affine_compose_result {
+    static_assert((traits::is_matrix_expression_v<LHS> && traits::is_matrix_expression_v<RHS>),
+                  "Both sides to the expession must be matrix expressions");
+    using lhs_type = std::decay_t<LHS>;
+    using rhs_type = std::decay_t<RHS>;
+    static_assert(lhs_type::rows == 3 && lhs_type::cols == 4,
+                  "Left hand side must be a 3x4 affine transform");
+    static_assert(rhs_type::rows == 3 && rhs_type::cols == 4,
+                  "Right hand side must be a 3x4 affine transform");
+    using value_type      = traits::scalar_expression_result_t<lhs_type, rhs_type>;
+    using component_names = traits::component_names_for_t<LHS, RHS>;
+    using type            = matrix<value_type, 3, 4, component_names>;
+};
+
+template <typename LHS, typename RHS>
+using affine_compose_result_t = typename affine_compose_result<LHS, RHS>::type;
+
+/**
+ * Product of two 4x4 matrices with the last rows 0 0 0 1, the rhs transform
+ * is applied first. The last row of the product is 0 0 0 1 as well, so only
+ * 36 multiplications are needed instead of 64.
+ */
+template <typename LHS, typename RHS>
+struct affine_compose
+    : matrix_expression<affine_compose<LHS, RHS>, affine_compose_result_t<LHS, RHS>>,
+      binary_expression<LHS, RHS> {
+
+    using base_type
+        = matrix_expression<affine_compose<LHS, RHS>, affine_compose_result_t<LHS, RHS>>;
+    using value_type      = typename base_type::value_type;
+    using expression_base = binary_expression<LHS, RHS>;
+    using expression_base::expression_base;
+
+    template <std::size_t R, std::size_t C>
+    constexpr value_type
+    element() const
+    {
+        static_assert(R < base_type::rows, "Invalid matrix expression row index");
+        static_assert(C < base_type::cols, "Invalid matrix expression col index");
+        auto const&      a   = this->lhs_;
+        auto const&      b   = this->rhs_;
+        value_type const res = a.template element<R, 0>() * b.template element<0, C>()
+                               + a.template element<R, 1>() * b.template element<1, C>()
+                               + a.template element<R, 2>() * b.template element<2, C>();
+        if constexpr (C == 3) {
+            return res + a.template element<R, 3>();
+        } else {
+            return res;
+        }
+    }
+};
+
+template <typename LHS, typename RHS, typename = traits::enable_if_matrix_expressions<LHS, RHS>>
+constexpr auto
+compose(LHS&& lhs, RHS&& rhs)
+{
+    return make_binary_expression<affine_compose>(std::forward<LHS>(lhs), std::forward<RHS>(rhs));
+}
+//@}
+
+}    // namespace m
+
+inline namespace v {
+
+//@{
+/** @name Apply an affine transform */
+/**
+ * The point is transformed by the linear part and translated
+ */
+template <typename Matrix, typename Vector>
+struct affine_transform_point
+    : binary_vector_expression<affine_transform_point, Matrix, Vector,
+                               traits::vector_expression_result_t<Vector>>,
+      binary_expression<Matrix, Vector> {
+    using base_type = binary_vector_expression<affine_transform_point, Matrix, Vector,
+                                               traits::vector_expression_result_t<Vector>>;
+    static_assert(base_type::size == 3,
+                  "Only a 3D point can be transformed by an affine transform");
+    using value_type      = typename base_type::value_type;
+    using expression_base = binary_expression<Matrix, Vector>;
+    using expression_base::expression_base;
+
+    template <std::size_t N>
+    constexpr value_type
+    at() const
+    {
+        static_assert(N < base_type::size, "Invalid vector component index");
+        auto const& m = this->lhs_;
+        auto const& p = this->rhs_;
+        return m.template element<N, 0>() * p.template at<0>()
+               + m.template element<N, 1>() * p.template at<1>()
+               + m.template element<N, 2>() * p.template at<2>() + m.template element<N, 3>();
+    }
+};
+
+/**
+ * A direction is transformed only by the linear part, the translation
+ * doesn't apply to it
+ */
+template <typename Matrix, typename Vector>
+struct affine_transform_direction
+    : binary_vector_expression<affine_transform_direction, Matrix, Vector,
+                               traits::vector_expression_result_t<Vector>>,
+      binary_expression<Matrix, Vector> {
+    using base_type = binary_vector_expression<affine_transform_direction, Matrix, Vector,
+                                               traits::vector_expression_result_t<Vector>>;
+    static_assert(base_type::size == 3,
+                  "Only a 3D direction can be transformed by an affine transform");
+    using value_type      = typename base_type::value_type;
+    using expression_base = binary_expression<Matrix, Vector>;
+    using expression_base::expression_base;
+
+    template <std::size_t N>
+    constexpr value_type
+    at() const
+    {
+        static_assert(N < base_type::size, "Invalid vector component index");
+        auto const& m = this->lhs_;
+        auto const& p = this->rhs_;
+        return m.template element<N, 0>() * p.template at<0>()
+               + m.template element<N, 1>() * p.template at<1>()
+               + m.template element<N, 2>() * p.template at<2>();
+    }
+};
+
+template <typename T, typename Components, typename Vector,
+          typename = traits::enable_if_vector_expression<Vector>>
+constexpr auto
+transform_point(matrix<T, 3, 4, Components> const& m, Vector&& p)
+{
+    return make_binary_expression<affine_transform_point>(m, std::forward<Vector>(p));
+}
+
+template <typename T, typename Components, typename Vector,
+          typename = traits::enable_if_vector_expression<Vector>>
+constexpr auto
+transform_direction(matrix<T, 3, 4, Components> const& m, Vector&& v)
+{
+    return make_binary_expression<affine_transform_direction>(m, std::forward<Vector>(v));
+}
+//@}
+
+//@{
+/** @name Affine transform to 4x4 matrix conversion */
+template <typename T, typename U, typename Components, typename Expression>
+struct conversion<matrix<T, 3, 4, Components>, matrix<U, 4, 4, Components>, Expression>
+    : unary_expression<Expression> {
+    using expression_base = unary_expression<Expression>;
+    using expression_base::expression_base;
+
+    auto
+    result() const
+    {
+        // Only the first three rows are copied
+        matrix<U, 4, 4, Components> res(this->arg_);
+        U*                          m = res.data();
+        m[12] = m[13] = m[14] = 0;
+        m[15]                 = 1;
+        return res;
+    }
+};
+
+/**
+ * The last row of the matrix is dropped, it's expected to be 0 0 0 1. A
+ * projective transform cannot be converted.
+ */
+template <typename T, typename U, typename Components, typename Expression>
+struct conversion<matrix<T, 4, 4, Components>, matrix<U, 3, 4, Components>, Expression>
+    : unary_expression<Expression> {
+    using expression_base = unary_expression<Expression>;
+    using expression_base::expression_base;
+
+    auto
+    result() const
+    {
+        return matrix<U, 3, 4, Components>(this->arg_);
+    }
+};
+//@}
+
+}    // namespace v
+}    // namespace expr
+
+namespace detail {
+
+/**
+ * Product of two affine transforms stored as row-major 3x4 arrays, 36
+ * multiplications instead of 64 for 4x4 matrices. All the elements are
+ * loaded before any store, so dst may be the same as a or b.
+ */
+template <typename T>
+void
+affine_multiply(T const* a, T const* b, T* dst)
+{
+    T const a00 = a[0], a01 = a[1], a02 = a[2], a03 = a[3];
+    T const a10 = a[4], a11 = a[5], a12 = a[6], a13 = a[7];
+    T const a20 = a[8], a21 = a[9], a22 = a[10], a23 = a[11];
+    T const b00 = b[0], b01 = b[1], b02 = b[2], b03 = b[3];
+    T const b10 = b[4], b11 = b[5], b12 = b[6], b13 = b[7];
+    T const b20 = b[8], b21 = b[9], b22 = b[10], b23 = b[11];
+
+    dst[0]  = a00 * b00 + a01 * b10 + a02 * b20;
+    dst[1]  = a00 * b01 + a01 * b11 + a02 * b21;
+    dst[2]  = a00 * b02 + a01 * b12 + a02 * b22;
+    dst[3]  = a00 * b03 + a01 * b13 + a02 * b23 + a03;
+    dst[4]  = a10 * b00 + a11 * b10 + a12 * b20;
+    dst[5]  = a10 * b01 + a11 * b11 + a12 * b21;
+    dst[6]  = a10 * b02 + a11 * b12 + a12 * b22;
+    dst[7]  = a10 * b03 + a11 * b13 + a12 * b23 + a13;
+    dst[8]  = a20 * b00 + a21 * b10 + a22 * b20;
+    dst[9]  = a20 * b01 + a21 * b11 + a22 * b21;
+    dst[10] = a20 * b02 + a21 * b12 + a22 * b22;
+    dst[11] = a20 * b03 + a21 * b13 + a22 * b23 + a23;
+}
+
+/**
+ * Inverse of a general affine transform, the linear part is inverted by
+ * cofactors and the translation is t' = -A^-1 t.
+ */
+template <typename T>
+void
+affine_inverse(T const* m, T* dst)
+{
+    T const a00 = m[0], a01 = m[1], a02 = m[2], tx = m[3];
+    T const a10 = m[4], a11 = m[5], a12 = m[6], ty = m[7];
+    T const a20 = m[8], a21 = m[9], a22 = m[10], tz = m[11];
+
+    T const c00 = a11 * a22 - a12 * a21;
+    T const c01 = a12 * a20 - a10 * a22;
+    T const c02 = a10 * a21 - a11 * a20;
+    T const det = a00 * c00 + a01 * c01 + a02 * c02;
+    if (det == 0)
+        throw std::runtime_error("Cannot inverse a singular affine transform");
+    T const inv = 1 / det;
+
+    T const i00 = c00 * inv;
+    T const i01 = (a02 * a21 - a01 * a22) * inv;
+    T const i02 = (a01 * a12 - a02 * a11) * inv;
+    T const i10 = c01 * inv;
+    T const i11 = (a00 * a22 - a02 * a20) * inv;
+    T const i12 = (a02 * a10 - a00 * a12) * inv;
+    T const i20 = c02 * inv;
+    T const i21 = (a01 * a20 - a00 * a21) * inv;
+    T const i22 = (a00 * a11 - a01 * a10) * inv;
+
+    dst[0]  = i00;
+    dst[1]  = i01;
+    dst[2]  = i02;
+    dst[3]  = -(i00 * tx + i01 * ty + i02 * tz);
+    dst[4]  = i10;
+    dst[5]  = i11;
+    dst[6]  = i12;
+    dst[7]  = -(i10 * tx + i11 * ty + i12 * tz);
+    dst[8]  = i20;
+    dst[9]  = i21;
+    dst[10] = i22;
+    dst[11] = -(i20 * tx + i21 * ty + i22 * tz);
+}
+
+/**
+ * Inverse of a rotation and a translation, the rotation is transposed
+ */
+template <typename T>
+void
+rigid_inverse(T const* m, T* dst)
+{
+    T const a00 = m[0], a01 = m[1], a02 = m[2], tx = m[3];
+    T const a10 = m[4], a11 = m[5], a12 = m[6], ty = m[7];
+    T const a20 = m[8], a21 = m[9], a22 = m[10], tz = m[11];
+
+    dst[0]  = a00;
+    dst[1]  = a10;
+    dst[2]  = a20;
+    dst[3]  = -(a00 * tx + a10 * ty + a20 * tz);
+    dst[4]  = a01;
+    dst[5]  = a11;
+    dst[6]  = a21;
+    dst[7]  = -(a01 * tx + a11 * ty + a21 * tz);
+    dst[8]  = a02;
+    dst[9]  = a12;
+    dst[10] = a22;
+    dst[11] = -(a02 * tx + a12 * ty + a22 * tz);
+}
+
+}    // namespace detail
+
+//@{
+/** @name Inverse of an affine transform */
+/**
+ * @throws std::runtime_error if the linear part is singular
+ */
+template <typename T, typename Components>
+matrix<T, 3, 4, Components>
+inverse(matrix<T, 3, 4, Components> const& m)
+{
+    matrix<T, 3, 4, Components> res;
+    detail::affine_inverse(m.data(), res.data());
+    return res;
+}
+
+/**
+ * Inverse of a transform without scale and shear, i.e. the linear part is
+ * an orthonormal matrix. Cheaper than the general inverse.
+ */
+template <typename T, typename Components>
+matrix<T, 3, 4, Components>
+rigid_inverse(matrix<T, 3, 4, Components> const& m)
+{
+    matrix<T, 3, 4, Components> res;
+    detail::rigid_inverse(m.data(), res.data());
+    return res;
+}
+//@}
+
+//@{
+/** @name Affine transform from a decomposition */
+/**
+ * Rotation by a quaternion followed by a translation
+ */
+template <typename Quaternion, typename Vector,
+          typename = traits::enable_for_components<Quaternion, components::wxyz>,
+          typename = traits::enable_if_vector_expression<Vector>>
+auto
+make_affine_transform(Quaternion&& rotation, Vector&& translation)
+{
+    using quaternion_type = traits::vector_expression_result_t<Quaternion>;
+    using value_type      = typename quaternion_type::value_type;
+    static_assert(traits::vector_expression_size_v<Vector> == 3,
+                  "Translation must be a 3D vector");
+
+    quaternion_type const        r{std::forward<Quaternion>(rotation)};
+    affine_transform<value_type> res;
+    value_type*                  m = res.data();
+    detail::quaternion_to_matrix(r[0], r[1], r[2], r[3], m, 4);
+    m[3]  = translation.template at<0>();
+    m[7]  = translation.template at<1>();
+    m[11] = translation.template at<2>();
+    return res;
+}
+
+/**
+ * Scale along the axes, then rotation by a quaternion, then translation
+ */
+template <typename Quaternion, typename Vector, typename Scale,
+          typename = traits::enable_for_components<Quaternion, components::wxyz>,
+          typename = traits::enable_if_vector_expression<Vector>,
+          typename = traits::enable_if_vector_expression<Scale>>
+auto
+make_affine_transform(Quaternion&& rotation, Vector&& translation, Scale&& scale)
+{
+    static_assert(traits::vector_expression_size_v<Scale> == 3, "Scale must be a 3D vector");
+    auto res = make_affine_transform(std::forward<Quaternion>(rotation),
+                                     std::forward<Vector>(translation));
+    auto const  sx = scale.template at<0>();
+    auto const  sy = scale.template at<1>();
+    auto const  sz = scale.template at<2>();
+    auto* const m  = res.data();
+    for (std::size_t i = 0; i < 3; ++i) {
+        m[i * 4] *= sx;
+        m[i * 4 + 1] *= sy;
+        m[i * 4 + 2] *= sz;
+    }
+    return res;
+}
+//@}
+
+//@{
+/** @name Bulk composition */
+/**
+ * dst[i] = lhs[i] * rhs[i], e.g. world transforms of nodes from the world
+ * transforms of their parents and the local transforms. The destination may
+ * be the same range as either of the sources.
+ */
+template <typename T, typename Components>
+void
+compose(matrix<T, 3, 4, Components> const* lhs, matrix<T, 3, 4, Components> const* rhs,
+        std::size_t count, matrix<T, 3, 4, Components>* dst)
+{
+    for (std::size_t i = 0; i < count; ++i) {
+        detail::affine_multiply(lhs[i].data(), rhs[i].data(), dst[i].data());
+    }
+}
+
+/**
+ * dst[i] = parent * local[i], all the children of a node at once. The
+ * destination may be the same range as the source.
+ */
+template <typename T, typename Components>
+void
+compose(matrix<T, 3, 4, Components> const& parent, matrix<T, 3, 4, Components> const* local,
+        std::size_t count, matrix<T, 3, 4, Components>* dst)
+{
+    matrix<T, 3, 4, Components> const p = parent;
+    for (std::size_t i = 0; i < count; ++i) {
+        detail::affine_multiply(p.data(), local[i].data(), dst[i].data());
+    }
+}
+//@}
+
+//@{
+/** @name Bulk transform */
+/**
+ * Transform a contiguous range of points. The source and the destination
+ * may be the same range.
+ */
+template <typename T, typename Components, typename U, typename VComponents>
+void
+transform_point(matrix<T, 3, 4, Components> const& m, vector<U, 3, VComponents> const* src,
+                std::size_t count, vector<U, 3, VComponents>* dst)
+{
+    T const* a = m.data();
+    T const  a00 = a[0], a01 = a[1], a02 = a[2], a03 = a[3];
+    T const  a10 = a[4], a11 = a[5], a12 = a[6], a13 = a[7];
+    T const  a20 = a[8], a21 = a[9], a22 = a[10], a23 = a[11];
+    for (std::size_t i = 0; i < count; ++i) {
+        U const x = src[i][0], y = src[i][1], z = src[i][2];
+        dst[i][0] = a00 * x + a01 * y + a02 * z + a03;
+        dst[i][1] = a10 * x + a11 * y + a12 * z + a13;
+        dst[i][2] = a20 * x + a21 * y + a22 * z + a23;
+    }
+}
+
+/**
+ * Transform a contiguous range of directions by the linear part
+ */
+template <typename T, typename Components, typename U, typename VComponents>
+void
+transform_direction(matrix<T, 3, 4, Components> const& m, vector<U, 3, VComponents> const* src,
+                    std::size_t count, vector<U, 3, VComponents>* dst)
+{
+    T const* a = m.data();
+    T const  a00 = a[0], a01 = a[1], a02 = a[2];
+    T const  a10 = a[4], a11 = a[5], a12 = a[6];
+    T const  a20 = a[8], a21 = a[9], a22 = a[10];
+    for (std::size_t i = 0; i < count; ++i) {
+        U const x = src[i][0], y = src[i][1], z = src[i][2];
+        dst[i][0] = a00 * x + a01 * y + a02 * z;
+        dst[i][1] = a10 * x + a11 * y + a12 * z;
+        dst[i][2] = a20 * x + a21 * y + a22 * z;
+    }
+}
+//@}
+
+}    // namespace math
+}    // namespace psst
+
+#endif /* PSST_MATH_AFFINE_TRANSFORM_HPP_ */
@@ -0,0 +1,1194 @@
+/**
+ * Copyright 2019 Sergei A. Fedorov
+ * bvh.hpp
+ *
+ *  Created on: Feb 28, 2019
+ *      Author: ser-fedorov
+ */
+
+#ifndef PSST_MATH_BVH_HPP_
+#define PSST_MATH_BVH_HPP_
+
+#include <psst/math/aabb.hpp>
+#include <psst/math/config.hpp>
+#include <psst/math/detail/parallel.hpp>
+#include <psst/math/ray.hpp>
+#include <psst/math/vector_view.hpp>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <mutex>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace psst {
+namespace math {
+
+/**
+ * Node of a binary bounding volume hierarchy, 32 bytes for float values.
+ * An inner node has a zero count, its children are the nodes first and
+ * first + 1. A leaf references count primitive indices starting at first.
+ */
+template <typename T>
+struct alignas(32) bvh_node {
+    T             min[3];
+    std::uint32_t first;
+    T             max[3];
+    std::uint32_t count;
+
+    bool
+    leaf() const
+    {
+        return count != 0;
+    }
+
+    aabb<T, 3>
+    bounds() const
+    {
+        return {{min[0], min[1], min[2]}, {max[0], max[1], max[2]}};
+    }
+};
+
+static_assert(sizeof(bvh_node<float>) == 32, "A node must take 32 bytes");
+
+/**
+ * Node of a wide bounding volume hierarchy with up to Width children. The
+ * bounds of the children are stored by components, so that a ray is tested
+ * against all of them in a single loop. A slot with a non-zero count is a
+ * leaf referencing count primitive indices starting at child, an unused
+ * slot has an empty box and the child index empty.
+ */
+template <typename T, std::size_t Width>
+struct alignas(64) wide_bvh_node {
+    static_assert(Width == 4 || Width == 8, "Node width must be 4 or 8");
+
+    static constexpr std::uint32_t empty = std::numeric_limits<std::uint32_t>::max();
+
+    T             min[3][Width];
+    T             max[3][Width];
+    std::uint32_t child[Width];
+    std::uint32_t count[Width];
+
+    aabb<T, 3>
+    bounds(std::size_t slot) const
+    {
+        return {{min[0][slot], min[1][slot], min[2][slot]},
+                {max[0][slot], max[1][slot], max[2][slot]}};
+    }
+
+    /** Bounds of all the children */
+    aabb<T, 3>
+    bounds() const
+    {
+        aabb<T, 3> res;
+        for (std::size_t i = 0; i < Width; ++i) {
+            res.expand(bounds(i));
+        }
+        return res;
+    }
+
+    void
+    set_bounds(std::size_t slot, aabb<T, 3> const& box)
+    {
+        for (std::size_t i = 0; i < 3; ++i) {
+            min[i][slot] = box.min()[i];
+            max[i][slot] = box.max()[i];
+        }
+    }
+};
+
+namespace detail {
+
+/** Maximal depth of a hierarchy, defines the size of the traversal stacks */
+constexpr std::size_t bvh_max_depth = 64;
+/**
+ * Depth after which the ranges are split at the median, so that a hierarchy
+ * of less than 2^32 primitives is never deeper than bvh_max_depth
+ */
+constexpr std::size_t bvh_median_depth = bvh_max_depth - 32;
+
+/**
+ * Half of the surface area of a box, the SAH uses only the area ratios
+ */
+template <typename T>
+T
+half_area(aabb<T, 3> const& box)
+{
+    if (box.empty())
+        return 0;
+    auto const e = box.extents();
+    return e[0] * e[1] + e[1] * e[2] + e[2] * e[0];
+}
+
+template <typename T>
+void
+set_node(bvh_node<T>& node, aabb<T, 3> const& bounds, std::size_t first, std::size_t count)
+{
+    for (std::size_t i = 0; i < 3; ++i) {
+        node.min[i] = bounds.min()[i];
+        node.max[i] = bounds.max()[i];
+    }
+    node.first = static_cast<std::uint32_t>(first);
+    node.count = static_cast<std::uint32_t>(count);
+}
+
+template <typename T>
+bool
+overlaps(T const* min, T const* max, aabb<T, 3> const& box)
+{
+    return min[0] <= box.max()[0] && box.min()[0] <= max[0] && min[1] <= box.max()[1]
+           && box.min()[1] <= max[1] && min[2] <= box.max()[2] && box.min()[2] <= max[2];
+}
+
+/**
+ * Bounds and number of the primitives in a bin. The bounds are plain arrays,
+ * binning is the hot loop of the build. A bin is not initialized on
+ * construction, only the bins in use are reset.
+ */
+template <typename T>
+struct bvh_bin {
+    T           min[3];
+    T           max[3];
+    std::size_t count;
+
+    static bvh_bin
+    empty()
+    {
+        bvh_bin res;
+        res.reset();
+        return res;
+    }
+
+    void
+    reset()
+    {
+        for (std::size_t i = 0; i < 3; ++i) {
+            min[i] = std::numeric_limits<T>::max();
+            max[i] = std::numeric_limits<T>::lowest();
+        }
+        count = 0;
+    }
+
+    void
+    expand(T const* box_min, T const* box_max)
+    {
+        for (std::size_t i = 0; i < 3; ++i) {
+            min[i] = box_min[i] < min[i] ? box_min[i] : min[i];
+            max[i] = box_max[i] > max[i] ? box_max[i] : max[i];
+        }
+    }
+
+    void
+    merge(bvh_bin const& rhs)
+    {
+        expand(rhs.min, rhs.max);
+        count += rhs.count;
+    }
+
+    /** Half of the surface area, zero for an empty bin */
+    T
+    half_area() const
+    {
+        if (count == 0)
+            return 0;
+        T const x = max[0] - min[0], y = max[1] - min[1], z = max[2] - min[2];
+        return x * y + y * z + z * x;
+    }
+
+    aabb<T, 3>
+    bounds() const
+    {
+        return {{min[0], min[1], min[2]}, {max[0], max[1], max[2]}};
+    }
+};
+
+/** Bins of the three axes */
+template <typename T>
+using bvh_bins = std::array<bvh_bin<T>, 3 * config::bvh_bins>;
+
+/**
+ * Mapping of centroid coordinates to the bins, the bins split the centroid
+ * bounds of a range into equal intervals. A small range uses a bin per
+ * primitive, as evaluating empty bins costs more than binning.
+ */
+template <typename T>
+struct bvh_binning {
+    bvh_binning(aabb<T, 3> const& centroid_bounds, std::size_t count)
+        : min_{centroid_bounds.min()}, size_{std::min(config::bvh_bins, count)}
+    {
+        auto const e = centroid_bounds.extents();
+        for (std::size_t i = 0; i < 3; ++i) {
+            scale_[i] = e[i] > 0 ? size_ / e[i] : 0;
+        }
+    }
+
+    /** Number of bins per axis */
+    std::size_t
+    size() const
+    {
+        return size_;
+    }
+
+    /** All the centroids are the same point */
+    bool
+    degenerate() const
+    {
+        return scale_[0] == 0 && scale_[1] == 0 && scale_[2] == 0;
+    }
+
+    std::size_t
+    operator()(T const* centroid, std::size_t axis) const
+    {
+        auto const bin = static_cast<std::size_t>((centroid[axis] - min_[axis]) * scale_[axis]);
+        return std::min(bin, size_ - 1);
+    }
+
+private:
+    vector<T, 3> min_;
+    vector<T, 3> scale_;
+    std::size_t  size_;
+};
+
+/**
+ * A range of the primitive indices and the bounds of the primitives
+ */
+template <typename T>
+struct bvh_range {
+    std::size_t begin = 0;
+    std::size_t end   = 0;
+    std::size_t depth = 0;
+    aabb<T, 3>  bounds;
+    aabb<T, 3>  centroid_bounds;
+
+    std::size_t
+    size() const
+    {
+        return end - begin;
+    }
+};
+
+/**
+ * A primitive being sorted to the leaves
+ */
+template <typename T>
+struct bvh_primitive {
+    T             min[3];
+    T             max[3];
+    T             centroid[3];
+    std::uint32_t index;
+
+    bvh_primitive() = default;
+    bvh_primitive(aabb<T, 3> const& box, std::uint32_t idx) : index{idx}
+    {
+        for (std::size_t i = 0; i < 3; ++i) {
+            min[i]      = box.min()[i];
+            max[i]      = box.max()[i];
+            centroid[i] = (min[i] + max[i]) / 2;
+        }
+    }
+};
+
+/**
+ * Binned SAH builder. Splits ranges of the primitive array, the array is
+ * partitioned in place so that the primitives of a leaf are contiguous.
+ * The primitives are moved rather than their indices, so that binning of a
+ * range reads contiguous memory.
+ */
+template <typename T>
+struct bvh_builder {
+    using node_type = bvh_node<T>;
+    using range     = bvh_range<T>;
+    using task      = std::pair<range, std::uint32_t>;
+
+    bvh_primitive<T>* prims;
+
+    range
+    make_range(std::size_t begin, std::size_t end, std::size_t depth) const
+    {
+        auto bounds    = bvh_bin<T>::empty();
+        auto centroids = bvh_bin<T>::empty();
+        for (std::size_t i = begin; i < end; ++i) {
+            bounds.expand(prims[i].min, prims[i].max);
+            centroids.expand(prims[i].centroid, prims[i].centroid);
+        }
+        return {begin, end, depth, bounds.bounds(), centroids.bounds()};
+    }
+
+    static void
+    reset(bvh_binning<T> const& binning, bvh_bins<T>& bins)
+    {
+        for (std::size_t axis = 0; axis < 3; ++axis) {
+            for (std::size_t i = 0; i < binning.size(); ++i) {
+                bins[axis * config::bvh_bins + i].reset();
+            }
+        }
+    }
+
+    /** Merge the bins used by the binning, the rest are left uninitialized */
+    static void
+    merge(bvh_binning<T> const& binning, bvh_bins<T> const& from, bvh_bins<T>& to)
+    {
+        for (std::size_t axis = 0; axis < 3; ++axis) {
+            for (std::size_t i = 0; i < binning.size(); ++i) {
+                std::size_t const index = axis * config::bvh_bins + i;
+                to[index].merge(from[index]);
+            }
+        }
+    }
+
+    void
+    bin(bvh_binning<T> const& binning, std::size_t begin, std::size_t end,
+        bvh_bins<T>& bins) const
+    {
+        for (std::size_t i = begin; i < end; ++i) {
+            auto const& p = prims[i];
+            for (std::size_t axis = 0; axis < 3; ++axis) {
+                auto& b = bins[axis * config::bvh_bins + binning(p.centroid, axis)];
+                b.expand(p.min, p.max);
+                ++b.count;
+            }
+        }
+    }
+
+    /**
+     * Partition a range by a predicate, collecting the centroid bounds of
+     * both parts in the same pass
+     * @return the first primitive of the second part
+     */
+    template <typename Predicate>
+    std::size_t
+    partition(range const& r, Predicate pred, bvh_bin<T>& left, bvh_bin<T>& right) const
+    {
+        std::size_t i = r.begin;
+        std::size_t j = r.end;
+        while (true) {
+            for (; i < j && pred(prims[i]); ++i) {
+                left.expand(prims[i].centroid, prims[i].centroid);
+            }
+            for (; i < j && !pred(prims[j - 1]); --j) {
+                right.expand(prims[j - 1].centroid, prims[j - 1].centroid);
+            }
+            if (i == j)
+                return i;
+            std::swap(prims[i], prims[j - 1]);
+        }
+    }
+
+    void
+    median_split(range const& r, range& left, range& right) const
+    {
+        auto const        e    = r.centroid_bounds.extents();
+        std::size_t const axis = e[0] > e[1] ? (e[0] > e[2] ? 0 : 2) : (e[1] > e[2] ? 1 : 2);
+        std::size_t const mid  = r.begin + r.size() / 2;
+        std::nth_element(prims + r.begin, prims + mid, prims + r.end,
+                         [axis](bvh_primitive<T> const& a, bvh_primitive<T> const& b) {
+                             return a.centroid[axis] < b.centroid[axis];
+                         });
+        left  = make_range(r.begin, mid, r.depth + 1);
+        right = make_range(mid, r.end, r.depth + 1);
+    }
+
+    /**
+     * Split a range at the bin boundary with the lowest SAH cost
+     * @param threads number of threads binning a big range
+     * @return false if the range should become a leaf
+     */
+    bool
+    split(range const& r, std::size_t threads, range& left, range& right) const
+    {
+        std::size_t const count = r.size();
+        bool const        small = count <= config::bvh_max_leaf_size;
+        if (count <= 1)
+            return false;
+        bvh_binning<T> const binning{r.centroid_bounds, count};
+        if (r.depth >= bvh_median_depth || binning.degenerate()) {
+            if (small)
+                return false;
+            median_split(r, left, right);
+            return true;
+        }
+
+        bvh_bins<T> bins;
+        reset(binning, bins);
+        if (threads != 1 && count >= config::parallel_min_items) {
+            std::mutex mutex;
+            parallel_for(count, config::parallel_min_items, threads,
+                         [&](std::size_t begin, std::size_t end) {
+                             bvh_bins<T> local;
+                             reset(binning, local);
+                             bin(binning, r.begin + begin, r.begin + end, local);
+                             std::lock_guard<std::mutex> lock{mutex};
+                             merge(binning, local, bins);
+                         });
+        } else {
+            bin(binning, r.begin, r.end, bins);
+        }
+
+        std::size_t const bin_count = binning.size();
+        T                 best_cost = std::numeric_limits<T>::max();
+        std::size_t       best_axis = 0;
+        std::size_t       best_bin  = 0;
+        for (std::size_t axis = 0; axis < 3; ++axis) {
+            bvh_bin<T> const* b = bins.data() + axis * config::bvh_bins;
+            // Cost of the bins to the right of a boundary
+            T          right_cost[config::bvh_bins];
+            auto acc = bvh_bin<T>::empty();
+            for (std::size_t i = bin_count - 1; i > 0; --i) {
+                acc.merge(b[i]);
+                right_cost[i - 1] = acc.half_area() * acc.count;
+            }
+            acc.reset();
+            for (std::size_t i = 0; i + 1 < bin_count; ++i) {
+                acc.merge(b[i]);
+                if (acc.count == 0 || acc.count == count)
+                    continue;
+                T const cost = acc.half_area() * acc.count + right_cost[i];
+                if (cost < best_cost) {
+                    best_cost = cost;
+                    best_axis = axis;
+                    best_bin  = i;
+                }
+            }
+        }
+        // The costs of a node traversal and of a primitive test are taken equal
+        T const area = half_area(r.bounds);
+        if (small && area * count <= area + best_cost)
+            return false;
+        if (best_cost == std::numeric_limits<T>::max()) {
+            median_split(r, left, right);
+            return true;
+        }
+
+        auto lhs = bvh_bin<T>::empty();
+        auto rhs = bvh_bin<T>::empty();
+        for (std::size_t i = 0; i < bin_count; ++i) {
+            (i <= best_bin ? lhs : rhs).merge(bins[best_axis * config::bvh_bins + i]);
+        }
+        auto              left_centroids  = bvh_bin<T>::empty();
+        auto              right_centroids = bvh_bin<T>::empty();
+        std::size_t const split           = partition(
+            r,
+            [&binning, best_axis, best_bin](auto const& p) {
+                return binning(p.centroid, best_axis) <= best_bin;
+            },
+            left_centroids, right_centroids);
+        left  = range{r.begin, split, r.depth + 1, lhs.bounds(), left_centroids.bounds()};
+        right = range{split, r.end, r.depth + 1, rhs.bounds(), right_centroids.bounds()};
+        return true;
+    }
+
+    /**
+     * Build the subtree of a range depth first. The root of the subtree is
+     * nodes[root], the other nodes are appended to nodes, the children of a
+     * node are always adjacent.
+     *
+     * If tasks is not null, ranges not bigger than task_size are not split
+     * and are added to the tasks to be built later.
+     */
+    void
+    build(range const& root_range, std::uint32_t root, std::vector<node_type>& nodes,
+          std::size_t threads = 1, std::size_t task_size = 0,
+          std::vector<task>* tasks = nullptr) const
+    {
+        std::vector<task> stack{task{root_range, root}};
+        while (!stack.empty()) {
+            auto const [r, node] = stack.back();
+            stack.pop_back();
+            if (tasks && r.size() <= task_size) {
+                tasks->emplace_back(r, node);
+                continue;
+            }
+            range left, right;
+            if (!split(r, threads, left, right)) {
+                set_node(nodes[node], r.bounds, r.begin, r.size());
+                continue;
+            }
+            auto const first = static_cast<std::uint32_t>(nodes.size());
+            nodes.resize(nodes.size() + 2);
+            set_node(nodes[node], r.bounds, first, 0);
+            stack.emplace_back(right, first + 1);
+            stack.emplace_back(left, first);
+        }
+    }
+};
+
+}    // namespace detail
+
+/**
+ * Binary bounding volume hierarchy over primitives given by their bounding
+ * boxes, built by the binned surface area heuristic.
+ *
+ * The nodes are stored depth first, a child always follows its parent and
+ * the siblings are adjacent. The primitives are referenced by their indices
+ * in the input array, the primitives of a leaf are a contiguous range of
+ * indices().
+ *
+ * The structure doesn't change on refit, so the hierarchy stays valid for
+ * animated geometry while the quality degrades with big movements.
+ */
+template <typename T>
+struct bvh {
+    static_assert(std::is_floating_point_v<T>, "Hierarchy values must be floating point");
+
+    using value_type = T;
+    using box_type   = aabb<T, 3>;
+    using node_type  = bvh_node<T>;
+    using size_type  = std::size_t;
+
+    bvh() = default;
+    /**
+     * Build a hierarchy. The top of the tree is built with the binning split
+     * between the threads, then the subtrees are built in parallel.
+     * @param boxes bounds of the primitives, must not be empty
+     * @param threads maximum number of threads, 0 means the hardware concurrency
+     * @throws std::runtime_error if count doesn't fit 32 bits
+     */
+    bvh(box_type const* boxes, size_type count, size_type threads = 1)
+    {
+        build(boxes, count, threads);
+    }
+
+    bool
+    empty() const
+    {
+        return nodes_.empty();
+    }
+
+    size_type
+    primitive_count() const
+    {
+        return indices_.size();
+    }
+
+    std::vector<node_type> const&
+    nodes() const
+    {
+        return nodes_;
+    }
+
+    std::vector<std::uint32_t> const&
+    indices() const
+    {
+        return indices_;
+    }
+
+    box_type
+    bounds() const
+    {
+        return empty() ? box_type{} : nodes_.front().bounds();
+    }
+
+    /**
+     * Update the bounds of the nodes after the primitives moved
+     * @param boxes new bounds of the primitives, the same number of boxes as
+     *              the hierarchy was built for
+     * @param threads maximum number of threads, 0 means the hardware concurrency
+     */
+    void
+    refit(box_type const* boxes, size_type threads = 1)
+    {
+        detail::parallel_for(nodes_.size(), config::parallel_min_items, threads,
+                             [this, boxes](std::size_t begin, std::size_t end) {
+                                 for (std::size_t i = begin; i < end; ++i) {
+                                     auto& n = nodes_[i];
+                                     if (!n.leaf())
+                                         continue;
+                                     box_type box;
+                                     for (auto k = n.first; k < n.first + n.count; ++k) {
+                                         box.expand(boxes[indices_[k]]);
+                                     }
+                                     detail::set_node(n, box, n.first, n.count);
+                                 }
+                             });
+        // The children follow the parents
+        for (std::size_t i = nodes_.size(); i-- > 0;) {
+            auto& n = nodes_[i];
+            if (!n.leaf()) {
+                detail::set_node(n, merge(nodes_[n.first].bounds(), nodes_[n.first + 1].bounds()),
+                                 n.first, 0);
+            }
+        }
+    }
+
+    /**
+     * Call fn(primitive) for all the primitives of the leaves overlapping a
+     * box. The primitives are candidates, the caller tests them.
+     */
+    template <typename Function>
+    void
+    query(box_type const& box, Function&& fn) const
+    {
+        if (empty())
+            return;
+        std::uint32_t stack[detail::bvh_max_depth + 1];
+        std::size_t   top = 0;
+        stack[top++]      = 0;
+        while (top > 0) {
+            node_type const& n = nodes_[stack[--top]];
+            if (!detail::overlaps(n.min, n.max, box))
+                continue;
+            if (n.leaf()) {
+                for (auto k = n.first; k < n.first + n.count; ++k) {
+                    fn(indices_[k]);
+                }
+            } else {
+                stack[top++] = n.first + 1;
+                stack[top++] = n.first;
+            }
+        }
+    }
+
+    /**
+     * Closest hit traversal, the nearer child is visited first. fn(primitive,
+     * t) tests a primitive and returns true if it is hit closer than t, t is
+     * updated with the distance of the hit.
+     * @param t maximal distance on input, distance of the closest hit on output
+     * @return true if a primitive is hit
+     */
+    template <typename Components, typename Function>
+    bool
+    intersect(ray<T, Components> const& r, T& t, Function&& fn) const
+    {
+        T t_near;
+        if (empty() || !detail::slab_test(r, nodes_[0].min, nodes_[0].max, t, t_near))
+            return false;
+        std::uint32_t stack[detail::bvh_max_depth];
+        T             stack_t[detail::bvh_max_depth];
+        std::size_t   top  = 0;
+        std::uint32_t node = 0;
+        bool          hit  = false;
+        while (true) {
+            node_type const& n = nodes_[node];
+            if (n.leaf()) {
+                for (auto k = n.first; k < n.first + n.count; ++k) {
+                    hit = fn(indices_[k], t) || hit;
+                }
+            } else {
+                auto const& ln = nodes_[n.first];
+                auto const& rn = nodes_[n.first + 1];
+                T           t_left, t_right;
+                bool const  left  = detail::slab_test(r, ln.min, ln.max, t, t_left);
+                bool const  right = detail::slab_test(r, rn.min, rn.max, t, t_right);
+                if (left && right) {
+                    bool const left_first = t_left <= t_right;
+                    stack[top]            = left_first ? n.first + 1 : n.first;
+                    stack_t[top]          = left_first ? t_right : t_left;
+                    ++top;
+                    node = left_first ? n.first : n.first + 1;
+                    continue;
+                }
+                if (left || right) {
+                    node = left ? n.first : n.first + 1;
+                    continue;
+                }
+            }
+            // Nodes entered farther than the closest hit are skipped
+            while (top > 0 && stack_t[top - 1] > t) {
+                --top;
+            }
+            if (top == 0)
+                break;
+            node = stack[--top];
+        }
+        return hit;
+    }
+
+private:
+    void
+    build(box_type const* boxes, size_type count, size_type threads)
+    {
+        using builder_type = detail::bvh_builder<T>;
+        using range        = typename builder_type::range;
+
+        if (count == 0)
+            return;
+        if (count > std::numeric_limits<std::uint32_t>::max())
+            throw std::runtime_error{"Too many primitives for a bounding volume hierarchy"};
+        if (threads == 0)
+            threads = detail::default_thread_count();
+
+        std::vector<detail::bvh_primitive<T>> prims(count);
+        range                                 root{0, count, 0, {}, {}};
+        std::mutex                            mutex;
+        detail::parallel_for(count, config::parallel_min_items, threads,
+                             [&](std::size_t begin, std::size_t end) {
+                                 for (std::size_t i = begin; i < end; ++i) {
+                                     prims[i] = {boxes[i], static_cast<std::uint32_t>(i)};
+                                 }
+                                 range const part = builder_type{prims.data()}.make_range(
+                                     begin, end, 0);
+                                 std::lock_guard<std::mutex> lock{mutex};
+                                 root.bounds.expand(part.bounds);
+                                 root.centroid_bounds.expand(part.centroid_bounds);
+                             });
+        builder_type const builder{prims.data()};
+        nodes_.resize(1);
+        if (threads == 1 || count < 2 * config::parallel_min_items) {
+            builder.build(root, 0, nodes_);
+        } else {
+            build_parallel(builder, root, threads);
+        }
+
+        indices_.resize(count);
+        detail::parallel_for(count, config::parallel_min_items, threads,
+                             [this, &prims](std::size_t begin, std::size_t end) {
+                                 for (std::size_t i = begin; i < end; ++i) {
+                                     indices_[i] = prims[i].index;
+                                 }
+                             });
+    }
+
+    /**
+     * The top of the tree is split with parallel binning until there are
+     * enough subtrees for the load balance, then the subtrees are built by
+     * the threads into separate arrays and appended to the nodes.
+     */
+    void
+    build_parallel(detail::bvh_builder<T> const& builder, detail::bvh_range<T> const& root,
+                   size_type threads)
+    {
+        using task = typename detail::bvh_builder<T>::task;
+
+        size_type const   count     = root.size();
+        std::size_t const task_size = std::max(config::parallel_min_items, count / (threads * 8));
+        std::vector<task> tasks;
+        builder.build(root, 0, nodes_, threads, task_size, &tasks);
+        std::sort(tasks.begin(), tasks.end(), [](task const& a, task const& b) {
+            return a.first.size() > b.first.size();
+        });
+
+        std::vector<std::vector<node_type>> subtrees(tasks.size());
+        std::atomic<std::size_t>            next{0};
+        detail::parallel_for(threads, 1, threads, [&](std::size_t, std::size_t) {
+            for (std::size_t i = next++; i < tasks.size(); i = next++) {
+                subtrees[i].resize(1);
+                builder.build(tasks[i].first, 0, subtrees[i]);
+            }
+        });
+
+        // A subtree root replaces the task node, the other nodes are appended
+        std::size_t total = nodes_.size();
+        for (auto const& s : subtrees) {
+            total += s.size() - 1;
+        }
+        nodes_.reserve(total);
+        for (std::size_t i = 0; i < tasks.size(); ++i) {
+            auto const offset = static_cast<std::uint32_t>(nodes_.size() - 1);
+            auto       fix    = [offset](node_type const& n) {
+                node_type res = n;
+                if (!res.leaf())
+                    res.first += offset;
+                return res;
+            };
+            nodes_[tasks[i].second] = fix(subtrees[i][0]);
+            for (std::size_t k = 1; k < subtrees[i].size(); ++k) {
+                nodes_.push_back(fix(subtrees[i][k]));
+            }
+        }
+    }
+
+    std::vector<node_type>     nodes_;
+    std::vector<std::uint32_t> indices_;
+};
+
+/**
+ * Wide bounding volume hierarchy, a binary hierarchy collapsed to nodes of
+ * Width children. The child with the biggest surface is opened until a node
+ * is full, so a node replaces up to log2(Width) levels of the binary tree.
+ */
+template <typename T, std::size_t Width>
+struct wide_bvh {
+    using value_type = T;
+    using box_type   = aabb<T, 3>;
+    using node_type  = wide_bvh_node<T, Width>;
+    using size_type  = std::size_t;
+
+    static constexpr std::size_t width = Width;
+
+    wide_bvh() = default;
+    explicit wide_bvh(bvh<T> const& tree) : indices_{tree.indices()}
+    {
+        collapse(tree.nodes());
+    }
+    /**
+     * Build a binary hierarchy and collapse it
+     * @param threads maximum number of threads, 0 means the hardware concurrency
+     */
+    wide_bvh(box_type const* boxes, size_type count, size_type threads = 1)
+        : wide_bvh(bvh<T>{boxes, count, threads})
+    {}
+
+    bool
+    empty() const
+    {
+        return nodes_.empty();
+    }
+
+    size_type
+    primitive_count() const
+    {
+        return indices_.size();
+    }
+
+    std::vector<node_type> const&
+    nodes() const
+    {
+        return nodes_;
+    }
+
+    std::vector<std::uint32_t> const&
+    indices() const
+    {
+        return indices_;
+    }
+
+    box_type
+    bounds() const
+    {
+        return empty() ? box_type{} : nodes_.front().bounds();
+    }
+
+    /**
+     * Update the bounds of the nodes after the primitives moved
+     * @param boxes new bounds of the primitives, the same number of boxes as
+     *              the hierarchy was built for
+     * @param threads maximum number of threads, 0 means the hardware concurrency
+     */
+    void
+    refit(box_type const* boxes, size_type threads = 1)
+    {
+        detail::parallel_for(nodes_.size(), config::parallel_min_items / Width, threads,
+                             [this, boxes](std::size_t begin, std::size_t end) {
+                                 for (std::size_t i = begin; i < end; ++i) {
+                                     auto& n = nodes_[i];
+                                     for (std::size_t j = 0; j < Width; ++j) {
+                                         if (n.count[j] == 0)
+                                             continue;
+                                         box_type box;
+                                         auto const first = n.child[j];
+                                         for (auto k = first; k < first + n.count[j]; ++k) {
+                                             box.expand(boxes[indices_[k]]);
+                                         }
+                                         n.set_bounds(j, box);
+                                     }
+                                 }
+                             });
+        // The children follow the parents
+        for (std::size_t i = nodes_.size(); i-- > 0;) {
+            auto& n = nodes_[i];
+            for (std::size_t j = 0; j < Width; ++j) {
+                if (n.count[j] == 0 && n.child[j] != node_type::empty)
+                    n.set_bounds(j, nodes_[n.child[j]].bounds());
+            }
+        }
+    }
+
+    /**
+     * Call fn(primitive) for all the primitives of the leaves overlapping a
+     * box. The primitives are candidates, the caller tests them.
+     */
+    template <typename Function>
+    void
+    query(box_type const& box, Function&& fn) const
+    {
+        if (empty())
+            return;
+        std::uint32_t stack[(Width - 1) * detail::bvh_max_depth + 1];
+        std::size_t   top = 0;
+        stack[top++]      = 0;
+        while (top > 0) {
+            node_type const& n = nodes_[stack[--top]];
+            for (std::size_t j = 0; j < Width; ++j) {
+                T const min[3] = {n.min[0][j], n.min[1][j], n.min[2][j]};
+                T const max[3] = {n.max[0][j], n.max[1][j], n.max[2][j]};
+                if (n.child[j] == node_type::empty || !detail::overlaps(min, max, box))
+                    continue;
+                if (n.count[j] == 0) {
+                    stack[top++] = n.child[j];
+                    continue;
+                }
+                for (auto k = n.child[j]; k < n.child[j] + n.count[j]; ++k) {
+                    fn(indices_[k]);
+                }
+            }
+        }
+    }
+
+    /**
+     * Closest hit traversal, the children of a node are tested against the
+     * ray in a single loop and visited from the nearest one. fn(primitive, t)
+     * tests a primitive and returns true if it is hit closer than t, t is
+     * updated with the distance of the hit.
+     * @param t maximal distance on input, distance of the closest hit on output
+     * @return true if a primitive is hit
+     */
+    template <typename Components, typename Function>
+    bool
+    intersect(ray<T, Components> const& r, T& t, Function&& fn) const
+    {
+        if (empty())
+            return false;
+        T const ox = r.origin()[0], oy = r.origin()[1], oz = r.origin()[2];
+        T const ix = r.inv_direction()[0], iy = r.inv_direction()[1], iz = r.inv_direction()[2];
+
+        std::uint32_t stack[(Width - 1) * detail::bvh_max_depth + 1];
+        T             stack_t[(Width - 1) * detail::bvh_max_depth + 1];
+        std::size_t   top  = 0;
+        std::uint32_t node = 0;
+        bool          hit  = false;
+        while (true) {
+            node_type const& n = nodes_[node];
+            T                t_enter[Width];
+            std::int32_t     hits[Width];
+            for (std::size_t j = 0; j < Width; ++j) {
+                T const x0 = (n.min[0][j] - ox) * ix, x1 = (n.max[0][j] - ox) * ix;
+                T const y0 = (n.min[1][j] - oy) * iy, y1 = (n.max[1][j] - oy) * iy;
+                T const z0 = (n.min[2][j] - oz) * iz, z1 = (n.max[2][j] - oz) * iz;
+                T       lo = 0;
+                T       hi = t;
+                T const nx = x0 < x1 ? x0 : x1, fx = x0 < x1 ? x1 : x0;
+                T const ny = y0 < y1 ? y0 : y1, fy = y0 < y1 ? y1 : y0;
+                T const nz = z0 < z1 ? z0 : z1, fz = z0 < z1 ? z1 : z0;
+                lo         = nx > lo ? nx : lo;
+                lo         = ny > lo ? ny : lo;
+                lo         = nz > lo ? nz : lo;
+                hi         = fx < hi ? fx : hi;
+                hi         = fy < hi ? fy : hi;
+                hi         = fz < hi ? fz : hi;
+                t_enter[j] = lo;
+                // The slab test doesn't reject the inverted box of an unused slot
+                hits[j] = (lo <= hi) & (n.child[j] != node_type::empty);
+            }
+
+            // Child nodes hit, sorted by the entry distance
+            std::uint32_t next[Width];
+            T             next_t[Width];
+            std::size_t   next_count = 0;
+            for (std::size_t j = 0; j < Width; ++j) {
+                if (!hits[j])
+                    continue;
+                if (n.count[j] != 0) {
+                    for (auto k = n.child[j]; k < n.child[j] + n.count[j]; ++k) {
+                        hit = fn(indices_[k], t) || hit;
+                    }
+                    continue;
+                }
+                std::size_t pos = next_count++;
+                for (; pos > 0 && next_t[pos - 1] > t_enter[j]; --pos) {
+                    next[pos]   = next[pos - 1];
+                    next_t[pos] = next_t[pos - 1];
+                }
+                next[pos]   = n.child[j];
+                next_t[pos] = t_enter[j];
+            }
+            if (next_count > 0) {
+                for (std::size_t j = next_count - 1; j > 0; --j) {
+                    stack[top]   = next[j];
+                    stack_t[top] = next_t[j];
+                    ++top;
+                }
+                if (next_t[0] <= t) {
+                    node = next[0];
+                    continue;
+                }
+            }
+            // Nodes entered farther than the closest hit are skipped
+            while (top > 0 && stack_t[top - 1] > t) {
+                --top;
+            }
+            if (top == 0)
+                break;
+            node = stack[--top];
+        }
+        return hit;
+    }
+
+private:
+    void
+    collapse(std::vector<bvh_node<T>> const& src)
+    {
+        if (src.empty())
+            return;
+        nodes_.emplace_back();
+        // Pairs of a binary node and the wide node replacing it
+        std::vector<std::pair<std::uint32_t, std::uint32_t>> stack{{0, 0}};
+        while (!stack.empty()) {
+            auto const [from, to] = stack.back();
+            stack.pop_back();
+            std::uint32_t slots[Width];
+            std::size_t   n = 0;
+            if (src[from].leaf()) {
+                // Only a root can be a leaf
+                slots[n++] = from;
+            } else {
+                slots[n++] = src[from].first;
+                slots[n++] = src[from].first + 1;
+            }
+            while (n < Width) {
+                std::size_t best      = Width;
+                T           best_area = -1;
+                for (std::size_t j = 0; j < n; ++j) {
+                    auto const& s = src[slots[j]];
+                    if (!s.leaf() && detail::half_area(s.bounds()) > best_area) {
+                        best      = j;
+                        best_area = detail::half_area(s.bounds());
+                    }
+                }
+                if (best == Width)
+                    break;
+                auto const first = src[slots[best]].first;
+                slots[best]      = first;
+                slots[n++]       = first + 1;
+            }
+
+            for (std::size_t j = 0; j < Width; ++j) {
+                if (j >= n) {
+                    nodes_[to].set_bounds(j, box_type{});
+                    nodes_[to].child[j] = node_type::empty;
+                    nodes_[to].count[j] = 0;
+                    continue;
+                }
+                auto const& s = src[slots[j]];
+                nodes_[to].set_bounds(j, s.bounds());
+                if (s.leaf()) {
+                    nodes_[to].child[j] = s.first;
+                    nodes_[to].count[j] = s.count;
+                } else {
+                    auto const id = static_cast<std::uint32_t>(nodes_.size());
+                    nodes_.emplace_back();
+                    nodes_[to].child[j] = id;
+                    nodes_[to].count[j] = 0;
+                    stack.emplace_back(slots[j], id);
+                }
+            }
+        }
+    }
+
+    std::vector<node_type>     nodes_;
+    std::vector<std::uint32_t> indices_;
+};
+
+template <typename T>
+using bvh4 = wide_bvh<T, 4>;
+template <typename T>
+using bvh8 = wide_bvh<T, 8>;
+
+//@{
+/** @name Triangle meshes */
+namespace detail {
+
+template <typename U, typename Components, component_order Order>
+vector<std::remove_const_t<U>, 3>
+mesh_vertex(memory_vector_view<U*, 3, Components, Order> const& vertices, std::size_t i)
+{
+    auto const v = vertices[i];
+    return {v[0], v[1], v[2]};
+}
+
+template <typename Tree, typename U, typename Components, component_order Order>
+bool
+intersect_triangles(Tree const& tree, memory_vector_view<U*, 3, Components, Order> const& vertices,
+                    ray<typename Tree::value_type> const& r,
+                    triangle_hit<typename Tree::value_type>& hit, std::size_t& triangle)
+{
+    // The traversal distance is the distance of the hit, so that a triangle
+    // test narrows the traversal
+    return tree.intersect(r, hit.t, [&](std::uint32_t i, auto&) {
+        if (!math::intersect(r, mesh_vertex(vertices, i * 3), mesh_vertex(vertices, i * 3 + 1),
+                             mesh_vertex(vertices, i * 3 + 2), hit))
+            return false;
+        triangle = i;
+        return true;
+    });
+}
+
+}    // namespace detail
+
+/**
+ * Bounds of the triangles of a mesh, a triangle is a triplet of consecutive
+ * vertices
+ * @param threads maximum number of threads, 0 means the hardware concurrency
+ * @throws std::runtime_error if the number of vertices is not a multiple of 3
+ */
+template <typename U, typename Components, component_order Order>
+std::vector<aabb<std::remove_const_t<U>, 3>>
+triangle_bounds(memory_vector_view<U*, 3, Components, Order> const& vertices,
+                std::size_t                                         threads = 1)
+{
+    using box_type = aabb<std::remove_const_t<U>, 3>;
+    if (vertices.size() % 3 != 0)
+        throw std::runtime_error{"The number of vertices is not a multiple of 3"};
+    std::vector<box_type> res(vertices.size() / 3);
+    detail::parallel_for(res.size(), config::parallel_min_items, threads,
+                         [&res, &vertices](std::size_t begin, std::size_t end) {
+                             for (std::size_t i = begin; i < end; ++i) {
+                                 box_type box{detail::mesh_vertex(vertices, i * 3)};
+                                 box.expand(detail::mesh_vertex(vertices, i * 3 + 1));
+                                 box.expand(detail::mesh_vertex(vertices, i * 3 + 2));
+                                 res[i] = box;
+                             }
+                         });
+    return res;
+}
+
+/**
+ * Hierarchy of the triangles of a mesh, a triangle is a triplet of
+ * consecutive vertices
+ * @param threads maximum number of threads, 0 means the hardware concurrency
+ */
+template <typename U, typename Components, component_order Order>
+bvh<std::remove_const_t<U>>
+make_bvh(memory_vector_view<U*, 3, Components, Order> const& vertices, std::size_t threads = 1)
+{
+    auto const boxes = triangle_bounds(vertices, threads);
+    return {boxes.data(), boxes.size(), threads};
+}
+
+/**
+ * Update a hierarchy of triangles after the vertices moved
+ * @throws std::runtime_error if the number of triangles differs from the
+ *         hierarchy
+ */
+template <typename Tree, typename U, typename Components, component_order Order>
+void
+refit(Tree& tree, memory_vector_view<U*, 3, Components, Order> const& vertices,
+      std::size_t threads = 1)
+{
+    auto const boxes = triangle_bounds(vertices, threads);
+    if (boxes.size() != tree.primitive_count())
+        throw std::runtime_error{"The number of triangles doesn't match the hierarchy"};
+    tree.refit(boxes.data(), threads);
+}
+
+/**
+ * The nearest triangle of a mesh hit by a ray
+ * @param hit the hit, the distance is the maximal distance on input
+ * @param triangle index of the triangle hit, written only if a triangle is hit
+ * @return true if a triangle is hit closer than hit.t
+ */
+template <typename T, typename U, typename Components, component_order Order>
+bool
+intersect(bvh<T> const& tree, memory_vector_view<U*, 3, Components, Order> const& vertices,
+          ray<T> const& r, triangle_hit<T>& hit, std::size_t& triangle)
+{
+    return detail::intersect_triangles(tree, vertices, r, hit, triangle);
+}
+
+template <typename T, std::size_t Width, typename U, typename Components, component_order Order>
+bool
+intersect(wide_bvh<T, Width> const& tree,
+          memory_vector_view<U*, 3, Components, Order> const& vertices, ray<T> const& r,
+          triangle_hit<T>& hit, std::size_t& triangle)
+{
+    return detail::intersect_triangles(tree, vertices, r, hit, triangle);
+}
+//@}
+
+}    // namespace math
+}    // namespace psst
+
+#endif /* PSST_MATH_BVH_HPP_ */
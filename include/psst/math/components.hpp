@@ -46,7 +46,10 @@ struct xyw {
     static constexpr std::size_t w              = 2;
 };
 
-struct wxyz;    // Quaternion
+struct wxyz;         // Quaternion
+struct dual_wxyz;    // Dual quaternion
+struct axis_angle;
+struct euler;
 
 struct polar;
 struct spherical;
@@ -14,6 +14,73 @@
 namespace psst::math::config {
 
 constexpr std::size_t const template_unwrap_threshold = 1024;
+/**
+ * Minimal number of items processed by a thread in parallel algorithms.
+ * Smaller ranges are processed by the calling thread, as starting a thread
+ * costs more than processing them.
+ */
+constexpr std::size_t const parallel_min_items = 1 << 14;
+/**
+ * Number of bins per axis of the binned SAH bounding volume hierarchy
+ * builder. More bins give better splits at the cost of the build time.
+ */
+constexpr std::size_t const bvh_bins = 16;
+/**
+ * Maximal number of primitives in a leaf of a bounding volume hierarchy
+ */
+constexpr std::size_t const bvh_max_leaf_size = 4;
+/**
+ * Maximal number of points in a leaf of a k-d tree
+ */
+constexpr std::size_t const kd_tree_max_leaf_size = 8;
+/**
+ * Alignment of the heap memory of dynamic vectors and matrices, the size of
+ * a cache line
+ */
+constexpr std::size_t const dynamic_alignment = 64;
+/**
+ * Size of the buffer inside of a dynamic vector or matrix. The values that
+ * fit into the buffer, e.g. a 4x4 matrix of floats, are not allocated.
+ */
+constexpr std::size_t const dynamic_inline_bytes = 64;
+/**
+ * Number of rows and columns of the blocks of the blocked dynamic matrix
+ * kernels. A block of floats takes 16KB and stays in the L1 cache.
+ */
+constexpr std::size_t const dynamic_block_size = 64;
+/**
+ * Minimal number of rows and columns of the matrices multiplied by the
+ * packed matrix product kernel, see detail/gemm_kernel.hpp. The fixed size
+ * products of matrices this large are evaluated when the expression is
+ * built.
+ */
+constexpr std::size_t const gemm_min_size = 32;
+/**
+ * Number of rows of the left hand block of the packed matrix product kernel
+ * multiplied by a thread, the block stays in the L2 cache
+ */
+constexpr std::size_t const gemm_block_rows = 96;
+/**
+ * Length of the inner dimension of the blocks of the packed matrix product
+ * kernel, the slivers of the blocks stay in the L1 cache
+ */
+constexpr std::size_t const gemm_block_inner = 256;
+/**
+ * Number of columns of the right hand panel of the packed matrix product
+ * kernel, the panel is shared by the threads and stays in the L3 cache
+ */
+constexpr std::size_t const gemm_block_cols = 1024;
+/**
+ * Minimal number of multiply-adds computed by a thread of the packed matrix
+ * product kernel. A thread gets a few milliseconds of work, a lot more than
+ * it costs to start it.
+ */
+constexpr std::size_t const gemm_parallel_min_work = 1 << 24;
+/**
+ * Number of matrices in a packet of the batched small matrix operations, see
+ * matrix_batch.hpp. 8 floats fill an AVX register.
+ */
+constexpr std::size_t const batch_lanes = 8;
 
 }    // namespace psst::math::config
 
@@ -19,12 +19,25 @@ inline namespace v {
 template <typename Source, typename Target, typename Expression = Source>
 struct conversion;
 
+//@{
+/** @name conversion_source */
+template <typename Expression, typename = utils::void_t<>>
+struct conversion_source {
+    using type = traits::vector_expression_result_t<std::decay_t<Expression>>;
+};
+template <typename Expression>
+struct conversion_source<Expression, traits::enable_if_matrix_expression<Expression>> {
+    using type = typename std::decay_t<Expression>::result_type;
+};
+template <typename Expression>
+using conversion_source_t = typename conversion_source<Expression>::type;
+//@}
+
 //@{
 /** @name conversion_exists */
 template <typename Source, typename Target>
 struct conversion_exists
-    : utils::is_decl_complete_t<
-          conversion<traits::vector_expression_result_t<std::decay_t<Source>>, Target>> {};
+    : utils::is_decl_complete_t<conversion<conversion_source_t<Source>, Target>> {};
 template <typename Source, typename Target>
 using conversion_exists_t = typename conversion_exists<Source, Target>::type;
 template <typename Source, typename Target>
@@ -76,6 +89,40 @@ struct conversion<vector<RHS, RSize, components::none>, vector<LHS, LSize, Compo
     }
 };
 
+//@{
+/**
+ * @name same_shape
+ * Vectors of the same components are converted by copying the components,
+ * matrices must have the same number of rows and columns as well.
+ */
+template <typename Source, typename Target, typename = utils::void_t<>>
+struct same_shape : std::true_type {};
+template <typename Source, typename Target>
+struct same_shape<Source, Target,
+                  std::enable_if_t<traits::is_matrix_expression_v<Source>
+                                   && traits::is_matrix_v<Target>>>
+    : std::integral_constant<bool, std::decay_t<Source>::rows == Target::rows
+                                       && std::decay_t<Source>::cols == Target::cols> {};
+template <typename Source, typename Target>
+constexpr bool same_shape_v = same_shape<Source, Target>::value;
+//@}
+
+// Conversion between matrices of the same shape and components is always
+// defined
+template <typename RHS, typename LHS, std::size_t Rows, std::size_t Cols, typename Components,
+          typename Expression>
+struct conversion<matrix<RHS, Rows, Cols, Components>, matrix<LHS, Rows, Cols, Components>,
+                  Expression> : unary_expression<Expression> {
+    using expression_base = unary_expression<Expression>;
+    using expression_base::expression_base;
+
+    constexpr auto
+    result() const
+    {
+        return this->arg_;
+    }
+};
+
 template <typename Source, typename Target>
 struct bind_conversion_args {
     template <typename Expression>
@@ -89,17 +136,21 @@ template <typename Target, typename Expression>
 constexpr auto
 convert(Expression&& expr)
 {
-    static_assert(traits::is_vector_expression_v<Expression>,
-                  "Source expression must be a vector expression");
-    static_assert(traits::is_vector_v<Target>, "Conversion target must be a vector type");
+    static_assert(traits::is_vector_expression_v<Expression>
+                      || traits::is_matrix_expression_v<Expression>,
+                  "Source expression must be a vector or a matrix expression");
+    static_assert(traits::is_vector_v<Target> || traits::is_matrix_v<Target>,
+                  "Conversion target must be a vector or a matrix type");
     static_assert((expr::conversion_exists_v<Expression, Target>),
                   "Conversion between theses components is not defined");
-    if constexpr (traits::same_components_v<Expression, Target>) {
+    if constexpr (traits::is_vector_expression_v<Expression> == traits::is_vector_v<Target>
+                  && traits::same_components_v<Expression, Target>
+                  && expr::same_shape_v<Expression, Target>) {
         return std::forward<Expression>(expr);
     } else {
-        using source_vector_type = traits::vector_expression_result_t<Expression>;
+        using source_type = expr::conversion_source_t<Expression>;
         return expr::make_unary_expression<
-                   expr::bind_conversion_args<source_vector_type, Target>::template type>(
+                   expr::bind_conversion_args<source_type, Target>::template type>(
                    std::forward<Expression>(expr))
             .result();
     }
@@ -0,0 +1,967 @@
+/**
+ * Copyright 2019 Sergei A. Fedorov
+ * dynamic_expressions.hpp
+ *
+ *  Created on: Mar 4, 2019
+ *      Author: ser-fedorov
+ */
+
+#ifndef PSST_MATH_DETAIL_DYNAMIC_EXPRESSIONS_HPP_
+#define PSST_MATH_DETAIL_DYNAMIC_EXPRESSIONS_HPP_
+
+#include <psst/math/detail/dynamic_kernels.hpp>
+#include <psst/math/detail/expressions.hpp>
+#include <psst/math/detail/gemm_kernel.hpp>
+#include <psst/math/detail/value_traits.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+namespace psst {
+namespace math {
+namespace expr {
+
+inline namespace d {
+
+//----------------------------------------------------------------------------
+/**
+ * Base of the expressions of vectors of a size known at run time. The
+ * expression defines size() and at(i) for the run time index.
+ *
+ * An expression is elementwise when its element i depends only on the
+ * elements i of the arguments, such an expression is evaluated directly into
+ * the memory of its argument. The products are evaluated into temporaries
+ * when they are arguments of other expressions, so that the product is not
+ * computed again for each element.
+ */
+template <typename Expression, typename T>
+struct dynamic_vector_expression {
+    using expression_type = Expression;
+    using result_type     = dynamic_vector<T>;
+    using value_type      = T;
+    using value_tag       = traits::tag::dynamic_vector;
+
+    static constexpr bool elementwise     = true;
+    static constexpr bool evaluate_nested = false;
+};
+
+/**
+ * Base of the expressions of matrices of a size known at run time. The
+ * expression defines rows(), cols() and element(r, c) for the run time
+ * indexes, the elements are stored by rows.
+ */
+template <typename Expression, typename T>
+struct dynamic_matrix_expression {
+    using expression_type = Expression;
+    using result_type     = dynamic_matrix<T>;
+    using value_type      = T;
+    using value_tag       = traits::tag::dynamic_matrix;
+
+    static constexpr bool elementwise     = true;
+    static constexpr bool evaluate_nested = false;
+};
+
+//----------------------------------------------------------------------------
+//@{
+/** @name Fixed size vectors and matrices in dynamic expressions */
+/**
+ * A fixed size vector expression evaluated to be used in dynamic expressions
+ */
+template <typename Vector>
+struct dynamic_vector_adapter
+    : dynamic_vector_expression<dynamic_vector_adapter<Vector>, typename Vector::value_type> {
+    static_assert(Vector::size != utils::npos_v,
+                  "An unbounded vector expression cannot be used in dynamic expressions");
+    using value_type = typename Vector::value_type;
+
+    template <typename Expression>
+    explicit dynamic_vector_adapter(Expression&& arg) : arg_(std::forward<Expression>(arg))
+    {}
+
+    constexpr std::size_t
+    size() const
+    {
+        return Vector::size;
+    }
+    value_type
+    at(std::size_t i) const
+    {
+        return arg_[i];
+    }
+
+private:
+    Vector arg_;
+};
+
+/**
+ * A fixed size matrix expression evaluated to be used in dynamic expressions
+ */
+template <typename Matrix>
+struct dynamic_matrix_adapter
+    : dynamic_matrix_expression<dynamic_matrix_adapter<Matrix>, typename Matrix::value_type> {
+    static_assert(Matrix::size != utils::npos_v,
+                  "An unbounded matrix expression cannot be used in dynamic expressions");
+    using value_type = typename Matrix::value_type;
+
+    template <typename Expression>
+    explicit dynamic_matrix_adapter(Expression&& arg) : arg_(std::forward<Expression>(arg))
+    {}
+
+    constexpr std::size_t
+    rows() const
+    {
+        return Matrix::rows;
+    }
+    constexpr std::size_t
+    cols() const
+    {
+        return Matrix::cols;
+    }
+    value_type
+    element(std::size_t r, std::size_t c) const
+    {
+        return arg_[r][c];
+    }
+
+private:
+    Matrix arg_;
+};
+//@}
+
+namespace detail {
+
+template <typename T>
+constexpr bool is_vector_operand_v
+    = traits::is_dynamic_vector_expression_v<T> || traits::is_vector_expression_v<T>;
+template <typename T>
+constexpr bool is_matrix_operand_v
+    = traits::is_dynamic_matrix_expression_v<T> || traits::is_matrix_expression_v<T>;
+
+template <typename T>
+constexpr bool is_dynamic_v
+    = traits::is_dynamic_vector_expression_v<T> || traits::is_dynamic_matrix_expression_v<T>;
+
+/**
+ * Operands of an elementwise operation of vectors or matrices, at least one
+ * of them has the size known at run time
+ */
+template <typename LHS, typename RHS>
+constexpr bool dynamic_operands_v
+    = (is_dynamic_v<LHS> || is_dynamic_v<RHS>)
+      && ((is_vector_operand_v<LHS> && is_vector_operand_v<RHS>)
+          || (is_matrix_operand_v<LHS> && is_matrix_operand_v<RHS>));
+template <typename LHS, typename RHS>
+using enable_if_dynamic_operands = std::enable_if_t<dynamic_operands_v<LHS, RHS>>;
+
+template <typename T>
+constexpr bool
+elementwise()
+{
+    if constexpr (is_dynamic_v<T>) {
+        return std::decay_t<T>::elementwise;
+    } else {
+        return true;
+    }
+}
+template <typename T>
+constexpr bool elementwise_v = elementwise<T>();
+
+template <typename T, typename = utils::void_t<>>
+struct has_evaluate : std::false_type {};
+template <typename T>
+struct has_evaluate<T, utils::void_t<decltype(std::declval<T const&>().evaluate(
+                           std::declval<typename T::value_type*>()))>> : std::true_type {};
+
+/**
+ * A product adds its values to the memory or subtracts them by its kernel,
+ * without a temporary
+ */
+template <typename T, typename = utils::void_t<>>
+struct has_accumulate : std::false_type {};
+template <typename T>
+struct has_accumulate<T, utils::void_t<decltype(std::declval<T const&>().evaluate(
+                             std::declval<typename T::value_type*>(),
+                             math::detail::kernel_store::add))>> : std::true_type {};
+
+/**
+ * A dynamic expression as is, a fixed size vector or matrix expression
+ * evaluated to an adapter
+ */
+template <typename Expression>
+decltype(auto)
+dynamic_value(Expression&& expr)
+{
+    using expression_type = std::decay_t<Expression>;
+    if constexpr (traits::is_vector_expression_v<Expression>) {
+        return dynamic_vector_adapter<typename expression_type::result_type>{
+            std::forward<Expression>(expr)};
+    } else if constexpr (traits::is_matrix_expression_v<Expression>) {
+        return dynamic_matrix_adapter<typename expression_type::result_type>{
+            std::forward<Expression>(expr)};
+    } else {
+        return std::forward<Expression>(expr);
+    }
+}
+
+/**
+ * An argument of a dynamic expression. A product is evaluated to a
+ * temporary, other expressions are used as is.
+ */
+template <typename Expression>
+decltype(auto)
+dynamic_operand(Expression&& expr)
+{
+    if constexpr (is_dynamic_v<Expression>) {
+        using expression_type = std::decay_t<Expression>;
+        if constexpr (expression_type::evaluate_nested) {
+            return typename expression_type::result_type{expr};
+        } else {
+            return std::forward<Expression>(expr);
+        }
+    } else {
+        return dynamic_value(std::forward<Expression>(expr));
+    }
+}
+
+/**
+ * Write the values of a dynamic expression to memory, the values of a matrix
+ * by rows
+ */
+template <typename Expression, typename U>
+void
+evaluate(Expression const& expr, U* res)
+{
+    using value_type = typename Expression::value_type;
+    if constexpr (has_evaluate<Expression>::value && std::is_same<value_type, U>::value) {
+        expr.evaluate(res);
+    } else if constexpr (traits::is_dynamic_vector_expression_v<Expression>) {
+        std::size_t const size = expr.size();
+        for (std::size_t i = 0; i < size; ++i) {
+            res[i] = expr.at(i);
+        }
+    } else {
+        std::size_t const rows = expr.rows();
+        std::size_t const cols = expr.cols();
+        for (std::size_t r = 0; r < rows; ++r) {
+            for (std::size_t c = 0; c < cols; ++c) {
+                res[r * cols + c] = expr.element(r, c);
+            }
+        }
+    }
+}
+
+/**
+ * The values of an expression as a dynamic vector or matrix of U. A vector
+ * or a matrix of U is returned as is.
+ */
+template <typename U, typename Expression>
+decltype(auto)
+evaluated(Expression const& expr)
+{
+    using result_type = std::conditional_t<traits::is_dynamic_vector_expression_v<Expression>,
+                                           dynamic_vector<U>, dynamic_matrix<U>>;
+    if constexpr (std::is_same<Expression, result_type>::value) {
+        return (expr);
+    } else {
+        return result_type{expr};
+    }
+}
+
+template <typename LHS, typename RHS>
+void
+check_same_size(LHS const& lhs, RHS const& rhs)
+{
+    if constexpr (traits::is_dynamic_vector_expression_v<LHS>) {
+        if (lhs.size() != rhs.size())
+            throw std::runtime_error{"Dynamic vector sizes don't match"};
+    } else {
+        if (lhs.rows() != rhs.rows() || lhs.cols() != rhs.cols())
+            throw std::runtime_error{"Dynamic matrix sizes don't match"};
+    }
+}
+
+/**
+ * Make an elementwise expression of two dynamic operands of the same size
+ */
+template <template <typename, typename> class VectorExpression,
+          template <typename, typename> class MatrixExpression, typename LHS, typename RHS>
+auto
+make_elementwise_expression(LHS&& lhs, RHS&& rhs)
+{
+    check_same_size(lhs, rhs);
+    if constexpr (traits::is_dynamic_vector_expression_v<LHS>) {
+        return make_binary_expression<VectorExpression>(std::forward<LHS>(lhs),
+                                                        std::forward<RHS>(rhs));
+    } else {
+        return make_binary_expression<MatrixExpression>(std::forward<LHS>(lhs),
+                                                        std::forward<RHS>(rhs));
+    }
+}
+
+/**
+ * Make an expression of a dynamic operand and a scalar value
+ */
+template <template <typename, typename> class Expression, typename Arg, typename Scalar>
+auto
+make_scalar_expression(Arg&& arg, Scalar&& s)
+{
+    using expression_type = Expression<expression_parameter_t<Arg&&>, std::decay_t<Scalar>>;
+    return expression_type{static_cast<expression_argument_t<Arg&&>>(arg),
+                           static_cast<typename expression_type::value_type>(s)};
+}
+
+}    // namespace detail
+
+//----------------------------------------------------------------------------
+//@{
+/** @name Elementwise dynamic vector expressions */
+template <typename LHS, typename RHS>
+struct dynamic_vector_sum
+    : dynamic_vector_expression<dynamic_vector_sum<LHS, RHS>,
+                                traits::scalar_expression_result_t<LHS, RHS>>,
+      binary_expression<LHS, RHS> {
+    using base_type       = dynamic_vector_expression<dynamic_vector_sum<LHS, RHS>,
+                                                traits::scalar_expression_result_t<LHS, RHS>>;
+    using value_type      = typename base_type::value_type;
+    using expression_base = binary_expression<LHS, RHS>;
+    using expression_base::expression_base;
+
+    static constexpr bool elementwise = detail::elementwise_v<LHS> && detail::elementwise_v<RHS>;
+
+    std::size_t
+    size() const
+    {
+        return this->lhs_.size();
+    }
+    value_type
+    at(std::size_t i) const
+    {
+        return this->lhs_.at(i) + this->rhs_.at(i);
+    }
+};
+
+template <typename LHS, typename RHS>
+struct dynamic_vector_diff
+    : dynamic_vector_expression<dynamic_vector_diff<LHS, RHS>,
+                                traits::scalar_expression_result_t<LHS, RHS>>,
+      binary_expression<LHS, RHS> {
+    using base_type       = dynamic_vector_expression<dynamic_vector_diff<LHS, RHS>,
+                                                traits::scalar_expression_result_t<LHS, RHS>>;
+    using value_type      = typename base_type::value_type;
+    using expression_base = binary_expression<LHS, RHS>;
+    using expression_base::expression_base;
+
+    static constexpr bool elementwise = detail::elementwise_v<LHS> && detail::elementwise_v<RHS>;
+
+    std::size_t
+    size() const
+    {
+        return this->lhs_.size();
+    }
+    value_type
+    at(std::size_t i) const
+    {
+        return this->lhs_.at(i) - this->rhs_.at(i);
+    }
+};
+
+template <typename Expr>
+struct dynamic_vector_negate
+    : dynamic_vector_expression<dynamic_vector_negate<Expr>,
+                                typename std::decay_t<Expr>::value_type>,
+      unary_expression<Expr> {
+    using base_type       = dynamic_vector_expression<dynamic_vector_negate<Expr>,
+                                                typename std::decay_t<Expr>::value_type>;
+    using value_type      = typename base_type::value_type;
+    using expression_base = unary_expression<Expr>;
+    using expression_base::expression_base;
+
+    static constexpr bool elementwise = detail::elementwise_v<Expr>;
+
+    std::size_t
+    size() const
+    {
+        return this->arg_.size();
+    }
+    value_type
+    at(std::size_t i) const
+    {
+        return -this->arg_.at(i);
+    }
+};
+
+template <typename Expr, typename Scalar>
+struct dynamic_vector_scalar_multiply
+    : dynamic_vector_expression<dynamic_vector_scalar_multiply<Expr, Scalar>,
+                                traits::scalar_expression_result_t<Expr, Scalar>>,
+      unary_expression<Expr> {
+    using base_type       = dynamic_vector_expression<dynamic_vector_scalar_multiply<Expr, Scalar>,
+                                                traits::scalar_expression_result_t<Expr, Scalar>>;
+    using value_type      = typename base_type::value_type;
+    using expression_base = unary_expression<Expr>;
+    using arg_type        = typename expression_base::arg_type;
+
+    static constexpr bool elementwise = detail::elementwise_v<Expr>;
+
+    dynamic_vector_scalar_multiply(arg_type arg, value_type s)
+        : expression_base{std::forward<arg_type>(arg)}, scalar_{s}
+    {}
+
+    std::size_t
+    size() const
+    {
+        return this->arg_.size();
+    }
+    value_type
+    at(std::size_t i) const
+    {
+        return this->arg_.at(i) * scalar_;
+    }
+
+private:
+    value_type scalar_;
+};
+
+template <typename Expr, typename Scalar>
+struct dynamic_vector_scalar_divide
+    : dynamic_vector_expression<dynamic_vector_scalar_divide<Expr, Scalar>,
+                                traits::scalar_expression_result_t<Expr, Scalar>>,
+      unary_expression<Expr> {
+    using base_type       = dynamic_vector_expression<dynamic_vector_scalar_divide<Expr, Scalar>,
+                                                traits::scalar_expression_result_t<Expr, Scalar>>;
+    using value_type      = typename base_type::value_type;
+    using expression_base = unary_expression<Expr>;
+    using arg_type        = typename expression_base::arg_type;
+
+    static constexpr bool elementwise = detail::elementwise_v<Expr>;
+
+    dynamic_vector_scalar_divide(arg_type arg, value_type s)
+        : expression_base{std::forward<arg_type>(arg)}, scalar_{s}
+    {}
+
+    std::size_t
+    size() const
+    {
+        return this->arg_.size();
+    }
+    value_type
+    at(std::size_t i) const
+    {
+        return this->arg_.at(i) / scalar_;
+    }
+
+private:
+    value_type scalar_;
+};
+//@}
+
+//----------------------------------------------------------------------------
+//@{
+/** @name Elementwise dynamic matrix expressions */
+template <typename LHS, typename RHS>
+struct dynamic_matrix_sum
+    : dynamic_matrix_expression<dynamic_matrix_sum<LHS, RHS>,
+                                traits::scalar_expression_result_t<LHS, RHS>>,
+      binary_expression<LHS, RHS> {
+    using base_type       = dynamic_matrix_expression<dynamic_matrix_sum<LHS, RHS>,
+                                                traits::scalar_expression_result_t<LHS, RHS>>;
+    using value_type      = typename base_type::value_type;
+    using expression_base = binary_expression<LHS, RHS>;
+    using expression_base::expression_base;
+
+    static constexpr bool elementwise = detail::elementwise_v<LHS> && detail::elementwise_v<RHS>;
+
+    std::size_t
+    rows() const
+    {
+        return this->lhs_.rows();
+    }
+    std::size_t
+    cols() const
+    {
+        return this->lhs_.cols();
+    }
+    value_type
+    element(std::size_t r, std::size_t c) const
+    {
+        return this->lhs_.element(r, c) + this->rhs_.element(r, c);
+    }
+};
+
+template <typename LHS, typename RHS>
+struct dynamic_matrix_diff
+    : dynamic_matrix_expression<dynamic_matrix_diff<LHS, RHS>,
+                                traits::scalar_expression_result_t<LHS, RHS>>,
+      binary_expression<LHS, RHS> {
+    using base_type       = dynamic_matrix_expression<dynamic_matrix_diff<LHS, RHS>,
+                                                traits::scalar_expression_result_t<LHS, RHS>>;
+    using value_type      = typename base_type::value_type;
+    using expression_base = binary_expression<LHS, RHS>;
+    using expression_base::expression_base;
+
+    static constexpr bool elementwise = detail::elementwise_v<LHS> && detail::elementwise_v<RHS>;
+
+    std::size_t
+    rows() const
+    {
+        return this->lhs_.rows();
+    }
+    std::size_t
+    cols() const
+    {
+        return this->lhs_.cols();
+    }
+    value_type
+    element(std::size_t r, std::size_t c) const
+    {
+        return this->lhs_.element(r, c) - this->rhs_.element(r, c);
+    }
+};
+
+template <typename Expr>
+struct dynamic_matrix_negate
+    : dynamic_matrix_expression<dynamic_matrix_negate<Expr>,
+                                typename std::decay_t<Expr>::value_type>,
+      unary_expression<Expr> {
+    using base_type       = dynamic_matrix_expression<dynamic_matrix_negate<Expr>,
+                                                typename std::decay_t<Expr>::value_type>;
+    using value_type      = typename base_type::value_type;
+    using expression_base = unary_expression<Expr>;
+    using expression_base::expression_base;
+
+    static constexpr bool elementwise = detail::elementwise_v<Expr>;
+
+    std::size_t
+    rows() const
+    {
+        return this->arg_.rows();
+    }
+    std::size_t
+    cols() const
+    {
+        return this->arg_.cols();
+    }
+    value_type
+    element(std::size_t r, std::size_t c) const
+    {
+        return -this->arg_.element(r, c);
+    }
+};
+
+template <typename Expr, typename Scalar>
+struct dynamic_matrix_scalar_multiply
+    : dynamic_matrix_expression<dynamic_matrix_scalar_multiply<Expr, Scalar>,
+                                traits::scalar_expression_result_t<Expr, Scalar>>,
+      unary_expression<Expr> {
+    using base_type       = dynamic_matrix_expression<dynamic_matrix_scalar_multiply<Expr, Scalar>,
+                                                traits::scalar_expression_result_t<Expr, Scalar>>;
+    using value_type      = typename base_type::value_type;
+    using expression_base = unary_expression<Expr>;
+    using arg_type        = typename expression_base::arg_type;
+
+    static constexpr bool elementwise = detail::elementwise_v<Expr>;
+
+    dynamic_matrix_scalar_multiply(arg_type arg, value_type s)
+        : expression_base{std::forward<arg_type>(arg)}, scalar_{s}
+    {}
+
+    std::size_t
+    rows() const
+    {
+        return this->arg_.rows();
+    }
+    std::size_t
+    cols() const
+    {
+        return this->arg_.cols();
+    }
+    value_type
+    element(std::size_t r, std::size_t c) const
+    {
+        return this->arg_.element(r, c) * scalar_;
+    }
+
+private:
+    value_type scalar_;
+};
+
+template <typename Expr, typename Scalar>
+struct dynamic_matrix_scalar_divide
+    : dynamic_matrix_expression<dynamic_matrix_scalar_divide<Expr, Scalar>,
+                                traits::scalar_expression_result_t<Expr, Scalar>>,
+      unary_expression<Expr> {
+    using base_type       = dynamic_matrix_expression<dynamic_matrix_scalar_divide<Expr, Scalar>,
+                                                traits::scalar_expression_result_t<Expr, Scalar>>;
+    using value_type      = typename base_type::value_type;
+    using expression_base = unary_expression<Expr>;
+    using arg_type        = typename expression_base::arg_type;
+
+    static constexpr bool elementwise = detail::elementwise_v<Expr>;
+
+    dynamic_matrix_scalar_divide(arg_type arg, value_type s)
+        : expression_base{std::forward<arg_type>(arg)}, scalar_{s}
+    {}
+
+    std::size_t
+    rows() const
+    {
+        return this->arg_.rows();
+    }
+    std::size_t
+    cols() const
+    {
+        return this->arg_.cols();
+    }
+    value_type
+    element(std::size_t r, std::size_t c) const
+    {
+        return this->arg_.element(r, c) / scalar_;
+    }
+
+private:
+    value_type scalar_;
+};
+//@}
+
+//----------------------------------------------------------------------------
+//@{
+/** @name Dynamic matrix transposition */
+template <typename Expr>
+struct dynamic_matrix_transpose
+    : dynamic_matrix_expression<dynamic_matrix_transpose<Expr>,
+                                typename std::decay_t<Expr>::value_type>,
+      unary_expression<Expr> {
+    using base_type       = dynamic_matrix_expression<dynamic_matrix_transpose<Expr>,
+                                                typename std::decay_t<Expr>::value_type>;
+    using value_type      = typename base_type::value_type;
+    using expression_base = unary_expression<Expr>;
+    using expression_base::expression_base;
+
+    static constexpr bool elementwise = false;
+
+    std::size_t
+    rows() const
+    {
+        return this->arg_.cols();
+    }
+    std::size_t
+    cols() const
+    {
+        return this->arg_.rows();
+    }
+    value_type
+    element(std::size_t r, std::size_t c) const
+    {
+        return this->arg_.element(c, r);
+    }
+    void
+    evaluate(value_type* res) const
+    {
+        auto const& arg = detail::evaluated<value_type>(this->arg_);
+        math::detail::transpose_kernel(arg.data(), res, arg.rows(), arg.cols());
+    }
+};
+
+template <typename Expr, typename = traits::enable_if_dynamic_matrix_expression<Expr>>
+auto
+transpose(Expr&& expr)
+{
+    return make_unary_expression<dynamic_matrix_transpose>(
+        detail::dynamic_operand(std::forward<Expr>(expr)));
+}
+//@}
+
+//----------------------------------------------------------------------------
+//@{
+/** @name Dynamic matrix products */
+template <typename LHS, typename RHS>
+struct dynamic_matrix_multiply
+    : dynamic_matrix_expression<dynamic_matrix_multiply<LHS, RHS>,
+                                traits::scalar_expression_result_t<LHS, RHS>>,
+      binary_expression<LHS, RHS> {
+    using base_type       = dynamic_matrix_expression<dynamic_matrix_multiply<LHS, RHS>,
+                                                traits::scalar_expression_result_t<LHS, RHS>>;
+    using value_type      = typename base_type::value_type;
+    using expression_base = binary_expression<LHS, RHS>;
+    using expression_base::expression_base;
+
+    static constexpr bool elementwise     = false;
+    static constexpr bool evaluate_nested = true;
+
+    std::size_t
+    rows() const
+    {
+        return this->lhs_.rows();
+    }
+    std::size_t
+    cols() const
+    {
+        return this->rhs_.cols();
+    }
+    value_type
+    element(std::size_t r, std::size_t c) const
+    {
+        value_type        res{0};
+        std::size_t const inner = this->lhs_.cols();
+        for (std::size_t k = 0; k < inner; ++k) {
+            res += this->lhs_.element(r, k) * this->rhs_.element(k, c);
+        }
+        return res;
+    }
+    void
+    evaluate(value_type*                res,
+             math::detail::kernel_store mode = math::detail::kernel_store::assign) const
+    {
+        auto const& lhs = detail::evaluated<value_type>(this->lhs_);
+        auto const& rhs = detail::evaluated<value_type>(this->rhs_);
+        if (std::min({lhs.rows(), lhs.cols(), rhs.cols()}) >= config::gemm_min_size) {
+            math::detail::gemm_kernel(lhs.data(), rhs.data(), res, lhs.rows(), lhs.cols(),
+                                      rhs.cols(), mode);
+        } else {
+            math::detail::multiply_kernel(lhs.data(), rhs.data(), res, lhs.rows(), lhs.cols(),
+                                          rhs.cols(), mode);
+        }
+    }
+};
+
+template <typename LHS, typename RHS>
+struct dynamic_matrix_vector_multiply
+    : dynamic_vector_expression<dynamic_matrix_vector_multiply<LHS, RHS>,
+                                traits::scalar_expression_result_t<LHS, RHS>>,
+      binary_expression<LHS, RHS> {
+    using base_type       = dynamic_vector_expression<dynamic_matrix_vector_multiply<LHS, RHS>,
+                                                traits::scalar_expression_result_t<LHS, RHS>>;
+    using value_type      = typename base_type::value_type;
+    using expression_base = binary_expression<LHS, RHS>;
+    using expression_base::expression_base;
+
+    static constexpr bool elementwise     = false;
+    static constexpr bool evaluate_nested = true;
+
+    std::size_t
+    size() const
+    {
+        return this->lhs_.rows();
+    }
+    value_type
+    at(std::size_t i) const
+    {
+        value_type        res{0};
+        std::size_t const inner = this->lhs_.cols();
+        for (std::size_t k = 0; k < inner; ++k) {
+            res += this->lhs_.element(i, k) * this->rhs_.at(k);
+        }
+        return res;
+    }
+    void
+    evaluate(value_type*                res,
+             math::detail::kernel_store mode = math::detail::kernel_store::assign) const
+    {
+        auto const& lhs = detail::evaluated<value_type>(this->lhs_);
+        auto const& rhs = detail::evaluated<value_type>(this->rhs_);
+        math::detail::multiply_vector_kernel(lhs.data(), rhs.data(), res, lhs.rows(),
+                                             lhs.cols(), mode);
+    }
+};
+//@}
+
+//----------------------------------------------------------------------------
+//@{
+/** @name Operators */
+template <typename LHS, typename RHS, typename = detail::enable_if_dynamic_operands<LHS, RHS>>
+auto
+operator+(LHS&& lhs, RHS&& rhs)
+{
+    return detail::make_elementwise_expression<dynamic_vector_sum, dynamic_matrix_sum>(
+        detail::dynamic_operand(std::forward<LHS>(lhs)),
+        detail::dynamic_operand(std::forward<RHS>(rhs)));
+}
+
+template <typename LHS, typename RHS, typename = detail::enable_if_dynamic_operands<LHS, RHS>>
+auto
+operator-(LHS&& lhs, RHS&& rhs)
+{
+    return detail::make_elementwise_expression<dynamic_vector_diff, dynamic_matrix_diff>(
+        detail::dynamic_operand(std::forward<LHS>(lhs)),
+        detail::dynamic_operand(std::forward<RHS>(rhs)));
+}
+
+template <typename Expr, typename = std::enable_if_t<detail::is_dynamic_v<Expr>>>
+auto
+operator-(Expr&& expr)
+{
+    if constexpr (traits::is_dynamic_vector_expression_v<Expr>) {
+        return make_unary_expression<dynamic_vector_negate>(
+            detail::dynamic_operand(std::forward<Expr>(expr)));
+    } else {
+        return make_unary_expression<dynamic_matrix_negate>(
+            detail::dynamic_operand(std::forward<Expr>(expr)));
+    }
+}
+
+namespace detail {
+
+template <typename LHS, typename RHS>
+constexpr bool dynamic_multiplication_v
+    = (is_dynamic_v<LHS> && traits::is_scalar_v<RHS>)
+      || (traits::is_scalar_v<LHS> && is_dynamic_v<RHS>)
+      || ((is_dynamic_v<LHS> || is_dynamic_v<RHS>) && is_matrix_operand_v<LHS>
+          && (is_matrix_operand_v<RHS> || is_vector_operand_v<RHS>));
+
+template <typename Expr, typename Scalar>
+auto
+scalar_multiply(Expr&& expr, Scalar&& s)
+{
+    if constexpr (traits::is_dynamic_vector_expression_v<Expr>) {
+        return make_scalar_expression<dynamic_vector_scalar_multiply>(
+            dynamic_operand(std::forward<Expr>(expr)), std::forward<Scalar>(s));
+    } else {
+        return make_scalar_expression<dynamic_matrix_scalar_multiply>(
+            dynamic_operand(std::forward<Expr>(expr)), std::forward<Scalar>(s));
+    }
+}
+
+template <typename LHS, typename RHS>
+auto
+multiply(LHS&& lhs, RHS&& rhs)
+{
+    if constexpr (is_matrix_operand_v<RHS>) {
+        if (lhs.cols() != rhs.rows())
+            throw std::runtime_error{"Left hand columns must be equal to right hand rows"};
+        return make_binary_expression<dynamic_matrix_multiply>(std::forward<LHS>(lhs),
+                                                               std::forward<RHS>(rhs));
+    } else {
+        if (lhs.cols() != rhs.size())
+            throw std::runtime_error{"Matrix columns must be equal to the vector size"};
+        return make_binary_expression<dynamic_matrix_vector_multiply>(std::forward<LHS>(lhs),
+                                                                      std::forward<RHS>(rhs));
+    }
+}
+
+}    // namespace detail
+
+template <typename LHS, typename RHS,
+          typename = std::enable_if_t<detail::dynamic_multiplication_v<LHS, RHS>>>
+auto operator*(LHS&& lhs, RHS&& rhs)
+{
+    if constexpr (traits::is_scalar_v<RHS>) {
+        return detail::scalar_multiply(std::forward<LHS>(lhs), std::forward<RHS>(rhs));
+    } else if constexpr (traits::is_scalar_v<LHS>) {
+        return detail::scalar_multiply(std::forward<RHS>(rhs), std::forward<LHS>(lhs));
+    } else {
+        return detail::multiply(detail::dynamic_operand(std::forward<LHS>(lhs)),
+                                detail::dynamic_operand(std::forward<RHS>(rhs)));
+    }
+}
+
+template <typename LHS, typename RHS,
+          typename
+          = std::enable_if_t<detail::is_dynamic_v<LHS> && traits::is_scalar_v<RHS>>>
+auto
+operator/(LHS&& lhs, RHS&& rhs)
+{
+    if constexpr (traits::is_dynamic_vector_expression_v<LHS>) {
+        return detail::make_scalar_expression<dynamic_vector_scalar_divide>(
+            detail::dynamic_operand(std::forward<LHS>(lhs)), std::forward<RHS>(rhs));
+    } else {
+        return detail::make_scalar_expression<dynamic_matrix_scalar_divide>(
+            detail::dynamic_operand(std::forward<LHS>(lhs)), std::forward<RHS>(rhs));
+    }
+}
+//@}
+
+//----------------------------------------------------------------------------
+//@{
+/** @name Dynamic vector functions */
+template <typename LHS, typename RHS,
+          typename = std::enable_if_t<detail::dynamic_operands_v<LHS, RHS>
+                                      && detail::is_vector_operand_v<LHS>>>
+auto
+dot_product(LHS const& lhs, RHS const& rhs)
+{
+    decltype(auto) l = detail::dynamic_operand(lhs);
+    decltype(auto) r = detail::dynamic_operand(rhs);
+    detail::check_same_size(l, r);
+    using value_type = traits::scalar_expression_result_t<decltype(l), decltype(r)>;
+    value_type        res{0};
+    std::size_t const size = l.size();
+    for (std::size_t i = 0; i < size; ++i) {
+        res += l.at(i) * r.at(i);
+    }
+    return res;
+}
+
+template <typename LHS, typename RHS,
+          typename = std::enable_if_t<detail::dynamic_operands_v<LHS, RHS>
+                                      && detail::is_vector_operand_v<LHS>>>
+auto
+dot(LHS const& lhs, RHS const& rhs)
+{
+    return dot_product(lhs, rhs);
+}
+
+template <typename Expr, typename = traits::enable_if_dynamic_vector_expression<Expr>>
+auto
+magnitude_square(Expr const& expr)
+{
+    using value_type     = typename Expr::value_type;
+    using magnitude_type = typename traits::scalar_value_traits<value_type>::magnitude_type;
+    return static_cast<magnitude_type>(dot_product(expr, expr));
+}
+
+template <typename Expr, typename = traits::enable_if_dynamic_vector_expression<Expr>>
+auto
+magnitude(Expr const& expr)
+{
+    return std::sqrt(magnitude_square(expr));
+}
+
+template <typename LHS, typename RHS,
+          typename = std::enable_if_t<detail::dynamic_operands_v<LHS, RHS>>>
+bool
+operator==(LHS const& lhs, RHS const& rhs)
+{
+    decltype(auto) l = detail::dynamic_operand(lhs);
+    decltype(auto) r = detail::dynamic_operand(rhs);
+    using value_type   = traits::scalar_expression_result_t<decltype(l), decltype(r)>;
+    using value_traits = traits::scalar_value_traits<value_type>;
+    if constexpr (traits::is_dynamic_vector_expression_v<decltype(l)>) {
+        if (l.size() != r.size())
+            return false;
+        for (std::size_t i = 0; i < l.size(); ++i) {
+            if (!value_traits::eq(l.at(i), r.at(i)))
+                return false;
+        }
+    } else {
+        if (l.rows() != r.rows() || l.cols() != r.cols())
+            return false;
+        for (std::size_t row = 0; row < l.rows(); ++row) {
+            for (std::size_t col = 0; col < l.cols(); ++col) {
+                if (!value_traits::eq(l.element(row, col), r.element(row, col)))
+                    return false;
+            }
+        }
+    }
+    return true;
+}
+
+template <typename LHS, typename RHS,
+          typename = std::enable_if_t<detail::dynamic_operands_v<LHS, RHS>>>
+bool
+operator!=(LHS const& lhs, RHS const& rhs)
+{
+    return !(lhs == rhs);
+}
+//@}
+
+}    // namespace d
+
+}    // namespace expr
+}    // namespace math
+}    // namespace psst
+
+#endif /* PSST_MATH_DETAIL_DYNAMIC_EXPRESSIONS_HPP_ */
@@ -0,0 +1,152 @@
+/**
+ * Copyright 2019 Sergei A. Fedorov
+ * dynamic_kernels.hpp
+ *
+ *  Created on: Mar 4, 2019
+ *      Author: ser-fedorov
+ */
+
+#ifndef PSST_MATH_DETAIL_DYNAMIC_KERNELS_HPP_
+#define PSST_MATH_DETAIL_DYNAMIC_KERNELS_HPP_
+
+#include <psst/math/config.hpp>
+
+#include <algorithm>
+#include <cstddef>
+
+namespace psst {
+namespace math {
+namespace detail {
+
+/**
+ * How a kernel writes its result: overwrites the values of the destination,
+ * adds the result to them or subtracts it from them
+ */
+enum class kernel_store { assign, add, subtract };
+
+template <typename T>
+void
+store_result(T& dst, T value, kernel_store mode)
+{
+    switch (mode) {
+    case kernel_store::assign:
+        dst = value;
+        break;
+    case kernel_store::add:
+        dst += value;
+        break;
+    case kernel_store::subtract:
+        dst -= value;
+        break;
+    }
+}
+
+/**
+ * Dot product of two arrays
+ */
+template <typename T>
+T
+dot_kernel(T const* lhs, T const* rhs, std::size_t size)
+{
+    T res{0};
+    for (std::size_t i = 0; i < size; ++i) {
+        res += lhs[i] * rhs[i];
+    }
+    return res;
+}
+
+/**
+ * res = lhs * rhs for row-major matrices, lhs is rows x inner and rhs is
+ * inner x cols. The loops are blocked so that a block of rhs stays in the
+ * cache while the rows of lhs pass over it, the innermost loop runs along the
+ * contiguous rows of rhs and res. The product is added to res or subtracted
+ * from it in place by the other store modes.
+ */
+template <typename T>
+void
+multiply_kernel(T const* lhs, T const* rhs, T* res, std::size_t rows, std::size_t inner,
+                std::size_t cols, kernel_store mode = kernel_store::assign)
+{
+    constexpr std::size_t block  = config::dynamic_block_size;
+    bool const            negate = mode == kernel_store::subtract;
+    if (mode == kernel_store::assign)
+        std::fill(res, res + rows * cols, T{0});
+    for (std::size_t kb = 0; kb < inner; kb += block) {
+        std::size_t const ke = std::min(kb + block, inner);
+        for (std::size_t jb = 0; jb < cols; jb += block) {
+            std::size_t const je = std::min(jb + block, cols);
+            for (std::size_t i = 0; i < rows; ++i) {
+                T const* lhs_row = lhs + i * inner;
+                T*       res_row = res + i * cols;
+                for (std::size_t k = kb; k < ke; ++k) {
+                    T const        a       = negate ? -lhs_row[k] : lhs_row[k];
+                    T const* const rhs_row = rhs + k * cols;
+                    for (std::size_t j = jb; j < je; ++j) {
+                        res_row[j] += a * rhs_row[j];
+                    }
+                }
+            }
+        }
+    }
+}
+
+/**
+ * res = mtx * vec for a row-major matrix. Four rows are multiplied at once to
+ * load the values of the vector once for the four rows.
+ */
+template <typename T>
+void
+multiply_vector_kernel(T const* mtx, T const* vec, T* res, std::size_t rows, std::size_t cols,
+                       kernel_store mode = kernel_store::assign)
+{
+    std::size_t i = 0;
+    for (; i + 4 <= rows; i += 4) {
+        T const* r0 = mtx + i * cols;
+        T const* r1 = r0 + cols;
+        T const* r2 = r1 + cols;
+        T const* r3 = r2 + cols;
+        T        s0{0}, s1{0}, s2{0}, s3{0};
+        for (std::size_t j = 0; j < cols; ++j) {
+            T const v = vec[j];
+            s0 += r0[j] * v;
+            s1 += r1[j] * v;
+            s2 += r2[j] * v;
+            s3 += r3[j] * v;
+        }
+        store_result(res[i], s0, mode);
+        store_result(res[i + 1], s1, mode);
+        store_result(res[i + 2], s2, mode);
+        store_result(res[i + 3], s3, mode);
+    }
+    for (; i < rows; ++i) {
+        store_result(res[i], dot_kernel(mtx + i * cols, vec, cols), mode);
+    }
+}
+
+/**
+ * Transpose a row-major rows x cols matrix by square tiles, so that both the
+ * reads and the writes of a tile stay in the cache
+ */
+template <typename T>
+void
+transpose_kernel(T const* mtx, T* res, std::size_t rows, std::size_t cols)
+{
+    constexpr std::size_t tile = 16;
+    for (std::size_t rb = 0; rb < rows; rb += tile) {
+        std::size_t const re = std::min(rb + tile, rows);
+        for (std::size_t cb = 0; cb < cols; cb += tile) {
+            std::size_t const ce = std::min(cb + tile, cols);
+            for (std::size_t r = rb; r < re; ++r) {
+                for (std::size_t c = cb; c < ce; ++c) {
+                    res[c * rows + r] = mtx[r * cols + c];
+                }
+            }
+        }
+    }
+}
+
+}    // namespace detail
+}    // namespace math
+}    // namespace psst
+
+#endif /* PSST_MATH_DETAIL_DYNAMIC_KERNELS_HPP_ */
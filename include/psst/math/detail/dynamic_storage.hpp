@@ -0,0 +1,180 @@
+/**
+ * Copyright 2019 Sergei A. Fedorov
+ * dynamic_storage.hpp
+ *
+ *  Created on: Mar 4, 2019
+ *      Author: ser-fedorov
+ */
+
+#ifndef PSST_MATH_DETAIL_DYNAMIC_STORAGE_HPP_
+#define PSST_MATH_DETAIL_DYNAMIC_STORAGE_HPP_
+
+#include <psst/math/config.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace psst {
+namespace math {
+namespace detail {
+
+/**
+ * Contiguous storage of the values of dynamic vectors and matrices. The
+ * values that fit into config::dynamic_inline_bytes are kept in a buffer
+ * inside of the storage, larger arrays are allocated on the heap aligned to
+ * config::dynamic_alignment. The memory is reused when the size shrinks.
+ */
+template <typename T>
+class dynamic_storage {
+public:
+    static_assert(std::is_trivially_copyable_v<T>,
+                  "Values of dynamic vectors and matrices must be trivially copyable");
+    using value_type    = T;
+    using pointer       = T*;
+    using const_pointer = T const*;
+    using size_type     = std::size_t;
+
+    static constexpr size_type inline_capacity
+        = std::max<size_type>(config::dynamic_inline_bytes / sizeof(T), 1);
+
+    dynamic_storage() = default;
+    explicit dynamic_storage(size_type size) { allocate(size); }
+    dynamic_storage(dynamic_storage const& rhs)
+    {
+        allocate(rhs.size_);
+        std::copy(rhs.data_, rhs.data_ + rhs.size_, data_);
+    }
+    dynamic_storage(dynamic_storage&& rhs) noexcept { take(rhs); }
+    ~dynamic_storage() { release(); }
+
+    dynamic_storage&
+    operator=(dynamic_storage const& rhs)
+    {
+        if (this != &rhs) {
+            allocate(rhs.size_);
+            std::copy(rhs.data_, rhs.data_ + rhs.size_, data_);
+        }
+        return *this;
+    }
+    dynamic_storage&
+    operator=(dynamic_storage&& rhs) noexcept
+    {
+        if (this != &rhs) {
+            release();
+            take(rhs);
+        }
+        return *this;
+    }
+
+    pointer
+    data()
+    {
+        return data_;
+    }
+    const_pointer
+    data() const
+    {
+        return data_;
+    }
+
+    size_type
+    size() const
+    {
+        return size_;
+    }
+    size_type
+    capacity() const
+    {
+        return capacity_;
+    }
+    /**
+     * The values are stored in the buffer inside of the storage
+     */
+    bool
+    is_inline() const
+    {
+        return data_ == inline_;
+    }
+
+    /**
+     * Set the size without keeping the values, for the storage that is
+     * overwritten entirely
+     */
+    void
+    allocate(size_type size)
+    {
+        if (size > capacity_) {
+            release();
+            data_ = static_cast<pointer>(
+                ::operator new(size * sizeof(T), std::align_val_t{config::dynamic_alignment}));
+            capacity_ = size;
+        }
+        size_ = size;
+    }
+    /**
+     * Set the size keeping the values, the new values are zero
+     */
+    void
+    resize(size_type size)
+    {
+        if (size > capacity_) {
+            dynamic_storage tmp{size};
+            std::copy(data_, data_ + size_, tmp.data_);
+            tmp.size_ = size_;
+            *this     = std::move(tmp);
+        }
+        if (size > size_)
+            std::fill(data_ + size_, data_ + size, value_type{0});
+        size_ = size;
+    }
+    void
+    clear()
+    {
+        size_ = 0;
+    }
+
+private:
+    void
+    release()
+    {
+        if (data_ != inline_)
+            ::operator delete(data_, std::align_val_t{config::dynamic_alignment});
+        data_     = inline_;
+        size_     = 0;
+        capacity_ = inline_capacity;
+    }
+    /**
+     * Take the values of other storage, a heap array is moved, an inline
+     * buffer is copied
+     */
+    void
+    take(dynamic_storage& rhs)
+    {
+        if (rhs.data_ == rhs.inline_) {
+            std::copy(rhs.inline_, rhs.inline_ + rhs.size_, inline_);
+            data_     = inline_;
+            capacity_ = inline_capacity;
+        } else {
+            data_         = rhs.data_;
+            capacity_     = rhs.capacity_;
+            rhs.data_     = rhs.inline_;
+            rhs.capacity_ = inline_capacity;
+        }
+        size_     = rhs.size_;
+        rhs.size_ = 0;
+    }
+
+    pointer   data_     = inline_;
+    size_type size_     = 0;
+    size_type capacity_ = inline_capacity;
+    alignas(alignof(std::max_align_t)) value_type inline_[inline_capacity];
+};
+
+}    // namespace detail
+}    // namespace math
+}    // namespace psst
+
+#endif /* PSST_MATH_DETAIL_DYNAMIC_STORAGE_HPP_ */
@@ -6,11 +6,34 @@
 #include <psst/math/vector_fwd.hpp>
 
 #include <cmath>
+#include <cstdint>
 #include <tuple>
 #include <utility>
 
 namespace psst {
 namespace math {
+namespace detail {
+
+template <typename T, typename = utils::void_t<>>
+struct has_references : std::false_type {};
+template <typename T>
+struct has_references<
+    T, utils::void_t<decltype(std::declval<T const&>().references(nullptr, nullptr))>>
+    : std::true_type {};
+
+/**
+ * Check if [first, last) and [dst_first, dst_last) overlap. The addresses are
+ * compared as integers, as the ranges may belong to unrelated objects.
+ */
+inline bool
+overlaps(void const* first, void const* last, void const* dst_first, void const* dst_last)
+{
+    auto address = [](void const* ptr) { return reinterpret_cast<std::uintptr_t>(ptr); };
+    return address(first) < address(dst_last) && address(dst_first) < address(last);
+}
+
+}    // namespace detail
+
 namespace expr {
 
 //----------------------------------------------------------------------------
@@ -60,6 +83,60 @@ struct expression_argument_storage {
 template <typename T>
 using expression_argument_storage_t = typename expression_argument_storage<T>::type;
 
+//----------------------------------------------------------------------------
+/**
+ * Check if an expression argument references memory in [first, last). An
+ * expression references the memory if any of its arguments does, a leaf
+ * references the memory if the expression stores a reference to it. The
+ * arguments stored by value are a part of the expression.
+ */
+template <typename T>
+bool
+references(T const& arg, void const* first, void const* last)
+{
+    if constexpr (math::detail::has_references<T>::value) {
+        return arg.references(first, last);
+    } else {
+        return math::detail::overlaps(&arg, &arg + 1, first, last);
+    }
+}
+
+/**
+ * Assignment that evaluates an expression directly into the destination
+ * without checking if the expression references it, see noalias() of
+ * dynamic vectors and matrices. The compound assignments add a product to
+ * the destination by the kernel of the product.
+ */
+template <typename Destination>
+class noalias_assignment {
+public:
+    explicit constexpr noalias_assignment(Destination& dst) : dst_{dst} {}
+
+    template <typename Expression>
+    Destination&
+    operator=(Expression const& rhs)
+    {
+        return dst_.evaluate(rhs);
+    }
+
+    template <typename Expression>
+    Destination&
+    operator+=(Expression const& rhs)
+    {
+        return dst_.add(rhs);
+    }
+
+    template <typename Expression>
+    Destination&
+    operator-=(Expression const& rhs)
+    {
+        return dst_.subtract(rhs);
+    }
+
+private:
+    Destination& dst_;
+};
+
 //----------------------------------------------------------------------------
 template <typename Expression>
 struct unary_expression {
@@ -81,6 +158,12 @@ struct unary_expression {
         return arg_;
     }
 
+    bool
+    references(void const* first, void const* last) const
+    {
+        return expr::references(arg_, first, last);
+    }
+
 protected:
     arg_storage_type arg_;
 };
@@ -156,6 +239,12 @@ struct binary_expression {
         return rhs_;
     }
 
+    bool
+    references(void const* first, void const* last) const
+    {
+        return expr::references(lhs_, first, last) || expr::references(rhs_, first, last);
+    }
+
 protected:
     lhs_storage_type lhs_;
     rhs_storage_type rhs_;
@@ -202,6 +291,16 @@ struct n_ary_expression {
         return args_;
     }
 
+    bool
+    references(void const* first, void const* last) const
+    {
+        return std::apply(
+            [first, last](auto const&... args) {
+                return (expr::references(args, first, last) || ...);
+            },
+            args_);
+    }
+
 protected:
     template <std::size_t N>
     constexpr auto
@@ -0,0 +1,51 @@
+/**
+ * Copyright 2019 Sergei A. Fedorov
+ * gemm.hpp
+ *
+ *  Created on: Mar 5, 2019
+ *      Author: ser-fedorov
+ */
+
+#ifndef PSST_MATH_DETAIL_GEMM_HPP_
+#define PSST_MATH_DETAIL_GEMM_HPP_
+
+#include <psst/math/config.hpp>
+#include <psst/math/detail/gemm_kernel.hpp>
+#include <psst/math/detail/parallel.hpp>
+
+#include <algorithm>
+#include <cstddef>
+
+namespace psst {
+namespace math {
+namespace detail {
+
+/**
+ * res = lhs * rhs by the packed kernel, see gemm_panels. The row blocks of a
+ * panel of rhs are split between the threads, each thread packs its blocks of
+ * lhs and the threads share the packed panel.
+ *
+ * @param threads maximum number of threads, 0 means the hardware concurrency
+ */
+template <typename T>
+void
+parallel_gemm_kernel(T const* lhs, T const* rhs, T* res, std::size_t rows, std::size_t inner,
+                     std::size_t cols, std::size_t threads,
+                     kernel_store mode = kernel_store::assign)
+{
+    // Each thread gets at least gemm_parallel_min_work multiply-adds per panel
+    std::size_t const block_work = config::gemm_block_rows
+                                   * std::min(config::gemm_block_inner, inner)
+                                   * std::min(config::gemm_block_cols, cols);
+    std::size_t const min_blocks
+        = (config::gemm_parallel_min_work + block_work - 1) / std::max<std::size_t>(block_work, 1);
+    gemm_panels(lhs, rhs, res, rows, inner, cols, mode, [&](std::size_t count, auto&& fn) {
+        parallel_for(count, min_blocks, threads, fn);
+    });
+}
+
+}    // namespace detail
+}    // namespace math
+}    // namespace psst
+
+#endif /* PSST_MATH_DETAIL_GEMM_HPP_ */
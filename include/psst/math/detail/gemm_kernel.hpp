@@ -0,0 +1,207 @@
+/**
+ * Copyright 2019 Sergei A. Fedorov
+ * gemm_kernel.hpp
+ *
+ *  Created on: Mar 5, 2019
+ *      Author: ser-fedorov
+ */
+
+#ifndef PSST_MATH_DETAIL_GEMM_KERNEL_HPP_
+#define PSST_MATH_DETAIL_GEMM_KERNEL_HPP_
+
+#include <psst/math/config.hpp>
+#include <psst/math/detail/dynamic_kernels.hpp>
+#include <psst/math/detail/dynamic_storage.hpp>
+
+#include <algorithm>
+#include <cstddef>
+
+namespace psst {
+namespace math {
+namespace detail {
+
+/**
+ * Register tile of the matrix product micro-kernel. The tile of the result
+ * stays in the registers while the packed slivers of the operands stream
+ * through. A row of the tile takes two SSE registers.
+ */
+template <typename T>
+struct gemm_tile {
+    static constexpr std::size_t rows = 4;
+    static constexpr std::size_t cols = std::max<std::size_t>(32 / sizeof(T), 1);
+};
+
+/**
+ * Copy a rows x depth block of the left hand matrix into slivers of
+ * gemm_tile::rows rows, the values of a sliver are stored column by column.
+ * The rows past the end of the matrix are padded with zeros.
+ */
+template <typename T>
+void
+gemm_pack_lhs(T const* lhs, std::size_t stride, std::size_t rows, std::size_t depth, T* packed)
+{
+    constexpr std::size_t mr = gemm_tile<T>::rows;
+    for (std::size_t i = 0; i < rows; i += mr) {
+        std::size_t const n = std::min(mr, rows - i);
+        for (std::size_t k = 0; k < depth; ++k) {
+            for (std::size_t r = 0; r < n; ++r) {
+                packed[r] = lhs[(i + r) * stride + k];
+            }
+            for (std::size_t r = n; r < mr; ++r) {
+                packed[r] = T{0};
+            }
+            packed += mr;
+        }
+    }
+}
+
+/**
+ * Copy a depth x cols panel of the right hand matrix into slivers of
+ * gemm_tile::cols columns, the values of a sliver are stored row by row.
+ * The columns past the end of the matrix are padded with zeros.
+ */
+template <typename T>
+void
+gemm_pack_rhs(T const* rhs, std::size_t stride, std::size_t depth, std::size_t cols, T* packed)
+{
+    constexpr std::size_t nr = gemm_tile<T>::cols;
+    for (std::size_t j = 0; j < cols; j += nr) {
+        std::size_t const n = std::min(nr, cols - j);
+        for (std::size_t k = 0; k < depth; ++k) {
+            T const* row = rhs + k * stride + j;
+            for (std::size_t c = 0; c < n; ++c) {
+                packed[c] = row[c];
+            }
+            for (std::size_t c = n; c < nr; ++c) {
+                packed[c] = T{0};
+            }
+            packed += nr;
+        }
+    }
+}
+
+/**
+ * Multiply a packed sliver of lhs by a packed sliver of rhs and add the
+ * rows x cols part of the tile multiplied by alpha to res
+ */
+template <typename T>
+void
+gemm_micro_kernel(T const* lhs, T const* rhs, std::size_t depth, T* res, std::size_t stride,
+                  std::size_t rows, std::size_t cols, T alpha)
+{
+    constexpr std::size_t mr = gemm_tile<T>::rows;
+    constexpr std::size_t nr = gemm_tile<T>::cols;
+
+    T acc[mr][nr] = {};
+    for (std::size_t k = 0; k < depth; ++k) {
+        for (std::size_t r = 0; r < mr; ++r) {
+            T const a = lhs[r];
+            for (std::size_t c = 0; c < nr; ++c) {
+                acc[r][c] += a * rhs[c];
+            }
+        }
+        lhs += mr;
+        rhs += nr;
+    }
+    if (rows == mr && cols == nr) {
+        for (std::size_t r = 0; r < mr; ++r) {
+            for (std::size_t c = 0; c < nr; ++c) {
+                res[r * stride + c] += alpha * acc[r][c];
+            }
+        }
+    } else {
+        for (std::size_t r = 0; r < rows; ++r) {
+            for (std::size_t c = 0; c < cols; ++c) {
+                res[r * stride + c] += alpha * acc[r][c];
+            }
+        }
+    }
+}
+
+/**
+ * Multiply a packed rows x depth block of lhs by a packed depth x cols panel
+ * of rhs and add the product multiplied by alpha to res tile by tile
+ */
+template <typename T>
+void
+gemm_macro_kernel(T const* lhs, T const* rhs, std::size_t rows, std::size_t depth,
+                  std::size_t cols, T* res, std::size_t stride, T alpha)
+{
+    constexpr std::size_t mr = gemm_tile<T>::rows;
+    constexpr std::size_t nr = gemm_tile<T>::cols;
+    for (std::size_t j = 0; j < cols; j += nr) {
+        for (std::size_t i = 0; i < rows; i += mr) {
+            gemm_micro_kernel(lhs + i * depth, rhs + j * depth, depth, res + i * stride + j,
+                              stride, std::min(mr, rows - i), std::min(nr, cols - j), alpha);
+        }
+    }
+}
+
+/**
+ * res = lhs * rhs for row-major matrices, lhs is rows x inner and rhs is
+ * inner x cols, computed by the panels of config::gemm_block_cols columns and
+ * config::gemm_block_inner values of the inner dimension. A panel of rhs is
+ * packed once, the blocks of config::gemm_block_rows rows of lhs are packed
+ * and multiplied by the panel with the register-tiled micro-kernel.
+ *
+ * for_each_blocks(count, fn) calls fn(begin, end) for the ranges of the
+ * count row blocks of a panel, the ranges write distinct rows of the result.
+ */
+template <typename T, typename ForEachBlocks>
+void
+gemm_panels(T const* lhs, T const* rhs, T* res, std::size_t rows, std::size_t inner,
+            std::size_t cols, kernel_store mode, ForEachBlocks&& for_each_blocks)
+{
+    constexpr std::size_t nr = gemm_tile<T>::cols;
+    constexpr std::size_t mc = config::gemm_block_rows;
+    constexpr std::size_t kc = config::gemm_block_inner;
+    constexpr std::size_t nc = config::gemm_block_cols;
+    static_assert(mc % gemm_tile<T>::rows == 0 && nc % nr == 0,
+                  "Blocks must be multiples of the register tile");
+
+    if (mode == kernel_store::assign)
+        std::fill(res, res + rows * cols, T{0});
+    if (rows == 0 || inner == 0 || cols == 0)
+        return;
+
+    std::size_t const row_blocks = (rows + mc - 1) / mc;
+    T const           alpha      = mode == kernel_store::subtract ? T{-1} : T{1};
+
+    dynamic_storage<T> rhs_pack{std::min(kc, inner) * ((std::min(nc, cols) + nr - 1) / nr * nr)};
+    for (std::size_t jc = 0; jc < cols; jc += nc) {
+        std::size_t const nb = std::min(nc, cols - jc);
+        for (std::size_t pc = 0; pc < inner; pc += kc) {
+            std::size_t const kb = std::min(kc, inner - pc);
+            gemm_pack_rhs(rhs + pc * cols + jc, cols, kb, nb, rhs_pack.data());
+            for_each_blocks(row_blocks, [&](std::size_t begin, std::size_t end) {
+                dynamic_storage<T> lhs_pack{mc * kb};
+                for (std::size_t ic = begin * mc; ic < std::min(rows, end * mc); ic += mc) {
+                    std::size_t const mb = std::min(mc, rows - ic);
+                    gemm_pack_lhs(lhs + ic * inner + pc, inner, mb, kb, lhs_pack.data());
+                    gemm_macro_kernel(lhs_pack.data(), rhs_pack.data(), mb, kb, nb,
+                                      res + ic * cols + jc, cols, alpha);
+                }
+            });
+        }
+    }
+}
+
+/**
+ * res = lhs * rhs by the packed kernel in the calling thread, see
+ * gemm_panels. The product is added to res or subtracted from it in place by
+ * the other store modes. The threaded kernel is in detail/gemm.hpp.
+ */
+template <typename T>
+void
+gemm_kernel(T const* lhs, T const* rhs, T* res, std::size_t rows, std::size_t inner,
+            std::size_t cols, kernel_store mode = kernel_store::assign)
+{
+    gemm_panels(lhs, rhs, res, rows, inner, cols, mode,
+                [](std::size_t count, auto&& fn) { fn(std::size_t{0}, count); });
+}
+
+}    // namespace detail
+}    // namespace math
+}    // namespace psst
+
+#endif /* PSST_MATH_DETAIL_GEMM_KERNEL_HPP_ */
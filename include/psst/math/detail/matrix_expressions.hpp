@@ -8,8 +8,12 @@
 #ifndef PSST_MATH_DETAIL_MATRIX_EXPRESSIONS_HPP_
 #define PSST_MATH_DETAIL_MATRIX_EXPRESSIONS_HPP_
 
+#include <psst/math/config.hpp>
+#include <psst/math/detail/gemm_kernel.hpp>
 #include <psst/math/detail/vector_expressions.hpp>
 
+#include <algorithm>
+
 // Undefine minor macro that comes with some libc libraries
 #ifdef minor
 #    undef minor
@@ -68,7 +72,7 @@ struct identity_matrix : matrix_expression<identity_matrix<Matrix>, Matrix> {
     using base_type  = matrix_expression<identity_matrix<Matrix>, Matrix>;
     using value_type = typename base_type::value_type;
 
-    static_assert(base_type::cols == base_type::rows,
+    static_assert(traits::has_identity_v<base_type::rows, base_type::cols>,
                   "Identity matrix is defined only for square matrices");
 
     template <std::size_t R, std::size_t C>
@@ -426,36 +430,37 @@ minor(Matrix&& mtx)
 /** @name Compare two matrix expressions */
 namespace detail {
 
-template <std::size_t R, typename LHS, typename RHS>
-struct matrix_expression_cmp;
-
-template <typename LHS, typename RHS>
-struct matrix_expression_cmp<0, LHS, RHS> {
+/**
+ * Compares the matrices row by row, the rows are compared as vectors of the
+ * shorter size. Instead of a recursion over rows the elements are compared
+ * by a single fold over the flattened index.
+ */
+template <std::size_t Rows, typename LHS, typename RHS>
+struct matrix_expression_cmp {
     static_assert((traits::is_matrix_expression_v<LHS> && traits::is_matrix_expression_v<RHS>),
                   "Both sides to the comparison must be matrix expressions");
-    using lhs_type = std::decay_t<LHS>;
-    using rhs_type = std::decay_t<RHS>;
+    using lhs_type    = std::decay_t<LHS>;
+    using rhs_type    = std::decay_t<RHS>;
+    using traits_type = traits::value_traits_t<typename lhs_type::value_type>;
+
+    static constexpr std::size_t cols = utils::min_v<lhs_type::cols, rhs_type::cols>;
+
     constexpr static int
     cmp(lhs_type const& lhs, rhs_type const& rhs)
     {
-        return v::cmp(row<0>(lhs), row<0>(rhs));
+        return cmp(lhs, rhs, std::make_index_sequence<Rows * cols>{});
     }
-};
 
-template <std::size_t R, typename LHS, typename RHS>
-struct matrix_expression_cmp {
-    static_assert((traits::is_matrix_expression_v<LHS> && traits::is_matrix_expression_v<RHS>),
-                  "Both sides to the comparison must be matrix expressions");
-    using prev_element = matrix_expression_cmp<R - 1, LHS, RHS>;
-    using lhs_type     = std::decay_t<LHS>;
-    using rhs_type     = std::decay_t<RHS>;
+private:
+    template <std::size_t... Indexes>
     constexpr static int
-    cmp(lhs_type const& lhs, rhs_type const& rhs)
+    cmp(lhs_type const& lhs, rhs_type const& rhs, std::index_sequence<Indexes...>)
     {
-        auto res = prev_element::cmp(lhs, rhs);
-        if (res == 0) {
-            return v::cmp(row<R>(lhs), row<R>(rhs));
-        }
+        int res = 0;
+        (((res = traits_type::cmp(lhs.template element<Indexes / cols, Indexes % cols>(),
+                                  rhs.template element<Indexes / cols, Indexes % cols>()))
+          == 0)
+         && ...);
         return res;
     }
 };
@@ -470,7 +475,7 @@ struct matrix_cmp : binary_scalar_expression<matrix_cmp, LHS, RHS, int>,
     using lhs_type                        = std::decay_t<LHS>;
     using rhs_type                        = std::decay_t<RHS>;
     static constexpr std::size_t cmp_size = utils::min_v<lhs_type::rows, rhs_type::rows>;
-    using cmp_type                        = detail::matrix_expression_cmp<cmp_size - 1, LHS, RHS>;
+    using cmp_type                        = detail::matrix_expression_cmp<cmp_size, LHS, RHS>;
 
     using expression_base = binary_expression<LHS, RHS>;
     using expression_base::expression_base;
@@ -501,7 +506,7 @@ struct matrix_eq : binary_scalar_expression<matrix_eq, LHS, RHS, bool>,
     static_assert((traits::is_matrix_expression_v<LHS> && traits::is_matrix_expression_v<RHS>),
                   "Both sides to the comparison must be matrix expressions");
     static constexpr std::size_t cmp_size = utils::min_v<LHS::rows, RHS::rows>;
-    using cmp_type                        = detail::matrix_expression_cmp<cmp_size - 1, LHS, RHS>;
+    using cmp_type                        = detail::matrix_expression_cmp<cmp_size, LHS, RHS>;
 
     using expression_base = binary_expression<LHS, RHS>;
     using expression_base::expression_base;
@@ -537,7 +542,7 @@ struct matrix_less : binary_scalar_expression<matrix_less, LHS, RHS, bool>,
     static_assert((traits::is_matrix_expression_v<LHS> && traits::is_matrix_expression_v<RHS>),
                   "Both sides to the comparison must be matrix expressions");
     static constexpr std::size_t cmp_size = utils::min_v<LHS::rows, RHS::rows>;
-    using cmp_type                        = detail::matrix_expression_cmp<cmp_size - 1, LHS, RHS>;
+    using cmp_type                        = detail::matrix_expression_cmp<cmp_size, LHS, RHS>;
 
     using expression_base = binary_expression<LHS, RHS>;
     using expression_base::expression_base;
@@ -870,6 +875,38 @@ operator-(LHS&& lhs, RHS&& rhs)
 }
 //@}
 
+//----------------------------------------------------------------------------
+//@{
+/** @name Matrix negation */
+template <typename Expr>
+struct matrix_negate
+    : matrix_expression<matrix_negate<Expr>, typename std::decay_t<Expr>::matrix_type>,
+      unary_expression<Expr> {
+    using base_type
+        = matrix_expression<matrix_negate<Expr>, typename std::decay_t<Expr>::matrix_type>;
+    using value_type = typename base_type::value_type;
+
+    using expression_base = unary_expression<Expr>;
+    using expression_base::expression_base;
+
+    template <std::size_t R, std::size_t C>
+    constexpr value_type
+    element() const
+    {
+        static_assert(R < base_type::rows, "Invalid matrix expression row index");
+        static_assert(C < base_type::cols, "Invalid matrix expression col index");
+        return -this->arg_.template element<R, C>();
+    }
+};
+
+template <typename Expr, typename = traits::enable_if_matrix_expression<Expr>>
+constexpr auto
+operator-(Expr&& expr)
+{
+    return make_unary_expression<matrix_negate>(std::forward<Expr>(expr));
+}
+//@}
+
 //----------------------------------------------------------------------------
 //@{
 /** @name Matrix by scalar multiplication */
@@ -983,10 +1020,67 @@ struct matrix_matrix_multiply
     {
         static_assert(R < base_type::rows, "Invalid matrix expression row index");
         static_assert(C < base_type::cols, "Invalid matrix expression col index");
-        return dot_product(row<R>(this->lhs_), col<C>(this->rhs_));
+        return dot<R, C>(std::make_index_sequence<std::decay_t<LHS>::cols>{});
+    }
+
+private:
+    // Folds the products directly instead of building row and column
+    // expressions for each element of the result
+    template <std::size_t R, std::size_t C, std::size_t... K>
+    constexpr value_type
+    dot(std::index_sequence<K...>) const
+    {
+        return ((this->lhs_.template element<R, K>() * this->rhs_.template element<K, C>()) + ...);
     }
 };
 
+namespace detail {
+
+/**
+ * Products of matrices with all the dimensions of at least
+ * config::gemm_min_size are evaluated by the packed kernel when the
+ * expression is built. Folding the products of each element is cache-hostile
+ * for matrices this large and takes ages to compile.
+ */
+template <typename LHS, typename RHS>
+constexpr bool packed_product_v
+    = std::min({std::decay_t<LHS>::rows, std::decay_t<LHS>::cols, std::decay_t<RHS>::cols})
+      >= config::gemm_min_size;
+
+/**
+ * The operand of a packed product as a matrix of values of type T, a matrix
+ * is passed through, other expressions are evaluated
+ */
+template <typename T, typename Expr>
+decltype(auto)
+packed_operand(Expr const& expr)
+{
+    using expr_type   = std::decay_t<Expr>;
+    using matrix_type = matrix<T, expr_type::rows, expr_type::cols,
+                               typename expr_type::component_names>;
+    if constexpr (std::is_same_v<expr_type, matrix_type>) {
+        return (expr);
+    } else {
+        return matrix_type(expr);
+    }
+}
+
+template <typename LHS, typename RHS>
+auto
+packed_product(LHS const& lhs, RHS const& rhs)
+{
+    using result_type = matrix_matrix_mul_result_t<LHS, RHS>;
+    using value_type  = typename result_type::value_type;
+    auto const& l     = packed_operand<value_type>(lhs);
+    auto const& r     = packed_operand<value_type>(rhs);
+    result_type res;
+    math::detail::gemm_kernel(l.data(), r.data(), res.data(), result_type::rows,
+                              std::decay_t<LHS>::cols, result_type::cols);
+    return res;
+}
+
+}    // namespace detail
+
 //----------------------------------------------------------------------------
 template <typename LHS, typename RHS,
           typename = std::enable_if_t<
@@ -1005,8 +1099,12 @@ constexpr auto operator*(LHS&& lhs, RHS&& rhs)
                                                                            std::forward<LHS>(lhs));
     } else if constexpr (traits::is_matrix_expression_v<
                              LHS> && traits::is_matrix_expression_v<RHS>) {
-        return make_binary_expression<matrix_matrix_multiply>(std::forward<LHS>(lhs),
-                                                              std::forward<RHS>(rhs));
+        if constexpr (detail::packed_product_v<LHS, RHS>) {
+            return detail::packed_product(lhs, rhs);
+        } else {
+            return make_binary_expression<matrix_matrix_multiply>(std::forward<LHS>(lhs),
+                                                                  std::forward<RHS>(rhs));
+        }
     } else if constexpr (traits::is_matrix_expression_v<
                              LHS> && traits::is_vector_expression_v<RHS>) {
         return std::forward<LHS>(lhs) * as_col_matrix(std::forward<RHS>(rhs));
@@ -1023,6 +1121,88 @@ template <typename Expr, typename = traits::enable_if_matrix_expression<Expr>>
 constexpr auto
 det(Expr&& mtx);
 
+namespace detail {
+
+template <typename T, std::size_t N>
+constexpr void
+swap_rows(T (&a)[N][N], std::size_t lhs, std::size_t rhs)
+{
+    for (std::size_t c = 0; c < N; ++c) {
+        T tmp     = a[lhs][c];
+        a[lhs][c] = a[rhs][c];
+        a[rhs][c] = tmp;
+    }
+}
+
+/**
+ * Fraction-free Bareiss elimination, all the intermediate divisions are
+ * exact, so the determinant of an integral matrix is computed without
+ * rounding.
+ */
+template <typename T, std::size_t N>
+constexpr T
+bareiss_determinant(T (&a)[N][N])
+{
+    T sign = 1;
+    T prev = 1;
+    for (std::size_t k = 0; k < N - 1; ++k) {
+        if (a[k][k] == T{0}) {
+            std::size_t p = k + 1;
+            while (p < N && a[p][k] == T{0}) {
+                ++p;
+            }
+            if (p == N) {
+                return T{0};
+            }
+            swap_rows(a, k, p);
+            sign = -sign;
+        }
+        for (std::size_t r = k + 1; r < N; ++r) {
+            for (std::size_t c = k + 1; c < N; ++c) {
+                a[r][c] = (a[r][c] * a[k][k] - a[r][k] * a[k][c]) / prev;
+            }
+        }
+        prev = a[k][k];
+    }
+    return sign * a[N - 1][N - 1];
+}
+
+/**
+ * Gaussian elimination with partial pivoting
+ */
+template <typename T, std::size_t N>
+constexpr T
+gauss_determinant(T (&a)[N][N])
+{
+    auto abs = [](T v) { return v < T{0} ? -v : v; };
+    T    res = 1;
+    for (std::size_t k = 0; k < N; ++k) {
+        std::size_t p = k;
+        for (std::size_t r = k + 1; r < N; ++r) {
+            if (abs(a[p][k]) < abs(a[r][k])) {
+                p = r;
+            }
+        }
+        if (a[p][k] == T{0}) {
+            return T{0};
+        }
+        if (p != k) {
+            swap_rows(a, k, p);
+            res = -res;
+        }
+        res *= a[k][k];
+        for (std::size_t r = k + 1; r < N; ++r) {
+            T f = a[r][k] / a[k][k];
+            for (std::size_t c = k + 1; c < N; ++c) {
+                a[r][c] -= f * a[k][c];
+            }
+        }
+    }
+    return res;
+}
+
+}    // namespace detail
+
 template <typename Expr>
 struct matrix_determinant
     : scalar_expression<matrix_determinant<Expr>, typename std::decay_t<Expr>::value_type>,
@@ -1042,7 +1222,11 @@ struct matrix_determinant
     constexpr value_type
     value() const
     {
-        if constexpr (matrix_type::rows > 1) {
+        // Laplace expansion instantiates a factorial number of minor
+        // expressions, so it is used only for small matrices
+        if constexpr (matrix_type::rows > 3) {
+            return eliminate(std::make_index_sequence<matrix_type::size>{});
+        } else if constexpr (matrix_type::rows > 1) {
             return sum(col_indexes_type{});
         } else if constexpr (matrix_type::rows == 1) {
             return this->arg_.template element<0, 0>();
@@ -1069,6 +1253,19 @@ private:
     {
         return s::sum(this->template nth_element<CI>()...);
     }
+    template <std::size_t... I>
+    constexpr value_type
+    eliminate(std::index_sequence<I...>) const
+    {
+        constexpr auto n = matrix_type::rows;
+        value_type     a[n][n]{};
+        ((a[I / n][I % n] = this->arg_.template element<I / n, I % n>()), ...);
+        if constexpr (std::is_integral_v<value_type>) {
+            return detail::bareiss_determinant(a);
+        } else {
+            return detail::gauss_determinant(a);
+        }
+    }
 };
 
 template <typename Expr, typename>
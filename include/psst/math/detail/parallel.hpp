@@ -0,0 +1,89 @@
+/**
+ * Copyright 2019 Sergei A. Fedorov
+ * parallel.hpp
+ *
+ *  Created on: Feb 24, 2019
+ *      Author: ser-fedorov
+ */
+
+#ifndef PSST_MATH_DETAIL_PARALLEL_HPP_
+#define PSST_MATH_DETAIL_PARALLEL_HPP_
+
+#include <psst/math/config.hpp>
+
+#include <algorithm>
+#include <exception>
+#include <thread>
+#include <vector>
+
+namespace psst {
+namespace math {
+namespace detail {
+
+/**
+ * Number of threads to use when the caller passes 0. The value is queried
+ * once, as the query is a system call on some platforms.
+ */
+inline std::size_t
+default_thread_count()
+{
+    static std::size_t const n = std::max(std::thread::hardware_concurrency(), 1u);
+    return n;
+}
+
+/**
+ * Split [0, count) into contiguous chunks of at least min_chunk items and
+ * call fn(begin, end) for each of the chunks in parallel. The calling thread
+ * processes the first chunk. If the range is too small to be split or a
+ * single thread is requested, fn(0, count) is called in place.
+ *
+ * An exception thrown from fn is rethrown after all the threads are joined.
+ * @param threads maximum number of threads, 0 means the hardware concurrency
+ */
+template <typename Function>
+void
+parallel_for(std::size_t count, std::size_t min_chunk, std::size_t threads, Function&& fn)
+{
+    if (count == 0)
+        return;
+    if (threads == 0)
+        threads = default_thread_count();
+    min_chunk                = std::max<std::size_t>(min_chunk, 1);
+    std::size_t const chunks = std::min(threads, (count + min_chunk - 1) / min_chunk);
+    if (chunks <= 1) {
+        fn(std::size_t{0}, count);
+        return;
+    }
+
+    std::size_t const               chunk = (count + chunks - 1) / chunks;
+    std::vector<std::thread>        workers;
+    std::vector<std::exception_ptr> errors(chunks);
+    workers.reserve(chunks - 1);
+    auto run = [&fn, &errors](std::size_t n, std::size_t begin, std::size_t end) {
+        try {
+            fn(begin, end);
+        } catch (...) {
+            errors[n] = std::current_exception();
+        }
+    };
+    for (std::size_t n = 1; n < chunks; ++n) {
+        std::size_t const begin = n * chunk;
+        std::size_t const end   = std::min(count, begin + chunk);
+        if (begin < end)
+            workers.emplace_back(run, n, begin, end);
+    }
+    run(0, 0, std::min(count, chunk));
+    for (auto& w : workers) {
+        w.join();
+    }
+    for (auto const& e : errors) {
+        if (e)
+            std::rethrow_exception(e);
+    }
+}
+
+}    // namespace detail
+}    // namespace math
+}    // namespace psst
+
+#endif /* PSST_MATH_DETAIL_PARALLEL_HPP_ */
@@ -65,14 +65,22 @@ struct shorter_sequence<std::integer_sequence<T, LHS...>, std::integer_sequence<
 template <typename T, typename U>
 using shorter_sequence_t = typename shorter_sequence<T, U>::type;
 
+namespace detail {
+
 template <std::size_t... V>
-struct min;
-template <std::size_t L, std::size_t R>
-struct min<L, R> : size_constant<(L < R) ? L : R> {};
-template <std::size_t L, std::size_t R, std::size_t... V>
-struct min<L, R, V...> : min<min<L, R>::value, min<V...>::value> {};
-template <std::size_t V>
-struct min<V> : size_constant<V> {};
+constexpr std::size_t
+min_value()
+{
+    static_assert(sizeof...(V) > 0, "At least one value is required");
+    std::size_t res = std::numeric_limits<std::size_t>::max();
+    ((res = V < res ? V : res), ...);
+    return res;
+}
+
+}    // namespace detail
+
+template <std::size_t... V>
+struct min : size_constant<detail::min_value<V...>()> {};
 template <std::size_t... V>
 constexpr std::size_t min_v = min<V...>::value;
 
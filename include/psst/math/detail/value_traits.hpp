@@ -23,6 +23,9 @@ namespace tag {
 struct scalar {};
 struct vector {};
 struct matrix {};
+struct dynamic_vector {};
+struct dynamic_matrix {};
+struct sparse_matrix {};
 
 }    // namespace tag
 
@@ -391,6 +394,51 @@ template <typename... T>
 using enable_if_matrix_expressions = std::enable_if_t<(is_matrix_expression_v<T> && ...)>;
 //@}
 
+//@{
+/**
+ * @name has_identity trait
+ * Identity is defined for square matrices and for the 3x4 affine transform.
+ */
+template <std::size_t RC, std::size_t CC>
+struct has_identity : utils::bool_constant<RC == CC> {};
+template <>
+struct has_identity<3, 4> : std::true_type {};
+template <std::size_t RC, std::size_t CC>
+constexpr bool has_identity_v = has_identity<RC, CC>::value;
+//@}
+
+//@{
+/** @name is_dynamic_vector_expression trait */
+template <typename T, typename = utils::void_t<>>
+struct is_dynamic_vector_expression : std::false_type {};
+template <typename T>
+struct is_dynamic_vector_expression<
+    T, std::enable_if_t<std::is_same<value_tag_t<std::decay_t<T>>, tag::dynamic_vector>::value>>
+    : std::true_type {};
+template <typename T>
+using is_dynamic_vector_expression_t = typename is_dynamic_vector_expression<std::decay_t<T>>::type;
+template <typename T>
+constexpr bool is_dynamic_vector_expression_v = is_dynamic_vector_expression_t<T>::value;
+template <typename T>
+using enable_if_dynamic_vector_expression = std::enable_if_t<is_dynamic_vector_expression_v<T>>;
+//@}
+
+//@{
+/** @name is_dynamic_matrix_expression trait */
+template <typename T, typename = utils::void_t<>>
+struct is_dynamic_matrix_expression : std::false_type {};
+template <typename T>
+struct is_dynamic_matrix_expression<
+    T, std::enable_if_t<std::is_same<value_tag_t<std::decay_t<T>>, tag::dynamic_matrix>::value>>
+    : std::true_type {};
+template <typename T>
+using is_dynamic_matrix_expression_t = typename is_dynamic_matrix_expression<std::decay_t<T>>::type;
+template <typename T>
+constexpr bool is_dynamic_matrix_expression_v = is_dynamic_matrix_expression_t<T>::value;
+template <typename T>
+using enable_if_dynamic_matrix_expression = std::enable_if_t<is_dynamic_matrix_expression_v<T>>;
+//@}
+
 //@{
 /** @name Components names trait */
 namespace detail {
@@ -100,11 +100,8 @@ private:
 /** @name Compare vector expressions */
 namespace detail {
 
-template <std::size_t N, typename LHS, typename RHS>
-struct vector_expression_cmp;
-
-template <typename LHS, typename RHS>
-struct vector_expression_cmp<0, LHS, RHS> {
+template <std::size_t Size, typename LHS, typename RHS>
+struct vector_expression_cmp {
     static_assert((traits::is_vector_expression_v<LHS> && traits::is_vector_expression_v<RHS>),
                   "Both sides to the comparison must be vector expressions");
     using lhs_type    = std::decay_t<LHS>;
@@ -114,25 +111,18 @@ struct vector_expression_cmp<0, LHS, RHS> {
     constexpr static int
     cmp(lhs_type const& lhs, rhs_type const& rhs)
     {
-        return traits_type::cmp(lhs.template at<0>(), rhs.template at<0>());
+        return cmp(lhs, rhs, std::make_index_sequence<Size>{});
     }
-};
 
-template <std::size_t N, typename LHS, typename RHS>
-struct vector_expression_cmp {
-    static_assert((traits::is_vector_expression_v<LHS> && traits::is_vector_expression_v<RHS>),
-                  "Both sides to the comparison must be vector expressions");
-    using prev_element = vector_expression_cmp<N - 1, LHS, RHS>;
-    using lhs_type     = typename prev_element::lhs_type;
-    using rhs_type     = typename prev_element::rhs_type;
-    using traits_type  = typename prev_element::traits_type;
+private:
+    template <std::size_t... Indexes>
     constexpr static int
-    cmp(lhs_type const& lhs, rhs_type const& rhs)
+    cmp(lhs_type const& lhs, rhs_type const& rhs, std::index_sequence<Indexes...>)
     {
-        auto res = prev_element::cmp(lhs, rhs);
-        if (res == 0) {
-            return traits_type::cmp(lhs.template at<N>(), rhs.template at<N>());
-        }
+        int res = 0;
+        // The fold stops at the first pair of elements that differ
+        (((res = traits_type::cmp(lhs.template at<Indexes>(), rhs.template at<Indexes>())) == 0)
+         && ...);
         return res;
     }
 };
@@ -147,7 +137,7 @@ struct vector_cmp : binary_scalar_expression<vector_cmp, LHS, RHS, int>,
                   "Both sides to the comparison must be vector expressions");
     static constexpr std::size_t cmp_size = utils::min_v<traits::vector_expression_size_v<LHS>,
                                                          traits::vector_expression_size_v<RHS>>;
-    using cmp_type                        = detail::vector_expression_cmp<cmp_size - 1, LHS, RHS>;
+    using cmp_type                        = detail::vector_expression_cmp<cmp_size, LHS, RHS>;
 
     using expression_base = binary_expression<LHS, RHS>;
     using expression_base::expression_base;
@@ -176,7 +166,7 @@ struct vector_eq : binary_scalar_expression<vector_eq, LHS, RHS, bool>,
                   "Both sides to the comparison must be vector expressions");
     static constexpr std::size_t cmp_size = utils::min_v<traits::vector_expression_size_v<LHS>,
                                                          traits::vector_expression_size_v<RHS>>;
-    using cmp_type                        = detail::vector_expression_cmp<cmp_size - 1, LHS, RHS>;
+    using cmp_type                        = detail::vector_expression_cmp<cmp_size, LHS, RHS>;
 
     using expression_base = binary_expression<LHS, RHS>;
     using expression_base::expression_base;
@@ -217,7 +207,7 @@ struct vector_less : binary_scalar_expression<vector_less, LHS, RHS, bool>,
                   "Both sides to the comparison must be vector expressions");
     static constexpr std::size_t cmp_size = utils::min_v<traits::vector_expression_size_v<LHS>,
                                                          traits::vector_expression_size_v<RHS>>;
-    using cmp_type                        = detail::vector_expression_cmp<cmp_size - 1, LHS, RHS>;
+    using cmp_type                        = detail::vector_expression_cmp<cmp_size, LHS, RHS>;
 
     using expression_base = binary_expression<LHS, RHS>;
     using expression_base::expression_base;
@@ -0,0 +1,684 @@
+/**
+ * Copyright 2019 Sergei A. Fedorov
+ * dual_quaternion.hpp
+ *
+ *  Created on: Feb 20, 2019
+ *      Author: ser-fedorov
+ */
+
+#ifndef PSST_MATH_DUAL_QUATERNION_HPP_
+#define PSST_MATH_DUAL_QUATERNION_HPP_
+
+#include <psst/math/quaternion.hpp>
+#include <psst/math/rotation.hpp>
+#include <psst/math/vector.hpp>
+
+#include <cmath>
+#include <limits>
+
+namespace psst {
+namespace math {
+
+namespace expr {
+inline namespace v {
+
+template <typename Expr>
+struct dual_quaternion_real_part;
+template <typename Expr>
+struct dual_quaternion_dual_part;
+
+}    // namespace v
+}    // namespace expr
+
+namespace components {
+
+/**
+ * Dual quaternion r + εd, the real part r is followed by the dual part d,
+ * both in w, x, y, z order. A unit dual quaternion represents a rigid
+ * transform, r is the rotation and d = 1/2 t r, where t is the translation.
+ */
+struct dual_wxyz {
+    static constexpr std::size_t min_components = 8;
+    static constexpr std::size_t max_components = 8;
+    // Index of the first component of the parts
+    static constexpr std::size_t real = 0;
+    static constexpr std::size_t dual = 4;
+};
+
+}    // namespace components
+
+namespace component_access {
+
+//@{
+/** @name Dual quaternion parts */
+template <typename VectorType, typename T>
+struct component_access<8, components::dual_wxyz, VectorType, T>
+    : basic_component_access<VectorType, T, components::dual_wxyz> {
+
+    using base_type = basic_component_access<VectorType, T, components::dual_wxyz>;
+
+    constexpr auto
+    real() const;
+    constexpr auto
+    dual() const;
+};
+//@}
+
+}    // namespace component_access
+
+template <typename T>
+using dual_quaternion = vector<T, 8, components::dual_wxyz>;
+
+namespace expr {
+inline namespace v {
+
+namespace detail {
+
+/**
+ * Component N of the product of two quaternions, that are stored in lhs and
+ * rhs starting from indexes L and R.
+ */
+template <std::size_t N, std::size_t L, std::size_t R, typename LHS, typename RHS>
+constexpr auto
+quaternion_product(LHS const& lhs, RHS const& rhs)
+{
+    auto const lw = lhs.template at<L>(), lx = lhs.template at<L + 1>(),
+               ly = lhs.template at<L + 2>(), lz = lhs.template at<L + 3>();
+    auto const rw = rhs.template at<R>(), rx = rhs.template at<R + 1>(),
+               ry = rhs.template at<R + 2>(), rz = rhs.template at<R + 3>();
+    if constexpr (N == components::wxyz::w) {
+        return lw * rw - lx * rx - ly * ry - lz * rz;
+    } else if constexpr (N == components::wxyz::x) {
+        return lw * rx + lx * rw + ly * rz - lz * ry;
+    } else if constexpr (N == components::wxyz::y) {
+        return lw * ry - lx * rz + ly * rw + lz * rx;
+    } else if constexpr (N == components::wxyz::z) {
+        return lw * rz + lx * ry - ly * rx + lz * rw;
+    }
+}
+
+}    // namespace detail
+
+//@{
+/** @name Real and dual parts */
+template <typename Expr>
+struct dual_quaternion_real_part
+    : unary_vector_expression<
+          dual_quaternion_real_part, Expr,
+          vector<traits::scalar_expression_result_t<Expr>, 4, components::wxyz>>,
+      unary_expression<Expr> {
+    using base_type = unary_vector_expression<
+        dual_quaternion_real_part, Expr,
+        vector<traits::scalar_expression_result_t<Expr>, 4, components::wxyz>>;
+    using expression_base = unary_expression<Expr>;
+    using expression_base::expression_base;
+
+    template <std::size_t N>
+    constexpr auto
+    at() const
+    {
+        static_assert(N < base_type::size, "Invalid quaternion component index");
+        return this->arg_.template at<N + components::dual_wxyz::real>();
+    }
+};
+
+template <typename Expr>
+struct dual_quaternion_dual_part
+    : unary_vector_expression<
+          dual_quaternion_dual_part, Expr,
+          vector<traits::scalar_expression_result_t<Expr>, 4, components::wxyz>>,
+      unary_expression<Expr> {
+    using base_type = unary_vector_expression<
+        dual_quaternion_dual_part, Expr,
+        vector<traits::scalar_expression_result_t<Expr>, 4, components::wxyz>>;
+    using expression_base = unary_expression<Expr>;
+    using expression_base::expression_base;
+
+    template <std::size_t N>
+    constexpr auto
+    at() const
+    {
+        static_assert(N < base_type::size, "Invalid quaternion component index");
+        return this->arg_.template at<N + components::dual_wxyz::dual>();
+    }
+};
+//@}
+
+//@{
+/** @name Composition of rigid transforms */
+/**
+ * (r1 + εd1)(r2 + εd2) = r1r2 + ε(r1d2 + d1r2), the rhs transform is
+ * applied first.
+ */
+template <typename LHS, typename RHS>
+struct vector_vector_multiply<components::dual_wxyz, LHS, RHS>
+    : binary_vector_expression_components<vector_vector_multiply, components::dual_wxyz, LHS,
+                                          RHS>,
+      binary_expression<LHS, RHS> {
+    using base_type = binary_vector_expression_components<vector_vector_multiply,
+                                                          components::dual_wxyz, LHS, RHS>;
+    using value_type      = typename base_type::value_type;
+    using expression_base = binary_expression<LHS, RHS>;
+    using expression_base::expression_base;
+
+    template <std::size_t N>
+    constexpr value_type
+    at() const
+    {
+        static_assert(N < base_type::size, "Invalid dual quaternion component index");
+        constexpr std::size_t r = components::dual_wxyz::real;
+        constexpr std::size_t d = components::dual_wxyz::dual;
+        if constexpr (N < d) {
+            return detail::quaternion_product<N, r, r>(this->lhs_, this->rhs_);
+        } else {
+            return detail::quaternion_product<N - d, r, d>(this->lhs_, this->rhs_)
+                   + detail::quaternion_product<N - d, d, r>(this->lhs_, this->rhs_);
+        }
+    }
+};
+//@}
+
+//@{
+/**
+ * Unit dual quaternion. The dual number norm is |r| + ε(r·d)/|r|, so
+ *
+ *     r' = r / |r|
+ *     d' = d / |r| - r (r·d) / |r|^3
+ *
+ * and the dual part of the result is orthogonal to the real part.
+ */
+template <typename Expr>
+struct vector_normalize<components::dual_wxyz, Expr>
+    : unary_vector_expression_components<vector_normalize, components::dual_wxyz, Expr>,
+      unary_expression<Expr> {
+    using base_type
+        = unary_vector_expression_components<vector_normalize, components::dual_wxyz, Expr>;
+    using value_type      = typename base_type::value_type;
+    using expression_base = unary_expression<Expr>;
+    using expression_base::expression_base;
+
+    template <std::size_t N>
+    constexpr value_type
+    at() const
+    {
+        static_assert(N < base_type::size, "Invalid dual quaternion component index");
+        using std::sqrt;
+        constexpr std::size_t d   = components::dual_wxyz::dual;
+        auto const&           arg = this->arg_;
+
+        value_type const mag_sq = arg.template at<0>() * arg.template at<0>()
+                                  + arg.template at<1>() * arg.template at<1>()
+                                  + arg.template at<2>() * arg.template at<2>()
+                                  + arg.template at<3>() * arg.template at<3>();
+        if (mag_sq == 0)
+            throw std::runtime_error("Cannot normalise a dual quaternion with zero real part");
+        value_type const inv = 1 / sqrt(mag_sq);
+        if constexpr (N < d) {
+            return arg.template at<N>() * inv;
+        } else {
+            value_type const dot = arg.template at<0>() * arg.template at<d>()
+                                   + arg.template at<1>() * arg.template at<d + 1>()
+                                   + arg.template at<2>() * arg.template at<d + 2>()
+                                   + arg.template at<3>() * arg.template at<d + 3>();
+            return (arg.template at<N>() - arg.template at<N - d>() * dot / mag_sq) * inv;
+        }
+    }
+};
+//@}
+
+//@{
+/** @name Translation of a rigid transform */
+/**
+ * t = 2 d r*, only the vector part of the product is computed. The dual
+ * quaternion is expected to be normalized.
+ */
+template <typename Expr>
+struct dual_quaternion_translation
+    : unary_vector_expression<
+          dual_quaternion_translation, Expr,
+          vector<traits::scalar_expression_result_t<Expr>, 3, components::xyzw>>,
+      unary_expression<Expr> {
+    using base_type = unary_vector_expression<
+        dual_quaternion_translation, Expr,
+        vector<traits::scalar_expression_result_t<Expr>, 3, components::xyzw>>;
+    using value_type      = typename base_type::value_type;
+    using expression_base = unary_expression<Expr>;
+    using expression_base::expression_base;
+
+    template <std::size_t N>
+    constexpr value_type
+    at() const
+    {
+        static_assert(N < base_type::size, "Invalid vector component index");
+        constexpr std::size_t d = components::dual_wxyz::dual;
+        constexpr std::size_t a = (N + 1) % 3;
+        constexpr std::size_t b = (N + 2) % 3;
+
+        auto const& q = this->arg_;
+        // 2 (rw dv - dw rv + rv x dv)
+        return 2
+               * (q.template at<0>() * q.template at<d + N + 1>()
+                  - q.template at<d>() * q.template at<N + 1>()
+                  + q.template at<a + 1>() * q.template at<d + b + 1>()
+                  - q.template at<b + 1>() * q.template at<d + a + 1>());
+    }
+};
+
+template <typename Expr, typename = traits::enable_for_components<Expr, components::dual_wxyz>>
+constexpr auto
+translation(Expr&& expr)
+{
+    return make_unary_expression<dual_quaternion_translation>(std::forward<Expr>(expr));
+}
+//@}
+
+//@{
+/** @name Transform a point by a unit dual quaternion */
+/**
+ * The point is rotated by the real part and then translated, the same as
+ * the vector part of q (1 + εp) q*, but without the dual quaternion
+ * products. The point is evaluated when the expression is built, as the
+ * rotation is.
+ */
+template <typename DualQuaternion, typename Vector>
+struct dual_quaternion_transform
+    : binary_vector_expression<dual_quaternion_transform, DualQuaternion, Vector,
+                               traits::vector_expression_result_t<Vector>> {
+    using base_type = binary_vector_expression<dual_quaternion_transform, DualQuaternion, Vector,
+                                               traits::vector_expression_result_t<Vector>>;
+    static_assert(base_type::size == 3,
+                  "Only a 3D point can be transformed by a dual quaternion");
+    using value_type           = typename base_type::value_type;
+    using result_type          = typename base_type::result_type;
+    using dual_quaternion_type = std::decay_t<DualQuaternion>;
+    using vector_type          = std::decay_t<Vector>;
+
+    dual_quaternion_transform(dual_quaternion_type const& q, vector_type const& p)
+        : value_{make_binary_expression<quaternion_rotate>(
+                     make_unary_expression<dual_quaternion_real_part>(q), p)
+                 + make_unary_expression<dual_quaternion_translation>(q)}
+    {}
+
+    template <std::size_t N>
+    constexpr value_type
+    at() const
+    {
+        static_assert(N < base_type::size, "Invalid vector component index");
+        return value_.template at<N>();
+    }
+
+private:
+    result_type value_;
+};
+
+template <typename DualQuaternion, typename Vector,
+          typename = traits::enable_for_components<DualQuaternion, components::dual_wxyz>,
+          typename = traits::enable_if_vector_expression<Vector>>
+constexpr auto
+transform_point(DualQuaternion&& q, Vector&& p)
+{
+    return make_binary_expression<dual_quaternion_transform>(std::forward<DualQuaternion>(q),
+                                                             std::forward<Vector>(p));
+}
+//@}
+
+//@{
+/** @name Rigid transform from a rotation and a translation */
+/**
+ * q = r + ε 1/2 t r, the rotation is applied first.
+ */
+template <typename Quaternion, typename Vector,
+          typename = traits::enable_for_components<Quaternion, components::wxyz>,
+          typename = traits::enable_if_vector_expression<Vector>>
+constexpr auto
+make_dual_quaternion(Quaternion&& rotation, Vector&& translation)
+{
+    using quaternion_type = traits::vector_expression_result_t<Quaternion>;
+    using value_type      = typename quaternion_type::value_type;
+    static_assert(traits::vector_expression_size_v<Vector> == 3,
+                  "Translation must be a 3D vector");
+
+    quaternion_type const r{std::forward<Quaternion>(rotation)};
+    value_type const      tx = translation.template at<0>();
+    value_type const      ty = translation.template at<1>();
+    value_type const      tz = translation.template at<2>();
+    // 1/2 (0, t) r
+    return dual_quaternion<value_type>{
+        r[0],
+        r[1],
+        r[2],
+        r[3],
+        (-tx * r[1] - ty * r[2] - tz * r[3]) / 2,
+        (tx * r[0] + ty * r[3] - tz * r[2]) / 2,
+        (-tx * r[3] + ty * r[0] + tz * r[1]) / 2,
+        (tx * r[2] - ty * r[1] + tz * r[0]) / 2};
+}
+//@}
+
+//@{
+/** @name Screw linear interpolation */
+namespace detail {
+
+/**
+ * Interpolation of unit dual quaternions with a constant linear and angular
+ * velocity, start (start* end)^percent. The power is taken by scaling the
+ * screw parameters of the relative transform: the angle and the pitch. The
+ * interpolation takes the shortest path.
+ */
+template <typename T>
+vector<T, 8, components::dual_wxyz>
+sclerp(vector<T, 8, components::dual_wxyz> const& start,
+       vector<T, 8, components::dual_wxyz> const& end, T percent)
+{
+    using std::acos;
+    using std::cos;
+    using std::sin;
+    using std::sqrt;
+    using dual_quaternion_type = vector<T, 8, components::dual_wxyz>;
+
+    dual_quaternion_type diff = conjugate(start) * end;
+    if (diff[0] < 0) {
+        // The same transform, the rotation around the shorter arc
+        diff = diff * T{-1};
+    }
+    T const rw = diff[0], dw = diff[4];
+    T const vr_sq = diff[1] * diff[1] + diff[2] * diff[2] + diff[3] * diff[3];
+    if (vr_sq < std::numeric_limits<T>::epsilon() * std::numeric_limits<T>::epsilon()) {
+        // No rotation, interpolate the translation only
+        return start
+               * dual_quaternion_type{1, 0, 0, 0, 0, diff[5] * percent, diff[6] * percent,
+                                      diff[7] * percent};
+    }
+    T const inv   = 1 / sqrt(vr_sq);
+    T const angle = 2 * acos(rw < 1 ? rw : T{1});
+    T const pitch = -2 * dw * inv;
+    // Screw axis direction and moment
+    T const l[3]{diff[1] * inv, diff[2] * inv, diff[3] * inv};
+    T const m[3]{(diff[5] - l[0] * pitch * rw / 2) * inv, (diff[6] - l[1] * pitch * rw / 2) * inv,
+                 (diff[7] - l[2] * pitch * rw / 2) * inv};
+
+    T const half  = angle * percent / 2;
+    T const p     = pitch * percent;
+    T const sin_a = sin(half);
+    T const cos_a = cos(half);
+    return start
+           * dual_quaternion_type{cos_a,
+                                  l[0] * sin_a,
+                                  l[1] * sin_a,
+                                  l[2] * sin_a,
+                                  -p / 2 * sin_a,
+                                  m[0] * sin_a + p / 2 * cos_a * l[0],
+                                  m[1] * sin_a + p / 2 * cos_a * l[1],
+                                  m[2] * sin_a + p / 2 * cos_a * l[2]};
+}
+
+}    // namespace detail
+
+template <typename Start, typename End, typename U,
+          typename = traits::enable_for_components<Start, components::dual_wxyz>,
+          typename = traits::enable_for_components<End, components::dual_wxyz>,
+          typename = std::enable_if_t<traits::is_scalar_v<U>>>
+auto
+sclerp(Start&& start, End&& end, U percent)
+{
+    using result_type = traits::vector_expression_result_t<Start, End>;
+    using value_type  = typename result_type::value_type;
+    return detail::sclerp<value_type>(result_type(std::forward<Start>(start)),
+                                      result_type(std::forward<End>(end)),
+                                      static_cast<value_type>(percent));
+}
+//@}
+
+//@{
+/** @name Dual quaternion to rigid transform matrix conversion */
+template <typename T, typename U, typename Components, typename Expression>
+struct conversion<vector<T, 8, components::dual_wxyz>, matrix<U, 4, 4, Components>, Expression>
+    : unary_expression<Expression> {
+    using expression_base = unary_expression<Expression>;
+    using expression_base::expression_base;
+
+    auto
+    result() const
+    {
+        matrix<U, 4, 4, Components> res;
+        auto const                  r = this->arg_.real();
+        math::detail::quaternion_to_matrix<T>(r.w(), r.x(), r.y(), r.z(), res);
+        vector<T, 3> const t = translation(this->arg_);
+        U*                 m = res.data();
+        m[3]                 = t[0];
+        m[7]                 = t[1];
+        m[11]                = t[2];
+        return res;
+    }
+};
+
+/**
+ * The matrix must not contain scale, the translation is in the last column.
+ */
+template <typename T, typename U, typename Components, typename Expression>
+struct conversion<matrix<T, 4, 4, Components>, vector<U, 8, components::dual_wxyz>, Expression>
+    : unary_expression<Expression> {
+    using expression_base = unary_expression<Expression>;
+    using expression_base::expression_base;
+
+    auto
+    result() const
+    {
+        auto const& m = this->arg_;
+        return make_dual_quaternion(math::detail::matrix_expression_to_quaternion<U>(
+                                        minor<3, 3>(m), std::make_index_sequence<9>{}),
+                                    vector<U, 3>{static_cast<U>(m.template element<0, 3>()),
+                                                 static_cast<U>(m.template element<1, 3>()),
+                                                 static_cast<U>(m.template element<2, 3>())});
+    }
+};
+//@}
+
+}    // namespace v
+}    // namespace expr
+
+namespace component_access {
+
+template <typename VectorType, typename T>
+constexpr auto
+component_access<8, components::dual_wxyz, VectorType, T>::real() const
+{
+    return expr::make_unary_expression<expr::v::dual_quaternion_real_part>(base_type::rebind());
+}
+
+template <typename VectorType, typename T>
+constexpr auto
+component_access<8, components::dual_wxyz, VectorType, T>::dual() const
+{
+    return expr::make_unary_expression<expr::v::dual_quaternion_dual_part>(base_type::rebind());
+}
+
+}    // namespace component_access
+
+namespace detail {
+
+/**
+ * Rotate and translate a point by a dual quaternion given by its parts. The
+ * real part doesn't have to be normalized, scale is 1 / |r|^2. Both the
+ * rotation and the translation are quadratic in the dual quaternion, so the
+ * scale is applied instead of normalizing the parts.
+ */
+template <typename T, typename U>
+void
+dual_quaternion_apply(T const (&r)[4], T const (&d)[4], T scale, U const* src, U* dst)
+{
+    U const vx = src[0], vy = src[1], vz = src[2];
+    U const tx = 2 * scale * (r[2] * vz - r[3] * vy);
+    U const ty = 2 * scale * (r[3] * vx - r[1] * vz);
+    U const tz = 2 * scale * (r[1] * vy - r[2] * vx);
+    // Translation 2 (rw dv - dw rv + rv x dv)
+    U const px = 2 * scale * (r[0] * d[1] - d[0] * r[1] + r[2] * d[3] - r[3] * d[2]);
+    U const py = 2 * scale * (r[0] * d[2] - d[0] * r[2] + r[3] * d[1] - r[1] * d[3]);
+    U const pz = 2 * scale * (r[0] * d[3] - d[0] * r[3] + r[1] * d[2] - r[2] * d[1]);
+    dst[0]     = vx + r[0] * tx + r[2] * tz - r[3] * ty + px;
+    dst[1]     = vy + r[0] * ty + r[3] * tx - r[1] * tz + py;
+    dst[2]     = vz + r[0] * tz + r[1] * ty - r[2] * tx + pz;
+}
+
+template <typename T, typename U>
+void
+dual_quaternion_rotate(T const (&r)[4], T scale, U const* src, U* dst)
+{
+    U const vx = src[0], vy = src[1], vz = src[2];
+    U const tx = 2 * scale * (r[2] * vz - r[3] * vy);
+    U const ty = 2 * scale * (r[3] * vx - r[1] * vz);
+    U const tz = 2 * scale * (r[1] * vy - r[2] * vx);
+    dst[0]     = vx + r[0] * tx + r[2] * tz - r[3] * ty;
+    dst[1]     = vy + r[0] * ty + r[3] * tx - r[1] * tz;
+    dst[2]     = vz + r[0] * tz + r[1] * ty - r[2] * tx;
+}
+
+/**
+ * Dual quaternion linear blending, weighted sum of the dual quaternions. A
+ * dual quaternion in the opposite hemisphere to the first one is negated,
+ * so that the blend doesn't take the long way around. The sum is not
+ * normalized.
+ * @return squared magnitude of the real part of the sum
+ */
+template <std::size_t Count, typename T, typename Indexes>
+T
+blend_dual_quaternions(vector<T, 8, components::dual_wxyz> const* palette, Indexes const& index,
+                       T const* weight, std::size_t count, T (&r)[4], T (&d)[4])
+{
+    auto const& first = palette[index[0]];
+    for (std::size_t k = 0; k < 4; ++k) {
+        r[k] = first[k] * weight[0];
+        d[k] = first[k + 4] * weight[0];
+    }
+    std::size_t const n = Count > 0 ? Count : count;
+    for (std::size_t j = 1; j < n; ++j) {
+        auto const& q   = palette[index[j]];
+        T const     dot = first[0] * q[0] + first[1] * q[1] + first[2] * q[2] + first[3] * q[3];
+        T const     w   = dot < 0 ? -weight[j] : weight[j];
+        for (std::size_t k = 0; k < 4; ++k) {
+            r[k] += q[k] * w;
+            d[k] += q[k + 4] * w;
+        }
+    }
+    return r[0] * r[0] + r[1] * r[1] + r[2] * r[2] + r[3] * r[3];
+}
+
+struct identity_index {
+    constexpr std::size_t
+    operator[](std::size_t i) const
+    {
+        return i;
+    }
+};
+
+}    // namespace detail
+
+//@{
+/** @name Dual quaternion linear blending */
+/**
+ * Blend count unit dual quaternions with the weights. The weights are
+ * expected to sum up to one, the result is a rigid transform without the
+ * candy wrapper artifacts of linear matrix blending.
+ */
+template <typename T>
+dual_quaternion<T>
+blend(dual_quaternion<T> const* q, T const* weights, std::size_t count)
+{
+    if (count == 0)
+        throw std::runtime_error("Cannot blend zero dual quaternions");
+    T r[4], d[4];
+    detail::blend_dual_quaternions<0>(q, detail::identity_index{}, weights, count, r, d);
+    // The real and dual parts are not orthogonal after the blend
+    return normalize(dual_quaternion<T>{r[0], r[1], r[2], r[3], d[0], d[1], d[2], d[3]});
+}
+//@}
+
+//@{
+/** @name Bulk transform */
+/**
+ * Transform a contiguous range of points by a unit dual quaternion. The
+ * source and the destination may be the same range.
+ */
+template <typename T, typename U, typename Components>
+void
+transform_point(dual_quaternion<T> const& q, vector<U, 3, Components> const* src,
+                std::size_t count, vector<U, 3, Components>* dst)
+{
+    T const r[4]{q[0], q[1], q[2], q[3]};
+    T const d[4]{q[4], q[5], q[6], q[7]};
+    for (std::size_t i = 0; i < count; ++i) {
+        U p[3]{src[i][0], src[i][1], src[i][2]};
+        detail::dual_quaternion_apply(r, d, T{1}, p, p);
+        dst[i][0] = p[0];
+        dst[i][1] = p[1];
+        dst[i][2] = p[2];
+    }
+}
+//@}
+
+//@{
+/** @name Dual quaternion skinning */
+/**
+ * Skin vertices with a palette of bone transforms. Each vertex is affected
+ * by Influences bones, bones and weights arrays hold Influences elements per
+ * vertex. The weights of a vertex are expected to sum up to one, unused
+ * influences have zero weight. The transforms of the bones are blended with
+ * dual quaternion linear blending and the blend is applied to the vertex.
+ *
+ * A bone takes 8 values instead of 12 or 16 of a matrix palette. The loop
+ * doesn't depend on previous iterations and the source and the destination
+ * may be the same range.
+ */
+template <std::size_t Influences, typename T, typename Index, typename Components>
+void
+skin(dual_quaternion<T> const* palette, Index const* bones, T const* weights,
+     vector<T, 3, Components> const* src, std::size_t count, vector<T, 3, Components>* dst)
+{
+    static_assert(Influences > 0, "A vertex must be affected by at least one bone");
+    for (std::size_t i = 0; i < count; ++i) {
+        T       r[4], d[4];
+        T const scale = 1 / detail::blend_dual_quaternions<Influences>(
+                                palette, bones + i * Influences, weights + i * Influences,
+                                Influences, r, d);
+        T p[3]{src[i][0], src[i][1], src[i][2]};
+        detail::dual_quaternion_apply(r, d, scale, p, p);
+        dst[i][0] = p[0];
+        dst[i][1] = p[1];
+        dst[i][2] = p[2];
+    }
+}
+
+/**
+ * Skin vertex positions and normals, the normals are only rotated.
+ */
+template <std::size_t Influences, typename T, typename Index, typename Components>
+void
+skin(dual_quaternion<T> const* palette, Index const* bones, T const* weights,
+     vector<T, 3, Components> const* positions, vector<T, 3, Components> const* normals,
+     std::size_t count, vector<T, 3, Components>* dst_positions,
+     vector<T, 3, Components>* dst_normals)
+{
+    static_assert(Influences > 0, "A vertex must be affected by at least one bone");
+    for (std::size_t i = 0; i < count; ++i) {
+        T       r[4], d[4];
+        T const scale = 1 / detail::blend_dual_quaternions<Influences>(
+                                palette, bones + i * Influences, weights + i * Influences,
+                                Influences, r, d);
+        T p[3]{positions[i][0], positions[i][1], positions[i][2]};
+        T n[3]{normals[i][0], normals[i][1], normals[i][2]};
+        detail::dual_quaternion_apply(r, d, scale, p, p);
+        detail::dual_quaternion_rotate(r, scale, n, n);
+        dst_positions[i][0] = p[0];
+        dst_positions[i][1] = p[1];
+        dst_positions[i][2] = p[2];
+        dst_normals[i][0]   = n[0];
+        dst_normals[i][1]   = n[1];
+        dst_normals[i][2]   = n[2];
+    }
+}
+//@}
+
+}    // namespace math
+}    // namespace psst
+
+#endif /* PSST_MATH_DUAL_QUATERNION_HPP_ */
@@ -0,0 +1,464 @@
+/**
+ * Copyright 2019 Sergei A. Fedorov
+ * dynamic_matrix.hpp
+ *
+ *  Created on: Mar 4, 2019
+ *      Author: ser-fedorov
+ */
+
+#ifndef PSST_MATH_DYNAMIC_MATRIX_HPP_
+#define PSST_MATH_DYNAMIC_MATRIX_HPP_
+
+#include <psst/math/detail/gemm.hpp>
+#include <psst/math/dynamic_vector.hpp>
+#include <psst/math/matrix.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <initializer_list>
+#include <stdexcept>
+#include <utility>
+
+namespace psst {
+namespace math {
+
+/**
+ * Matrix of a size known at run time, the values are stored by rows. The
+ * matrix is used in expressions with other dynamic matrices and vectors and
+ * with fixed size matrices of the same size. The products are computed by
+ * blocked kernels, see detail/dynamic_kernels.hpp.
+ */
+template <typename T>
+struct dynamic_matrix : expr::dynamic_matrix_expression<dynamic_matrix<T>, T> {
+    using this_type        = dynamic_matrix<T>;
+    using value_traits     = traits::scalar_value_traits<T>;
+    using value_type       = typename value_traits::value_type;
+    using lvalue_reference = typename value_traits::lvalue_reference;
+    using const_reference  = typename value_traits::const_reference;
+    using pointer          = typename value_traits::pointer;
+    using const_pointer    = typename value_traits::const_pointer;
+    using iterator         = pointer;
+    using const_iterator   = const_pointer;
+    using size_type        = std::size_t;
+    using row_type         = dynamic_vector<T>;
+    using col_type         = dynamic_vector<T>;
+    using init_list        = std::initializer_list<std::initializer_list<value_type>>;
+
+    dynamic_matrix() = default;
+    /**
+     * Matrix of rows x cols set to the same value
+     */
+    dynamic_matrix(size_type rows, size_type cols, value_type val = value_type{0})
+        : rows_{rows}, cols_{cols}, data_{rows * cols}
+    {
+        std::fill(begin(), end(), val);
+    }
+    /**
+     * Matrix of rows x cols from the values stored by rows
+     */
+    dynamic_matrix(size_type rows, size_type cols, const_pointer p)
+        : rows_{rows}, cols_{cols}, data_{rows * cols}
+    {
+        std::copy(p, p + rows * cols, begin());
+    }
+    /**
+     * Matrix from a list of rows
+     * @throws std::runtime_error if the rows are of different sizes
+     */
+    dynamic_matrix(init_list const& args)
+        : rows_{args.size()},
+          cols_{args.size() ? args.begin()->size() : 0},
+          data_{rows_ * cols_}
+    {
+        auto p = begin();
+        for (auto const& row : args) {
+            if (row.size() != cols_)
+                throw std::runtime_error{"Dynamic matrix rows must be of the same size"};
+            p = std::copy(row.begin(), row.end(), p);
+        }
+    }
+    /**
+     * Construct from a dynamic or a fixed size matrix expression
+     */
+    template <typename Expression,
+              typename = std::enable_if_t<expr::d::detail::is_matrix_operand_v<Expression>>>
+    /* implicit */ dynamic_matrix(Expression const& rhs)
+    {
+        evaluate(rhs);
+    }
+    /**
+     * Fill the matrix with rows x cols values of an unbounded matrix
+     * expression, e.g. random_matrix_data
+     */
+    template <typename Expression, typename = math::traits::enable_if_matrix_expression<Expression>>
+    dynamic_matrix(size_type rows, size_type cols, Expression const& rhs)
+        : rows_{rows}, cols_{cols}, data_{rows * cols}
+    {
+        static_assert(Expression::size == utils::npos_v,
+                      "Only an unbounded matrix expression can be sampled");
+        std::generate(begin(), end(), [&rhs]() { return rhs.template element<0, 0>(); });
+    }
+
+    template <typename Expression,
+              typename = std::enable_if_t<expr::d::detail::is_matrix_operand_v<Expression>>>
+    this_type&
+    operator=(Expression const& rhs)
+    {
+        if constexpr (!expr::d::detail::elementwise_v<Expression>) {
+            // The matrix can be an argument of the expression
+            if (expr::references(rhs, this, this + 1)) {
+                return *this = this_type(rhs);
+            }
+        }
+        return evaluate(rhs);
+    }
+    /**
+     * Assignment that evaluates an expression directly into the matrix
+     * storage without checking if the expression references the matrix.
+     * @code
+     * c.noalias() = a * b;
+     * @endcode
+     */
+    expr::noalias_assignment<this_type>
+    noalias()
+    {
+        return expr::noalias_assignment<this_type>{*this};
+    }
+
+    static this_type
+    identity(size_type rows, size_type cols)
+    {
+        this_type res(rows, cols);
+        for (size_type i = 0; i < std::min(rows, cols); ++i) {
+            res.element(i, i) = value_type{1};
+        }
+        return res;
+    }
+    static this_type
+    identity(size_type size)
+    {
+        return identity(size, size);
+    }
+
+    size_type
+    rows() const
+    {
+        return rows_;
+    }
+    size_type
+    cols() const
+    {
+        return cols_;
+    }
+    size_type
+    size() const
+    {
+        return data_.size();
+    }
+    bool
+    empty() const
+    {
+        return data_.size() == 0;
+    }
+    /**
+     * Change the size of the matrix keeping the values of the rows and
+     * columns that remain, the new values are zero
+     */
+    void
+    resize(size_type rows, size_type cols)
+    {
+        if (cols == cols_) {
+            data_.resize(rows * cols);
+        } else {
+            this_type tmp(rows, cols);
+            for (size_type r = 0; r < std::min(rows, rows_); ++r) {
+                std::copy(row_begin(r), row_begin(r) + std::min(cols, cols_), tmp.row_begin(r));
+            }
+            *this = std::move(tmp);
+        }
+        rows_ = rows;
+        cols_ = cols;
+    }
+    void
+    clear()
+    {
+        rows_ = cols_ = 0;
+        data_.clear();
+    }
+
+    pointer
+    data()
+    {
+        return data_.data();
+    }
+    const_pointer
+    data() const
+    {
+        return data_.data();
+    }
+
+    iterator
+    begin()
+    {
+        return data();
+    }
+    const_iterator
+    begin() const
+    {
+        return cbegin();
+    }
+    const_iterator
+    cbegin() const
+    {
+        return data();
+    }
+
+    iterator
+    end()
+    {
+        return data() + size();
+    }
+    const_iterator
+    end() const
+    {
+        return cend();
+    }
+    const_iterator
+    cend() const
+    {
+        return data() + size();
+    }
+
+    iterator
+    row_begin(size_type r)
+    {
+        assert(r < rows_);
+        return data() + r * cols_;
+    }
+    const_iterator
+    row_begin(size_type r) const
+    {
+        assert(r < rows_);
+        return data() + r * cols_;
+    }
+
+    lvalue_reference
+    element(size_type r, size_type c)
+    {
+        assert(c < cols_);
+        return row_begin(r)[c];
+    }
+    const_reference
+    element(size_type r, size_type c) const
+    {
+        assert(c < cols_);
+        return row_begin(r)[c];
+    }
+
+    /**
+     * Pointer to the row values, for the mtx[r][c] access
+     */
+    pointer operator[](size_type r)
+    {
+        return row_begin(r);
+    }
+    const_pointer operator[](size_type r) const
+    {
+        return row_begin(r);
+    }
+
+    row_type
+    row(size_type r) const
+    {
+        return row_type(row_begin(r), cols_);
+    }
+    col_type
+    col(size_type c) const
+    {
+        assert(c < cols_);
+        col_type res(rows_);
+        for (size_type r = 0; r < rows_; ++r) {
+            res[r] = element(r, c);
+        }
+        return res;
+    }
+
+    /**
+     * Copy of R x C values starting at row and col as a fixed size matrix
+     */
+    template <std::size_t R, std::size_t C>
+    matrix<T, R, C>
+    block(size_type row, size_type col) const
+    {
+        assert(row + R <= rows_ && col + C <= cols_);
+        matrix<T, R, C> res;
+        for (size_type r = 0; r < R; ++r) {
+            std::copy(row_begin(row + r) + col, row_begin(row + r) + col + C, res[r].begin());
+        }
+        return res;
+    }
+    /**
+     * Set the values starting at row and col from a fixed size matrix
+     * expression
+     */
+    template <typename Expression, typename = math::traits::enable_if_matrix_expression<Expression>>
+    void
+    set_block(size_type row, size_type col, Expression const& rhs)
+    {
+        using matrix_type = typename Expression::result_type;
+        assert(row + matrix_type::rows <= rows_ && col + matrix_type::cols <= cols_);
+        matrix_type const m = rhs;
+        for (size_type r = 0; r < matrix_type::rows; ++r) {
+            std::copy(m[r].begin(), m[r].end(), row_begin(row + r) + col);
+        }
+    }
+
+    //@{
+    /**
+     * @name Compound assignment, modifies the matrix in place. A product is
+     * added by its kernel unless it references the matrix.
+     */
+    template <typename Expression,
+              typename = std::enable_if_t<expr::d::detail::is_matrix_operand_v<Expression>>>
+    this_type&
+    operator+=(Expression const& rhs)
+    {
+        if constexpr (!expr::d::detail::elementwise_v<Expression>) {
+            // The matrix can be an argument of the expression
+            if (expr::references(rhs, this, this + 1)) {
+                return *this += this_type(rhs);
+            }
+        }
+        return add(rhs);
+    }
+    template <typename Expression,
+              typename = std::enable_if_t<expr::d::detail::is_matrix_operand_v<Expression>>>
+    this_type&
+    operator-=(Expression const& rhs)
+    {
+        if constexpr (!expr::d::detail::elementwise_v<Expression>) {
+            // The matrix can be an argument of the expression
+            if (expr::references(rhs, this, this + 1)) {
+                return *this -= this_type(rhs);
+            }
+        }
+        return subtract(rhs);
+    }
+    template <typename U, typename = math::traits::enable_if_scalar_value<U>>
+    this_type&
+    operator*=(U s)
+    {
+        for (auto& v : *this) {
+            v *= s;
+        }
+        return *this;
+    }
+    template <typename U, typename = math::traits::enable_if_scalar_value<U>>
+    this_type&
+    operator/=(U s)
+    {
+        for (auto& v : *this) {
+            v /= s;
+        }
+        return *this;
+    }
+    //@}
+
+    this_type
+    transpose() const
+    {
+        return expr::transpose(*this);
+    }
+
+private:
+    friend class expr::noalias_assignment<this_type>;
+
+    template <typename Expression>
+    this_type&
+    evaluate(Expression const& rhs)
+    {
+        decltype(auto) arg = expr::d::detail::dynamic_value(rhs);
+        data_.allocate(arg.rows() * arg.cols());
+        rows_ = arg.rows();
+        cols_ = arg.cols();
+        expr::d::detail::evaluate(arg, data());
+        return *this;
+    }
+    template <typename Expression>
+    this_type&
+    add(Expression const& rhs)
+    {
+        if constexpr (expr::d::detail::has_accumulate<Expression>::value
+                      && std::is_same<typename Expression::value_type, T>::value) {
+            expr::d::detail::check_same_size(*this, rhs);
+            rhs.evaluate(data(), math::detail::kernel_store::add);
+        } else {
+            decltype(auto) arg = expr::d::detail::dynamic_operand(rhs);
+            expr::d::detail::check_same_size(*this, arg);
+            for (size_type r = 0; r < rows_; ++r) {
+                pointer const row = row_begin(r);
+                for (size_type c = 0; c < cols_; ++c) {
+                    row[c] += arg.element(r, c);
+                }
+            }
+        }
+        return *this;
+    }
+    template <typename Expression>
+    this_type&
+    subtract(Expression const& rhs)
+    {
+        if constexpr (expr::d::detail::has_accumulate<Expression>::value
+                      && std::is_same<typename Expression::value_type, T>::value) {
+            expr::d::detail::check_same_size(*this, rhs);
+            rhs.evaluate(data(), math::detail::kernel_store::subtract);
+        } else {
+            decltype(auto) arg = expr::d::detail::dynamic_operand(rhs);
+            expr::d::detail::check_same_size(*this, arg);
+            for (size_type r = 0; r < rows_; ++r) {
+                pointer const row = row_begin(r);
+                for (size_type c = 0; c < cols_; ++c) {
+                    row[c] -= arg.element(r, c);
+                }
+            }
+        }
+        return *this;
+    }
+
+private:
+    size_type                  rows_ = 0;
+    size_type                  cols_ = 0;
+    detail::dynamic_storage<T> data_;
+};
+
+/**
+ * res = lhs * rhs, the rows of the large products are split between the
+ * threads of the packed matrix product kernel. The operators compute the
+ * products in the calling thread.
+ * @param threads maximum number of threads, 0 means the hardware concurrency
+ * @throws std::runtime_error if lhs.cols() is not rhs.rows() or res is an
+ *         operand
+ */
+template <typename T>
+void
+multiply(dynamic_matrix<T> const& lhs, dynamic_matrix<T> const& rhs, dynamic_matrix<T>& res,
+         std::size_t threads = 1)
+{
+    if (lhs.cols() != rhs.rows())
+        throw std::runtime_error{"Left hand columns must be equal to right hand rows"};
+    if (&res == &lhs || &res == &rhs)
+        throw std::runtime_error{"Matrix product cannot be computed in place"};
+    res.resize(lhs.rows(), rhs.cols());
+    if (std::min({lhs.rows(), lhs.cols(), rhs.cols()}) >= config::gemm_min_size) {
+        detail::parallel_gemm_kernel(lhs.data(), rhs.data(), res.data(), lhs.rows(),
+                                     lhs.cols(), rhs.cols(), threads);
+    } else {
+        detail::multiply_kernel(lhs.data(), rhs.data(), res.data(), lhs.rows(), lhs.cols(),
+                                rhs.cols());
+    }
+}
+
+}    // namespace math
+}    // namespace psst
+
+#endif /* PSST_MATH_DYNAMIC_MATRIX_HPP_ */
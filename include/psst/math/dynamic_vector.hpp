@@ -0,0 +1,355 @@
+/**
+ * Copyright 2019 Sergei A. Fedorov
+ * dynamic_vector.hpp
+ *
+ *  Created on: Mar 4, 2019
+ *      Author: ser-fedorov
+ */
+
+#ifndef PSST_MATH_DYNAMIC_VECTOR_HPP_
+#define PSST_MATH_DYNAMIC_VECTOR_HPP_
+
+#include <psst/math/detail/dynamic_expressions.hpp>
+#include <psst/math/detail/dynamic_storage.hpp>
+#include <psst/math/vector.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <initializer_list>
+
+namespace psst {
+namespace math {
+
+/**
+ * Vector of a size known at run time. The vector is used in expressions with
+ * other dynamic vectors and matrices and with fixed size vectors of the same
+ * size. Small vectors don't allocate memory, see detail::dynamic_storage.
+ */
+template <typename T>
+struct dynamic_vector : expr::dynamic_vector_expression<dynamic_vector<T>, T> {
+    using this_type        = dynamic_vector<T>;
+    using value_traits     = traits::scalar_value_traits<T>;
+    using value_type       = typename value_traits::value_type;
+    using lvalue_reference = typename value_traits::lvalue_reference;
+    using const_reference  = typename value_traits::const_reference;
+    using magnitude_type   = typename value_traits::magnitude_type;
+    using pointer          = typename value_traits::pointer;
+    using const_pointer    = typename value_traits::const_pointer;
+    using iterator         = pointer;
+    using const_iterator   = const_pointer;
+    using size_type        = std::size_t;
+    using init_list        = std::initializer_list<value_type>;
+
+    dynamic_vector() = default;
+    /**
+     * Vector of size values set to the same value. To precede initializer
+     * list constructor, should be called with round parenthesis.
+     */
+    explicit dynamic_vector(size_type size, value_type val = value_type{0}) : data_{size}
+    {
+        std::fill(begin(), end(), val);
+    }
+    dynamic_vector(init_list const& args) : data_{args.size()}
+    {
+        std::copy(args.begin(), args.end(), begin());
+    }
+    dynamic_vector(const_pointer p, size_type size) : data_{size}
+    {
+        std::copy(p, p + size, begin());
+    }
+    /**
+     * Construct from a dynamic or a fixed size vector expression
+     */
+    template <typename Expression,
+              typename = std::enable_if_t<expr::d::detail::is_vector_operand_v<Expression>>>
+    /* implicit */ dynamic_vector(Expression const& rhs)
+    {
+        evaluate(rhs);
+    }
+    /**
+     * Fill the vector with size values of an unbounded vector expression,
+     * e.g. random_vector_data
+     */
+    template <typename Expression, typename = math::traits::enable_if_vector_expression<Expression>>
+    dynamic_vector(size_type size, Expression const& rhs) : data_{size}
+    {
+        static_assert(Expression::size == utils::npos_v,
+                      "Only an unbounded vector expression can be sampled");
+        std::generate(begin(), end(), [&rhs]() { return rhs.template at<0>(); });
+    }
+
+    template <typename Expression,
+              typename = std::enable_if_t<expr::d::detail::is_vector_operand_v<Expression>>>
+    this_type&
+    operator=(Expression const& rhs)
+    {
+        if constexpr (!expr::d::detail::elementwise_v<Expression>) {
+            // The vector can be an argument of the expression
+            if (expr::references(rhs, this, this + 1)) {
+                return *this = this_type(rhs);
+            }
+        }
+        return evaluate(rhs);
+    }
+    /**
+     * Assignment that evaluates an expression directly into the vector
+     * storage without checking if the expression references the vector.
+     * @code
+     * y.noalias() = a * x;
+     * @endcode
+     */
+    expr::noalias_assignment<this_type>
+    noalias()
+    {
+        return expr::noalias_assignment<this_type>{*this};
+    }
+
+    size_type
+    size() const
+    {
+        return data_.size();
+    }
+    bool
+    empty() const
+    {
+        return data_.size() == 0;
+    }
+    size_type
+    capacity() const
+    {
+        return data_.capacity();
+    }
+    /**
+     * Change the size of the vector keeping the values, the new values are
+     * zero
+     */
+    void
+    resize(size_type size)
+    {
+        data_.resize(size);
+    }
+    void
+    clear()
+    {
+        data_.clear();
+    }
+
+    pointer
+    data()
+    {
+        return data_.data();
+    }
+    const_pointer
+    data() const
+    {
+        return data_.data();
+    }
+
+    iterator
+    begin()
+    {
+        return data();
+    }
+    const_iterator
+    begin() const
+    {
+        return cbegin();
+    }
+    const_iterator
+    cbegin() const
+    {
+        return data();
+    }
+
+    iterator
+    end()
+    {
+        return data() + size();
+    }
+    const_iterator
+    end() const
+    {
+        return cend();
+    }
+    const_iterator
+    cend() const
+    {
+        return data() + size();
+    }
+
+    lvalue_reference
+    at(size_type idx)
+    {
+        assert(idx < size());
+        return data()[idx];
+    }
+    const_reference
+    at(size_type idx) const
+    {
+        assert(idx < size());
+        return data()[idx];
+    }
+
+    lvalue_reference operator[](size_type idx)
+    {
+        return at(idx);
+    }
+    const_reference operator[](size_type idx) const
+    {
+        return at(idx);
+    }
+
+    /**
+     * Copy of N values starting at start as a fixed size vector
+     */
+    template <std::size_t N>
+    vector<T, N>
+    segment(size_type start) const
+    {
+        assert(start + N <= size());
+        return vector<T, N>(data() + start);
+    }
+    /**
+     * Set N values starting at start from a fixed size vector expression
+     */
+    template <typename Expression, typename = math::traits::enable_if_vector_expression<Expression>>
+    void
+    set_segment(size_type start, Expression const& rhs)
+    {
+        using vector_type = typename Expression::result_type;
+        assert(start + vector_type::size <= size());
+        vector_type const v = rhs;
+        std::copy(v.begin(), v.end(), data() + start);
+    }
+
+    //@{
+    /**
+     * @name Compound assignment, modifies the vector in place. A product is
+     * added by its kernel unless it references the vector.
+     */
+    template <typename Expression,
+              typename = std::enable_if_t<expr::d::detail::is_vector_operand_v<Expression>>>
+    this_type&
+    operator+=(Expression const& rhs)
+    {
+        if constexpr (!expr::d::detail::elementwise_v<Expression>) {
+            // The vector can be an argument of the expression
+            if (expr::references(rhs, this, this + 1)) {
+                return *this += this_type(rhs);
+            }
+        }
+        return add(rhs);
+    }
+    template <typename Expression,
+              typename = std::enable_if_t<expr::d::detail::is_vector_operand_v<Expression>>>
+    this_type&
+    operator-=(Expression const& rhs)
+    {
+        if constexpr (!expr::d::detail::elementwise_v<Expression>) {
+            // The vector can be an argument of the expression
+            if (expr::references(rhs, this, this + 1)) {
+                return *this -= this_type(rhs);
+            }
+        }
+        return subtract(rhs);
+    }
+    template <typename U, typename = math::traits::enable_if_scalar_value<U>>
+    this_type&
+    operator*=(U s)
+    {
+        for (auto& v : *this) {
+            v *= s;
+        }
+        return *this;
+    }
+    template <typename U, typename = math::traits::enable_if_scalar_value<U>>
+    this_type&
+    operator/=(U s)
+    {
+        for (auto& v : *this) {
+            v /= s;
+        }
+        return *this;
+    }
+    //@}
+
+    magnitude_type
+    magnitude_square() const
+    {
+        return expr::magnitude_square(*this);
+    }
+    magnitude_type
+    magnitude() const
+    {
+        return expr::magnitude(*this);
+    }
+    template <typename Expression,
+              typename = std::enable_if_t<expr::d::detail::is_vector_operand_v<Expression>>>
+    auto
+    dot(Expression const& rhs) const
+    {
+        return expr::dot_product(*this, rhs);
+    }
+
+    this_type&
+    zero()
+    {
+        std::fill(begin(), end(), value_type{0});
+        return *this;
+    }
+
+private:
+    friend class expr::noalias_assignment<this_type>;
+
+    template <typename Expression>
+    this_type&
+    evaluate(Expression const& rhs)
+    {
+        decltype(auto) arg = expr::d::detail::dynamic_value(rhs);
+        data_.allocate(arg.size());
+        expr::d::detail::evaluate(arg, data());
+        return *this;
+    }
+    template <typename Expression>
+    this_type&
+    add(Expression const& rhs)
+    {
+        if constexpr (expr::d::detail::has_accumulate<Expression>::value
+                      && std::is_same<typename Expression::value_type, T>::value) {
+            expr::d::detail::check_same_size(*this, rhs);
+            rhs.evaluate(data(), math::detail::kernel_store::add);
+        } else {
+            decltype(auto) arg = expr::d::detail::dynamic_operand(rhs);
+            expr::d::detail::check_same_size(*this, arg);
+            for (size_type i = 0; i < size(); ++i) {
+                data()[i] += arg.at(i);
+            }
+        }
+        return *this;
+    }
+    template <typename Expression>
+    this_type&
+    subtract(Expression const& rhs)
+    {
+        if constexpr (expr::d::detail::has_accumulate<Expression>::value
+                      && std::is_same<typename Expression::value_type, T>::value) {
+            expr::d::detail::check_same_size(*this, rhs);
+            rhs.evaluate(data(), math::detail::kernel_store::subtract);
+        } else {
+            decltype(auto) arg = expr::d::detail::dynamic_operand(rhs);
+            expr::d::detail::check_same_size(*this, arg);
+            for (size_type i = 0; i < size(); ++i) {
+                data()[i] -= arg.at(i);
+            }
+        }
+        return *this;
+    }
+
+private:
+    detail::dynamic_storage<T> data_;
+};
+
+}    // namespace math
+}    // namespace psst
+
+#endif /* PSST_MATH_DYNAMIC_VECTOR_HPP_ */
@@ -0,0 +1,493 @@
+/**
+ * Copyright 2019 Sergei A. Fedorov
+ * frustum.hpp
+ *
+ *  Created on: Feb 26, 2019
+ *      Author: ser-fedorov
+ */
+
+#ifndef PSST_MATH_FRUSTUM_HPP_
+#define PSST_MATH_FRUSTUM_HPP_
+
+#include <psst/math/aabb.hpp>
+#include <psst/math/detail/parallel.hpp>
+#include <psst/math/matrix.hpp>
+#include <psst/math/vector.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <type_traits>
+
+namespace psst {
+namespace math {
+
+/**
+ * Depth range of the clip space of a projection matrix
+ */
+enum class clip_depth {
+    /** -w <= z <= w, OpenGL convention */
+    negative_one_to_one,
+    /** 0 <= z <= w, Direct3D and Vulkan convention */
+    zero_to_one
+};
+
+/**
+ * View frustum as six planes. A plane is stored as a vector (a, b, c, d) with
+ * a unit normal (a, b, c) pointing inside the frustum, a point p is on the
+ * inner side of the plane if a * x + b * y + c * z + d >= 0.
+ */
+template <typename T>
+struct frustum {
+    static_assert(std::is_floating_point_v<T>, "Frustum values must be floating point");
+
+    using value_type = T;
+    using plane_type = vector<T, 4>;
+
+    // Not near and far, these are macros in <windows.h>
+    enum side { left, right, bottom, top, near_plane, far_plane };
+    static constexpr std::size_t plane_count = 6;
+
+    frustum() = default;
+    /**
+     * Construct a frustum from planes in the order of the side enumeration,
+     * the planes are normalized.
+     */
+    explicit frustum(std::array<plane_type, plane_count> const& planes) : planes_{planes}
+    {
+        for (auto& p : planes_) {
+            T const len = std::sqrt(p[0] * p[0] + p[1] * p[1] + p[2] * p[2]);
+            p           = p / len;
+        }
+    }
+
+    plane_type const&
+    plane(std::size_t side) const
+    {
+        return planes_[side];
+    }
+
+    std::array<plane_type, plane_count> const&
+    planes() const
+    {
+        return planes_;
+    }
+
+private:
+    std::array<plane_type, plane_count> planes_;
+};
+
+/**
+ * Extract the frustum planes from a projection or a view-projection matrix,
+ * that transforms column vectors to the clip space (G. Gribb, K. Hartmann,
+ * Fast Extraction of Viewing Frustum Planes from the World-View-Projection
+ * Matrix). For a view-projection matrix the planes are in the world space.
+ */
+template <typename T, typename Components>
+frustum<T>
+make_frustum(matrix<T, 4, 4, Components> const& m,
+             clip_depth                          depth = clip_depth::negative_one_to_one)
+{
+    using plane_type = typename frustum<T>::plane_type;
+    T const*   d     = m.data();
+    plane_type row0{d[0], d[1], d[2], d[3]};
+    plane_type row1{d[4], d[5], d[6], d[7]};
+    plane_type row2{d[8], d[9], d[10], d[11]};
+    plane_type row3{d[12], d[13], d[14], d[15]};
+    plane_type near_clip = depth == clip_depth::zero_to_one ? row2 : plane_type(row3 + row2);
+    return frustum<T>{{row3 + row0, row3 - row0, row3 + row1, row3 - row1, near_clip, row3 - row2}};
+}
+
+//@{
+/** @name Tests of single objects */
+template <typename T, typename Components>
+bool
+contains(frustum<T> const& f, vector<T, 3, Components> const& point)
+{
+    for (auto const& p : f.planes()) {
+        if (p[0] * point[0] + p[1] * point[1] + p[2] * point[2] + p[3] < 0)
+            return false;
+    }
+    return true;
+}
+
+/**
+ * The sphere is at least partially inside the frustum. The test is
+ * conservative, a sphere near a corner of the frustum may be reported as
+ * intersecting while being outside.
+ */
+template <typename T, typename Components>
+bool
+intersects(frustum<T> const& f, vector<T, 3, Components> const& center, T radius)
+{
+    for (auto const& p : f.planes()) {
+        if (p[0] * center[0] + p[1] * center[1] + p[2] * center[2] + p[3] < -radius)
+            return false;
+    }
+    return true;
+}
+
+/**
+ * The box is at least partially inside the frustum. Conservative in the same
+ * way as the sphere test, an empty box is never inside.
+ */
+template <typename T, typename Components>
+bool
+intersects(frustum<T> const& f, aabb<T, 3, Components> const& box)
+{
+    if (box.empty())
+        return false;
+    for (auto const& p : f.planes()) {
+        // The corner farthest along the plane normal
+        T const x = p[0] < 0 ? box.min()[0] : box.max()[0];
+        T const y = p[1] < 0 ? box.min()[1] : box.max()[1];
+        T const z = p[2] < 0 ? box.min()[2] : box.max()[2];
+        if (p[0] * x + p[1] * y + p[2] * z + p[3] < 0)
+            return false;
+    }
+    return true;
+}
+//@}
+
+namespace detail {
+
+/** Number of objects tested at once, one word of a visibility mask */
+constexpr std::size_t cull_block_size = 64;
+
+/**
+ * Planes of a frustum as separate arrays of components, loaded once per a
+ * batch of tests.
+ */
+template <typename T>
+struct frustum_planes {
+    explicit frustum_planes(frustum<T> const& f)
+    {
+        for (std::size_t i = 0; i < frustum<T>::plane_count; ++i) {
+            a[i] = f.plane(i)[0];
+            b[i] = f.plane(i)[1];
+            c[i] = f.plane(i)[2];
+            d[i] = f.plane(i)[3];
+        }
+    }
+
+    T a[frustum<T>::plane_count];
+    T b[frustum<T>::plane_count];
+    T c[frustum<T>::plane_count];
+    T d[frustum<T>::plane_count];
+};
+
+/**
+ * Minimal signed distance from the spheres to the planes for a block of at
+ * most cull_block_size spheres in SoA layout. A sphere is visible if the
+ * distance is not negative. The loops over the spheres are vectorized by the
+ * compiler.
+ */
+template <typename T>
+void
+sphere_block_distance(frustum_planes<T> const& planes, T const* x, T const* y, T const* z,
+                      T const* r, std::size_t n, T* dist)
+{
+    for (std::size_t i = 0; i < n; ++i) {
+        dist[i] = r[i] + planes.a[0] * x[i] + planes.b[0] * y[i] + planes.c[0] * z[i]
+                  + planes.d[0];
+    }
+    for (std::size_t p = 1; p < frustum<T>::plane_count; ++p) {
+        T const a = planes.a[p], b = planes.b[p], c = planes.c[p], d = planes.d[p];
+        for (std::size_t i = 0; i < n; ++i) {
+            T const s = r[i] + a * x[i] + b * y[i] + c * z[i] + d;
+            dist[i]   = s < dist[i] ? s : dist[i];
+        }
+    }
+}
+
+/**
+ * The same for boxes given by centers and half extents. A box with a
+ * negative half extent is empty and gets a negative distance.
+ */
+template <typename T>
+void
+box_block_distance(frustum_planes<T> const& planes, T const* x, T const* y, T const* z,
+                   T const* ex, T const* ey, T const* ez, std::size_t n, T* dist)
+{
+    for (std::size_t i = 0; i < n; ++i) {
+        T const e = ex[i] < ey[i] ? ex[i] : ey[i];
+        dist[i]   = e < ez[i] ? e : ez[i];
+    }
+    for (std::size_t p = 0; p < frustum<T>::plane_count; ++p) {
+        T const a = planes.a[p], b = planes.b[p], c = planes.c[p], d = planes.d[p];
+        T const aa = std::abs(a), ab = std::abs(b), ac = std::abs(c);
+        for (std::size_t i = 0; i < n; ++i) {
+            T const s = a * x[i] + b * y[i] + c * z[i] + d + aa * ex[i] + ab * ey[i] + ac * ez[i];
+            dist[i]   = s < dist[i] ? s : dist[i];
+        }
+    }
+}
+
+/**
+ * Visibility bits of a block. The flags are computed as bytes, so that the
+ * comparison is vectorized, and each eight of them are packed to bits with
+ * a multiplication.
+ */
+template <typename T>
+std::uint64_t
+visibility_bits(T const* dist, std::size_t n)
+{
+    std::uint8_t flags[cull_block_size] = {};
+    for (std::size_t i = 0; i < n; ++i) {
+        flags[i] = !(dist[i] < 0);
+    }
+    std::uint64_t bits = 0;
+    for (std::size_t g = 0; g < cull_block_size / 8; ++g) {
+        std::uint64_t bytes = 0;
+        for (std::size_t k = 0; k < 8; ++k) {
+            bytes |= std::uint64_t{flags[g * 8 + k]} << (k * 8);
+        }
+        // Byte k of the flags is moved to bit 56 + k
+        bits |= ((bytes * 0x0102040810204080ull) >> 56) << (g * 8);
+    }
+    return bits;
+}
+
+/**
+ * Indices of visible objects of a block starting at base, written without
+ * branches.
+ * @return number of written indices
+ */
+template <typename T, typename Index>
+std::size_t
+visible_indices(T const* dist, std::size_t n, std::size_t base, Index* indices)
+{
+    std::size_t count = 0;
+    for (std::size_t i = 0; i < n; ++i) {
+        indices[count] = static_cast<Index>(base + i);
+        count += !(dist[i] < 0);
+    }
+    return count;
+}
+
+inline std::size_t
+count_bits(std::uint64_t bits)
+{
+    std::size_t count = 0;
+    for (; bits != 0; bits &= bits - 1) {
+        ++count;
+    }
+    return count;
+}
+
+/**
+ * Cull count objects to a visibility mask. The Distance function fills the
+ * distances of a block of objects given the first object and the size.
+ * @return number of visible objects
+ */
+template <typename T, typename Distance>
+std::size_t
+cull_to_mask(std::size_t count, std::size_t threads, Distance&& distance, std::uint64_t* mask)
+{
+    std::size_t const blocks = (count + cull_block_size - 1) / cull_block_size;
+    parallel_for(blocks, config::parallel_min_items / cull_block_size, threads,
+                 [&](std::size_t begin, std::size_t end) {
+                     T dist[cull_block_size];
+                     for (std::size_t b = begin; b < end; ++b) {
+                         std::size_t const first = b * cull_block_size;
+                         std::size_t const n     = std::min(cull_block_size, count - first);
+                         // The block size is a constant for full blocks, the
+                         // loops are unrolled without remainders
+                         if (n == cull_block_size) {
+                             distance(first, cull_block_size, dist);
+                             mask[b] = visibility_bits(dist, cull_block_size);
+                         } else {
+                             distance(first, n, dist);
+                             mask[b] = visibility_bits(dist, n);
+                         }
+                     }
+                 });
+    std::size_t visible = 0;
+    for (std::size_t b = 0; b < blocks; ++b) {
+        visible += count_bits(mask[b]);
+    }
+    return visible;
+}
+
+/**
+ * Cull count objects to a list of visible indices
+ * @return number of visible objects
+ */
+template <typename T, typename Distance, typename Index>
+std::size_t
+cull_to_indices(std::size_t count, Distance&& distance, Index* indices)
+{
+    static_assert(std::is_integral_v<Index>, "Index type must be integral");
+    T           dist[cull_block_size];
+    std::size_t visible = 0;
+    for (std::size_t first = 0; first < count; first += cull_block_size) {
+        std::size_t const n = std::min(cull_block_size, count - first);
+        if (n == cull_block_size) {
+            distance(first, cull_block_size, dist);
+            visible += visible_indices(dist, cull_block_size, first, indices + visible);
+        } else {
+            distance(first, n, dist);
+            visible += visible_indices(dist, n, first, indices + visible);
+        }
+    }
+    return visible;
+}
+
+/**
+ * Load a block of spheres with centers as an array of vectors, transposing
+ * them to SoA.
+ */
+template <typename T, typename Components>
+void
+sphere_block_distance(frustum_planes<T> const& planes, vector<T, 3, Components> const* centers,
+                      T const* radii, std::size_t n, T* dist)
+{
+    T x[cull_block_size], y[cull_block_size], z[cull_block_size];
+    for (std::size_t i = 0; i < n; ++i) {
+        x[i] = centers[i][0];
+        y[i] = centers[i][1];
+        z[i] = centers[i][2];
+    }
+    sphere_block_distance(planes, x, y, z, radii, n, dist);
+}
+
+template <typename T, typename Components>
+void
+box_block_distance(frustum_planes<T> const& planes, aabb<T, 3, Components> const* boxes,
+                   std::size_t n, T* dist)
+{
+    T x[cull_block_size], y[cull_block_size], z[cull_block_size];
+    T ex[cull_block_size], ey[cull_block_size], ez[cull_block_size];
+    for (std::size_t i = 0; i < n; ++i) {
+        auto const& min = boxes[i].min();
+        auto const& max = boxes[i].max();
+        x[i]            = (min[0] + max[0]) / 2;
+        y[i]            = (min[1] + max[1]) / 2;
+        z[i]            = (min[2] + max[2]) / 2;
+        ex[i]           = (max[0] - min[0]) / 2;
+        ey[i]           = (max[1] - min[1]) / 2;
+        ez[i]           = (max[2] - min[2]) / 2;
+    }
+    box_block_distance(planes, x, y, z, ex, ey, ez, n, dist);
+}
+
+}    // namespace detail
+
+//@{
+/**
+ * @name Batch culling
+ *
+ * The objects are tested by blocks of 64 against all six planes. Culling to
+ * a mask sets bit i % 64 of mask[i / 64] if object i is visible, the mask
+ * must have room for (count + 63) / 64 words. Culling to indices writes the
+ * indices of visible objects in ascending order, the buffer must have room
+ * for count indices.
+ *
+ * The tests are conservative in the same way as the single object tests.
+ * The objects are transposed to SoA layout by blocks, so that the plane
+ * tests are vectorized by the compiler.
+ */
+/**
+ * Cull spheres with centers in an array of vectors to a mask
+ * @param threads maximum number of threads, 0 means the hardware concurrency
+ * @return number of visible spheres
+ */
+template <typename T, typename Components>
+std::size_t
+cull_spheres(frustum<T> const& f, vector<T, 3, Components> const* centers, T const* radii,
+             std::size_t count, std::uint64_t* mask, std::size_t threads = 1)
+{
+    detail::frustum_planes<T> const planes{f};
+    return detail::cull_to_mask<T>(
+        count, threads,
+        [&](std::size_t first, std::size_t n, T* dist) {
+            detail::sphere_block_distance(planes, centers + first, radii + first, n, dist);
+        },
+        mask);
+}
+
+/**
+ * Cull spheres with center coordinates in separate arrays to a mask
+ */
+template <typename T>
+std::size_t
+cull_spheres(frustum<T> const& f, T const* x, T const* y, T const* z, T const* radii,
+             std::size_t count, std::uint64_t* mask, std::size_t threads = 1)
+{
+    detail::frustum_planes<T> const planes{f};
+    return detail::cull_to_mask<T>(
+        count, threads,
+        [&](std::size_t first, std::size_t n, T* dist) {
+            detail::sphere_block_distance(planes, x + first, y + first, z + first, radii + first,
+                                          n, dist);
+        },
+        mask);
+}
+
+template <typename T, typename Components>
+std::size_t
+cull_boxes(frustum<T> const& f, aabb<T, 3, Components> const* boxes, std::size_t count,
+           std::uint64_t* mask, std::size_t threads = 1)
+{
+    detail::frustum_planes<T> const planes{f};
+    return detail::cull_to_mask<T>(
+        count, threads,
+        [&](std::size_t first, std::size_t n, T* dist) {
+            detail::box_block_distance(planes, boxes + first, n, dist);
+        },
+        mask);
+}
+
+/**
+ * Indices of visible spheres with centers in an array of vectors
+ * @return number of visible spheres
+ */
+template <typename T, typename Components, typename Index>
+std::size_t
+visible_spheres(frustum<T> const& f, vector<T, 3, Components> const* centers, T const* radii,
+                std::size_t count, Index* indices)
+{
+    detail::frustum_planes<T> const planes{f};
+    return detail::cull_to_indices<T>(
+        count,
+        [&](std::size_t first, std::size_t n, T* dist) {
+            detail::sphere_block_distance(planes, centers + first, radii + first, n, dist);
+        },
+        indices);
+}
+
+template <typename T, typename Index>
+std::size_t
+visible_spheres(frustum<T> const& f, T const* x, T const* y, T const* z, T const* radii,
+                std::size_t count, Index* indices)
+{
+    detail::frustum_planes<T> const planes{f};
+    return detail::cull_to_indices<T>(
+        count,
+        [&](std::size_t first, std::size_t n, T* dist) {
+            detail::sphere_block_distance(planes, x + first, y + first, z + first, radii + first,
+                                          n, dist);
+        },
+        indices);
+}
+
+template <typename T, typename Components, typename Index>
+std::size_t
+visible_boxes(frustum<T> const& f, aabb<T, 3, Components> const* boxes, std::size_t count,
+              Index* indices)
+{
+    detail::frustum_planes<T> const planes{f};
+    return detail::cull_to_indices<T>(
+        count,
+        [&](std::size_t first, std::size_t n, T* dist) {
+            detail::box_block_distance(planes, boxes + first, n, dist);
+        },
+        indices);
+}
+//@}
+
+}    // namespace math
+}    // namespace psst
+
+#endif /* PSST_MATH_FRUSTUM_HPP_ */
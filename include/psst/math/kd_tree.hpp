@@ -0,0 +1,538 @@
+/**
+ * Copyright 2019 Sergei A. Fedorov
+ * kd_tree.hpp
+ *
+ *  Created on: Mar 1, 2019
+ *      Author: ser-fedorov
+ */
+
+#ifndef PSST_MATH_KD_TREE_HPP_
+#define PSST_MATH_KD_TREE_HPP_
+
+#include <psst/math/aabb.hpp>
+#include <psst/math/config.hpp>
+#include <psst/math/detail/parallel.hpp>
+#include <psst/math/vector.hpp>
+#include <psst/math/vector_view.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <mutex>
+#include <numeric>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+namespace psst {
+namespace math {
+
+/**
+ * Node of a k-d tree. An inner node has a zero count, its left child is the
+ * next node and the right child is the node first. A leaf references count
+ * point indices starting at first.
+ */
+template <typename T>
+struct kd_tree_node {
+    T             split;
+    std::uint32_t axis;
+    std::uint32_t first;
+    std::uint32_t count;
+
+    bool
+    leaf() const
+    {
+        return count != 0;
+    }
+};
+
+namespace detail {
+
+/**
+ * Number of nodes of a k-d tree over count points, the points are split at
+ * the median, so the layout of a subtree depends only on its size.
+ */
+inline std::size_t
+kd_tree_node_count(std::size_t count)
+{
+    // The sizes of the subtrees at a level differ at most by one, a level is
+    // counted as a number of subtrees of a size and of the size + 1
+    std::size_t size  = count;
+    std::size_t small = 1;
+    std::size_t large = 0;
+    std::size_t nodes = 0;
+    while (small + large > 0) {
+        nodes += small + large;
+        std::size_t const half       = size / 2;
+        std::size_t       next_small = 0;
+        std::size_t       next_large = 0;
+        auto              split      = [&](std::size_t subtree, std::size_t subtrees) {
+            if (subtree <= config::kd_tree_max_leaf_size)
+                return;
+            for (std::size_t child : {subtree / 2, subtree - subtree / 2}) {
+                (child == half ? next_small : next_large) += subtrees;
+            }
+        };
+        split(size, small);
+        split(size + 1, large);
+        size  = half;
+        small = next_small;
+        large = next_large;
+    }
+    return nodes;
+}
+
+/**
+ * A subtree to build, the cell is the region of space the subtree covers
+ */
+template <typename T, std::size_t Size>
+struct kd_tree_task {
+    std::uint32_t node;
+    std::size_t   begin;
+    std::size_t   end;
+    T             min[Size];
+    T             max[Size];
+};
+
+}    // namespace detail
+
+/**
+ * A k-d tree over points in a memory buffer. The tree doesn't copy the
+ * points, it keeps the view and a permutation of the point indices, so the
+ * buffer must outlive the tree and the points must not move. A moved point
+ * cloud needs a new tree.
+ *
+ * The points are split at the median along the longest axis of the cell,
+ * the tree is balanced and its depth is log2 of the number of leaves.
+ */
+template <typename View>
+class kd_tree;
+
+template <typename T, std::size_t Size, typename Components, component_order Order>
+class kd_tree<memory_vector_view<T*, Size, Components, Order>> {
+public:
+    using value_type  = std::remove_const_t<T>;
+    using view_type   = memory_vector_view<T*, Size, Components, Order>;
+    using vector_type = vector<value_type, Size, Components>;
+    using box_type    = aabb<value_type, Size, Components>;
+    using node_type   = kd_tree_node<value_type>;
+
+    /** Index of a missing neighbour in the batch results */
+    static constexpr std::uint32_t npos = std::numeric_limits<std::uint32_t>::max();
+
+    struct neighbour {
+        std::uint32_t index;
+        value_type    distance_square;
+    };
+
+    /**
+     * Build a tree over the points
+     * @param threads maximum number of threads, 0 means the hardware concurrency
+     * @throws std::runtime_error if there are more points than a 32 bit index
+     *         can address
+     */
+    explicit kd_tree(view_type const& points, std::size_t threads = 1) : points_{points}
+    {
+        build(threads);
+    }
+
+    bool
+    empty() const
+    {
+        return nodes_.empty();
+    }
+
+    view_type const&
+    points() const
+    {
+        return points_;
+    }
+
+    std::vector<node_type> const&
+    nodes() const
+    {
+        return nodes_;
+    }
+
+    /** The point indices referenced by the leaves */
+    std::vector<std::uint32_t> const&
+    indices() const
+    {
+        return indices_;
+    }
+
+    //@{
+    /** @name Single point queries */
+    /**
+     * The k nearest points closer than the maximal distance
+     * @param res array of at least k neighbours, the found neighbours are
+     *        sorted by the distance
+     * @return number of the neighbours found
+     */
+    std::size_t
+    nearest(vector_type const& point, std::size_t k, neighbour* res,
+            value_type max_distance_square = std::numeric_limits<value_type>::max()) const
+    {
+        if (empty() || k == 0)
+            return 0;
+        nearest_result result{res, k, max_distance_square};
+        search(point, result);
+        return result.count;
+    }
+
+    /**
+     * The nearest point
+     * @return false if the tree is empty
+     */
+    bool
+    nearest(vector_type const& point, neighbour& res) const
+    {
+        return nearest(point, 1, &res) != 0;
+    }
+
+    /**
+     * Call fn(index, distance_square) for every point within the radius,
+     * the points are not sorted
+     */
+    template <typename Function>
+    void
+    within_radius(vector_type const& point, value_type radius, Function&& fn) const
+    {
+        if (empty())
+            return;
+        radius_result<Function&> result{fn, radius * radius};
+        search(point, result);
+    }
+
+    /**
+     * Append the points within the radius to res
+     */
+    void
+    within_radius(vector_type const& point, value_type radius, std::vector<neighbour>& res) const
+    {
+        within_radius(point, radius, [&res](std::uint32_t index, value_type d) {
+            res.push_back({index, d});
+        });
+    }
+
+    /**
+     * Call fn(index) for every point inside the box, the boundary included
+     */
+    template <typename Function>
+    void
+    query(box_type const& box, Function&& fn) const
+    {
+        if (empty())
+            return;
+        std::uint32_t stack[64];
+        std::size_t   top = 0;
+        stack[top++]      = 0;
+        while (top != 0) {
+            auto const& n = nodes_[stack[--top]];
+            if (n.leaf()) {
+                for (auto i = n.first; i < n.first + n.count; ++i) {
+                    if (contains(box, vector_type(points_[indices_[i]])))
+                        fn(indices_[i]);
+                }
+                continue;
+            }
+            std::uint32_t const self = static_cast<std::uint32_t>(&n - nodes_.data());
+            if (box.max()[n.axis] >= n.split)
+                stack[top++] = n.first;
+            if (box.min()[n.axis] <= n.split)
+                stack[top++] = self + 1;
+        }
+    }
+    //@}
+
+    //@{
+    /** @name Batch queries */
+    /**
+     * The k nearest points of every query point. The neighbours of query i
+     * are res[i * k] to res[i * k + k - 1], the missing ones have the index
+     * npos and the maximal distance.
+     * @param threads maximum number of threads, 0 means the hardware concurrency
+     */
+    template <typename U, typename QComponents, component_order QOrder>
+    void
+    nearest(memory_vector_view<U*, Size, QComponents, QOrder> const& queries, std::size_t k,
+            neighbour* res, std::size_t threads = 1) const
+    {
+        detail::parallel_for(
+            queries.size(), min_batch, threads, [&](std::size_t begin, std::size_t end) {
+                for (std::size_t i = begin; i < end; ++i) {
+                    neighbour* const  out = res + i * k;
+                    std::size_t const n   = nearest(queries[i], k, out);
+                    std::fill(out + n, out + k,
+                              neighbour{npos, std::numeric_limits<value_type>::max()});
+                }
+            });
+    }
+
+    /**
+     * The points within the radius of every query point. The neighbours of
+     * query i are res[offsets[i]] to res[offsets[i + 1] - 1].
+     * @param threads maximum number of threads, 0 means the hardware concurrency
+     */
+    template <typename U, typename QComponents, component_order QOrder>
+    void
+    within_radius(memory_vector_view<U*, Size, QComponents, QOrder> const& queries,
+                  value_type radius, std::vector<std::size_t>& offsets,
+                  std::vector<neighbour>& res, std::size_t threads = 1) const
+    {
+        struct chunk {
+            std::size_t              begin;
+            std::vector<std::size_t> counts;
+            std::vector<neighbour>   found;
+        };
+        std::vector<chunk> chunks;
+        std::mutex         mutex;
+        detail::parallel_for(
+            queries.size(), min_batch, threads, [&](std::size_t begin, std::size_t end) {
+                chunk c{begin, {}, {}};
+                c.counts.reserve(end - begin);
+                for (std::size_t i = begin; i < end; ++i) {
+                    std::size_t const size = c.found.size();
+                    within_radius(queries[i], radius, c.found);
+                    c.counts.push_back(c.found.size() - size);
+                }
+                std::lock_guard<std::mutex> lock{mutex};
+                chunks.push_back(std::move(c));
+            });
+        std::sort(chunks.begin(), chunks.end(),
+                  [](chunk const& a, chunk const& b) { return a.begin < b.begin; });
+
+        offsets.assign(1, 0);
+        offsets.reserve(queries.size() + 1);
+        res.clear();
+        for (auto const& c : chunks) {
+            for (auto n : c.counts) {
+                offsets.push_back(offsets.back() + n);
+            }
+            res.insert(res.end(), c.found.begin(), c.found.end());
+        }
+    }
+    //@}
+
+private:
+    using task_type = detail::kd_tree_task<value_type, Size>;
+
+    /** Minimal number of query points processed by a thread */
+    static constexpr std::size_t min_batch = 256;
+
+    /** The k nearest points, sorted by insertion as k is usually small */
+    struct nearest_result {
+        neighbour*  res;
+        std::size_t k;
+        value_type  max_distance_square;
+        std::size_t count = 0;
+
+        nearest_result(neighbour* r, std::size_t n, value_type max)
+            : res{r}, k{n}, max_distance_square{max}
+        {}
+
+        /** Distance of the farthest point to be found */
+        value_type
+        limit() const
+        {
+            return count < k ? max_distance_square : res[k - 1].distance_square;
+        }
+
+        bool
+        accepts(value_type d) const
+        {
+            return d < limit();
+        }
+
+        void
+        add(std::uint32_t index, value_type d)
+        {
+            std::size_t i = count < k ? count++ : k - 1;
+            for (; i > 0 && res[i - 1].distance_square > d; --i) {
+                res[i] = res[i - 1];
+            }
+            res[i] = {index, d};
+        }
+    };
+
+    template <typename Function>
+    struct radius_result {
+        Function   fn;
+        value_type radius_square;
+
+        bool
+        accepts(value_type d) const
+        {
+            return d <= radius_square;
+        }
+
+        void
+        add(std::uint32_t index, value_type d)
+        {
+            fn(index, d);
+        }
+    };
+
+    /**
+     * Search the nearest leaves first. The distance to a cell is kept
+     * incrementally by the offsets of the query point from the cell along the
+     * axes, so a subtree is skipped as soon as its cell is farther than the
+     * farthest point to be found.
+     */
+    template <typename Result>
+    void
+    search(vector_type const& point, Result& result) const
+    {
+        value_type offsets[Size] = {};
+        search(0, point, offsets, 0, result);
+    }
+
+    template <typename Result>
+    void
+    search(std::uint32_t node, vector_type const& point, value_type* offsets,
+           value_type cell_distance, Result& result) const
+    {
+        auto const& n = nodes_[node];
+        if (n.leaf()) {
+            for (auto i = n.first; i < n.first + n.count; ++i) {
+                value_type const d = distance_square(point, points_[indices_[i]]);
+                if (result.accepts(d))
+                    result.add(indices_[i], d);
+            }
+            return;
+        }
+        value_type const    diff = point[n.axis] - n.split;
+        std::uint32_t const near_child = diff < 0 ? node + 1 : n.first;
+        std::uint32_t const far_child  = diff < 0 ? n.first : node + 1;
+        search(near_child, point, offsets, cell_distance, result);
+
+        value_type const old = offsets[n.axis];
+        value_type const d   = cell_distance - old * old + diff * diff;
+        if (result.accepts(d)) {
+            offsets[n.axis] = diff;
+            search(far_child, point, offsets, d, result);
+            offsets[n.axis] = old;
+        }
+    }
+
+    void
+    build(std::size_t threads)
+    {
+        std::size_t const count = points_.size();
+        if (count == 0)
+            return;
+        if (count > std::numeric_limits<std::uint32_t>::max())
+            throw std::runtime_error{"Too many points for a k-d tree"};
+
+        indices_.resize(count);
+        std::iota(indices_.begin(), indices_.end(), std::uint32_t{0});
+        nodes_.resize(detail::kd_tree_node_count(count));
+
+        task_type root{0, 0, count, {}, {}};
+        auto const bounds = make_aabb(points_, threads);
+        for (std::size_t i = 0; i < Size; ++i) {
+            root.min[i] = bounds.min()[i];
+            root.max[i] = bounds.max()[i];
+        }
+
+        if (threads == 0)
+            threads = detail::default_thread_count();
+        std::vector<task_type> tasks;
+        if (threads == 1 || count < 2 * config::parallel_min_items) {
+            build(root, 0, tasks);
+            return;
+        }
+        // Subtrees are independent, the top of the tree is split by the
+        // calling thread and the subtrees are built in parallel. The median
+        // splits make the subtrees of the same size.
+        build(root, std::max(config::parallel_min_items, count / (threads * 4)), tasks);
+        detail::parallel_for(tasks.size(), 1, threads, [&](std::size_t begin, std::size_t end) {
+            std::vector<task_type> none;
+            for (std::size_t i = begin; i < end; ++i) {
+                build(tasks[i], 0, none);
+            }
+        });
+    }
+
+    /**
+     * Build the subtree of a task, the subtrees smaller than task_size are
+     * added to tasks instead of being built
+     */
+    void
+    build(task_type const& root, std::size_t task_size, std::vector<task_type>& tasks)
+    {
+        // The depth of a balanced tree over 32 bit indices is less than 32
+        task_type   stack[64];
+        std::size_t top = 0;
+        stack[top++]    = root;
+        while (top != 0) {
+            task_type const   t     = stack[--top];
+            std::size_t const count = t.end - t.begin;
+            if (count <= config::kd_tree_max_leaf_size) {
+                auto& n = nodes_[t.node];
+                n.split = 0;
+                n.axis  = 0;
+                n.first = static_cast<std::uint32_t>(t.begin);
+                n.count = static_cast<std::uint32_t>(count);
+                continue;
+            }
+            if (count < task_size) {
+                tasks.push_back(t);
+                continue;
+            }
+
+            std::size_t axis = 0;
+            for (std::size_t i = 1; i < Size; ++i) {
+                if (t.max[i] - t.min[i] > t.max[axis] - t.min[axis])
+                    axis = i;
+            }
+            std::size_t const mid = t.begin + count / 2;
+            std::nth_element(indices_.begin() + t.begin, indices_.begin() + mid,
+                             indices_.begin() + t.end,
+                             [this, axis](std::uint32_t a, std::uint32_t b) {
+                                 return points_[a][axis] < points_[b][axis];
+                             });
+            value_type const split = points_[indices_[mid]][axis];
+
+            std::size_t const left_nodes = detail::kd_tree_node_count(mid - t.begin);
+            task_type         left       = t;
+            task_type         right      = t;
+            left.node                    = t.node + 1;
+            left.end                     = mid;
+            left.max[axis]               = split;
+            right.node                   = static_cast<std::uint32_t>(left.node + left_nodes);
+            right.begin                  = mid;
+            right.min[axis]              = split;
+
+            auto& n = nodes_[t.node];
+            n.split = split;
+            n.axis  = static_cast<std::uint32_t>(axis);
+            n.first = right.node;
+            n.count = 0;
+
+            stack[top++] = right;
+            stack[top++] = left;
+        }
+    }
+
+    view_type                  points_;
+    std::vector<node_type>     nodes_;
+    std::vector<std::uint32_t> indices_;
+};
+
+/**
+ * Build a k-d tree over the points of a memory buffer
+ * @param threads maximum number of threads, 0 means the hardware concurrency
+ */
+template <typename T, std::size_t Size, typename Components, component_order Order>
+kd_tree<memory_vector_view<T*, Size, Components, Order>>
+make_kd_tree(memory_vector_view<T*, Size, Components, Order> const& points,
+             std::size_t threads = 1)
+{
+    return kd_tree<memory_vector_view<T*, Size, Components, Order>>{points, threads};
+}
+
+}    // namespace math
+}    // namespace psst
+
+#endif /* PSST_MATH_KD_TREE_HPP_ */
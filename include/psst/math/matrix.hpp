@@ -60,6 +60,12 @@ struct matrix : expr::matrix_expression<matrix<T, RC, CC, Components>> {    //,
 
     using init_list = std::initializer_list<typename row_type::init_list>;
 
+    template <typename Expression>
+    using enable_if_same_size
+        = std::enable_if_t<math::traits::is_matrix_expression_v<Expression>
+                           && std::decay_t<Expression>::rows == RC
+                           && std::decay_t<Expression>::cols == CC>;
+
     constexpr matrix() = default;
 
     constexpr explicit matrix(value_type val) : matrix(val, col_indexes_type{}) {}
@@ -183,25 +189,23 @@ struct matrix : expr::matrix_expression<matrix<T, RC, CC, Components>> {    //,
         return data_[idx];
     }
 
-    // TODO Make it an expression
-    this_type
-    operator-()
-    {
-        this_type res(*this);
-        res *= -1;
-        return res;
-    }
-
-    template <typename U>
+    //@{
+    /**
+     * @name Compound assignment
+     * The result is evaluated into a temporary, so the matrix can be an
+     * argument of the expression, e.g. m += m * n. A temporary of a fixed
+     * size is kept in registers and is faster than evaluating in place.
+     */
+    template <typename Expression, typename = enable_if_same_size<Expression>>
     this_type&
-    operator+=(matrix<U, RC, CC, Components> const& rhs)
+    operator+=(Expression const& rhs)
     {
         return *this = *this + rhs;
     }
 
-    template <typename U>
+    template <typename Expression, typename = enable_if_same_size<Expression>>
     this_type&
-    operator-=(matrix<U, RC, CC, Components> const& rhs)
+    operator-=(Expression const& rhs)
     {
         return *this = *this - rhs;
     }
@@ -219,6 +223,7 @@ struct matrix : expr::matrix_expression<matrix<T, RC, CC, Components>> {    //,
     {
         return *this = *this / s;
     }
+    //@}
 
     transposed_type
     transpose() const
@@ -236,7 +241,8 @@ struct matrix : expr::matrix_expression<matrix<T, RC, CC, Components>> {    //,
     operator const_pointer() const { return data(); }
 
     template <typename U = T>
-    constexpr static typename std::enable_if<RC == CC, matrix<U, RC, CC, Components>>::type
+    constexpr static typename std::enable_if<math::traits::has_identity_v<RC, CC>,
+                                             matrix<U, RC, CC, Components>>::type
     identity()
     {
         return expr::identity<this_type>();
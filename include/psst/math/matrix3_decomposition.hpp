@@ -0,0 +1,398 @@
+/**
+ * Copyright 2019 Sergei A. Fedorov
+ * matrix3_decomposition.hpp
+ *
+ *  Created on: Mar 8, 2019
+ *      Author: ser-fedorov
+ */
+
+#ifndef PSST_MATH_MATRIX3_DECOMPOSITION_HPP_
+#define PSST_MATH_MATRIX3_DECOMPOSITION_HPP_
+
+#include <psst/math/matrix.hpp>
+#include <psst/math/matrix_batch.hpp>
+#include <psst/math/vector.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <type_traits>
+
+namespace psst {
+namespace math {
+
+/**
+ * Eigen decomposition of a symmetric 3x3 matrix A = V * diag(values) *
+ * transpose(V). The eigenvalues are sorted in descending order, the
+ * eigenvector of values[i] is the column i of vectors, the vectors make a
+ * rotation matrix.
+ */
+template <typename T>
+struct symmetric_eigen3 {
+    vector<T, 3>    values;
+    matrix<T, 3, 3> vectors;
+};
+
+/**
+ * Singular value decomposition of a 3x3 matrix A = U * diag(s) *
+ * transpose(V). U and V are rotation matrices, the singular values are
+ * sorted by magnitude in descending order. The last singular value is
+ * negative if the determinant of A is negative, so that U * transpose(V)
+ * is the rotation of the polar decomposition.
+ */
+template <typename T>
+struct svd3 {
+    matrix<T, 3, 3> u;
+    vector<T, 3>    s;
+    matrix<T, 3, 3> v;
+};
+
+namespace detail {
+
+/**
+ * Number of Jacobi sweeps, the off-diagonal elements of a 3x3 matrix
+ * converge quadratically
+ */
+template <typename T>
+constexpr std::size_t
+jacobi_sweeps()
+{
+    return sizeof(T) > 4 ? 6 : 4;
+}
+
+/** Index of the element of the upper triangle of a symmetric 3x3 matrix */
+constexpr std::size_t
+sym3(std::size_t r, std::size_t c)
+{
+    return r == c ? r : r + c + 2;
+}
+
+/**
+ * Jacobi rotation of the rows and columns P and Q that zeroes the element
+ * (P, Q) of the symmetric matrix a, the rotation is accumulated in the
+ * columns of v. The rotation is computed without branches, a zero element
+ * gives an identity rotation.
+ */
+template <std::size_t P, std::size_t Q, typename T, std::size_t L>
+void
+jacobi_rotate(T (&a)[6][L], T (&v)[9][L])
+{
+    constexpr std::size_t R   = 3 - P - Q;
+    constexpr T           eps = std::numeric_limits<T>::epsilon();
+    for (std::size_t i = 0; i < L; ++i) {
+        T const app = a[sym3(P, P)][i];
+        T const aqq = a[sym3(Q, Q)][i];
+        // A negligible element is zeroed, so that the converging elements
+        // don't become denormal
+        T const off = a[sym3(P, Q)][i];
+        T const apq = std::abs(off) > eps * (std::abs(app) + std::abs(aqq)) ? off : T{0};
+        T const arp = a[sym3(R, P)][i];
+        T const arq = a[sym3(R, Q)][i];
+
+        // The smaller rotation angle, the diagonal elements become the
+        // eigenvalues of the 2x2 block, h is their difference
+        T const d    = aqq - app;
+        T const sign = d < 0 ? -1 : 1;
+        T const h    = std::sqrt(d * d + 4 * apq * apq);
+        T const g    = std::sqrt(2 * h * (std::abs(d) + h));
+        T const inv  = 1 / (g > 0 ? g : T{1});
+        T const c    = g > 0 ? (std::abs(d) + h) * inv : T{1};
+        T const s    = 2 * sign * apq * inv;
+        T const mean = (app + aqq) / 2;
+
+        a[sym3(P, P)][i] = mean - sign * h / 2;
+        a[sym3(Q, Q)][i] = mean + sign * h / 2;
+        a[sym3(P, Q)][i] = 0;
+        a[sym3(R, P)][i] = c * arp - s * arq;
+        a[sym3(R, Q)][i] = s * arp + c * arq;
+        for (std::size_t k = 0; k < 3; ++k) {
+            T const vp        = v[k * 3 + P][i];
+            T const vq        = v[k * 3 + Q][i];
+            v[k * 3 + P][i] = c * vp - s * vq;
+            v[k * 3 + Q][i] = s * vp + c * vq;
+        }
+    }
+}
+
+/**
+ * Diagonalise the symmetric matrix a, v is set to the accumulated rotation
+ */
+template <typename T, std::size_t L>
+void
+jacobi_eigen3(T (&a)[6][L], T (&v)[9][L])
+{
+    for (std::size_t e = 0; e < 9; ++e) {
+        for (std::size_t i = 0; i < L; ++i) {
+            v[e][i] = e % 4 == 0 ? T{1} : T{0};
+        }
+    }
+    for (std::size_t sweep = 0; sweep < jacobi_sweeps<T>(); ++sweep) {
+        jacobi_rotate<0, 1>(a, v);
+        jacobi_rotate<0, 2>(a, v);
+        jacobi_rotate<1, 2>(a, v);
+    }
+}
+
+/**
+ * Order the values P and Q descending, the columns of v are exchanged and
+ * one of them is negated to keep v a rotation
+ */
+template <std::size_t P, std::size_t Q, typename T, std::size_t L>
+void
+sort_columns(T (&values)[3][L], T (&v)[9][L])
+{
+    for (std::size_t i = 0; i < L; ++i) {
+        T const    vp   = values[P][i];
+        T const    vq   = values[Q][i];
+        bool const swap = vp < vq;
+        values[P][i]    = swap ? vq : vp;
+        values[Q][i]    = swap ? vp : vq;
+        for (std::size_t k = 0; k < 3; ++k) {
+            T const cp        = v[k * 3 + P][i];
+            T const cq        = v[k * 3 + Q][i];
+            v[k * 3 + P][i] = swap ? cq : cp;
+            v[k * 3 + Q][i] = swap ? -cp : cq;
+        }
+    }
+}
+
+template <typename T, std::size_t L>
+void
+sort_eigen3(T (&values)[3][L], T (&v)[9][L])
+{
+    sort_columns<0, 1>(values, v);
+    sort_columns<0, 2>(values, v);
+    sort_columns<1, 2>(values, v);
+}
+
+/**
+ * Givens rotation of the rows P and Q of b that zeroes the element (Q, P),
+ * the transposed rotation is accumulated in the columns of u
+ */
+template <std::size_t P, std::size_t Q, typename T, std::size_t L>
+void
+givens_rotate(T (&b)[9][L], T (&u)[9][L])
+{
+    for (std::size_t i = 0; i < L; ++i) {
+        T const a1  = b[P * 3 + P][i];
+        T const a2  = b[Q * 3 + P][i];
+        T const r   = std::sqrt(a1 * a1 + a2 * a2);
+        T const inv = 1 / (r > 0 ? r : T{1});
+        T const c   = r > 0 ? a1 * inv : T{1};
+        T const s   = a2 * inv;
+        for (std::size_t k = 0; k < 3; ++k) {
+            T const bp        = b[P * 3 + k][i];
+            T const bq        = b[Q * 3 + k][i];
+            b[P * 3 + k][i] = c * bp + s * bq;
+            b[Q * 3 + k][i] = c * bq - s * bp;
+            T const up        = u[k * 3 + P][i];
+            T const uq        = u[k * 3 + Q][i];
+            u[k * 3 + P][i] = c * up + s * uq;
+            u[k * 3 + Q][i] = c * uq - s * up;
+        }
+    }
+}
+
+template <typename T, std::size_t L>
+void
+store_lane(matrix_packet<T, 3, L> const& p, std::size_t i, matrix<T, 3, 3>& m)
+{
+    for (std::size_t r = 0; r < 3; ++r) {
+        for (std::size_t c = 0; c < 3; ++c) {
+            m[r][c] = p.element(r, c)[i];
+        }
+    }
+}
+
+template <typename T, std::size_t L>
+void
+store_lane(T const (&values)[3][L], std::size_t i, vector<T, 3>& v)
+{
+    for (std::size_t r = 0; r < 3; ++r) {
+        v[r] = values[r][i];
+    }
+}
+
+}    // namespace detail
+
+//@{
+/**
+ * @name Packet operations
+ * Decompositions of all the lanes of a packet, the same fixed number of
+ * steps for every lane without branches.
+ */
+/**
+ * Eigen decomposition of the symmetric matrices of a packet, only the upper
+ * triangles of the matrices are read
+ */
+template <typename T, std::size_t L>
+void
+symmetric_eigen(matrix_packet<T, 3, L> const& m, T (&values)[3][L],
+                matrix_packet<T, 3, L>& vectors)
+{
+    T a[6][L];
+    for (std::size_t r = 0; r < 3; ++r) {
+        for (std::size_t c = r; c < 3; ++c) {
+            for (std::size_t i = 0; i < L; ++i) {
+                a[detail::sym3(r, c)][i] = m.element(r, c)[i];
+            }
+        }
+    }
+    // Local arrays, so that the loops are not versioned for aliasing
+    T v[9][L], d[3][L];
+    detail::jacobi_eigen3(a, v);
+    for (std::size_t r = 0; r < 3; ++r) {
+        for (std::size_t i = 0; i < L; ++i) {
+            d[r][i] = a[r][i];
+        }
+    }
+    detail::sort_eigen3(d, v);
+    std::copy(&d[0][0], &d[0][0] + 3 * L, &values[0][0]);
+    std::copy(&v[0][0], &v[0][0] + 9 * L, &vectors.v[0][0]);
+}
+
+/**
+ * Singular value decomposition of the matrices of a packet. V diagonalises
+ * transpose(A) * A, A * V is orthogonalised by Givens rotations into U.
+ */
+template <typename T, std::size_t L>
+void
+svd(matrix_packet<T, 3, L> const& m, matrix_packet<T, 3, L>& u, T (&s)[3][L],
+    matrix_packet<T, 3, L>& v)
+{
+    T ata[6][L];
+    for (std::size_t r = 0; r < 3; ++r) {
+        for (std::size_t c = r; c < 3; ++c) {
+            for (std::size_t i = 0; i < L; ++i) {
+                ata[detail::sym3(r, c)][i] = m.v[r][i] * m.v[c][i] + m.v[3 + r][i] * m.v[3 + c][i]
+                                             + m.v[6 + r][i] * m.v[6 + c][i];
+            }
+        }
+    }
+    // Local arrays, so that the loops are not versioned for aliasing
+    T vl[9][L], ul[9][L], d[3][L];
+    detail::jacobi_eigen3(ata, vl);
+    for (std::size_t r = 0; r < 3; ++r) {
+        for (std::size_t i = 0; i < L; ++i) {
+            d[r][i] = ata[r][i];
+        }
+    }
+    detail::sort_eigen3(d, vl);
+    std::copy(&vl[0][0], &vl[0][0] + 9 * L, &v.v[0][0]);
+
+    // B = A * V, the columns are orthogonal and sorted by the norm
+    matrix_packet<T, 3, L> b;
+    multiply(m, v, b);
+    for (std::size_t e = 0; e < 9; ++e) {
+        for (std::size_t i = 0; i < L; ++i) {
+            ul[e][i] = e % 4 == 0 ? T{1} : T{0};
+        }
+    }
+    // QR decomposition of B, R is diagonal up to the rounding errors
+    detail::givens_rotate<0, 1>(b.v, ul);
+    detail::givens_rotate<0, 2>(b.v, ul);
+    detail::givens_rotate<1, 2>(b.v, ul);
+    for (std::size_t r = 0; r < 3; ++r) {
+        for (std::size_t i = 0; i < L; ++i) {
+            s[r][i] = b.v[r * 4][i];
+        }
+    }
+    std::copy(&ul[0][0], &ul[0][0] + 9 * L, &u.v[0][0]);
+}
+//@}
+
+//@{
+/** @name Decompositions of a single matrix */
+/**
+ * Eigen decomposition of a symmetric 3x3 matrix, only the upper triangle of
+ * the matrix is read
+ */
+template <typename Expr, typename = traits::enable_if_matrix_expression<Expr>>
+auto
+symmetric_eigen(Expr const& expr)
+{
+    using matrix_type = typename Expr::matrix_type;
+    using value_type  = typename matrix_type::value_type;
+    static_assert(matrix_type::rows == 3 && matrix_type::cols == 3,
+                  "Eigen decomposition is implemented only for 3x3 matrices");
+    matrix<value_type, 3, 3> const  m = expr;
+    matrix_packet<value_type, 3, 1> p, vectors;
+    value_type                      values[3][1];
+    symmetric_eigen3<value_type>    res;
+    p.load(&m, 1);
+    symmetric_eigen(p, values, vectors);
+    detail::store_lane(values, 0, res.values);
+    detail::store_lane(vectors, 0, res.vectors);
+    return res;
+}
+
+template <typename Expr, typename = traits::enable_if_matrix_expression<Expr>>
+auto
+svd(Expr const& expr)
+{
+    using matrix_type = typename Expr::matrix_type;
+    using value_type  = typename matrix_type::value_type;
+    static_assert(matrix_type::rows == 3 && matrix_type::cols == 3,
+                  "Singular value decomposition is implemented only for 3x3 matrices");
+    matrix<value_type, 3, 3> const  m = expr;
+    matrix_packet<value_type, 3, 1> p, u, v;
+    value_type                      s[3][1];
+    svd3<value_type>                res;
+    p.load(&m, 1);
+    svd(p, u, s, v);
+    detail::store_lane(u, 0, res.u);
+    detail::store_lane(s, 0, res.s);
+    detail::store_lane(v, 0, res.v);
+    return res;
+}
+//@}
+
+//@{
+/**
+ * @name Batched decompositions
+ * Decompositions of count independent matrices by packets of
+ * config::batch_lanes matrices.
+ * @param threads maximum number of threads, 0 means the hardware concurrency
+ */
+template <typename T, typename Components>
+void
+symmetric_eigen(matrix<T, 3, 3, Components> const* src, std::size_t count,
+                symmetric_eigen3<T>* dst, std::size_t threads = 1)
+{
+    constexpr std::size_t L = config::batch_lanes;
+    detail::for_each_packet<L, 3>(count, threads, [&](std::size_t first, std::size_t n) {
+        matrix_packet<T, 3, L> p, vectors;
+        T                      values[3][L];
+        p.load(src + first, n);
+        symmetric_eigen(p, values, vectors);
+        for (std::size_t i = 0; i < n; ++i) {
+            detail::store_lane(values, i, dst[first + i].values);
+            detail::store_lane(vectors, i, dst[first + i].vectors);
+        }
+    });
+}
+
+template <typename T, typename Components>
+void
+svd(matrix<T, 3, 3, Components> const* src, std::size_t count, svd3<T>* dst,
+    std::size_t threads = 1)
+{
+    constexpr std::size_t L = config::batch_lanes;
+    detail::for_each_packet<L, 3>(count, threads, [&](std::size_t first, std::size_t n) {
+        matrix_packet<T, 3, L> p, u, v;
+        T                      s[3][L];
+        p.load(src + first, n);
+        svd(p, u, s, v);
+        for (std::size_t i = 0; i < n; ++i) {
+            detail::store_lane(u, i, dst[first + i].u);
+            detail::store_lane(s, i, dst[first + i].s);
+            detail::store_lane(v, i, dst[first + i].v);
+        }
+    });
+}
+//@}
+
+}    // namespace math
+}    // namespace psst
+
+#endif /* PSST_MATH_MATRIX3_DECOMPOSITION_HPP_ */
@@ -0,0 +1,418 @@
+/**
+ * Copyright 2019 Sergei A. Fedorov
+ * matrix_batch.hpp
+ *
+ *  Created on: Mar 6, 2019
+ *      Author: ser-fedorov
+ */
+
+#ifndef PSST_MATH_MATRIX_BATCH_HPP_
+#define PSST_MATH_MATRIX_BATCH_HPP_
+
+#include <psst/math/config.hpp>
+#include <psst/math/detail/parallel.hpp>
+#include <psst/math/matrix.hpp>
+#include <psst/math/vector.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <bitset>
+#include <cstdint>
+#include <type_traits>
+
+namespace psst {
+namespace math {
+
+/**
+ * Square matrices in SoA layout, the values of an element of all the lanes
+ * are contiguous. An operation on L matrices is a loop over the lanes of
+ * scalar code vectorized by the compiler, the lanes of an element fill the
+ * SIMD registers instead of the values of a single matrix. A packet of one
+ * lane is a single matrix.
+ *
+ * Loading and storing a packet transposes the matrices, for the best
+ * throughput keep the matrices in packets between the operations.
+ */
+template <typename T, std::size_t N, std::size_t L>
+struct matrix_packet {
+    static_assert(std::is_floating_point_v<T>, "Matrix packet values must be floating point");
+    static_assert(L == 1 || L == 4 || L == 8 || L == 16, "Packet size must be 1, 4, 8 or 16");
+
+    using value_type = T;
+    /** Bit i is set for the lane i */
+    using mask_type = std::uint32_t;
+
+    static constexpr std::size_t rows = N;
+    static constexpr std::size_t cols = N;
+    static constexpr std::size_t size = L;
+
+    matrix_packet() = default;
+
+    /**
+     * Load count <= L matrices, the rest of the lanes are set to identity
+     */
+    template <typename Components>
+    void
+    load(matrix<T, N, N, Components> const* src, std::size_t count)
+    {
+        for (std::size_t e = 0; e < N * N; ++e) {
+            for (std::size_t i = count; i < L; ++i) {
+                v[e][i] = e % (N + 1) == 0 ? T{1} : T{0};
+            }
+        }
+        for (std::size_t i = 0; i < count; ++i) {
+            T const* p = src[i].data();
+            for (std::size_t e = 0; e < N * N; ++e) {
+                v[e][i] = p[e];
+            }
+        }
+    }
+    /**
+     * Store the first count <= L lanes
+     */
+    template <typename Components>
+    void
+    store(matrix<T, N, N, Components>* dst, std::size_t count) const
+    {
+        for (std::size_t i = 0; i < count; ++i) {
+            T* p = dst[i].data();
+            for (std::size_t e = 0; e < N * N; ++e) {
+                p[e] = v[e][i];
+            }
+        }
+    }
+
+    /** Values of the element at row r and column c of the lanes */
+    T*
+    element(std::size_t r, std::size_t c)
+    {
+        return v[r * N + c];
+    }
+    T const*
+    element(std::size_t r, std::size_t c) const
+    {
+        return v[r * N + c];
+    }
+
+    T v[N * N][L];
+};
+
+namespace detail {
+
+template <std::size_t L>
+std::uint32_t
+singular_mask(std::int32_t const* singular)
+{
+    std::uint32_t mask = 0;
+    for (std::size_t i = 0; i < L; ++i) {
+        mask |= static_cast<std::uint32_t>(singular[i]) << i;
+    }
+    return mask;
+}
+
+}    // namespace detail
+
+//@{
+/**
+ * @name Packet operations
+ * The same operations as for a single matrix for all the lanes of a packet,
+ * without branches. The result may be the same packet as an argument.
+ */
+/**
+ * res = lhs * rhs for each lane
+ */
+template <typename T, std::size_t N, std::size_t L>
+void
+multiply(matrix_packet<T, N, L> const& lhs, matrix_packet<T, N, L> const& rhs,
+         matrix_packet<T, N, L>& res)
+{
+    for (std::size_t i = 0; i < L; ++i) {
+        // Local copies of the lane, so that the loop is not versioned for
+        // aliasing of the result with the arguments
+        T a[N * N], b[N * N];
+        for (std::size_t e = 0; e < N * N; ++e) {
+            a[e] = lhs.v[e][i];
+            b[e] = rhs.v[e][i];
+        }
+        for (std::size_t r = 0; r < N; ++r) {
+            for (std::size_t c = 0; c < N; ++c) {
+                T sum{0};
+                for (std::size_t k = 0; k < N; ++k) {
+                    sum += a[r * N + k] * b[k * N + c];
+                }
+                res.v[r * N + c][i] = sum;
+            }
+        }
+    }
+}
+
+/**
+ * Inverse of each lane by the cofactors. The lanes with a zero determinant
+ * are set to zero.
+ * @return mask of the singular lanes
+ */
+template <typename T, std::size_t L>
+std::uint32_t
+inverse(matrix_packet<T, 2, L> const& m, matrix_packet<T, 2, L>& res)
+{
+    std::int32_t singular[L];
+    for (std::size_t i = 0; i < L; ++i) {
+        T const a00 = m.v[0][i], a01 = m.v[1][i];
+        T const a10 = m.v[2][i], a11 = m.v[3][i];
+        T const det     = a00 * a11 - a01 * a10;
+        T const inv_det = (det != 0 ? T{1} : T{0}) / (det != 0 ? det : T{1});
+        res.v[0][i]     = a11 * inv_det;
+        res.v[1][i]     = -a01 * inv_det;
+        res.v[2][i]     = -a10 * inv_det;
+        res.v[3][i]     = a00 * inv_det;
+        singular[i] = det == 0;
+    }
+    return detail::singular_mask<L>(singular);
+}
+
+template <typename T, std::size_t L>
+std::uint32_t
+inverse(matrix_packet<T, 3, L> const& m, matrix_packet<T, 3, L>& res)
+{
+    std::int32_t singular[L];
+    for (std::size_t i = 0; i < L; ++i) {
+        T const a00 = m.v[0][i], a01 = m.v[1][i], a02 = m.v[2][i];
+        T const a10 = m.v[3][i], a11 = m.v[4][i], a12 = m.v[5][i];
+        T const a20 = m.v[6][i], a21 = m.v[7][i], a22 = m.v[8][i];
+
+        T const c00     = a11 * a22 - a12 * a21;
+        T const c01     = a12 * a20 - a10 * a22;
+        T const c02     = a10 * a21 - a11 * a20;
+        T const det     = a00 * c00 + a01 * c01 + a02 * c02;
+        T const inv_det = (det != 0 ? T{1} : T{0}) / (det != 0 ? det : T{1});
+
+        res.v[0][i] = c00 * inv_det;
+        res.v[1][i] = (a02 * a21 - a01 * a22) * inv_det;
+        res.v[2][i] = (a01 * a12 - a02 * a11) * inv_det;
+        res.v[3][i] = c01 * inv_det;
+        res.v[4][i] = (a00 * a22 - a02 * a20) * inv_det;
+        res.v[5][i] = (a02 * a10 - a00 * a12) * inv_det;
+        res.v[6][i] = c02 * inv_det;
+        res.v[7][i] = (a01 * a20 - a00 * a21) * inv_det;
+        res.v[8][i] = (a00 * a11 - a01 * a10) * inv_det;
+        singular[i] = det == 0;
+    }
+    return detail::singular_mask<L>(singular);
+}
+
+template <typename T, std::size_t L>
+std::uint32_t
+inverse(matrix_packet<T, 4, L> const& m, matrix_packet<T, 4, L>& res)
+{
+    std::int32_t singular[L];
+    for (std::size_t i = 0; i < L; ++i) {
+        T const a00 = m.v[0][i], a01 = m.v[1][i], a02 = m.v[2][i], a03 = m.v[3][i];
+        T const a10 = m.v[4][i], a11 = m.v[5][i], a12 = m.v[6][i], a13 = m.v[7][i];
+        T const a20 = m.v[8][i], a21 = m.v[9][i], a22 = m.v[10][i], a23 = m.v[11][i];
+        T const a30 = m.v[12][i], a31 = m.v[13][i], a32 = m.v[14][i], a33 = m.v[15][i];
+
+        // 2x2 determinants of the two upper and the two lower rows
+        T const s0 = a00 * a11 - a10 * a01;
+        T const s1 = a00 * a12 - a10 * a02;
+        T const s2 = a00 * a13 - a10 * a03;
+        T const s3 = a01 * a12 - a11 * a02;
+        T const s4 = a01 * a13 - a11 * a03;
+        T const s5 = a02 * a13 - a12 * a03;
+        T const c0 = a20 * a31 - a30 * a21;
+        T const c1 = a20 * a32 - a30 * a22;
+        T const c2 = a20 * a33 - a30 * a23;
+        T const c3 = a21 * a32 - a31 * a22;
+        T const c4 = a21 * a33 - a31 * a23;
+        T const c5 = a22 * a33 - a32 * a23;
+
+        T const det     = s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0;
+        T const inv_det = (det != 0 ? T{1} : T{0}) / (det != 0 ? det : T{1});
+
+        res.v[0][i]  = (a11 * c5 - a12 * c4 + a13 * c3) * inv_det;
+        res.v[1][i]  = (-a01 * c5 + a02 * c4 - a03 * c3) * inv_det;
+        res.v[2][i]  = (a31 * s5 - a32 * s4 + a33 * s3) * inv_det;
+        res.v[3][i]  = (-a21 * s5 + a22 * s4 - a23 * s3) * inv_det;
+        res.v[4][i]  = (-a10 * c5 + a12 * c2 - a13 * c1) * inv_det;
+        res.v[5][i]  = (a00 * c5 - a02 * c2 + a03 * c1) * inv_det;
+        res.v[6][i]  = (-a30 * s5 + a32 * s2 - a33 * s1) * inv_det;
+        res.v[7][i]  = (a20 * s5 - a22 * s2 + a23 * s1) * inv_det;
+        res.v[8][i]  = (a10 * c4 - a11 * c2 + a13 * c0) * inv_det;
+        res.v[9][i]  = (-a00 * c4 + a01 * c2 - a03 * c0) * inv_det;
+        res.v[10][i] = (a30 * s4 - a31 * s2 + a33 * s0) * inv_det;
+        res.v[11][i] = (-a20 * s4 + a21 * s2 - a23 * s0) * inv_det;
+        res.v[12][i] = (-a10 * c3 + a11 * c1 - a12 * c0) * inv_det;
+        res.v[13][i] = (a00 * c3 - a01 * c1 + a02 * c0) * inv_det;
+        res.v[14][i] = (-a30 * s3 + a31 * s1 - a32 * s0) * inv_det;
+        res.v[15][i] = (a20 * s3 - a21 * s1 + a22 * s0) * inv_det;
+        singular[i] = det == 0;
+    }
+    return detail::singular_mask<L>(singular);
+}
+//@}
+
+namespace detail {
+
+template <std::size_t L, std::size_t N>
+constexpr std::size_t
+batch_min_packets()
+{
+    return std::max<std::size_t>(config::parallel_min_items / (N * N * L), 1);
+}
+
+/**
+ * Call fn(begin, count) for the packets of L matrices of a batch, split
+ * between threads by chunks of packets
+ */
+template <std::size_t L, std::size_t N, typename Function>
+void
+for_each_packet(std::size_t count, std::size_t threads, Function&& fn)
+{
+    std::size_t const packets = (count + L - 1) / L;
+    parallel_for(packets, batch_min_packets<L, N>(), threads,
+                 [&](std::size_t begin, std::size_t end) {
+                     for (std::size_t p = begin; p < end; ++p) {
+                         fn(p * L, std::min(L, count - p * L));
+                     }
+                 });
+}
+
+}    // namespace detail
+
+//@{
+/**
+ * @name Batched operations
+ * Operations on count independent matrices, loaded by packets of
+ * config::batch_lanes matrices. The destination may be the same range as
+ * a source.
+ * @param threads maximum number of threads, 0 means the hardware concurrency
+ */
+/**
+ * dst[i] = lhs[i] * rhs[i]
+ */
+template <typename T, std::size_t N, typename Components>
+void
+multiply(matrix<T, N, N, Components> const* lhs, matrix<T, N, N, Components> const* rhs,
+         std::size_t count, matrix<T, N, N, Components>* dst, std::size_t threads = 1)
+{
+    constexpr std::size_t L = config::batch_lanes;
+    detail::for_each_packet<L, N>(count, threads, [&](std::size_t first, std::size_t n) {
+        if constexpr (N < 4) {
+            // The product of a single small matrix is vectorized well enough,
+            // the transposition to a packet costs more than it saves
+            for (std::size_t i = first; i < first + n; ++i) {
+                dst[i] = lhs[i] * rhs[i];
+            }
+        } else {
+            matrix_packet<T, N, L> a, b;
+            a.load(lhs + first, n);
+            b.load(rhs + first, n);
+            multiply(a, b, a);
+            a.store(dst + first, n);
+        }
+    });
+}
+
+/**
+ * dst[i] = inverse of src[i], the singular matrices are set to zero
+ * @return number of the singular matrices
+ */
+template <typename T, std::size_t N, typename Components>
+std::size_t
+inverse(matrix<T, N, N, Components> const* src, std::size_t count,
+        matrix<T, N, N, Components>* dst, std::size_t threads = 1)
+{
+    constexpr std::size_t    L = config::batch_lanes;
+    std::atomic<std::size_t> singular{0};
+    detail::for_each_packet<L, N>(count, threads, [&](std::size_t first, std::size_t n) {
+        matrix_packet<T, N, L> m;
+        m.load(src + first, n);
+        if (auto const mask = inverse(m, m))
+            singular += std::bitset<32>{mask}.count();
+        m.store(dst + first, n);
+    });
+    return singular;
+}
+
+/**
+ * dst[i] = lhs[i] * rhs[i] for count packets
+ */
+template <typename T, std::size_t N, std::size_t L>
+void
+multiply(matrix_packet<T, N, L> const* lhs, matrix_packet<T, N, L> const* rhs,
+         std::size_t count, matrix_packet<T, N, L>* dst, std::size_t threads = 1)
+{
+    detail::parallel_for(count, detail::batch_min_packets<L, N>(), threads,
+                         [&](std::size_t begin, std::size_t end) {
+                             for (std::size_t i = begin; i < end; ++i) {
+                                 multiply(lhs[i], rhs[i], dst[i]);
+                             }
+                         });
+}
+
+/**
+ * dst[i] = inverse of src[i] for count packets, the singular matrices are
+ * set to zero
+ * @return number of the singular matrices
+ */
+template <typename T, std::size_t N, std::size_t L>
+std::size_t
+inverse(matrix_packet<T, N, L> const* src, std::size_t count, matrix_packet<T, N, L>* dst,
+        std::size_t threads = 1)
+{
+    std::atomic<std::size_t> singular{0};
+    detail::parallel_for(count, detail::batch_min_packets<L, N>(), threads,
+                         [&](std::size_t begin, std::size_t end) {
+                             std::size_t n = 0;
+                             for (std::size_t i = begin; i < end; ++i) {
+                                 n += std::bitset<32>{inverse(src[i], dst[i])}.count();
+                             }
+                             singular += n;
+                         });
+    return singular;
+}
+
+/**
+ * Solve a[i] * x[i] = b[i] by the inverse of a[i], the solutions of the
+ * singular systems are set to zero
+ * @return number of the singular systems
+ */
+template <typename T, std::size_t N, typename Components, typename VComponents>
+std::size_t
+solve(matrix<T, N, N, Components> const* a, vector<T, N, VComponents> const* b,
+      std::size_t count, vector<T, N, VComponents>* x, std::size_t threads = 1)
+{
+    constexpr std::size_t    L = config::batch_lanes;
+    std::atomic<std::size_t> singular{0};
+    detail::for_each_packet<L, N>(count, threads, [&](std::size_t first, std::size_t n) {
+        matrix_packet<T, N, L> m;
+        m.load(a + first, n);
+        if (auto const mask = inverse(m, m))
+            singular += std::bitset<32>{mask}.count();
+        T rhs[N][L] = {}, res[N][L] = {};
+        for (std::size_t i = 0; i < n; ++i) {
+            for (std::size_t r = 0; r < N; ++r) {
+                rhs[r][i] = b[first + i][r];
+            }
+        }
+        for (std::size_t r = 0; r < N; ++r) {
+            for (std::size_t k = 0; k < N; ++k) {
+                T const* inv = m.element(r, k);
+                for (std::size_t i = 0; i < L; ++i) {
+                    res[r][i] += inv[i] * rhs[k][i];
+                }
+            }
+        }
+        for (std::size_t i = 0; i < n; ++i) {
+            for (std::size_t r = 0; r < N; ++r) {
+                x[first + i][r] = res[r][i];
+            }
+        }
+    });
+    return singular;
+}
+//@}
+
+}    // namespace math
+}    // namespace psst
+
+#endif /* PSST_MATH_MATRIX_BATCH_HPP_ */
@@ -0,0 +1,460 @@
+/**
+ * Copyright 2019 Sergei A. Fedorov
+ * matrix_decomposition.hpp
+ *
+ *  Created on: Mar 7, 2019
+ *      Author: ser-fedorov
+ */
+
+#ifndef PSST_MATH_MATRIX_DECOMPOSITION_HPP_
+#define PSST_MATH_MATRIX_DECOMPOSITION_HPP_
+
+#include <psst/math/matrix.hpp>
+#include <psst/math/vector.hpp>
+
+#include <cmath>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+namespace psst {
+namespace math {
+
+namespace detail {
+
+/**
+ * Copy a square or a tall matrix expression into a plain array
+ */
+template <typename T, std::size_t R, std::size_t C, typename Expr>
+void
+load_matrix(Expr const& expr, T (&a)[R][C])
+{
+    using matrix_type = typename Expr::matrix_type;
+    static_assert(matrix_type::rows == R && matrix_type::cols == C,
+                  "Matrix size doesn't match the decomposition");
+    matrix_type const m = expr;
+    for (std::size_t r = 0; r < R; ++r) {
+        for (std::size_t c = 0; c < C; ++c) {
+            a[r][c] = m[r][c];
+        }
+    }
+}
+
+/**
+ * Number of the right hand side columns, a vector is a single column
+ */
+template <typename Expr>
+constexpr std::size_t
+rhs_cols()
+{
+    if constexpr (traits::is_vector_expression_v<Expr>) {
+        return 1;
+    } else {
+        static_assert(traits::is_matrix_expression_v<Expr>,
+                      "Right hand side must be a vector or a matrix expression");
+        return std::decay_t<Expr>::cols;
+    }
+}
+
+/**
+ * Copy a right hand side expression into a plain array of N rows and K
+ * columns
+ */
+template <typename T, std::size_t N, std::size_t K, typename Expr>
+void
+load_rhs(Expr const& expr, T (&b)[N][K])
+{
+    if constexpr (traits::is_vector_expression_v<Expr>) {
+        using vector_type = typename Expr::result_type;
+        static_assert(vector_type::size == N, "Right hand side size doesn't match the matrix");
+        vector_type const v = expr;
+        for (std::size_t r = 0; r < N; ++r) {
+            b[r][0] = v[r];
+        }
+    } else {
+        load_matrix(expr, b);
+    }
+}
+
+/**
+ * The solution of the type of the right hand side, a vector or a matrix of
+ * N rows
+ */
+template <typename T, std::size_t N, std::size_t K, typename Expr>
+auto
+store_solution(T const (&x)[N][K])
+{
+    if constexpr (traits::is_vector_expression_v<Expr>) {
+        vector<T, N> res;
+        for (std::size_t r = 0; r < N; ++r) {
+            res[r] = x[r][0];
+        }
+        return res;
+    } else {
+        matrix<T, N, K> res;
+        for (std::size_t r = 0; r < N; ++r) {
+            for (std::size_t c = 0; c < K; ++c) {
+                res[r][c] = x[r][c];
+            }
+        }
+        return res;
+    }
+}
+
+}    // namespace detail
+
+/**
+ * LU decomposition with partial pivoting P * A = L * U of a square matrix.
+ * L has ones on the diagonal, both triangles are stored in a single array.
+ * The loops have compile-time bounds, so they are unrolled for small
+ * matrices, the decomposition doesn't allocate memory.
+ */
+template <typename T, std::size_t N>
+class lu_decomposition {
+public:
+    static_assert(std::is_floating_point_v<T>, "LU decomposition requires floating point values");
+    using value_type  = T;
+    using matrix_type = matrix<T, N, N>;
+
+    /**
+     * @throws std::runtime_error if the matrix is singular
+     */
+    template <typename Expr, typename = traits::enable_if_matrix_expression<Expr>>
+    explicit lu_decomposition(Expr const& a)
+    {
+        detail::load_matrix(a, lu_);
+        for (std::size_t r = 0; r < N; ++r) {
+            perm_[r] = r;
+        }
+        for (std::size_t k = 0; k < N; ++k) {
+            std::size_t p = k;
+            for (std::size_t r = k + 1; r < N; ++r) {
+                if (std::abs(lu_[p][k]) < std::abs(lu_[r][k]))
+                    p = r;
+            }
+            if (lu_[p][k] == T{0})
+                throw std::runtime_error("Cannot decompose a singular matrix");
+            if (p != k) {
+                for (std::size_t c = 0; c < N; ++c) {
+                    std::swap(lu_[k][c], lu_[p][c]);
+                }
+                std::swap(perm_[k], perm_[p]);
+                sign_ = -sign_;
+            }
+            T const inv = T{1} / lu_[k][k];
+            for (std::size_t r = k + 1; r < N; ++r) {
+                T const f = lu_[r][k] *= inv;
+                for (std::size_t c = k + 1; c < N; ++c) {
+                    lu_[r][c] -= f * lu_[k][c];
+                }
+            }
+        }
+    }
+
+    /**
+     * Solve A * x = b, b is a vector of N values or a matrix of N rows
+     */
+    template <typename Expr>
+    auto
+    solve(Expr const& b) const
+    {
+        constexpr std::size_t K = detail::rhs_cols<Expr>();
+        T                     rhs[N][K], x[N][K];
+        detail::load_rhs(b, rhs);
+        for (std::size_t r = 0; r < N; ++r) {
+            for (std::size_t c = 0; c < K; ++c) {
+                x[r][c] = rhs[perm_[r]][c];
+            }
+        }
+        // L * y = P * b
+        for (std::size_t r = 1; r < N; ++r) {
+            for (std::size_t k = 0; k < r; ++k) {
+                for (std::size_t c = 0; c < K; ++c) {
+                    x[r][c] -= lu_[r][k] * x[k][c];
+                }
+            }
+        }
+        // U * x = y
+        for (std::size_t r = N; r-- > 0;) {
+            for (std::size_t k = r + 1; k < N; ++k) {
+                for (std::size_t c = 0; c < K; ++c) {
+                    x[r][c] -= lu_[r][k] * x[k][c];
+                }
+            }
+            T const inv = T{1} / lu_[r][r];
+            for (std::size_t c = 0; c < K; ++c) {
+                x[r][c] *= inv;
+            }
+        }
+        return detail::store_solution<T, N, K, Expr>(x);
+    }
+
+    value_type
+    det() const
+    {
+        T res = sign_;
+        for (std::size_t r = 0; r < N; ++r) {
+            res *= lu_[r][r];
+        }
+        return res;
+    }
+
+    matrix_type
+    inverse() const
+    {
+        return solve(matrix_type::identity());
+    }
+
+private:
+    T           lu_[N][N];
+    std::size_t perm_[N];
+    T           sign_ = 1;
+};
+
+/**
+ * Cholesky decomposition A = L * transpose(L) of a symmetric positive
+ * definite matrix. Only the lower triangle of the matrix is read.
+ */
+template <typename T, std::size_t N>
+class cholesky_decomposition {
+public:
+    static_assert(std::is_floating_point_v<T>,
+                  "Cholesky decomposition requires floating point values");
+    using value_type  = T;
+    using matrix_type = matrix<T, N, N>;
+
+    /**
+     * @throws std::runtime_error if the matrix is not positive definite
+     */
+    template <typename Expr, typename = traits::enable_if_matrix_expression<Expr>>
+    explicit cholesky_decomposition(Expr const& a)
+    {
+        detail::load_matrix(a, l_);
+        for (std::size_t c = 0; c < N; ++c) {
+            T d = l_[c][c];
+            for (std::size_t k = 0; k < c; ++k) {
+                d -= l_[c][k] * l_[c][k];
+            }
+            if (!(d > T{0}))
+                throw std::runtime_error("Cannot decompose a matrix that is not positive definite");
+            l_[c][c]     = std::sqrt(d);
+            inv_diag_[c] = T{1} / l_[c][c];
+            for (std::size_t r = c + 1; r < N; ++r) {
+                T s = l_[r][c];
+                for (std::size_t k = 0; k < c; ++k) {
+                    s -= l_[r][k] * l_[c][k];
+                }
+                l_[r][c] = s * inv_diag_[c];
+            }
+        }
+    }
+
+    /**
+     * Solve A * x = b, b is a vector of N values or a matrix of N rows
+     */
+    template <typename Expr>
+    auto
+    solve(Expr const& b) const
+    {
+        constexpr std::size_t K = detail::rhs_cols<Expr>();
+        T                     x[N][K];
+        detail::load_rhs(b, x);
+        // L * y = b
+        for (std::size_t r = 0; r < N; ++r) {
+            for (std::size_t k = 0; k < r; ++k) {
+                for (std::size_t c = 0; c < K; ++c) {
+                    x[r][c] -= l_[r][k] * x[k][c];
+                }
+            }
+            for (std::size_t c = 0; c < K; ++c) {
+                x[r][c] *= inv_diag_[r];
+            }
+        }
+        // transpose(L) * x = y
+        for (std::size_t r = N; r-- > 0;) {
+            for (std::size_t k = r + 1; k < N; ++k) {
+                for (std::size_t c = 0; c < K; ++c) {
+                    x[r][c] -= l_[k][r] * x[k][c];
+                }
+            }
+            for (std::size_t c = 0; c < K; ++c) {
+                x[r][c] *= inv_diag_[r];
+            }
+        }
+        return detail::store_solution<T, N, K, Expr>(x);
+    }
+
+    /**
+     * The lower triangular factor
+     */
+    matrix_type
+    lower() const
+    {
+        matrix_type res;
+        for (std::size_t r = 0; r < N; ++r) {
+            for (std::size_t c = 0; c < N; ++c) {
+                res[r][c] = c <= r ? l_[r][c] : T{0};
+            }
+        }
+        return res;
+    }
+
+    value_type
+    det() const
+    {
+        T res = 1;
+        for (std::size_t r = 0; r < N; ++r) {
+            res *= l_[r][r];
+        }
+        return res * res;
+    }
+
+private:
+    T l_[N][N];
+    T inv_diag_[N];
+};
+
+/**
+ * Householder QR decomposition A = Q * R of a matrix with R >= C rows. Q is
+ * kept as the Householder vectors below the diagonal of R. The solution of
+ * an overdetermined system is the least squares solution.
+ */
+template <typename T, std::size_t R, std::size_t C = R>
+class qr_decomposition {
+public:
+    static_assert(std::is_floating_point_v<T>, "QR decomposition requires floating point values");
+    static_assert(R >= C, "QR decomposition requires at least as many rows as columns");
+    using value_type  = T;
+    using matrix_type = matrix<T, R, C>;
+
+    /**
+     * @throws std::runtime_error if the columns of the matrix are linearly
+     * dependent
+     */
+    template <typename Expr, typename = traits::enable_if_matrix_expression<Expr>>
+    explicit qr_decomposition(Expr const& a)
+    {
+        detail::load_matrix(a, qr_);
+        for (std::size_t k = 0; k < C; ++k) {
+            T norm = 0;
+            for (std::size_t r = k; r < R; ++r) {
+                norm += qr_[r][k] * qr_[r][k];
+            }
+            norm = std::sqrt(norm);
+            if (norm == T{0})
+                throw std::runtime_error("Cannot decompose a rank deficient matrix");
+            // The reflection to the opposite sign avoids the cancellation
+            T const alpha = qr_[k][k] < T{0} ? norm : -norm;
+            qr_[k][k] -= alpha;
+            diag_[k]  = alpha;
+            // H = I - tau * v * transpose(v), v * v = 2 * norm * (norm + |a_kk|)
+            tau_[k] = T{1} / (norm * std::abs(qr_[k][k]));
+            for (std::size_t c = k + 1; c < C; ++c) {
+                T s = 0;
+                for (std::size_t r = k; r < R; ++r) {
+                    s += qr_[r][k] * qr_[r][c];
+                }
+                s *= tau_[k];
+                for (std::size_t r = k; r < R; ++r) {
+                    qr_[r][c] -= s * qr_[r][k];
+                }
+            }
+        }
+    }
+
+    /**
+     * Solve A * x = b in the least squares sense, b is a vector of R values
+     * or a matrix of R rows, x has C rows
+     */
+    template <typename Expr>
+    auto
+    solve(Expr const& b) const
+    {
+        constexpr std::size_t K = detail::rhs_cols<Expr>();
+        T                     y[R][K];
+        detail::load_rhs(b, y);
+        // transpose(Q) * b
+        for (std::size_t k = 0; k < C; ++k) {
+            T s[K] = {};
+            for (std::size_t r = k; r < R; ++r) {
+                for (std::size_t c = 0; c < K; ++c) {
+                    s[c] += qr_[r][k] * y[r][c];
+                }
+            }
+            for (std::size_t c = 0; c < K; ++c) {
+                s[c] *= tau_[k];
+            }
+            for (std::size_t r = k; r < R; ++r) {
+                for (std::size_t c = 0; c < K; ++c) {
+                    y[r][c] -= s[c] * qr_[r][k];
+                }
+            }
+        }
+        // R * x = transpose(Q) * b
+        T x[C][K];
+        for (std::size_t r = C; r-- > 0;) {
+            for (std::size_t c = 0; c < K; ++c) {
+                x[r][c] = y[r][c];
+            }
+            for (std::size_t k = r + 1; k < C; ++k) {
+                for (std::size_t c = 0; c < K; ++c) {
+                    x[r][c] -= qr_[r][k] * x[k][c];
+                }
+            }
+            T const inv = T{1} / diag_[r];
+            for (std::size_t c = 0; c < K; ++c) {
+                x[r][c] *= inv;
+            }
+        }
+        return detail::store_solution<T, C, K, Expr>(x);
+    }
+
+    /**
+     * The upper triangular factor
+     */
+    matrix<T, C, C>
+    upper() const
+    {
+        matrix<T, C, C> res;
+        for (std::size_t r = 0; r < C; ++r) {
+            for (std::size_t c = 0; c < C; ++c) {
+                res[r][c] = r == c ? diag_[r] : (r < c ? qr_[r][c] : T{0});
+            }
+        }
+        return res;
+    }
+
+private:
+    T qr_[R][C];
+    T diag_[C];
+    T tau_[C];
+};
+
+//@{
+/** @name Deduction of the decomposition from a matrix expression */
+template <typename Expr, typename = traits::enable_if_matrix_expression<Expr>>
+lu_decomposition(Expr const&)
+    -> lu_decomposition<typename Expr::value_type, Expr::rows>;
+template <typename Expr, typename = traits::enable_if_matrix_expression<Expr>>
+cholesky_decomposition(Expr const&)
+    -> cholesky_decomposition<typename Expr::value_type, Expr::rows>;
+template <typename Expr, typename = traits::enable_if_matrix_expression<Expr>>
+qr_decomposition(Expr const&)
+    -> qr_decomposition<typename Expr::value_type, Expr::rows, Expr::cols>;
+//@}
+
+/**
+ * Solve a * x = b by the LU decomposition of a
+ * @throws std::runtime_error if a is singular
+ */
+template <typename Matrix, typename Expr, typename = traits::enable_if_matrix_expression<Matrix>>
+auto
+solve(Matrix const& a, Expr const& b)
+{
+    return lu_decomposition{a}.solve(b);
+}
+
+}    // namespace math
+}    // namespace psst
+
+#endif /* PSST_MATH_MATRIX_DECOMPOSITION_HPP_ */
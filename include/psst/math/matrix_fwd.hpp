@@ -17,6 +17,12 @@ template <typename T, size_t RC, size_t CC,
           typename Components = components::default_components_t<(CC > RC) ? CC : RC>>
 struct matrix;
 
+/**
+ * A matrix of a size known at run time
+ */
+template <typename T>
+struct dynamic_matrix;
+
 } /* namespace math */
 } /* namespace psst */
 
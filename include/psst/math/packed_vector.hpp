@@ -0,0 +1,680 @@
+/**
+ * Copyright 2019 Sergei A. Fedorov
+ * packed_vector.hpp
+ *
+ *  Created on: Feb 2, 2019
+ *      Author: ser-fedorov
+ */
+
+#ifndef PSST_MATH_PACKED_VECTOR_HPP_
+#define PSST_MATH_PACKED_VECTOR_HPP_
+
+#include <psst/math/vector.hpp>
+
+#include <cstdint>
+#include <cstring>
+
+namespace psst {
+namespace math {
+
+/**
+ * Namespace for scalar encodings used by packed vectors.
+ *
+ * An encoding defines a storage_type, a value_type and two static functions,
+ * encode and decode, that convert between them. The functions are branch-free
+ * so that the bulk pack/unpack loops can be vectorised by the compiler.
+ */
+namespace encoding {
+
+namespace detail {
+
+template <typename To, typename From>
+To
+bit_cast(From const& from)
+{
+    static_assert(sizeof(To) == sizeof(From), "Sizes of types must be equal for a bit cast");
+    To to;
+    std::memcpy(&to, &from, sizeof(To));
+    return to;
+}
+
+}    // namespace detail
+
+/**
+ * IEEE 754 binary16 (half precision) encoding.
+ * Rounds to nearest even, overflows to infinity, preserves NaN.
+ */
+struct half {
+    using storage_type = std::uint16_t;
+    using value_type   = float;
+
+    static storage_type
+    encode(value_type val)
+    {
+        using detail::bit_cast;
+        constexpr std::uint32_t f32_infinity = 255u << 23;
+        constexpr std::uint32_t f16_max      = (127u + 16u) << 23;
+        constexpr std::uint32_t denorm_magic = ((127u - 15u) + (23u - 10u) + 1u) << 23;
+
+        std::uint32_t bits = bit_cast<std::uint32_t>(val);
+        std::uint32_t sign = bits & 0x80000000u;
+        bits ^= sign;
+
+        // Result is a subnormal half or zero. Adding the magic value aligns the
+        // 10 mantissa bits at the bottom of the float with the hardware rounding.
+        std::uint32_t denorm
+            = bit_cast<std::uint32_t>(bit_cast<float>(bits) + bit_cast<float>(denorm_magic))
+              - denorm_magic;
+        // Normalized half, rebias exponent and round to nearest even
+        std::uint32_t mant_odd = (bits >> 13) & 1u;
+        std::uint32_t normal   = (bits + ((15u - 127u) << 23) + 0xfffu + mant_odd) >> 13;
+        // Infinity or NaN
+        std::uint32_t inf_nan = bits > f32_infinity ? 0x7e00u : 0x7c00u;
+
+        std::uint32_t res
+            = bits >= f16_max ? inf_nan : bits < (113u << 23) ? denorm : normal;
+        return static_cast<storage_type>(res | (sign >> 16));
+    }
+
+    static value_type
+    decode(storage_type val)
+    {
+        using detail::bit_cast;
+        constexpr std::uint32_t shifted_exp = 0x7c00u << 13;
+        constexpr std::uint32_t magic       = 113u << 23;
+
+        std::uint32_t bits = (std::uint32_t{val} & 0x7fffu) << 13;
+        std::uint32_t exp  = shifted_exp & bits;
+        bits += (127u - 15u) << 23;
+
+        // Infinity or NaN, adjust the exponent once more
+        std::uint32_t inf_nan = bits + ((128u - 16u) << 23);
+        // Zero or subnormal, renormalize
+        std::uint32_t denorm = bit_cast<std::uint32_t>(
+            bit_cast<float>(bits + (1u << 23)) - bit_cast<float>(magic));
+
+        bits = exp == shifted_exp ? inf_nan : exp == 0 ? denorm : bits;
+        bits |= (std::uint32_t{val} & 0x8000u) << 16;
+        return bit_cast<float>(bits);
+    }
+};
+
+/**
+ * Signed normalized integer encoding, maps [-1, 1] to [-max, max].
+ */
+template <typename Integer>
+struct snorm {
+    static_assert(std::is_integral<Integer>{} && std::is_signed<Integer>{},
+                  "Storage type for snorm encoding must be a signed integer");
+    using storage_type = Integer;
+    using value_type   = float;
+
+    static constexpr value_type max_value = std::numeric_limits<storage_type>::max();
+
+    static storage_type
+    encode(value_type val)
+    {
+        using std::round;
+        val = val < -1 ? -1 : val > 1 ? 1 : val;
+        return static_cast<storage_type>(round(val * max_value));
+    }
+
+    static value_type
+    decode(storage_type val)
+    {
+        value_type res = val / max_value;
+        // The minimal value of the storage type is -1 as well
+        return res < -1 ? -1 : res;
+    }
+};
+
+/**
+ * Unsigned normalized integer encoding, maps [0, 1] to [0, max].
+ */
+template <typename Integer>
+struct unorm {
+    static_assert(std::is_integral<Integer>{} && std::is_unsigned<Integer>{},
+                  "Storage type for unorm encoding must be an unsigned integer");
+    using storage_type = Integer;
+    using value_type   = float;
+
+    static constexpr value_type max_value = std::numeric_limits<storage_type>::max();
+
+    static storage_type
+    encode(value_type val)
+    {
+        using std::round;
+        val = val < 0 ? 0 : val > 1 ? 1 : val;
+        return static_cast<storage_type>(round(val * max_value));
+    }
+
+    static value_type
+    decode(storage_type val)
+    {
+        return val / max_value;
+    }
+};
+
+using snorm8  = snorm<std::int8_t>;
+using snorm16 = snorm<std::int16_t>;
+using unorm8  = unorm<std::uint8_t>;
+using unorm16 = unorm<std::uint16_t>;
+
+}    // namespace encoding
+
+//----------------------------------------------------------------------------
+/**
+ * A vector that stores it's components in a compact encoded form and decodes
+ * them on access. A packed vector is a vector expression, so it can be used in
+ * any vector expression and converted to a full precision vector.
+ *
+ * @code
+ * using normal_h = packed_vector<encoding::half, 3>;
+ * normal_h n = vector<float, 3>{0, 1, 0};
+ * vector<float, 3> v = n * 2;
+ * @endcode
+ */
+template <typename Encoding, std::size_t Size,
+          typename Components = components::default_components_t<Size>>
+struct packed_vector
+    : expr::vector_expression<packed_vector<Encoding, Size, Components>,
+                              vector<typename Encoding::value_type, Size, Components>> {
+    using this_type            = packed_vector<Encoding, Size, Components>;
+    using encoding_type        = Encoding;
+    using storage_type         = typename encoding_type::storage_type;
+    using base_expression_type = expr::vector_expression<
+        this_type, vector<typename encoding_type::value_type, Size, Components>>;
+    using value_type          = typename base_expression_type::value_type;
+    using index_sequence_type = typename base_expression_type::index_sequence_type;
+    using init_list           = std::initializer_list<value_type>;
+
+    static constexpr auto size = base_expression_type::size;
+
+    constexpr packed_vector() : data_{} {}
+
+    packed_vector(init_list const& args) : data_{}
+    {
+        auto p = args.begin();
+        for (std::size_t i = 0; i < size && p != args.end(); ++i, ++p) {
+            data_[i] = encoding_type::encode(*p);
+        }
+    }
+
+    template <typename Expression, typename = math::traits::enable_if_vector_expression<Expression>,
+              typename = math::traits::enable_for_compatible_components<this_type, Expression>>
+    /* implicit */ packed_vector(Expression const& rhs) : data_{}
+    {
+        assign(rhs, utils::make_min_index_sequence<
+                        size, math::traits::vector_expression_size_v<Expression>>{});
+    }
+
+    template <typename Expression, typename = math::traits::enable_if_vector_expression<Expression>,
+              typename = math::traits::enable_for_compatible_components<this_type, Expression>>
+    packed_vector&
+    operator=(Expression const& rhs)
+    {
+        return assign(rhs, utils::make_min_index_sequence<
+                               size, math::traits::vector_expression_size_v<Expression>>{});
+    }
+
+    template <std::size_t N>
+    value_type
+    at() const
+    {
+        static_assert(N < size, "Invalid component index in packed vector");
+        return encoding_type::decode(std::get<N>(data_));
+    }
+
+    /**
+     * Encode and store a value for the component N.
+     */
+    template <std::size_t N>
+    void
+    set(value_type val)
+    {
+        static_assert(N < size, "Invalid component index in packed vector");
+        std::get<N>(data_) = encoding_type::encode(val);
+    }
+
+    value_type operator[](std::size_t idx) const
+    {
+        assert(idx < size);
+        return encoding_type::decode(data_[idx]);
+    }
+
+    storage_type*
+    data()
+    {
+        return data_.data();
+    }
+    constexpr storage_type const*
+    data() const
+    {
+        return data_.data();
+    }
+
+private:
+    template <typename Expr, std::size_t... Indexes>
+    packed_vector&
+    assign(Expr const& rhs, std::index_sequence<Indexes...>)
+    {
+        ((std::get<Indexes>(data_) = encoding_type::encode(expr::get<Indexes>(rhs))), ...);
+        return *this;
+    }
+
+private:
+    std::array<storage_type, Size> data_;
+};
+
+//----------------------------------------------------------------------------
+/**
+ * Four component vector packed into a single 32-bit word, three 10-bit
+ * components and one 2-bit component. The first component occupies the least
+ * significant bits. Components are normalized, signed or unsigned.
+ */
+template <bool Signed, typename Components = components::default_components_t<4>>
+struct packed_10_10_10_2
+    : expr::vector_expression<packed_10_10_10_2<Signed, Components>, vector<float, 4, Components>> {
+    using this_type            = packed_10_10_10_2<Signed, Components>;
+    using storage_type         = std::uint32_t;
+    using base_expression_type = expr::vector_expression<this_type, vector<float, 4, Components>>;
+    using value_type           = typename base_expression_type::value_type;
+    using init_list            = std::initializer_list<value_type>;
+
+    static constexpr auto size = base_expression_type::size;
+
+    template <std::size_t N>
+    static constexpr std::uint32_t bits = N < 3 ? 10 : 2;
+    template <std::size_t N>
+    static constexpr std::uint32_t shift = N * 10;
+    template <std::size_t N>
+    static constexpr std::uint32_t mask = (1u << bits<N>)-1;
+    template <std::size_t N>
+    static constexpr value_type max_value = Signed ? (mask<N> >> 1) : mask<N>;
+
+    constexpr packed_10_10_10_2() : data_{0} {}
+    explicit constexpr packed_10_10_10_2(storage_type raw) : data_{raw} {}
+
+    packed_10_10_10_2(init_list const& args) : data_{0}
+    {
+        assign(vector<value_type, 4, Components>(args), std::make_index_sequence<4>{});
+    }
+
+    template <typename Expression, typename = math::traits::enable_if_vector_expression<Expression>,
+              typename = math::traits::enable_for_compatible_components<this_type, Expression>>
+    /* implicit */ packed_10_10_10_2(Expression const& rhs) : data_{0}
+    {
+        assign(rhs, utils::make_min_index_sequence<
+                        size, math::traits::vector_expression_size_v<Expression>>{});
+    }
+
+    template <typename Expression, typename = math::traits::enable_if_vector_expression<Expression>,
+              typename = math::traits::enable_for_compatible_components<this_type, Expression>>
+    packed_10_10_10_2&
+    operator=(Expression const& rhs)
+    {
+        data_ = 0;
+        return assign(rhs, utils::make_min_index_sequence<
+                               size, math::traits::vector_expression_size_v<Expression>>{});
+    }
+
+    template <std::size_t N>
+    value_type
+    at() const
+    {
+        static_assert(N < size, "Invalid component index in packed vector");
+        std::uint32_t raw = (data_ >> shift<N>)&mask<N>;
+        if constexpr (Signed) {
+            // Sign-extend the field
+            std::int32_t val = static_cast<std::int32_t>(raw << (32 - bits<N>)) >> (32 - bits<N>);
+            value_type   res = val / max_value<N>;
+            return res < -1 ? -1 : res;
+        } else {
+            return raw / max_value<N>;
+        }
+    }
+
+    template <std::size_t N>
+    void
+    set(value_type val)
+    {
+        static_assert(N < size, "Invalid component index in packed vector");
+        using std::round;
+        constexpr value_type lo = Signed ? -1 : 0;
+        val                     = val < lo ? lo : val > 1 ? 1 : val;
+        auto raw = static_cast<std::uint32_t>(static_cast<std::int32_t>(round(val * max_value<N>)));
+        data_    = (data_ & ~(mask<N> << shift<N>)) | ((raw & mask<N>) << shift<N>);
+    }
+
+    value_type operator[](std::size_t idx) const
+    {
+        assert(idx < size);
+        switch (idx) {
+        case 0:
+            return at<0>();
+        case 1:
+            return at<1>();
+        case 2:
+            return at<2>();
+        default:
+            return at<3>();
+        }
+    }
+
+    constexpr storage_type
+    raw() const
+    {
+        return data_;
+    }
+
+private:
+    template <typename Expr, std::size_t... Indexes>
+    packed_10_10_10_2&
+    assign(Expr const& rhs, std::index_sequence<Indexes...>)
+    {
+        (this->template set<Indexes>(expr::get<Indexes>(rhs)), ...);
+        return *this;
+    }
+
+private:
+    storage_type data_;
+};
+
+template <typename Components = components::default_components_t<4>>
+using unorm_10_10_10_2 = packed_10_10_10_2<false, Components>;
+template <typename Components = components::default_components_t<4>>
+using snorm_10_10_10_2 = packed_10_10_10_2<true, Components>;
+
+//----------------------------------------------------------------------------
+template <typename T>
+struct decoded_normal;
+
+/**
+ * Unit vector stored as two components using octahedral mapping.
+ *
+ * The unit sphere is projected onto an octahedron, that is unfolded onto a
+ * square [-1, 1]². The two coordinates on the square are stored using the
+ * Encoding. Decoding yields a normalized vector.
+ *
+ * All the components are decoded together. An argument of an expression or a
+ * conversion to a vector is evaluated to a decoded_normal, so the normal is
+ * decoded once per use instead of once per component.
+ */
+template <typename Encoding = encoding::snorm16>
+struct octahedral_normal
+    : expr::vector_expression<octahedral_normal<Encoding>,
+                              vector<typename Encoding::value_type, 3, components::xyzw>> {
+    using this_type            = octahedral_normal<Encoding>;
+    using encoding_type        = Encoding;
+    using storage_type         = typename encoding_type::storage_type;
+    using base_expression_type = expr::vector_expression<
+        this_type, vector<typename encoding_type::value_type, 3, components::xyzw>>;
+    using value_type      = typename base_expression_type::value_type;
+    using result_type     = typename base_expression_type::result_type;
+    using expression_type = decoded_normal<value_type>;
+
+    static constexpr auto size = base_expression_type::size;
+
+    constexpr octahedral_normal() : data_{} {}
+
+    template <typename Expression, typename = math::traits::enable_if_vector_expression<Expression>,
+              typename = math::traits::enable_for_compatible_components<this_type, Expression>>
+    /* implicit */ octahedral_normal(Expression const& rhs) : data_{}
+    {
+        assign(rhs);
+    }
+
+    template <typename Expression, typename = math::traits::enable_if_vector_expression<Expression>,
+              typename = math::traits::enable_for_compatible_components<this_type, Expression>>
+    octahedral_normal&
+    operator=(Expression const& rhs)
+    {
+        return assign(rhs);
+    }
+
+    template <std::size_t N>
+    value_type
+    at() const
+    {
+        static_assert(N < size, "Invalid component index in octahedral normal");
+        return decoded().template at<N>();
+    }
+
+    value_type operator[](std::size_t idx) const
+    {
+        assert(idx < size);
+        return decoded()[idx];
+    }
+
+    result_type
+    decoded() const
+    {
+        return decode(encoding_type::decode(data_[0]), encoding_type::decode(data_[1]));
+    }
+
+    storage_type*
+    data()
+    {
+        return data_.data();
+    }
+    constexpr storage_type const*
+    data() const
+    {
+        return data_.data();
+    }
+
+    /**
+     * Map a direction onto the octahedron square. The vector doesn't need to
+     * be normalized, but must not be zero.
+     */
+    static vector<value_type, 2, components::xyzw>
+    encode(value_type x, value_type y, value_type z)
+    {
+        using std::abs;
+        value_type l1 = abs(x) + abs(y) + abs(z);
+        value_type u  = x / l1;
+        value_type v  = y / l1;
+        if (z < 0) {
+            value_type fu = (1 - abs(v)) * (u >= 0 ? 1 : -1);
+            value_type fv = (1 - abs(u)) * (v >= 0 ? 1 : -1);
+            u             = fu;
+            v             = fv;
+        }
+        return {u, v};
+    }
+
+    /**
+     * Map a point on the octahedron square back to a unit vector.
+     */
+    static result_type
+    decode(value_type u, value_type v)
+    {
+        using std::abs;
+        using std::sqrt;
+        value_type z = 1 - abs(u) - abs(v);
+        // Unfold the lower hemisphere without branching
+        value_type t = z < 0 ? -z : 0;
+        value_type x = u + (u >= 0 ? -t : t);
+        value_type y = v + (v >= 0 ? -t : t);
+        value_type l = 1 / sqrt(x * x + y * y + z * z);
+        return {x * l, y * l, z * l};
+    }
+
+private:
+    template <typename Expr>
+    octahedral_normal&
+    assign(Expr const& rhs)
+    {
+        auto uv  = encode(expr::get<0>(rhs), expr::get<1>(rhs), expr::get<2>(rhs));
+        data_[0] = encoding_type::encode(uv.x());
+        data_[1] = encoding_type::encode(uv.y());
+        return *this;
+    }
+
+private:
+    std::array<storage_type, 2> data_;
+};
+
+/**
+ * Octahedral normal decoded to be used in expressions
+ */
+template <typename T>
+struct decoded_normal
+    : expr::vector_expression<decoded_normal<T>, vector<T, 3, components::xyzw>> {
+    using base_expression_type
+        = expr::vector_expression<decoded_normal<T>, vector<T, 3, components::xyzw>>;
+    using value_type  = typename base_expression_type::value_type;
+    using result_type = typename base_expression_type::result_type;
+
+    static constexpr auto size = base_expression_type::size;
+
+    template <typename Encoding>
+    /* implicit */ decoded_normal(octahedral_normal<Encoding> const& rhs) : value_{rhs.decoded()}
+    {}
+
+    template <std::size_t N>
+    constexpr value_type
+    at() const
+    {
+        return value_.template at<N>();
+    }
+
+    value_type operator[](std::size_t idx) const
+    {
+        return value_[idx];
+    }
+
+private:
+    result_type value_;
+};
+
+namespace expr {
+
+/**
+ * The decoded value of an octahedral normal is a part of the expression,
+ * even if the normal is an lvalue
+ */
+template <typename T>
+struct arg_by_value<decoded_normal<T>> : std::true_type {};
+
+}    // namespace expr
+
+//----------------------------------------------------------------------------
+//@{
+/** @name Bulk pack and unpack */
+/**
+ * Encode a contiguous range of scalars. The loop has no dependencies between
+ * iterations and the encodings are branch-free, so the compiler vectorises it.
+ */
+template <typename Encoding>
+void
+pack(typename Encoding::value_type const* src, std::size_t count,
+     typename Encoding::storage_type* dst)
+{
+    for (std::size_t i = 0; i < count; ++i) {
+        dst[i] = Encoding::encode(src[i]);
+    }
+}
+
+/**
+ * Decode a contiguous range of scalars.
+ */
+template <typename Encoding>
+void
+unpack(typename Encoding::storage_type const* src, std::size_t count,
+       typename Encoding::value_type* dst)
+{
+    for (std::size_t i = 0; i < count; ++i) {
+        dst[i] = Encoding::decode(src[i]);
+    }
+}
+
+template <typename Encoding, std::size_t Size, typename Components>
+void
+pack(vector<typename Encoding::value_type, Size, Components> const* src, std::size_t count,
+     packed_vector<Encoding, Size, Components>* dst)
+{
+    using source_type = vector<typename Encoding::value_type, Size, Components>;
+    using target_type = packed_vector<Encoding, Size, Components>;
+    static_assert(sizeof(source_type) == sizeof(typename Encoding::value_type) * Size,
+                  "Vector must have the memory layout of an array");
+    static_assert(sizeof(target_type) == sizeof(typename Encoding::storage_type) * Size,
+                  "Packed vector must have the memory layout of an array");
+    if (count > 0)
+        pack<Encoding>(src->data(), count * Size, dst->data());
+}
+
+template <typename Encoding, std::size_t Size, typename Components>
+void
+unpack(packed_vector<Encoding, Size, Components> const* src, std::size_t count,
+       vector<typename Encoding::value_type, Size, Components>* dst)
+{
+    using source_type = packed_vector<Encoding, Size, Components>;
+    using target_type = vector<typename Encoding::value_type, Size, Components>;
+    static_assert(sizeof(source_type) == sizeof(typename Encoding::storage_type) * Size,
+                  "Packed vector must have the memory layout of an array");
+    static_assert(sizeof(target_type) == sizeof(typename Encoding::value_type) * Size,
+                  "Vector must have the memory layout of an array");
+    if (count > 0)
+        unpack<Encoding>(src->data(), count * Size, dst->data());
+}
+
+template <bool Signed, typename Components>
+void
+pack(vector<float, 4, Components> const* src, std::size_t count,
+     packed_10_10_10_2<Signed, Components>* dst)
+{
+    for (std::size_t i = 0; i < count; ++i) {
+        dst[i] = src[i];
+    }
+}
+
+template <bool Signed, typename Components>
+void
+unpack(packed_10_10_10_2<Signed, Components> const* src, std::size_t count,
+       vector<float, 4, Components>* dst)
+{
+    for (std::size_t i = 0; i < count; ++i) {
+        dst[i] = src[i];
+    }
+}
+
+template <typename Encoding>
+void
+pack(vector<typename Encoding::value_type, 3, components::xyzw> const* src, std::size_t count,
+     octahedral_normal<Encoding>* dst)
+{
+    for (std::size_t i = 0; i < count; ++i) {
+        dst[i] = src[i];
+    }
+}
+
+template <typename Encoding>
+void
+unpack(octahedral_normal<Encoding> const* src, std::size_t count,
+       vector<typename Encoding::value_type, 3, components::xyzw>* dst)
+{
+    for (std::size_t i = 0; i < count; ++i) {
+        dst[i] = src[i].decoded();
+    }
+}
+//@}
+
+//@{
+/** @name Type aliases for commonly used packed vectors */
+template <std::size_t Size, typename Components = components::default_components_t<Size>>
+using half_vector = packed_vector<encoding::half, Size, Components>;
+template <std::size_t Size, typename Components = components::default_components_t<Size>>
+using snorm8_vector = packed_vector<encoding::snorm8, Size, Components>;
+template <std::size_t Size, typename Components = components::default_components_t<Size>>
+using snorm16_vector = packed_vector<encoding::snorm16, Size, Components>;
+template <std::size_t Size, typename Components = components::default_components_t<Size>>
+using unorm8_vector = packed_vector<encoding::unorm8, Size, Components>;
+template <std::size_t Size, typename Components = components::default_components_t<Size>>
+using unorm16_vector = packed_vector<encoding::unorm16, Size, Components>;
+//@}
+
+}    // namespace math
+}    // namespace psst
+
+#endif /* PSST_MATH_PACKED_VECTOR_HPP_ */
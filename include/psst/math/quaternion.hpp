@@ -188,7 +188,8 @@ struct quaternion_conjugate : unary_vector_expression<quaternion_conjugate, Expr
     at() const
     {
         static_assert(N < base_type::size, "Invalid quaternion component index");
-        if constexpr (N == components::wxyz::w) {
+        // Scalar parts of a quaternion or of both parts of a dual quaternion
+        if constexpr (N % 4 == components::wxyz::w) {
             return this->arg_.template at<N>();
         } else {
             return -this->arg_.template at<N>();
@@ -196,7 +197,8 @@ struct quaternion_conjugate : unary_vector_expression<quaternion_conjugate, Expr
     }
 };
 
-template <typename Expr, typename = traits::enable_for_components<Expr, components::wxyz>>
+template <typename Expr, typename = traits::enable_for_components<Expr, components::wxyz,
+                                                                  components::dual_wxyz>>
 constexpr auto
 conjugate(Expr&& expr)
 {
@@ -205,17 +207,204 @@ conjugate(Expr&& expr)
 //@}
 
 //@{
-template <typename Expr, typename = traits::enable_for_components<Expr, components::wxyz>>
+/**
+ * A dual quaternion of a rigid transform has orthogonal real and dual
+ * parts, so it's inverted by the conjugate as well, divided by the squared
+ * magnitude of the real part.
+ */
+template <typename Expr, typename = traits::enable_for_components<Expr, components::wxyz,
+                                                                  components::dual_wxyz>>
 constexpr auto
 inverse(Expr&& expr)
 {
-    auto mag_sq = magnitude_square(expr).value();
+    auto mag_sq = [&expr]() {
+        if constexpr (traits::has_components_v<Expr, components::dual_wxyz>) {
+            return magnitude_square(expr.real()).value();
+        } else {
+            return magnitude_square(expr).value();
+        }
+    }();
     if (mag_sq == 0)
         throw std::runtime_error("Cannot inverse a zero quaternion");
     return conjugate(std::forward<Expr>(expr)) / mag_sq;
 }
 //@}
 
+//@{
+/** @name Rotate a vector by a unit quaternion */
+/**
+ * Rotation of a 3D vector v by a unit quaternion q = (w, u) without
+ * computing q * v * q^-1:
+ *
+ *     t  = 2 (u x v)
+ *     v' = v + w t + u x t
+ *
+ * Every component of the result depends on all of t, so the rotation is
+ * evaluated when the expression is built. The arguments are evaluated once
+ * instead of once per component.
+ *
+ * The quaternion is expected to be normalized.
+ */
+template <typename Quaternion, typename Vector>
+struct quaternion_rotate : binary_vector_expression<quaternion_rotate, Quaternion, Vector,
+                                                    traits::vector_expression_result_t<Vector>> {
+    using base_type = binary_vector_expression<quaternion_rotate, Quaternion, Vector,
+                                               traits::vector_expression_result_t<Vector>>;
+    static_assert(base_type::size == 3, "Only a 3D vector can be rotated by a quaternion");
+    using value_type      = typename base_type::value_type;
+    using result_type     = typename base_type::result_type;
+    using quaternion_type = std::decay_t<Quaternion>;
+    using vector_type     = std::decay_t<Vector>;
+
+    quaternion_rotate(quaternion_type const& q, vector_type const& v) : value_{rotated(q, v)} {}
+
+    template <std::size_t N>
+    constexpr value_type
+    at() const
+    {
+        static_assert(N < base_type::size, "Invalid vector component index");
+        return value_.template at<N>();
+    }
+
+private:
+    static result_type
+    rotated(quaternion_type const& q, vector_type const& v)
+    {
+        // Vector part of the quaternion starts at index 1
+        value_type const w  = q.template at<0>();
+        value_type const x  = q.template at<1>();
+        value_type const y  = q.template at<2>();
+        value_type const z  = q.template at<3>();
+        value_type const vx = v.template at<0>();
+        value_type const vy = v.template at<1>();
+        value_type const vz = v.template at<2>();
+
+        value_type const tx = 2 * (y * vz - z * vy);
+        value_type const ty = 2 * (z * vx - x * vz);
+        value_type const tz = 2 * (x * vy - y * vx);
+        return {vx + w * tx + y * tz - z * ty, vy + w * ty + z * tx - x * tz,
+                vz + w * tz + x * ty - y * tx};
+    }
+
+    result_type value_;
+};
+
+template <typename Quaternion, typename Vector,
+          typename = traits::enable_for_components<Quaternion, components::wxyz>,
+          typename = traits::enable_if_vector_expression<Vector>>
+constexpr auto
+rotate(Quaternion&& q, Vector&& v)
+{
+    return make_binary_expression<quaternion_rotate>(std::forward<Quaternion>(q),
+                                                     std::forward<Vector>(v));
+}
+//@}
+
+//@{
+/** @name Quaternion interpolation */
+namespace detail {
+
+/**
+ * Normalized linear interpolation along the shortest path
+ */
+template <typename T>
+vector<T, 4, components::wxyz>
+nlerp(vector<T, 4, components::wxyz> const& start, vector<T, 4, components::wxyz> const& end,
+      T percent)
+{
+    using std::sqrt;
+    T const dot = start[0] * end[0] + start[1] * end[1] + start[2] * end[2] + start[3] * end[3];
+    // q and -q are the same rotation, take the one closer to start
+    T const a = 1 - percent;
+    T const b = dot < 0 ? -percent : percent;
+    T const w = start[0] * a + end[0] * b;
+    T const x = start[1] * a + end[1] * b;
+    T const y = start[2] * a + end[2] * b;
+    T const z = start[3] * a + end[3] * b;
+    T const n = 1 / sqrt(w * w + x * x + y * y + z * z);
+    return {w * n, x * n, y * n, z * n};
+}
+
+/**
+ * Spherical linear interpolation along the shortest path without
+ * trigonometric functions. sin(t * theta) / sin(theta) is expanded in a
+ * polynomial of (cos(theta) - 1), the last term is corrected to minimize the
+ * error of the truncated series (D. Eberly, A Fast and Accurate Algorithm for
+ * Computing SLERP). The maximum error of a component is about 2e-5.
+ */
+template <typename T>
+constexpr vector<T, 4, components::wxyz>
+fast_slerp(vector<T, 4, components::wxyz> const& start,
+           vector<T, 4, components::wxyz> const& end, T percent)
+{
+    constexpr std::size_t terms = 8;
+    constexpr T           mu    = T(1.85298109240830);
+    // u[i] = 1 / (i * (2i + 1)), v[i] = i / (2i + 1), i = 1..8
+    constexpr T u[terms]{T(1) / (1 * 3),  T(1) / (2 * 5),  T(1) / (3 * 7),  T(1) / (4 * 9),
+                         T(1) / (5 * 11), T(1) / (6 * 13), T(1) / (7 * 15), mu / (8 * 17)};
+    constexpr T v[terms]{T(1) / 3,  T(2) / 5,  T(3) / 7,  T(4) / 9,
+                         T(5) / 11, T(6) / 13, T(7) / 15, mu * 8 / 17};
+
+    T dot = start[0] * end[0] + start[1] * end[1] + start[2] * end[2] + start[3] * end[3];
+    T const sign = dot < 0 ? T{-1} : T{1};
+    dot *= sign;
+
+    T const xm1 = dot - 1;
+    T const d   = 1 - percent;
+    T const sqt = percent * percent;
+    T const sqd = d * d;
+    T       ct  = 1;
+    T       cd  = 1;
+    for (std::size_t i = terms; i > 0; --i) {
+        ct = 1 + (u[i - 1] * sqt - v[i - 1]) * xm1 * ct;
+        cd = 1 + (u[i - 1] * sqd - v[i - 1]) * xm1 * cd;
+    }
+    ct *= sign * percent;
+    cd *= d;
+    return {start[0] * cd + end[0] * ct, start[1] * cd + end[1] * ct,
+            start[2] * cd + end[2] * ct, start[3] * cd + end[3] * ct};
+}
+
+}    // namespace detail
+
+/**
+ * Normalized linear interpolation of rotations, takes the shortest path.
+ * The angular velocity is not constant, but the result is always a unit
+ * quaternion and it's the cheapest blend.
+ */
+template <typename Start, typename End, typename U,
+          typename = traits::enable_for_components<Start, components::wxyz>,
+          typename = traits::enable_for_components<End, components::wxyz>,
+          typename = std::enable_if_t<traits::is_scalar_v<U>>>
+auto
+nlerp(Start&& start, End&& end, U percent)
+{
+    using result_type = traits::vector_expression_result_t<Start, End>;
+    using value_type  = typename result_type::value_type;
+    return detail::nlerp<value_type>(result_type(std::forward<Start>(start)),
+                                     result_type(std::forward<End>(end)),
+                                     static_cast<value_type>(percent));
+}
+
+/**
+ * Approximation of spherical linear interpolation of unit quaternions,
+ * takes the shortest path. Uses only multiplications and additions.
+ */
+template <typename Start, typename End, typename U,
+          typename = traits::enable_for_components<Start, components::wxyz>,
+          typename = traits::enable_for_components<End, components::wxyz>,
+          typename = std::enable_if_t<traits::is_scalar_v<U>>>
+constexpr auto
+fast_slerp(Start&& start, End&& end, U percent)
+{
+    using result_type = traits::vector_expression_result_t<Start, End>;
+    using value_type  = typename result_type::value_type;
+    return detail::fast_slerp<value_type>(result_type(std::forward<Start>(start)),
+                                          result_type(std::forward<End>(end)),
+                                          static_cast<value_type>(percent));
+}
+//@}
+
 }    // namespace v
 }    // namespace expr
 
@@ -240,6 +429,103 @@ component_access<4, components::wxyz, VectorType, T>::vector_part() const
 template <typename T>
 using quaternion = vector<T, 4, components::wxyz>;
 
+//@{
+/** @name Bulk rotation */
+/**
+ * Rotate a contiguous range of vectors by a unit quaternion. The quaternion
+ * components are loaded once and the loop has no dependencies between
+ * iterations, so the compiler vectorises it. The source and the destination
+ * may be the same range.
+ */
+template <typename T, typename U, typename Components>
+void
+rotate(quaternion<T> const& q, vector<U, 3, Components> const* src, std::size_t count,
+       vector<U, 3, Components>* dst)
+{
+    U const w = q.w(), x = q.x(), y = q.y(), z = q.z();
+    for (std::size_t i = 0; i < count; ++i) {
+        U const vx = src[i][0], vy = src[i][1], vz = src[i][2];
+        U const tx = 2 * (y * vz - z * vy);
+        U const ty = 2 * (z * vx - x * vz);
+        U const tz = 2 * (x * vy - y * vx);
+        dst[i][0]  = vx + w * tx + y * tz - z * ty;
+        dst[i][1]  = vy + w * ty + z * tx - x * tz;
+        dst[i][2]  = vz + w * tz + x * ty - y * tx;
+    }
+}
+
+/**
+ * Rotate each vector by the corresponding unit quaternion, e.g. body space
+ * vectors of rigid bodies by their orientations.
+ */
+template <typename T, typename U, typename Components>
+void
+rotate(quaternion<T> const* q, vector<U, 3, Components> const* src, std::size_t count,
+       vector<U, 3, Components>* dst)
+{
+    for (std::size_t i = 0; i < count; ++i) {
+        U const w = q[i][0], x = q[i][1], y = q[i][2], z = q[i][3];
+        U const vx = src[i][0], vy = src[i][1], vz = src[i][2];
+        U const tx = 2 * (y * vz - z * vy);
+        U const ty = 2 * (z * vx - x * vz);
+        U const tz = 2 * (x * vy - y * vx);
+        dst[i][0]  = vx + w * tx + y * tz - z * ty;
+        dst[i][1]  = vy + w * ty + z * tx - x * tz;
+        dst[i][2]  = vz + w * tz + x * ty - y * tx;
+    }
+}
+//@}
+
+//@{
+/** @name Bulk interpolation */
+/**
+ * Blend two arrays of orientations, e.g. two animation poses, with the same
+ * weight. Each pair is interpolated along the shortest path.
+ */
+template <typename T>
+void
+nlerp(quaternion<T> const* start, quaternion<T> const* end, T percent, std::size_t count,
+      quaternion<T>* dst)
+{
+    for (std::size_t i = 0; i < count; ++i) {
+        dst[i] = expr::v::detail::nlerp(start[i], end[i], percent);
+    }
+}
+
+/**
+ * Interpolate pairs of keyframes, each with its own weight
+ */
+template <typename T>
+void
+nlerp(quaternion<T> const* start, quaternion<T> const* end, T const* percent, std::size_t count,
+      quaternion<T>* dst)
+{
+    for (std::size_t i = 0; i < count; ++i) {
+        dst[i] = expr::v::detail::nlerp(start[i], end[i], percent[i]);
+    }
+}
+
+template <typename T>
+void
+fast_slerp(quaternion<T> const* start, quaternion<T> const* end, T percent, std::size_t count,
+           quaternion<T>* dst)
+{
+    for (std::size_t i = 0; i < count; ++i) {
+        dst[i] = expr::v::detail::fast_slerp(start[i], end[i], percent);
+    }
+}
+
+template <typename T>
+void
+fast_slerp(quaternion<T> const* start, quaternion<T> const* end, T const* percent,
+           std::size_t count, quaternion<T>* dst)
+{
+    for (std::size_t i = 0; i < count; ++i) {
+        dst[i] = expr::v::detail::fast_slerp(start[i], end[i], percent[i]);
+    }
+}
+//@}
+
 }    // namespace math
 }    // namespace psst
 
@@ -0,0 +1,161 @@
+/**
+ * Copyright 2019 Sergei A. Fedorov
+ * radix_sort.hpp
+ *
+ *  Created on: Mar 3, 2019
+ *      Author: ser-fedorov
+ */
+
+#ifndef PSST_MATH_RADIX_SORT_HPP_
+#define PSST_MATH_RADIX_SORT_HPP_
+
+#include <psst/math/config.hpp>
+#include <psst/math/detail/parallel.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace psst {
+namespace math {
+
+/**
+ * Sort unsigned integer keys with a least significant digit radix sort and
+ * return the permutation of the sort. The sort is stable, the passes over
+ * the digits all the keys share are skipped, so the keys of a few bits are
+ * sorted in a few passes.
+ *
+ * The keys are split between threads in contiguous parts, each part counts
+ * its digits and scatters its keys to its own ranges of the digits, so the
+ * result doesn't depend on the number of threads.
+ *
+ * @param order array of count indices, order[i] is the original index of the
+ *        key at position i after the sort
+ * @param threads maximum number of threads, 0 means the hardware concurrency
+ * @throws std::runtime_error if there are more keys than a 32 bit index can
+ *         address
+ */
+template <typename Key>
+void
+radix_sort(Key* keys, std::uint32_t* order, std::size_t count, std::size_t threads = 1)
+{
+    static_assert(std::is_unsigned_v<Key>, "Radix sort keys must be unsigned integers");
+    constexpr std::size_t digit_bits = 8;
+    constexpr std::size_t radix      = 1 << digit_bits;
+    constexpr Key         mask       = radix - 1;
+
+    if (count > std::numeric_limits<std::uint32_t>::max())
+        throw std::runtime_error{"Too many keys for a radix sort"};
+    if (threads == 0)
+        threads = detail::default_thread_count();
+    std::size_t const parts =
+        std::max<std::size_t>(std::min(threads, count / config::parallel_min_items), 1);
+    auto part_begin = [count, parts](std::size_t i) { return count * i / parts; };
+
+    std::vector<Key>           key_buffer(count);
+    std::vector<std::uint32_t> order_buffer(count);
+    std::vector<std::size_t>   counts(parts * radix);
+    Key*                       src_keys  = keys;
+    Key*                       dst_keys  = key_buffer.data();
+    std::uint32_t*             src_order = order;
+    std::uint32_t*             dst_order = order_buffer.data();
+    bool                       first     = true;
+
+    for (std::size_t shift = 0; shift < sizeof(Key) * 8; shift += digit_bits) {
+        std::fill(counts.begin(), counts.end(), 0);
+        detail::parallel_for(parts, 1, parts, [&](std::size_t begin, std::size_t end) {
+            for (std::size_t i = begin; i < end; ++i) {
+                std::size_t* part_counts = counts.data() + i * radix;
+                for (std::size_t k = part_begin(i); k < part_begin(i + 1); ++k) {
+                    ++part_counts[(src_keys[k] >> shift) & mask];
+                }
+            }
+        });
+        // Offsets of the digits of the parts
+        std::size_t sum     = 0;
+        bool        skipped = false;
+        for (std::size_t d = 0; d < radix && !skipped; ++d) {
+            std::size_t const digit_begin = sum;
+            for (std::size_t i = 0; i < parts; ++i) {
+                std::size_t const n   = counts[i * radix + d];
+                counts[i * radix + d] = sum;
+                sum += n;
+            }
+            skipped = sum - digit_begin == count;
+        }
+        if (skipped)
+            continue;
+
+        detail::parallel_for(parts, 1, parts, [&](std::size_t begin, std::size_t end) {
+            for (std::size_t i = begin; i < end; ++i) {
+                std::size_t* part_offsets = counts.data() + i * radix;
+                for (std::size_t k = part_begin(i); k < part_begin(i + 1); ++k) {
+                    std::size_t const pos = part_offsets[(src_keys[k] >> shift) & mask]++;
+                    dst_keys[pos]         = src_keys[k];
+                    dst_order[pos]        = first ? static_cast<std::uint32_t>(k) : src_order[k];
+                }
+            }
+        });
+        first = false;
+        std::swap(src_keys, dst_keys);
+        std::swap(src_order, dst_order);
+    }
+
+    if (first) {
+        // All the keys are the same
+        detail::parallel_for(count, config::parallel_min_items, threads,
+                             [order](std::size_t begin, std::size_t end) {
+                                 for (std::size_t i = begin; i < end; ++i) {
+                                     order[i] = static_cast<std::uint32_t>(i);
+                                 }
+                             });
+    } else if (src_keys != keys) {
+        detail::parallel_for(count, config::parallel_min_items, threads,
+                             [&](std::size_t begin, std::size_t end) {
+                                 std::copy(src_keys + begin, src_keys + end, keys + begin);
+                                 std::copy(src_order + begin, src_order + end, order + begin);
+                             });
+    }
+}
+
+/**
+ * Reorder an array by a permutation, values[i] becomes the old
+ * values[order[i]]
+ * @param threads maximum number of threads, 0 means the hardware concurrency
+ */
+template <typename T>
+void
+reorder(T* values, std::uint32_t const* order, std::size_t count, std::size_t threads = 1)
+{
+    std::vector<T> const copy(values, values + count);
+    detail::parallel_for(count, config::parallel_min_items, threads,
+                         [&](std::size_t begin, std::size_t end) {
+                             for (std::size_t i = begin; i < end; ++i) {
+                                 values[i] = copy[order[i]];
+                             }
+                         });
+}
+
+/**
+ * Sort the keys and reorder the parallel arrays, e.g. positions, velocities
+ * and colors of particles, in the order of the keys. The number of threads
+ * precedes the arrays, as the arrays are a parameter pack.
+ * @param threads maximum number of threads, 0 means the hardware concurrency
+ */
+template <typename Key, typename... T>
+void
+sort_by_keys(Key* keys, std::size_t count, std::size_t threads, T*... arrays)
+{
+    std::vector<std::uint32_t> order(count);
+    radix_sort(keys, order.data(), count, threads);
+    (reorder(arrays, order.data(), count, threads), ...);
+}
+
+}    // namespace math
+}    // namespace psst
+
+#endif /* PSST_MATH_RADIX_SORT_HPP_ */
@@ -0,0 +1,426 @@
+/**
+ * Copyright 2019 Sergei A. Fedorov
+ * ray.hpp
+ *
+ *  Created on: Feb 27, 2019
+ *      Author: ser-fedorov
+ */
+
+#ifndef PSST_MATH_RAY_HPP_
+#define PSST_MATH_RAY_HPP_
+
+#include <psst/math/aabb.hpp>
+#include <psst/math/vector.hpp>
+
+#include <cmath>
+#include <cstdint>
+#include <limits>
+
+namespace psst {
+namespace math {
+
+/**
+ * A ray with the origin and the direction. The reciprocal of the direction
+ * is computed on construction for the slab tests, a zero component of the
+ * direction gives an infinite reciprocal.
+ *
+ * The intersection distances are measured in units of the direction length,
+ * a point of the ray is origin + direction * t.
+ */
+template <typename T, typename Components = components::default_components_t<3>>
+struct ray {
+    static_assert(std::is_floating_point_v<T>, "Ray values must be floating point");
+
+    using value_type  = T;
+    using vector_type = vector<T, 3, Components>;
+
+    ray() = default;
+    ray(vector_type const& origin, vector_type const& direction)
+        : origin_{origin},
+          direction_{direction},
+          inv_direction_{1 / direction[0], 1 / direction[1], 1 / direction[2]}
+    {}
+
+    vector_type const&
+    origin() const
+    {
+        return origin_;
+    }
+
+    vector_type const&
+    direction() const
+    {
+        return direction_;
+    }
+
+    vector_type const&
+    inv_direction() const
+    {
+        return inv_direction_;
+    }
+
+    vector_type
+    point_at(T t) const
+    {
+        return origin_ + direction_ * t;
+    }
+
+private:
+    vector_type origin_;
+    vector_type direction_;
+    vector_type inv_direction_;
+};
+
+/**
+ * Nearest intersection of a ray with triangles. The distance is initialized
+ * with the maximal distance of the search, a test updates the hit only if
+ * the intersection is closer. The barycentric coordinates u and v are the
+ * weights of the second and the third vertex of the triangle.
+ */
+template <typename T>
+struct triangle_hit {
+    T t = std::numeric_limits<T>::infinity();
+    T u = 0;
+    T v = 0;
+};
+
+namespace detail {
+
+/**
+ * Slab test of a ray and a box given by the arrays of the corner components.
+ * An empty box is never hit, though its swapped slabs enclose the whole ray.
+ */
+template <typename T, typename Components>
+bool
+slab_test(ray<T, Components> const& r, T const* min, T const* max, T t_max, T& t_near)
+{
+    T    lo    = 0;
+    T    hi    = t_max;
+    bool empty = false;
+    for (std::size_t i = 0; i < 3; ++i) {
+        empty |= max[i] < min[i];
+        T const t0 = (min[i] - r.origin()[i]) * r.inv_direction()[i];
+        T const t1 = (max[i] - r.origin()[i]) * r.inv_direction()[i];
+        // Written so that a NaN from 0 * inf doesn't narrow the interval
+        T const t_enter = t0 < t1 ? t0 : t1;
+        T const t_exit  = t0 < t1 ? t1 : t0;
+        lo              = t_enter > lo ? t_enter : lo;
+        hi              = t_exit < hi ? t_exit : hi;
+    }
+    if (empty || hi < lo)
+        return false;
+    t_near = lo;
+    return true;
+}
+
+}    // namespace detail
+
+//@{
+/** @name Single ray tests */
+/**
+ * Möller-Trumbore ray-triangle intersection, both sides of the triangle
+ * are hit.
+ * @return true if the triangle is hit closer than hit.t, the hit is updated
+ */
+template <typename T, typename Components>
+bool
+intersect(ray<T, Components> const& r, vector<T, 3, Components> const& v0,
+          vector<T, 3, Components> const& v1, vector<T, 3, Components> const& v2,
+          triangle_hit<T>& hit)
+{
+    vector<T, 3, Components> const e1 = v1 - v0;
+    vector<T, 3, Components> const e2 = v2 - v0;
+    // Product of two vectors is the cross product
+    vector<T, 3, Components> const p   = r.direction() * e2;
+    T const                        det = dot_product(e1, p);
+    if (det == 0)
+        return false;
+    T const                        inv_det = 1 / det;
+    vector<T, 3, Components> const s       = r.origin() - v0;
+    T const                        u       = dot_product(s, p) * inv_det;
+    if (u < 0 || u > 1)
+        return false;
+    vector<T, 3, Components> const q = s * e1;
+    T const                        v = dot_product(r.direction(), q) * inv_det;
+    if (v < 0 || u + v > 1)
+        return false;
+    T const t = dot_product(e2, q) * inv_det;
+    if (!(t > 0 && t < hit.t))
+        return false;
+    hit.t = t;
+    hit.u = u;
+    hit.v = v;
+    return true;
+}
+
+/**
+ * Slab test of a ray and a box without branches.
+ * @param t_max maximal distance
+ * @param t_near distance to the entry point, 0 if the origin is inside,
+ *               written only if the box is hit
+ * @return true if the ray enters the box in [0, t_max]
+ */
+template <typename T, typename Components>
+bool
+intersect(ray<T, Components> const& r, aabb<T, 3, Components> const& box, T t_max, T& t_near)
+{
+    return detail::slab_test(r, box.min().data(), box.max().data(), t_max, t_near);
+}
+
+/**
+ * Ray-sphere intersection.
+ * @param t maximal distance on input, distance to the nearest intersection
+ *          in front of the origin on output if the sphere is hit
+ * @return true if the sphere is hit closer than t
+ */
+template <typename T, typename Components>
+bool
+intersect(ray<T, Components> const& r, vector<T, 3, Components> const& center, T radius, T& t)
+{
+    vector<T, 3, Components> const oc   = r.origin() - center;
+    T const                        a    = dot_product(r.direction(), r.direction());
+    T const                        b    = dot_product(oc, r.direction());
+    T const                        c    = dot_product(oc, oc) - radius * radius;
+    T const                        disc = b * b - a * c;
+    if (disc < 0)
+        return false;
+    // The root without cancellation of b and the square root of the
+    // discriminant, the other one from the product of the roots
+    T const sq = std::sqrt(disc);
+    T const q  = -(b + std::copysign(sq, b));
+    T const ta = q / a;
+    T const tb = c / q;
+    T const t0 = ta < tb ? ta : tb;
+    T const t1 = ta < tb ? tb : ta;
+    // The far intersection if the origin is inside the sphere
+    T const res = t0 > 0 ? t0 : t1;
+    if (!(res > 0 && res < t))
+        return false;
+    t = res;
+    return true;
+}
+//@}
+
+/**
+ * Rays in SoA layout, so that a test of N rays against a primitive is a
+ * loop over the lanes vectorized by the compiler.
+ */
+template <typename T, std::size_t N>
+struct ray_packet {
+    static_assert(std::is_floating_point_v<T>, "Ray values must be floating point");
+    static_assert(N == 4 || N == 8 || N == 16, "Packet size must be 4, 8 or 16");
+
+    using value_type = T;
+    /** Bit i is set if the lane i is hit */
+    using mask_type = std::uint32_t;
+
+    static constexpr std::size_t size = N;
+
+    ray_packet() = default;
+
+    template <typename Components>
+    explicit ray_packet(ray<T, Components> const* rays)
+    {
+        for (std::size_t i = 0; i < N; ++i) {
+            set(i, rays[i]);
+        }
+    }
+
+    template <typename Components>
+    void
+    set(std::size_t lane, ray<T, Components> const& r)
+    {
+        ox[lane]  = r.origin()[0];
+        oy[lane]  = r.origin()[1];
+        oz[lane]  = r.origin()[2];
+        dx[lane]  = r.direction()[0];
+        dy[lane]  = r.direction()[1];
+        dz[lane]  = r.direction()[2];
+        idx[lane] = r.inv_direction()[0];
+        idy[lane] = r.inv_direction()[1];
+        idz[lane] = r.inv_direction()[2];
+    }
+
+    T ox[N], oy[N], oz[N];
+    T dx[N], dy[N], dz[N];
+    T idx[N], idy[N], idz[N];
+};
+
+/**
+ * Nearest triangle intersections of a packet of rays, the same as
+ * triangle_hit for each lane.
+ */
+template <typename T, std::size_t N>
+struct triangle_hit_packet {
+    triangle_hit_packet() { reset(std::numeric_limits<T>::infinity()); }
+    explicit triangle_hit_packet(T t_max) { reset(t_max); }
+
+    void
+    reset(T t_max)
+    {
+        for (std::size_t i = 0; i < N; ++i) {
+            t[i] = t_max;
+            u[i] = 0;
+            v[i] = 0;
+        }
+    }
+
+    T t[N];
+    T u[N];
+    T v[N];
+};
+
+namespace detail {
+
+template <std::size_t N>
+std::uint32_t
+lane_mask(std::int32_t const* hits)
+{
+    std::uint32_t mask = 0;
+    for (std::size_t i = 0; i < N; ++i) {
+        mask |= static_cast<std::uint32_t>(hits[i]) << i;
+    }
+    return mask;
+}
+
+template <std::size_t N, typename T>
+void
+copy_lanes(T const* src, T* dst)
+{
+    for (std::size_t i = 0; i < N; ++i) {
+        dst[i] = src[i];
+    }
+}
+
+}    // namespace detail
+
+//@{
+/**
+ * @name Packet tests
+ * The same tests as for a single ray for all lanes of a packet, without
+ * branches. The results are written only for the lanes that are hit.
+ * @return mask of the lanes hit
+ */
+template <typename T, std::size_t N, typename Components>
+std::uint32_t
+intersect(ray_packet<T, N> const& r, vector<T, 3, Components> const& v0,
+          vector<T, 3, Components> const& v1, vector<T, 3, Components> const& v2,
+          triangle_hit_packet<T, N>& hit)
+{
+    T const e1x = v1[0] - v0[0], e1y = v1[1] - v0[1], e1z = v1[2] - v0[2];
+    T const e2x = v2[0] - v0[0], e2y = v2[1] - v0[1], e2z = v2[2] - v0[2];
+    T const v0x = v0[0], v0y = v0[1], v0z = v0[2];
+    // Local copies of the results, so that the loop is not versioned for
+    // aliasing of the results with the rays
+    T            t_hit[N], u_hit[N], v_hit[N];
+    std::int32_t hits[N];
+    detail::copy_lanes<N>(hit.t, t_hit);
+    detail::copy_lanes<N>(hit.u, u_hit);
+    detail::copy_lanes<N>(hit.v, v_hit);
+    for (std::size_t i = 0; i < N; ++i) {
+        T const px      = r.dy[i] * e2z - r.dz[i] * e2y;
+        T const py      = r.dz[i] * e2x - r.dx[i] * e2z;
+        T const pz      = r.dx[i] * e2y - r.dy[i] * e2x;
+        T const det     = e1x * px + e1y * py + e1z * pz;
+        T const inv_det = 1 / det;
+        T const sx = r.ox[i] - v0x, sy = r.oy[i] - v0y, sz = r.oz[i] - v0z;
+        T const u  = (sx * px + sy * py + sz * pz) * inv_det;
+        T const qx = sy * e1z - sz * e1y;
+        T const qy = sz * e1x - sx * e1z;
+        T const qz = sx * e1y - sy * e1x;
+        T const v  = (r.dx[i] * qx + r.dy[i] * qy + r.dz[i] * qz) * inv_det;
+        T const t  = (e2x * qx + e2y * qy + e2z * qz) * inv_det;
+        // Comparisons with NaN from a zero determinant are false
+        bool const h = (det != 0) & (u >= 0) & (v >= 0) & (u + v <= 1) & (t > 0) & (t < t_hit[i]);
+        t_hit[i]     = h ? t : t_hit[i];
+        u_hit[i]     = h ? u : u_hit[i];
+        v_hit[i]     = h ? v : v_hit[i];
+        hits[i]      = h;
+    }
+    detail::copy_lanes<N>(t_hit, hit.t);
+    detail::copy_lanes<N>(u_hit, hit.u);
+    detail::copy_lanes<N>(v_hit, hit.v);
+    return detail::lane_mask<N>(hits);
+}
+
+/**
+ * Slab test of a packet of rays and a box, an empty box is hit by no lane
+ * @param t_max maximal distances of the lanes
+ * @param t_near entry distances of the lanes
+ */
+template <typename T, std::size_t N, typename Components>
+std::uint32_t
+intersect(ray_packet<T, N> const& r, aabb<T, 3, Components> const& box, T const* t_max,
+          T* t_near)
+{
+    T const minx = box.min()[0], miny = box.min()[1], minz = box.min()[2];
+    T const maxx = box.max()[0], maxy = box.max()[1], maxz = box.max()[2];
+    if (box.empty())
+        return 0;
+    T            t_enter[N];
+    std::int32_t hits[N];
+    detail::copy_lanes<N>(t_near, t_enter);
+    for (std::size_t i = 0; i < N; ++i) {
+        T const x0 = (minx - r.ox[i]) * r.idx[i], x1 = (maxx - r.ox[i]) * r.idx[i];
+        T const y0 = (miny - r.oy[i]) * r.idy[i], y1 = (maxy - r.oy[i]) * r.idy[i];
+        T const z0 = (minz - r.oz[i]) * r.idz[i], z1 = (maxz - r.oz[i]) * r.idz[i];
+        T       lo = 0;
+        T       hi = t_max[i];
+        T const nx = x0 < x1 ? x0 : x1, fx = x0 < x1 ? x1 : x0;
+        T const ny = y0 < y1 ? y0 : y1, fy = y0 < y1 ? y1 : y0;
+        T const nz = z0 < z1 ? z0 : z1, fz = z0 < z1 ? z1 : z0;
+        lo         = nx > lo ? nx : lo;
+        lo         = ny > lo ? ny : lo;
+        lo         = nz > lo ? nz : lo;
+        hi         = fx < hi ? fx : hi;
+        hi         = fy < hi ? fy : hi;
+        hi         = fz < hi ? fz : hi;
+        bool const h = lo <= hi;
+        t_enter[i]   = h ? lo : t_enter[i];
+        hits[i]      = h;
+    }
+    detail::copy_lanes<N>(t_enter, t_near);
+    return detail::lane_mask<N>(hits);
+}
+
+/**
+ * Ray-sphere test of a packet of rays
+ * @param t maximal distances of the lanes on input, distances to the
+ *          intersections for the lanes hit on output
+ */
+template <typename T, std::size_t N, typename Components>
+std::uint32_t
+intersect(ray_packet<T, N> const& r, vector<T, 3, Components> const& center, T radius, T* t)
+{
+    T const cx = center[0], cy = center[1], cz = center[2];
+    T const r2 = radius * radius;
+    T            t_hit[N];
+    std::int32_t hits[N];
+    detail::copy_lanes<N>(t, t_hit);
+    for (std::size_t i = 0; i < N; ++i) {
+        T const ocx  = r.ox[i] - cx, ocy = r.oy[i] - cy, ocz = r.oz[i] - cz;
+        T const a    = r.dx[i] * r.dx[i] + r.dy[i] * r.dy[i] + r.dz[i] * r.dz[i];
+        T const b    = ocx * r.dx[i] + ocy * r.dy[i] + ocz * r.dz[i];
+        T const c    = ocx * ocx + ocy * ocy + ocz * ocz - r2;
+        T const disc = b * b - a * c;
+        T const sq   = std::sqrt(disc < 0 ? T{0} : disc);
+        T const q    = -(b + std::copysign(sq, b));
+        T const ta   = q / a;
+        T const tb   = c / q;
+        T const t0   = ta < tb ? ta : tb;
+        T const t1   = ta < tb ? tb : ta;
+        T const res  = t0 > 0 ? t0 : t1;
+        // std::sqrt sets errno, so the loop is vectorized only with -fno-math-errno
+        bool const h = (disc >= 0) & (res > 0) & (res < t_hit[i]);
+        t_hit[i]     = h ? res : t_hit[i];
+        hits[i]      = h;
+    }
+    detail::copy_lanes<N>(t_hit, t);
+    return detail::lane_mask<N>(hits);
+}
+//@}
+
+}    // namespace math
+}    // namespace psst
+
+#endif /* PSST_MATH_RAY_HPP_ */
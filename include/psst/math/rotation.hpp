@@ -0,0 +1,407 @@
+/**
+ * Copyright 2019 Sergei A. Fedorov
+ * rotation.hpp
+ *
+ *  Created on: Feb 12, 2019
+ *      Author: ser-fedorov
+ */
+
+#ifndef PSST_MATH_ROTATION_HPP_
+#define PSST_MATH_ROTATION_HPP_
+
+#include <psst/math/detail/conversion.hpp>
+#include <psst/math/matrix.hpp>
+#include <psst/math/quaternion.hpp>
+#include <psst/math/vector.hpp>
+
+#include <cmath>
+
+namespace psst {
+namespace math {
+
+namespace components {
+
+/**
+ * Rotation around an axis, the axis doesn't have to be normalized.
+ */
+struct axis_angle {
+    static constexpr std::size_t min_components = 4;
+    static constexpr std::size_t max_components = 4;
+    static constexpr std::size_t x              = 0;
+    static constexpr std::size_t y              = 1;
+    static constexpr std::size_t z              = 2;
+    static constexpr std::size_t angle          = 3;
+};
+
+/**
+ * Tait-Bryan angles in radians. The rotation is applied as roll around X,
+ * then pitch around Y, then yaw around Z, that is q = yaw * pitch * roll.
+ */
+struct euler {
+    static constexpr std::size_t min_components = 3;
+    static constexpr std::size_t max_components = 3;
+    static constexpr std::size_t roll           = 0;
+    static constexpr std::size_t pitch          = 1;
+    static constexpr std::size_t yaw            = 2;
+    // Alternative names
+    static constexpr std::size_t bank     = roll;
+    static constexpr std::size_t attitude = pitch;
+    static constexpr std::size_t heading  = yaw;
+};
+
+}    // namespace components
+
+namespace component_access {
+
+//@{
+/** @name Axis-angle components */
+template <typename VectorType, typename T>
+struct component_access<4, components::axis_angle, VectorType, T>
+    : basic_component_access<VectorType, T, components::axis_angle> {
+
+    using base_type = basic_component_access<VectorType, T, components::axis_angle>;
+
+    PSST_MATH_COMPONENT_ACCESS(x)
+    PSST_MATH_COMPONENT_ACCESS(y)
+    PSST_MATH_COMPONENT_ACCESS(z)
+    PSST_MATH_COMPONENT_ACCESS(angle)
+};
+//@}
+
+//@{
+/** @name Euler angles components */
+template <typename VectorType, typename T>
+struct component_access<3, components::euler, VectorType, T>
+    : basic_component_access<VectorType, T, components::euler> {
+
+    using base_type = basic_component_access<VectorType, T, components::euler>;
+
+    PSST_MATH_COMPONENT_ACCESS(roll)
+    PSST_MATH_COMPONENT_ACCESS(pitch)
+    PSST_MATH_COMPONENT_ACCESS(yaw)
+    PSST_MATH_COMPONENT_ACCESS(bank)
+    PSST_MATH_COMPONENT_ACCESS(attitude)
+    PSST_MATH_COMPONENT_ACCESS(heading)
+};
+//@}
+
+}    // namespace component_access
+
+template <typename T>
+using axis_angle = vector<T, 4, components::axis_angle>;
+template <typename T>
+using euler_angles = vector<T, 3, components::euler>;
+
+namespace detail {
+
+/**
+ * Rotation matrix elements of a quaternion, the quaternion doesn't have to
+ * be normalized.
+ * @param m row-major 3x3 array, that can be a part of a bigger matrix
+ * @param stride distance between the rows in m
+ */
+template <typename T, typename U>
+constexpr void
+quaternion_to_matrix(T w, T x, T y, T z, U* m, std::size_t stride)
+{
+    T const s  = T{2} / (w * w + x * x + y * y + z * z);
+    T const xs = x * s, ys = y * s, zs = z * s;
+    T const wx = w * xs, wy = w * ys, wz = w * zs;
+    T const xx = x * xs, xy = x * ys, xz = x * zs;
+    T const yy = y * ys, yz = y * zs, zz = z * zs;
+
+    m[0]              = 1 - (yy + zz);
+    m[1]              = xy - wz;
+    m[2]              = xz + wy;
+    m[stride]         = xy + wz;
+    m[stride + 1]     = 1 - (xx + zz);
+    m[stride + 2]     = yz - wx;
+    m[2 * stride]     = xz - wy;
+    m[2 * stride + 1] = yz + wx;
+    m[2 * stride + 2] = 1 - (xx + yy);
+}
+
+template <typename T, typename U, typename Components>
+constexpr void
+quaternion_to_matrix(T w, T x, T y, T z, matrix<U, 3, 3, Components>& res)
+{
+    quaternion_to_matrix(w, x, y, z, res.data(), 3);
+}
+
+template <typename T, typename U, typename Components>
+constexpr void
+quaternion_to_matrix(T w, T x, T y, T z, matrix<U, 4, 4, Components>& res)
+{
+    U* m = res.data();
+    quaternion_to_matrix(w, x, y, z, m, 4);
+    m[3] = m[7] = m[11] = m[12] = m[13] = m[14] = 0;
+    m[15]                                       = 1;
+}
+
+/**
+ * Quaternion of a rotation matrix by Shepperd's method. The square root is
+ * taken of the largest of 4w^2, 4x^2, 4y^2, 4z^2, so there is no
+ * cancellation when the trace is close to -1.
+ * @param m row-major 3x3 array, that can be a part of a bigger matrix
+ * @param stride distance between the rows in m
+ */
+template <typename T, typename U>
+quaternion<U>
+matrix_to_quaternion(T const* m, std::size_t stride)
+{
+    using std::sqrt;
+    T const m00 = m[0], m01 = m[1], m02 = m[2];
+    T const m10 = m[stride], m11 = m[stride + 1], m12 = m[stride + 2];
+    T const m20 = m[2 * stride], m21 = m[2 * stride + 1], m22 = m[2 * stride + 2];
+    T const trace = m00 + m11 + m22;
+
+    if (trace >= m00 && trace >= m11 && trace >= m22) {
+        T const r = sqrt(1 + trace);
+        T const s = T{0.5} / r;
+        return {r * T{0.5}, (m21 - m12) * s, (m02 - m20) * s, (m10 - m01) * s};
+    } else if (m00 >= m11 && m00 >= m22) {
+        T const r = sqrt(1 + m00 - m11 - m22);
+        T const s = T{0.5} / r;
+        return {(m21 - m12) * s, r * T{0.5}, (m01 + m10) * s, (m02 + m20) * s};
+    } else if (m11 >= m22) {
+        T const r = sqrt(1 - m00 + m11 - m22);
+        T const s = T{0.5} / r;
+        return {(m02 - m20) * s, (m01 + m10) * s, r * T{0.5}, (m12 + m21) * s};
+    } else {
+        T const r = sqrt(1 - m00 - m11 + m22);
+        T const s = T{0.5} / r;
+        return {(m10 - m01) * s, (m02 + m20) * s, (m12 + m21) * s, r * T{0.5}};
+    }
+}
+
+template <typename U, typename Expression, std::size_t... RC>
+quaternion<U>
+matrix_expression_to_quaternion(Expression const& expr, std::index_sequence<RC...>)
+{
+    using value_type = typename std::decay_t<Expression>::value_type;
+    value_type const m[9]{expr.template element<RC / 3, RC % 3>()...};
+    return matrix_to_quaternion<value_type, U>(m, 3);
+}
+
+}    // namespace detail
+
+namespace expr {
+inline namespace v {
+
+//@{
+/** @name Quaternion to rotation matrix conversion */
+template <typename T, typename U, typename Components, typename Expression>
+struct conversion<vector<T, 4, components::wxyz>, matrix<U, 3, 3, Components>, Expression>
+    : unary_expression<Expression> {
+    using expression_base = unary_expression<Expression>;
+    using expression_base::expression_base;
+
+    auto
+    result() const
+    {
+        matrix<U, 3, 3, Components> res;
+        math::detail::quaternion_to_matrix<T>(this->arg_.w(), this->arg_.x(), this->arg_.y(),
+                                              this->arg_.z(), res);
+        return res;
+    }
+};
+
+template <typename T, typename U, typename Components, typename Expression>
+struct conversion<vector<T, 4, components::wxyz>, matrix<U, 4, 4, Components>, Expression>
+    : unary_expression<Expression> {
+    using expression_base = unary_expression<Expression>;
+    using expression_base::expression_base;
+
+    auto
+    result() const
+    {
+        matrix<U, 4, 4, Components> res;
+        math::detail::quaternion_to_matrix<T>(this->arg_.w(), this->arg_.x(), this->arg_.y(),
+                                              this->arg_.z(), res);
+        return res;
+    }
+};
+//@}
+
+//@{
+/** @name Rotation matrix to quaternion conversion */
+template <typename T, typename U, typename Components, typename Expression>
+struct conversion<matrix<T, 3, 3, Components>, vector<U, 4, components::wxyz>, Expression>
+    : unary_expression<Expression> {
+    using expression_base = unary_expression<Expression>;
+    using expression_base::expression_base;
+
+    auto
+    result() const
+    {
+        return math::detail::matrix_expression_to_quaternion<U>(this->arg_,
+                                                                std::make_index_sequence<9>{});
+    }
+};
+
+/**
+ * Only the upper left 3x3 part of the matrix is used, the matrix must not
+ * contain scale.
+ */
+template <typename T, typename U, typename Components, typename Expression>
+struct conversion<matrix<T, 4, 4, Components>, vector<U, 4, components::wxyz>, Expression>
+    : unary_expression<Expression> {
+    using expression_base = unary_expression<Expression>;
+    using expression_base::expression_base;
+
+    auto
+    result() const
+    {
+        return math::detail::matrix_expression_to_quaternion<U>(
+            minor<3, 3>(this->arg_), std::make_index_sequence<9>{});
+    }
+};
+//@}
+
+//@{
+/** @name Quaternion to axis-angle conversion */
+template <typename T, typename U, typename Expression>
+struct conversion<vector<T, 4, components::wxyz>, vector<U, 4, components::axis_angle>,
+                  Expression> : unary_expression<Expression> {
+    using expression_base = unary_expression<Expression>;
+    using expression_base::expression_base;
+
+    auto
+    result() const
+    {
+        using std::atan2;
+        using std::sqrt;
+        U const w   = this->arg_.w();
+        U const x   = this->arg_.x();
+        U const y   = this->arg_.y();
+        U const z   = this->arg_.z();
+        U const len = sqrt(x * x + y * y + z * z);
+        if (len == 0) {
+            // No rotation, the axis is arbitrary
+            return axis_angle<U>{1, 0, 0, 0};
+        }
+        // atan2 stays accurate for small angles, unlike acos(w)
+        return axis_angle<U>{x / len, y / len, z / len, 2 * atan2(len, w)};
+    }
+};
+//@}
+
+//@{
+/** @name Axis-angle to quaternion conversion */
+template <typename T, typename U, typename Expression>
+struct conversion<vector<T, 4, components::axis_angle>, vector<U, 4, components::wxyz>,
+                  Expression> : unary_expression<Expression> {
+    using expression_base = unary_expression<Expression>;
+    using expression_base::expression_base;
+
+    auto
+    result() const
+    {
+        using std::cos;
+        using std::sin;
+        using std::sqrt;
+        U const x   = this->arg_.x();
+        U const y   = this->arg_.y();
+        U const z   = this->arg_.z();
+        U const len = sqrt(x * x + y * y + z * z);
+        if (len == 0) {
+            return quaternion<U>{1, 0, 0, 0};
+        }
+        U const half = U(this->arg_.angle()) / 2;
+        U const s    = sin(half) / len;
+        return quaternion<U>{cos(half), x * s, y * s, z * s};
+    }
+};
+//@}
+
+//@{
+/** @name Quaternion to Euler angles conversion */
+template <typename T, typename U, typename Expression>
+struct conversion<vector<T, 4, components::wxyz>, vector<U, 3, components::euler>, Expression>
+    : unary_expression<Expression> {
+    using expression_base = unary_expression<Expression>;
+    using expression_base::expression_base;
+
+    auto
+    result() const
+    {
+        using std::asin;
+        using std::atan2;
+        U const w = this->arg_.w();
+        U const x = this->arg_.x();
+        U const y = this->arg_.y();
+        U const z = this->arg_.z();
+        // Clamp to avoid NaN because of rounding near the gimbal lock
+        U sin_pitch = 2 * (w * y - z * x);
+        sin_pitch   = sin_pitch > 1 ? U{1} : (sin_pitch < -1 ? U{-1} : sin_pitch);
+        return euler_angles<U>{atan2(2 * (w * x + y * z), 1 - 2 * (x * x + y * y)),
+                               asin(sin_pitch),
+                               atan2(2 * (w * z + x * y), 1 - 2 * (y * y + z * z))};
+    }
+};
+//@}
+
+//@{
+/** @name Euler angles to quaternion conversion */
+template <typename T, typename U, typename Expression>
+struct conversion<vector<T, 3, components::euler>, vector<U, 4, components::wxyz>, Expression>
+    : unary_expression<Expression> {
+    using expression_base = unary_expression<Expression>;
+    using expression_base::expression_base;
+
+    auto
+    result() const
+    {
+        using std::cos;
+        using std::sin;
+        U const roll  = U(this->arg_.roll()) / 2;
+        U const pitch = U(this->arg_.pitch()) / 2;
+        U const yaw   = U(this->arg_.yaw()) / 2;
+        U const cr = cos(roll), sr = sin(roll);
+        U const cp = cos(pitch), sp = sin(pitch);
+        U const cy = cos(yaw), sy = sin(yaw);
+        return quaternion<U>{cr * cp * cy + sr * sp * sy, sr * cp * cy - cr * sp * sy,
+                             cr * sp * cy + sr * cp * sy, cr * cp * sy - sr * sp * cy};
+    }
+};
+//@}
+
+}    // namespace v
+}    // namespace expr
+
+//----------------------------------------------------------------------------
+//@{
+/** @name Bulk conversions */
+/**
+ * Convert a contiguous range of quaternions to rotation matrices, e.g. a
+ * skeleton pose before uploading it to a renderer. The loop has no
+ * dependencies between iterations, so the compiler vectorises it.
+ */
+template <typename T, typename U, std::size_t Size, typename Components>
+void
+convert(quaternion<T> const* src, std::size_t count, matrix<U, Size, Size, Components>* dst)
+{
+    static_assert(Size == 3 || Size == 4, "Rotation matrix must be 3x3 or 4x4");
+    for (std::size_t i = 0; i < count; ++i) {
+        detail::quaternion_to_matrix<T>(src[i][0], src[i][1], src[i][2], src[i][3], dst[i]);
+    }
+}
+
+/**
+ * Convert a contiguous range of rotation matrices to quaternions
+ */
+template <typename T, typename U, std::size_t Size, typename Components>
+void
+convert(matrix<T, Size, Size, Components> const* src, std::size_t count, quaternion<U>* dst)
+{
+    static_assert(Size == 3 || Size == 4, "Rotation matrix must be 3x3 or 4x4");
+    for (std::size_t i = 0; i < count; ++i) {
+        dst[i] = detail::matrix_to_quaternion<T, U>(src[i].data(), Size);
+    }
+}
+//@}
+
+}    // namespace math
+}    // namespace psst
+
+#endif /* PSST_MATH_ROTATION_HPP_ */
@@ -0,0 +1,388 @@
+/**
+ * Copyright 2019 Sergei A. Fedorov
+ * space_filling_curve.hpp
+ *
+ *  Created on: Mar 3, 2019
+ *      Author: ser-fedorov
+ */
+
+#ifndef PSST_MATH_SPACE_FILLING_CURVE_HPP_
+#define PSST_MATH_SPACE_FILLING_CURVE_HPP_
+
+#include <psst/math/aabb.hpp>
+#include <psst/math/config.hpp>
+#include <psst/math/detail/parallel.hpp>
+#include <psst/math/vector.hpp>
+
+#include <cstdint>
+#include <type_traits>
+
+namespace psst {
+namespace math {
+
+/**
+ * Number of bits per axis of a code of a space filling curve. 16 and 32 bits
+ * for 2D codes, 10 and 21 bits for 3D codes.
+ */
+template <typename Key, std::size_t N>
+constexpr std::size_t curve_bits = sizeof(Key) * 8 / N;
+
+namespace detail {
+
+/** The low curve_bits set */
+template <typename Key, std::size_t N>
+constexpr Key curve_mask = (Key{1} << curve_bits<Key, N>) - 1;
+
+template <typename Key, std::size_t N>
+constexpr void
+check_curve_key()
+{
+    static_assert(std::is_same_v<Key, std::uint32_t> || std::is_same_v<Key, std::uint64_t>,
+                  "Space filling curve code must be a 32 or 64 bit unsigned integer");
+    static_assert(N == 2 || N == 3, "Space filling curves are defined for 2D and 3D");
+}
+
+/**
+ * Spread the low curve_bits of a value so that there are N - 1 zero bits
+ * between them
+ */
+template <typename Key, std::size_t N>
+constexpr Key
+spread_bits(Key v)
+{
+    check_curve_key<Key, N>();
+    if constexpr (N == 2 && sizeof(Key) == 4) {
+        v &= 0x0000ffff;
+        v = (v | (v << 8)) & 0x00ff00ff;
+        v = (v | (v << 4)) & 0x0f0f0f0f;
+        v = (v | (v << 2)) & 0x33333333;
+        v = (v | (v << 1)) & 0x55555555;
+    } else if constexpr (N == 2) {
+        v &= 0x00000000ffffffff;
+        v = (v | (v << 16)) & 0x0000ffff0000ffff;
+        v = (v | (v << 8)) & 0x00ff00ff00ff00ff;
+        v = (v | (v << 4)) & 0x0f0f0f0f0f0f0f0f;
+        v = (v | (v << 2)) & 0x3333333333333333;
+        v = (v | (v << 1)) & 0x5555555555555555;
+    } else if constexpr (sizeof(Key) == 4) {
+        v &= 0x000003ff;
+        v = (v | (v << 16)) & 0x030000ff;
+        v = (v | (v << 8)) & 0x0300f00f;
+        v = (v | (v << 4)) & 0x030c30c3;
+        v = (v | (v << 2)) & 0x09249249;
+    } else {
+        v &= 0x00000000001fffff;
+        v = (v | (v << 32)) & 0x001f00000000ffff;
+        v = (v | (v << 16)) & 0x001f0000ff0000ff;
+        v = (v | (v << 8)) & 0x100f00f00f00f00f;
+        v = (v | (v << 4)) & 0x10c30c30c30c30c3;
+        v = (v | (v << 2)) & 0x1249249249249249;
+    }
+    return v;
+}
+
+/**
+ * Gather every Nth bit of a value to the low bits, the inverse of
+ * spread_bits
+ */
+template <typename Key, std::size_t N>
+constexpr Key
+compact_bits(Key v)
+{
+    check_curve_key<Key, N>();
+    if constexpr (N == 2 && sizeof(Key) == 4) {
+        v &= 0x55555555;
+        v = (v | (v >> 1)) & 0x33333333;
+        v = (v | (v >> 2)) & 0x0f0f0f0f;
+        v = (v | (v >> 4)) & 0x00ff00ff;
+        v = (v | (v >> 8)) & 0x0000ffff;
+    } else if constexpr (N == 2) {
+        v &= 0x5555555555555555;
+        v = (v | (v >> 1)) & 0x3333333333333333;
+        v = (v | (v >> 2)) & 0x0f0f0f0f0f0f0f0f;
+        v = (v | (v >> 4)) & 0x00ff00ff00ff00ff;
+        v = (v | (v >> 8)) & 0x0000ffff0000ffff;
+        v = (v | (v >> 16)) & 0x00000000ffffffff;
+    } else if constexpr (sizeof(Key) == 4) {
+        v &= 0x09249249;
+        v = (v | (v >> 2)) & 0x030c30c3;
+        v = (v | (v >> 4)) & 0x0300f00f;
+        v = (v | (v >> 8)) & 0x030000ff;
+        v = (v | (v >> 16)) & 0x000003ff;
+    } else {
+        v &= 0x1249249249249249;
+        v = (v | (v >> 2)) & 0x10c30c30c30c30c3;
+        v = (v | (v >> 4)) & 0x100f00f00f00f00f;
+        v = (v | (v >> 8)) & 0x001f0000ff0000ff;
+        v = (v | (v >> 16)) & 0x001f00000000ffff;
+        v = (v | (v >> 32)) & 0x00000000001fffff;
+    }
+    return v;
+}
+
+/**
+ * Interleave the bits of N coordinates, the first coordinate takes the
+ * lowest bit
+ */
+template <typename Key, std::size_t N>
+constexpr Key
+interleave_bits(Key const* coords)
+{
+    Key res = 0;
+    for (std::size_t k = 0; k < N; ++k) {
+        res |= spread_bits<Key, N>(coords[k]) << k;
+    }
+    return res;
+}
+
+/**
+ * Transform coordinates to the transposed Hilbert index (J. Skilling,
+ * Programming the Hilbert curve, 2004). The conditional inversions and
+ * exchanges are done with masks, so that there are no data dependent
+ * branches.
+ */
+template <typename Key, std::size_t N>
+constexpr void
+hilbert_transpose(Key* x)
+{
+    constexpr Key m = Key{1} << (curve_bits<Key, N> - 1);
+    for (Key q = m; q > 1; q >>= 1) {
+        Key const p = q - 1;
+        for (std::size_t i = 0; i < N; ++i) {
+            // Invert the low bits of x[0] if the bit of x[i] is set,
+            // exchange the low bits of x[0] and x[i] otherwise
+            Key const set = Key{0} - static_cast<Key>((x[i] & q) != 0);
+            Key const t   = (x[0] ^ x[i]) & p & ~set;
+            x[0] ^= (p & set) | t;
+            x[i] ^= t;
+        }
+    }
+    // Gray encode
+    for (std::size_t i = 1; i < N; ++i) {
+        x[i] ^= x[i - 1];
+    }
+    Key t = 0;
+    for (Key q = m; q > 1; q >>= 1) {
+        t ^= (q - 1) & (Key{0} - static_cast<Key>((x[N - 1] & q) != 0));
+    }
+    for (std::size_t i = 0; i < N; ++i) {
+        x[i] ^= t;
+    }
+}
+
+/**
+ * Quantization of the coordinates against a box to curve_bits unsigned
+ * integers
+ */
+template <typename Key, std::size_t N, typename T>
+struct curve_quantizer {
+    static constexpr std::size_t bits = curve_bits<Key, N>;
+    // A signed integer type that keeps the quantized values, it is converted
+    // from floating point faster than an unsigned one
+    using int_type = std::conditional_t<(bits < 31), std::int32_t, std::int64_t>;
+
+    static constexpr int_type max_value = (int_type{1} << bits) - 1;
+
+    template <typename Components>
+    explicit curve_quantizer(aabb<T, N, Components> const& box)
+    {
+        for (std::size_t k = 0; k < N; ++k) {
+            T const extent = box.max()[k] - box.min()[k];
+            min[k]         = box.min()[k];
+            scale[k]       = extent > 0 ? static_cast<T>(max_value + 1) / extent : 0;
+        }
+    }
+
+    Key
+    operator()(T v, std::size_t k) const
+    {
+        // The value is clamped before the conversion, as the conversion of
+        // an out of range value is undefined. The limit can round up to
+        // max_value + 1, so the integer is clamped too.
+        constexpr T    limit = static_cast<T>(max_value);
+        T const        q     = (v - min[k]) * scale[k];
+        int_type const i     = static_cast<int_type>(q > 0 ? (q < limit ? q : limit) : 0);
+        return static_cast<Key>(i < max_value ? i : max_value);
+    }
+
+    T min[N];
+    T scale[N];
+};
+
+/**
+ * The codes of count points of N contiguous scalars
+ */
+template <typename Key, std::size_t N, typename T>
+void
+morton_codes(T const* p, std::size_t count, curve_quantizer<Key, N, T> const& quantize,
+             Key* codes)
+{
+    for (std::size_t i = 0; i < count; ++i, p += N) {
+        Key code = 0;
+        for (std::size_t k = 0; k < N; ++k) {
+            code |= spread_bits<Key, N>(quantize(p[k], k)) << k;
+        }
+        codes[i] = code;
+    }
+}
+
+template <typename Key, std::size_t N, typename T>
+void
+hilbert_codes(T const* p, std::size_t count, curve_quantizer<Key, N, T> const& quantize,
+              Key* codes)
+{
+    for (std::size_t i = 0; i < count; ++i, p += N) {
+        Key x[N];
+        for (std::size_t k = 0; k < N; ++k) {
+            x[k] = quantize(p[k], k);
+        }
+        hilbert_transpose<Key, N>(x);
+        // The first transposed coordinate has the highest bits of the index
+        Key reversed[N];
+        for (std::size_t k = 0; k < N; ++k) {
+            reversed[k] = x[N - 1 - k];
+        }
+        codes[i] = interleave_bits<Key, N>(reversed);
+    }
+}
+
+}    // namespace detail
+
+//@{
+/** @name Morton codes of integer coordinates */
+/**
+ * Morton code (Z-order) of integer coordinates, the bits of x are the lowest
+ * bits of the groups. Only curve_bits<Key, N> low bits of the coordinates are
+ * used.
+ */
+template <typename Key = std::uint32_t>
+constexpr Key
+morton_encode(Key x, Key y)
+{
+    Key const coords[] = {x, y};
+    return detail::interleave_bits<Key, 2>(coords);
+}
+
+template <typename Key = std::uint32_t>
+constexpr Key
+morton_encode(Key x, Key y, Key z)
+{
+    Key const coords[] = {x, y, z};
+    return detail::interleave_bits<Key, 3>(coords);
+}
+
+/**
+ * Integer coordinates of a Morton code
+ */
+template <std::size_t N, typename Key>
+constexpr vector<Key, N>
+morton_decode(Key code)
+{
+    vector<Key, N> res;
+    for (std::size_t k = 0; k < N; ++k) {
+        res[k] = detail::compact_bits<Key, N>(code >> k);
+    }
+    return res;
+}
+//@}
+
+//@{
+/** @name Hilbert codes of integer coordinates */
+/**
+ * Index of integer coordinates on the Hilbert curve. Only curve_bits<Key, N>
+ * low bits of the coordinates are used.
+ */
+template <typename Key = std::uint32_t>
+constexpr Key
+hilbert_encode(Key x, Key y)
+{
+    constexpr Key mask     = detail::curve_mask<Key, 2>;
+    Key           coords[] = {x & mask, y & mask};
+    detail::hilbert_transpose<Key, 2>(coords);
+    return morton_encode<Key>(coords[1], coords[0]);
+}
+
+template <typename Key = std::uint32_t>
+constexpr Key
+hilbert_encode(Key x, Key y, Key z)
+{
+    constexpr Key mask     = detail::curve_mask<Key, 3>;
+    Key           coords[] = {x & mask, y & mask, z & mask};
+    detail::hilbert_transpose<Key, 3>(coords);
+    return morton_encode<Key>(coords[2], coords[1], coords[0]);
+}
+//@}
+
+//@{
+/** @name Codes of points quantized against a box */
+/**
+ * Morton code of a point. The box is split into 2^curve_bits<Key, N> cells
+ * along each axis, the points outside of the box are clamped to it.
+ */
+template <typename Key = std::uint32_t, typename T, std::size_t N, typename Components>
+Key
+morton_code(vector<T, N, Components> const& p, aabb<T, N, Components> const& box)
+{
+    Key code = 0;
+    detail::morton_codes<Key, N>(p.data(), 1, detail::curve_quantizer<Key, N, T>{box}, &code);
+    return code;
+}
+
+/**
+ * Hilbert code of a point, the quantization is the same as for the Morton
+ * code. Points close on the Hilbert curve are always close in space, the
+ * curve doesn't jump as the Z-order does, at the cost of slower encoding.
+ */
+template <typename Key = std::uint32_t, typename T, std::size_t N, typename Components>
+Key
+hilbert_code(vector<T, N, Components> const& p, aabb<T, N, Components> const& box)
+{
+    Key code = 0;
+    detail::hilbert_codes<Key, N>(p.data(), 1, detail::curve_quantizer<Key, N, T>{box}, &code);
+    return code;
+}
+
+/**
+ * Morton codes of an array of points. The codes are computed without
+ * branches and the loop is vectorized by the compiler.
+ * @param threads maximum number of threads, 0 means the hardware concurrency
+ */
+template <typename Key = std::uint32_t, typename T, std::size_t N, typename Components>
+void
+morton_codes(vector<T, N, Components> const* points, std::size_t count,
+             aabb<T, N, Components> const& box, Key* codes, std::size_t threads = 1)
+{
+    static_assert(sizeof(vector<T, N, Components>) == sizeof(T) * N,
+                  "Vector components must be contiguous");
+    detail::curve_quantizer<Key, N, T> const quantize{box};
+    detail::parallel_for(count, config::parallel_min_items, threads,
+                         [&](std::size_t begin, std::size_t end) {
+                             detail::morton_codes(points[begin].data(), end - begin, quantize,
+                                                  codes + begin);
+                         });
+}
+
+/**
+ * Hilbert codes of an array of points
+ * @param threads maximum number of threads, 0 means the hardware concurrency
+ */
+template <typename Key = std::uint32_t, typename T, std::size_t N, typename Components>
+void
+hilbert_codes(vector<T, N, Components> const* points, std::size_t count,
+              aabb<T, N, Components> const& box, Key* codes, std::size_t threads = 1)
+{
+    static_assert(sizeof(vector<T, N, Components>) == sizeof(T) * N,
+                  "Vector components must be contiguous");
+    detail::curve_quantizer<Key, N, T> const quantize{box};
+    detail::parallel_for(count, config::parallel_min_items, threads,
+                         [&](std::size_t begin, std::size_t end) {
+                             detail::hilbert_codes(points[begin].data(), end - begin, quantize,
+                                                   codes + begin);
+                         });
+}
+//@}
+
+}    // namespace math
+}    // namespace psst
+
+#endif /* PSST_MATH_SPACE_FILLING_CURVE_HPP_ */
@@ -0,0 +1,530 @@
+/**
+ * Copyright 2019 Sergei A. Fedorov
+ * sparse_matrix.hpp
+ *
+ *  Created on: Mar 9, 2019
+ *      Author: ser-fedorov
+ */
+
+#ifndef PSST_MATH_SPARSE_MATRIX_HPP_
+#define PSST_MATH_SPARSE_MATRIX_HPP_
+
+#include <psst/math/config.hpp>
+#include <psst/math/detail/dynamic_kernels.hpp>
+#include <psst/math/detail/parallel.hpp>
+#include <psst/math/dynamic_matrix.hpp>
+#include <psst/math/dynamic_vector.hpp>
+#include <psst/math/matrix.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+namespace psst {
+namespace math {
+
+/**
+ * Value of a sparse matrix at a row and a column, in blocks for a block
+ * sparse matrix
+ */
+template <typename Block>
+struct sparse_entry {
+    std::size_t row;
+    std::size_t col;
+    Block       value;
+};
+
+/**
+ * Sparse matrix in the compressed sparse row (CSR) format. With B > 1 the
+ * matrix is stored by B x B blocks (BSR), a block is a matrix<T, B, B>, the
+ * rows and columns of the blocks are the block rows and columns, the scalar
+ * size of the matrix is B times bigger. The matrix is multiplied by dynamic
+ * vectors of the scalar size.
+ *
+ * The matrix is immutable after construction, the values of the blocks can
+ * be changed in place to reuse the structure between the steps of a
+ * simulation.
+ */
+template <typename T, std::size_t B = 1>
+class sparse_matrix {
+public:
+    static_assert(B > 0, "Block size must be positive");
+    using value_tag   = traits::tag::sparse_matrix;
+    using value_type  = T;
+    using block_type  = std::conditional_t<B == 1, T, matrix<T, B, B>>;
+    using entry_type  = sparse_entry<block_type>;
+    using size_type   = std::size_t;
+    using index_type  = std::uint32_t;
+    using vector_type = dynamic_vector<T>;
+
+    static constexpr size_type block_size = B;
+
+    sparse_matrix() = default;
+    /**
+     * Matrix of block_rows x block_cols blocks, the entries may come in any
+     * order, the values of the duplicate entries are summed, as assembled
+     * from the elements of a mesh.
+     * @throws std::runtime_error if an entry is out of the matrix or the
+     *         columns don't fit the 32 bit index
+     */
+    sparse_matrix(size_type block_rows, size_type block_cols, std::vector<entry_type> entries)
+        : block_rows_{block_rows}, block_cols_{block_cols}, row_offsets_(block_rows + 1, 0)
+    {
+        if (block_cols > std::numeric_limits<index_type>::max())
+            throw std::runtime_error{"Too many columns for a sparse matrix"};
+        for (auto const& e : entries) {
+            if (e.row >= block_rows || e.col >= block_cols)
+                throw std::runtime_error{"Sparse matrix entry is out of range"};
+        }
+        std::sort(entries.begin(), entries.end(), [](entry_type const& lhs, entry_type const& rhs) {
+            return lhs.row < rhs.row || (lhs.row == rhs.row && lhs.col < rhs.col);
+        });
+        col_indices_.reserve(entries.size());
+        blocks_.reserve(entries.size());
+        for (std::size_t i = 0; i < entries.size(); ++i) {
+            auto const& e = entries[i];
+            if (i > 0 && e.row == entries[i - 1].row && e.col == entries[i - 1].col) {
+                blocks_.back() += e.value;
+            } else {
+                col_indices_.push_back(static_cast<index_type>(e.col));
+                blocks_.push_back(e.value);
+                ++row_offsets_[e.row + 1];
+            }
+        }
+        for (size_type r = 0; r < block_rows; ++r) {
+            row_offsets_[r + 1] += row_offsets_[r];
+        }
+    }
+
+    //@{
+    /** @name Size */
+    /** Scalar rows */
+    size_type
+    rows() const
+    {
+        return block_rows_ * B;
+    }
+    /** Scalar columns */
+    size_type
+    cols() const
+    {
+        return block_cols_ * B;
+    }
+    size_type
+    block_rows() const
+    {
+        return block_rows_;
+    }
+    size_type
+    block_cols() const
+    {
+        return block_cols_;
+    }
+    /** Number of the stored blocks */
+    size_type
+    non_zeros() const
+    {
+        return blocks_.size();
+    }
+    //@}
+
+    //@{
+    /** @name CSR arrays */
+    /** block_rows() + 1 offsets of the rows in the column and block arrays */
+    size_type const*
+    row_offsets() const
+    {
+        return row_offsets_.data();
+    }
+    index_type const*
+    col_indices() const
+    {
+        return col_indices_.data();
+    }
+    block_type*
+    blocks()
+    {
+        return blocks_.data();
+    }
+    block_type const*
+    blocks() const
+    {
+        return blocks_.data();
+    }
+    //@}
+
+    /**
+     * Pointer to the stored block at row r and column c, nullptr if the
+     * block is not stored
+     */
+    block_type*
+    find(size_type r, size_type c)
+    {
+        auto const* first = col_indices_.data() + row_offsets_[r];
+        auto const* last  = col_indices_.data() + row_offsets_[r + 1];
+        auto const* p     = std::lower_bound(first, last, c);
+        return p != last && *p == c ? blocks_.data() + (p - col_indices_.data()) : nullptr;
+    }
+    block_type const*
+    find(size_type r, size_type c) const
+    {
+        return const_cast<sparse_matrix*>(this)->find(r, c);
+    }
+
+    /**
+     * Scalar diagonal of the matrix, the missing values are zero
+     */
+    vector_type
+    diagonal() const
+    {
+        vector_type res(std::min(rows(), cols()));
+        for (size_type r = 0; r < std::min(block_rows_, block_cols_); ++r) {
+            if (auto const* b = find(r, r)) {
+                T const* data = block_data(*b);
+                for (size_type i = 0; i < B; ++i) {
+                    res[r * B + i] = data[i * B + i];
+                }
+            }
+        }
+        return res;
+    }
+
+    /**
+     * Dense copy of the matrix
+     */
+    dynamic_matrix<T>
+    dense() const
+    {
+        dynamic_matrix<T> res(rows(), cols());
+        for (size_type r = 0; r < block_rows_; ++r) {
+            for (size_type k = row_offsets_[r]; k < row_offsets_[r + 1]; ++k) {
+                T const* data = block_data(blocks_[k]);
+                for (size_type i = 0; i < B; ++i) {
+                    for (size_type j = 0; j < B; ++j) {
+                        res[r * B + i][col_indices_[k] * B + j] = data[i * B + j];
+                    }
+                }
+            }
+        }
+        return res;
+    }
+
+    /** Scalar values of a block stored by rows */
+    static T const*
+    block_data(block_type const& b)
+    {
+        if constexpr (B == 1) {
+            return &b;
+        } else {
+            return b.data();
+        }
+    }
+
+private:
+    size_type               block_rows_ = 0;
+    size_type               block_cols_ = 0;
+    std::vector<size_type>  row_offsets_{0};
+    std::vector<index_type> col_indices_;
+    std::vector<block_type> blocks_;
+};
+
+/**
+ * Sparse matrix of 3x3 blocks, e.g. of a cloth or an FEM system with a 3D
+ * displacement per node
+ */
+template <typename T>
+using block_sparse_matrix3 = sparse_matrix<T, 3>;
+
+namespace detail {
+
+/**
+ * Number of contiguous parts to split count items of the given cost into,
+ * a part is at least config::parallel_min_items of work
+ */
+inline std::size_t
+parallel_parts(std::size_t count, std::size_t item_cost, std::size_t threads)
+{
+    if (threads == 0)
+        threads = default_thread_count();
+    std::size_t const work = count * std::max<std::size_t>(item_cost, 1);
+    return std::max<std::size_t>(std::min(threads, work / config::parallel_min_items), 1);
+}
+
+/**
+ * Call fn(part, begin, end) for parts contiguous ranges of [0, count)
+ */
+template <typename Function>
+void
+for_each_part(std::size_t count, std::size_t parts, Function&& fn)
+{
+    parallel_for(parts, 1, parts, [&](std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end; ++i) {
+            fn(i, count * i / parts, count * (i + 1) / parts);
+        }
+    });
+}
+
+template <typename T>
+void
+check_multiply_size(dynamic_vector<T> const& x, dynamic_vector<T> const& y, std::size_t size)
+{
+    if (x.size() != size)
+        throw std::runtime_error{"Vector size doesn't match the sparse matrix"};
+    if (&x == &y)
+        throw std::runtime_error{"Sparse matrix product cannot be computed in place"};
+}
+
+/**
+ * Sum of lhs[i] * rhs[i] for the parts of the vectors, the partial sums are
+ * added in the order of the parts, so the result doesn't depend on the
+ * scheduling of the threads
+ */
+template <typename T, typename Function>
+T
+parallel_sum(std::size_t count, std::size_t parts, Function&& fn)
+{
+    std::vector<T> sums(parts, T{0});
+    for_each_part(count, parts, [&](std::size_t part, std::size_t begin, std::size_t end) {
+        sums[part] = fn(begin, end);
+    });
+    T res{0};
+    for (auto s : sums) {
+        res += s;
+    }
+    return res;
+}
+
+}    // namespace detail
+
+//@{
+/**
+ * @name Sparse matrix and vector products
+ * @param threads maximum number of threads, 0 means the hardware concurrency
+ */
+/**
+ * y = a * x. The rows are split between the threads.
+ * @throws std::runtime_error if the size of x is not a.cols() or x is y
+ */
+template <typename T, std::size_t B>
+void
+multiply(sparse_matrix<T, B> const& a, dynamic_vector<T> const& x, dynamic_vector<T>& y,
+         std::size_t threads = 1)
+{
+    detail::check_multiply_size(x, y, a.cols());
+    y.resize(a.rows());
+    auto const* offsets = a.row_offsets();
+    auto const* cols    = a.col_indices();
+    auto const* blocks  = a.blocks();
+    T const*    xp      = x.data();
+    T*          yp      = y.data();
+
+    std::size_t const avg_cost = a.block_rows() ? a.non_zeros() * B * B / a.block_rows() : 0;
+    std::size_t const parts    = detail::parallel_parts(a.block_rows(), avg_cost, threads);
+    detail::for_each_part(a.block_rows(), parts, [&](std::size_t, std::size_t begin,
+                                                     std::size_t end) {
+        for (std::size_t r = begin; r < end; ++r) {
+            T sum[B] = {};
+            for (std::size_t k = offsets[r]; k < offsets[r + 1]; ++k) {
+                T const* blk = sparse_matrix<T, B>::block_data(blocks[k]);
+                T const* xb  = xp + cols[k] * B;
+                for (std::size_t i = 0; i < B; ++i) {
+                    for (std::size_t j = 0; j < B; ++j) {
+                        sum[i] += blk[i * B + j] * xb[j];
+                    }
+                }
+            }
+            for (std::size_t i = 0; i < B; ++i) {
+                yp[r * B + i] = sum[i];
+            }
+        }
+    });
+}
+
+/**
+ * y = transpose(a) * x. The rows are split between the threads, each thread
+ * scatters its rows into its own copy of y and the copies are added
+ * together.
+ * @throws std::runtime_error if the size of x is not a.rows() or x is y
+ */
+template <typename T, std::size_t B>
+void
+multiply_transposed(sparse_matrix<T, B> const& a, dynamic_vector<T> const& x,
+                    dynamic_vector<T>& y, std::size_t threads = 1)
+{
+    detail::check_multiply_size(x, y, a.rows());
+    y.resize(a.cols());
+    y.zero();
+    auto const* offsets = a.row_offsets();
+    auto const* cols    = a.col_indices();
+    auto const* blocks  = a.blocks();
+    T const*    xp      = x.data();
+
+    std::size_t const avg_cost = a.block_rows() ? a.non_zeros() * B * B / a.block_rows() : 0;
+    std::size_t const parts    = detail::parallel_parts(a.block_rows(), avg_cost, threads);
+    std::vector<dynamic_vector<T>> partial(parts - 1);
+    detail::for_each_part(a.block_rows(), parts, [&](std::size_t part, std::size_t begin,
+                                                     std::size_t end) {
+        T* yp = y.data();
+        if (part > 0) {
+            partial[part - 1] = dynamic_vector<T>(a.cols());
+            yp                = partial[part - 1].data();
+        }
+        for (std::size_t r = begin; r < end; ++r) {
+            T const* xb = xp + r * B;
+            for (std::size_t k = offsets[r]; k < offsets[r + 1]; ++k) {
+                T const* blk = sparse_matrix<T, B>::block_data(blocks[k]);
+                T*       yb  = yp + cols[k] * B;
+                for (std::size_t i = 0; i < B; ++i) {
+                    for (std::size_t j = 0; j < B; ++j) {
+                        yb[j] += blk[i * B + j] * xb[i];
+                    }
+                }
+            }
+        }
+    });
+    if (parts > 1) {
+        detail::for_each_part(a.cols(), parts, [&](std::size_t, std::size_t begin,
+                                                   std::size_t end) {
+            for (auto const& p : partial) {
+                for (std::size_t i = begin; i < end; ++i) {
+                    y[i] += p[i];
+                }
+            }
+        });
+    }
+}
+
+template <typename T, std::size_t B>
+dynamic_vector<T>
+operator*(sparse_matrix<T, B> const& a, dynamic_vector<T> const& x)
+{
+    dynamic_vector<T> res;
+    multiply(a, x, res);
+    return res;
+}
+//@}
+
+/**
+ * Result of an iterative solver
+ */
+template <typename T>
+struct solver_result {
+    /** Number of the iterations done */
+    std::size_t iterations;
+    /** Norm of the residual relative to the norm of the right hand side */
+    T residual;
+    bool converged;
+};
+
+/**
+ * Solve a * x = b for a symmetric positive definite matrix by the conjugate
+ * gradient method with the Jacobi (diagonal) preconditioner. x is the
+ * initial guess and the solution. The products and the vector updates are
+ * split between the threads. Besides the product and its dot product, an
+ * iteration makes two passes over the vectors: the x and r updates with
+ * the reductions for the residual and beta, then the p update.
+ *
+ * @param tolerance the relative residual |b - a * x| / |b| to stop at
+ * @param max_iterations 0 means the size of the system
+ * @param threads maximum number of threads, 0 means the hardware concurrency
+ * @return not converged result when the tolerance is not reached in
+ *         max_iterations or the method breaks down on a matrix that is not
+ *         positive definite
+ * @throws std::runtime_error if the matrix is not square or the vector sizes
+ *         don't match
+ */
+template <typename T, std::size_t B>
+solver_result<T>
+conjugate_gradient(sparse_matrix<T, B> const& a, dynamic_vector<T> const& b,
+                   dynamic_vector<T>& x, T tolerance, std::size_t max_iterations = 0,
+                   std::size_t threads = 1)
+{
+    std::size_t const n = a.rows();
+    if (a.cols() != n)
+        throw std::runtime_error{"Conjugate gradient requires a square matrix"};
+    if (b.size() != n)
+        throw std::runtime_error{"Vector size doesn't match the sparse matrix"};
+    if (x.size() != n)
+        x = dynamic_vector<T>(n);
+    if (max_iterations == 0)
+        max_iterations = n;
+
+    std::size_t const parts = detail::parallel_parts(n, 1, threads);
+    auto dot = [parts, n](dynamic_vector<T> const& lhs, dynamic_vector<T> const& rhs) {
+        return detail::parallel_sum<T>(n, parts, [&](std::size_t begin, std::size_t end) {
+            return detail::dot_kernel(lhs.data() + begin, rhs.data() + begin, end - begin);
+        });
+    };
+
+    T const b_norm = std::sqrt(dot(b, b));
+    if (b_norm == T{0}) {
+        x.zero();
+        return {0, T{0}, true};
+    }
+
+    dynamic_vector<T> inv_diag = a.diagonal();
+    for (auto& v : inv_diag) {
+        v = v != T{0} ? 1 / v : T{1};
+    }
+    dynamic_vector<T> r, p(n), q;
+    multiply(a, x, q, threads);
+    r = b - q;
+    detail::for_each_part(n, parts, [&](std::size_t, std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end; ++i) {
+            p[i] = inv_diag[i] * r[i];
+        }
+    });
+    T rz       = dot(r, p);
+    T residual = std::sqrt(dot(r, r)) / b_norm;
+
+    std::vector<T> r_norm2_parts(parts);
+    std::vector<T> rz_parts(parts);
+    std::size_t    it = 0;
+    for (; it < max_iterations && residual > tolerance; ++it) {
+        multiply(a, p, q, threads);
+        T const pq = dot(p, q);
+        // The matrix is not positive definite, the step along p is undefined
+        if (!(pq > T{0}))
+            return {it, residual, false};
+        T const alpha = rz / pq;
+        // x += alpha * p, r -= alpha * q, |r|^2 and r * z for z = r / diag
+        detail::for_each_part(n, parts, [&](std::size_t part, std::size_t begin, std::size_t end) {
+            T r_norm2{0};
+            T rz_next{0};
+            for (std::size_t i = begin; i < end; ++i) {
+                x[i] += alpha * p[i];
+                r[i] -= alpha * q[i];
+                r_norm2 += r[i] * r[i];
+                rz_next += inv_diag[i] * r[i] * r[i];
+            }
+            r_norm2_parts[part] = r_norm2;
+            rz_parts[part]      = rz_next;
+        });
+        // The partial sums are added in the order of the parts
+        T r_norm2{0};
+        T rz_next{0};
+        for (std::size_t part = 0; part < parts; ++part) {
+            r_norm2 += r_norm2_parts[part];
+            rz_next += rz_parts[part];
+        }
+        residual     = std::sqrt(r_norm2) / b_norm;
+        T const beta = rz_next / rz;
+        rz           = rz_next;
+        // p = z + beta * p
+        detail::for_each_part(n, parts, [&](std::size_t, std::size_t begin, std::size_t end) {
+            for (std::size_t i = begin; i < end; ++i) {
+                p[i] = inv_diag[i] * r[i] + beta * p[i];
+            }
+        });
+    }
+    return {it, residual, residual <= tolerance};
+}
+
+}    // namespace math
+}    // namespace psst
+
+#endif /* PSST_MATH_SPARSE_MATRIX_HPP_ */
@@ -0,0 +1,282 @@
+/**
+ * Copyright 2019 Sergei A. Fedorov
+ * spatial_hash_grid.hpp
+ *
+ *  Created on: Mar 2, 2019
+ *      Author: ser-fedorov
+ */
+
+#ifndef PSST_MATH_SPATIAL_HASH_GRID_HPP_
+#define PSST_MATH_SPATIAL_HASH_GRID_HPP_
+
+#include <psst/math/config.hpp>
+#include <psst/math/detail/parallel.hpp>
+#include <psst/math/vector.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+namespace psst {
+namespace math {
+
+/**
+ * A uniform grid of cubic cells over points, for neighbour searches within a
+ * radius close to the cell size.
+ *
+ * The grid is unbounded, the cells are hashed into a table of buckets with
+ * as many buckets as there are points, rounded up to a power of two. The
+ * points are sorted by the bucket with a counting sort, the grid keeps the
+ * sorted copies of the points and their cells and the original indices. A
+ * bucket is a range of the sorted points, the ranges are kept as offsets, so
+ * the grid needs a single array of the bucket count for all of them.
+ *
+ * The grid is meant to be rebuilt every step of a simulation, build reuses
+ * the memory of the previous step.
+ */
+template <typename T, typename Components = components::default_components_t<3>>
+class spatial_hash_grid {
+public:
+    using value_type  = T;
+    using vector_type = vector<T, 3, Components>;
+    using cell_type   = vector<std::int32_t, 3>;
+
+    /**
+     * An empty grid
+     * @throws std::runtime_error if the cell size is not positive
+     */
+    explicit spatial_hash_grid(T cell_size) : cell_size_{cell_size}, inv_cell_size_{1 / cell_size}
+    {
+        if (!(cell_size > 0))
+            throw std::runtime_error{"Cell size of a grid must be positive"};
+    }
+
+    /**
+     * A grid over an array of points
+     * @param threads maximum number of threads, 0 means the hardware concurrency
+     */
+    spatial_hash_grid(vector_type const* points, std::size_t count, T cell_size,
+                      std::size_t threads = 1)
+        : spatial_hash_grid{cell_size}
+    {
+        build(points, count, threads);
+    }
+
+    /**
+     * Sort the points to the cells, the previous contents of the grid are
+     * replaced
+     * @param threads maximum number of threads, 0 means the hardware concurrency
+     * @throws std::runtime_error if there are more points than a 32 bit index
+     *         can address
+     */
+    void
+    build(vector_type const* points, std::size_t count, std::size_t threads = 1)
+    {
+        if (count > std::numeric_limits<std::uint32_t>::max())
+            throw std::runtime_error{"Too many points for a spatial hash grid"};
+        std::size_t buckets = 1;
+        while (buckets < count) {
+            buckets <<= 1;
+        }
+        mask_ = static_cast<std::uint32_t>(buckets - 1);
+
+        if (threads == 0)
+            threads = detail::default_thread_count();
+        std::size_t const parts =
+            std::max<std::size_t>(std::min(threads, count / config::parallel_min_items), 1);
+        keys_.resize(count);
+        counts_.assign(parts * buckets, 0);
+        // Every part counts the keys of its points
+        detail::parallel_for(parts, 1, parts, [&](std::size_t begin, std::size_t end) {
+            for (std::size_t i = begin; i < end; ++i) {
+                std::uint32_t* part_counts = counts_.data() + i * buckets;
+                for (std::size_t p = count * i / parts; p < count * (i + 1) / parts; ++p) {
+                    keys_[p] = bucket(cell(points[p]));
+                    ++part_counts[keys_[p]];
+                }
+            }
+        });
+        // The points of a bucket are ordered by the part, so the sort is
+        // stable and doesn't depend on the number of threads
+        offsets_.resize(buckets + 1);
+        std::uint32_t sum = 0;
+        for (std::size_t b = 0; b < buckets; ++b) {
+            offsets_[b] = sum;
+            for (std::size_t i = 0; i < parts; ++i) {
+                std::uint32_t const n    = counts_[i * buckets + b];
+                counts_[i * buckets + b] = sum;
+                sum += n;
+            }
+        }
+        offsets_[buckets] = sum;
+
+        indices_.resize(count);
+        points_.resize(count);
+        cells_.resize(count);
+        detail::parallel_for(parts, 1, parts, [&](std::size_t begin, std::size_t end) {
+            for (std::size_t i = begin; i < end; ++i) {
+                std::uint32_t* part_offsets = counts_.data() + i * buckets;
+                for (std::size_t p = count * i / parts; p < count * (i + 1) / parts; ++p) {
+                    std::uint32_t const pos = part_offsets[keys_[p]]++;
+                    indices_[pos]           = static_cast<std::uint32_t>(p);
+                    points_[pos]            = points[p];
+                    cells_[pos]             = cell(points[p]);
+                }
+            }
+        });
+    }
+
+    T
+    cell_size() const
+    {
+        return cell_size_;
+    }
+
+    std::size_t
+    size() const
+    {
+        return points_.size();
+    }
+
+    bool
+    empty() const
+    {
+        return points_.empty();
+    }
+
+    /** The points sorted by the bucket */
+    std::vector<vector_type> const&
+    points() const
+    {
+        return points_;
+    }
+
+    /** The original indices of the sorted points */
+    std::vector<std::uint32_t> const&
+    indices() const
+    {
+        return indices_;
+    }
+
+    /** The cell of a point */
+    cell_type
+    cell(vector_type const& p) const
+    {
+        return {static_cast<std::int32_t>(std::floor(p[0] * inv_cell_size_)),
+                static_cast<std::int32_t>(std::floor(p[1] * inv_cell_size_)),
+                static_cast<std::int32_t>(std::floor(p[2] * inv_cell_size_))};
+    }
+
+    /**
+     * Call fn(index, distance_square) for every point within the radius, the
+     * index is the original index of the point
+     */
+    template <typename Function>
+    void
+    for_each_neighbour(vector_type const& point, T radius, Function&& fn) const
+    {
+        if (empty())
+            return;
+        T const r2 = radius * radius;
+        for_each_cell<false>(cell(point), reach(radius), [&](std::size_t i) {
+            T const d = distance_square(point, points_[i]);
+            if (d <= r2)
+                fn(indices_[i], d);
+        });
+    }
+
+    /**
+     * Call fn(i, j, distance_square) once for every pair of points within the
+     * radius, i and j are the original indices of the points. When several
+     * threads are used, fn is called concurrently and must be thread safe.
+     * @param threads maximum number of threads, 0 means the hardware concurrency
+     */
+    template <typename Function>
+    void
+    for_each_pair(T radius, Function&& fn, std::size_t threads = 1) const
+    {
+        T const            r2    = radius * radius;
+        std::int32_t const cells = reach(radius);
+        detail::parallel_for(size(), min_batch, threads, [&](std::size_t begin, std::size_t end) {
+            for (std::size_t a = begin; a < end; ++a) {
+                vector_type const   p     = points_[a];
+                cell_type const     c     = cells_[a];
+                std::uint32_t const index = indices_[a];
+                for_each_cell<true>(c, cells, [&](std::size_t b) {
+                    // The pairs in the same cell are found from the first point
+                    if (b <= a && cells_[b] == c)
+                        return;
+                    T const d = distance_square(p, points_[b]);
+                    if (d <= r2)
+                        fn(index, indices_[b], d);
+                });
+            }
+        });
+    }
+
+private:
+    /** Minimal number of points processed by a thread in the pair search */
+    static constexpr std::size_t min_batch = 1024;
+
+    std::uint32_t
+    bucket(cell_type const& c) const
+    {
+        auto const x = static_cast<std::uint32_t>(c[0]) * 73856093u;
+        auto const y = static_cast<std::uint32_t>(c[1]) * 19349663u;
+        auto const z = static_cast<std::uint32_t>(c[2]) * 83492791u;
+        return (x ^ y ^ z) & mask_;
+    }
+
+    /** Number of cells around a cell that may contain the points within radius */
+    std::int32_t
+    reach(T radius) const
+    {
+        return std::max(static_cast<std::int32_t>(std::ceil(radius * inv_cell_size_)), 1);
+    }
+
+    /**
+     * Call fn(sorted index) for the points of the cells around a cell. Several
+     * cells can share a bucket, the points of other cells are skipped.
+     * @tparam Forward visit only the cell and the cells after it in z, y, x
+     *         order, so that a pair of cells is visited once from one of them
+     */
+    template <bool Forward, typename Function>
+    void
+    for_each_cell(cell_type const& c, std::int32_t cells, Function&& fn) const
+    {
+        for (std::int32_t dz = Forward ? 0 : -cells; dz <= cells; ++dz) {
+            for (std::int32_t dy = Forward && dz == 0 ? 0 : -cells; dy <= cells; ++dy) {
+                std::int32_t const first = Forward && dz == 0 && dy == 0 ? 0 : -cells;
+                for (std::int32_t dx = first; dx <= cells; ++dx) {
+                    cell_type const     target{c[0] + dx, c[1] + dy, c[2] + dz};
+                    std::uint32_t const b = bucket(target);
+                    for (auto i = offsets_[b]; i < offsets_[b + 1]; ++i) {
+                        if (cells_[i][0] == target[0] && cells_[i][1] == target[1]
+                            && cells_[i][2] == target[2])
+                            fn(i);
+                    }
+                }
+            }
+        }
+    }
+
+    T             cell_size_;
+    T             inv_cell_size_;
+    std::uint32_t mask_ = 0;
+
+    std::vector<vector_type>   points_;
+    std::vector<cell_type>     cells_;
+    std::vector<std::uint32_t> indices_;
+    std::vector<std::uint32_t> offsets_;
+    // Scratch memory of the build
+    std::vector<std::uint32_t> keys_;
+    std::vector<std::uint32_t> counts_;
+};
+
+}    // namespace math
+}    // namespace psst
+
+#endif /* PSST_MATH_SPATIAL_HASH_GRID_HPP_ */
@@ -0,0 +1,336 @@
+/**
+ * Copyright 2019 Sergei A. Fedorov
+ * transform_hierarchy.hpp
+ *
+ *  Created on: Feb 24, 2019
+ *      Author: ser-fedorov
+ */
+
+#ifndef PSST_MATH_TRANSFORM_HIERARCHY_HPP_
+#define PSST_MATH_TRANSFORM_HIERARCHY_HPP_
+
+#include <psst/math/affine_transform.hpp>
+#include <psst/math/config.hpp>
+#include <psst/math/detail/parallel.hpp>
+#include <psst/math/matrix.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+namespace psst {
+namespace math {
+
+namespace detail {
+
+template <typename T, typename Components>
+void
+compose_world(matrix<T, 4, 4, Components> const& parent, matrix<T, 4, 4, Components> const& local,
+              matrix<T, 4, 4, Components>& world)
+{
+    // The result is evaluated to a temporary first, so that the compiler
+    // doesn't need to reload the arguments after every store to world
+    matrix<T, 4, 4, Components> const res = parent * local;
+    world                                 = res;
+}
+
+template <typename T, typename Components>
+void
+compose_world(matrix<T, 3, 4, Components> const& parent, matrix<T, 3, 4, Components> const& local,
+              matrix<T, 3, 4, Components>& world)
+{
+    affine_multiply(parent.data(), local.data(), world.data());
+}
+
+}    // namespace detail
+
+/**
+ * Flat hierarchy of transforms, e.g. nodes of a scene graph. A node is
+ * identified by its index, a parent is always added before its children,
+ * so the nodes are topologically sorted and the world transforms can be
+ * computed in a single pass over the arrays.
+ *
+ * A node becomes dirty when its local transform changes. update() computes
+ * world transforms only for the dirty nodes and their descendants, world of
+ * a node is world of the parent multiplied by the local transform.
+ *
+ * @tparam Transform matrix<T, 4, 4> or affine_transform<T>
+ */
+template <typename Transform>
+struct transform_hierarchy {
+    static_assert(traits::is_matrix_v<Transform>, "Transform must be a matrix");
+    static_assert(Transform::cols == 4 && (Transform::rows == 4 || Transform::rows == 3),
+                  "Transform must be a 4x4 matrix or a 3x4 affine transform");
+
+    using transform_type = Transform;
+    using size_type      = std::size_t;
+
+    /** Parent index of a root node */
+    static constexpr size_type no_parent = std::numeric_limits<size_type>::max();
+
+    transform_hierarchy() = default;
+
+    void
+    reserve(size_type n)
+    {
+        parents_.reserve(n);
+        local_.reserve(n);
+        world_.reserve(n);
+        dirty_.reserve(n);
+    }
+
+    size_type
+    size() const
+    {
+        return parents_.size();
+    }
+
+    bool
+    empty() const
+    {
+        return parents_.empty();
+    }
+
+    /**
+     * Add a node and return its index. The node is dirty until the next
+     * update.
+     * @param parent index of the parent or no_parent for a root node
+     * @throws std::out_of_range if parent is not a valid node index
+     */
+    size_type
+    add_node(size_type parent, transform_type const& local)
+    {
+        if (parent != no_parent && parent >= size())
+            throw std::out_of_range("Invalid parent node index");
+        parents_.push_back(parent);
+        local_.push_back(local);
+        world_.push_back(local);
+        dirty_.push_back(1);
+        schedule_valid_ = false;
+        return size() - 1;
+    }
+
+    size_type
+    add_node(transform_type const& local)
+    {
+        return add_node(no_parent, local);
+    }
+
+    size_type
+    parent(size_type node) const
+    {
+        return parents_[node];
+    }
+
+    transform_type const&
+    local(size_type node) const
+    {
+        return local_[node];
+    }
+
+    void
+    set_local(size_type node, transform_type const& local)
+    {
+        local_[node] = local;
+        dirty_[node] = 1;
+    }
+
+    void
+    mark_dirty(size_type node)
+    {
+        dirty_[node] = 1;
+    }
+
+    bool
+    dirty(size_type node) const
+    {
+        return dirty_[node] != 0;
+    }
+
+    /**
+     * World transform of the node as of the last update
+     */
+    transform_type const&
+    world(size_type node) const
+    {
+        return world_[node];
+    }
+
+    /**
+     * World transforms of all the nodes, contiguous and in the node order
+     */
+    transform_type const*
+    world_data() const
+    {
+        return world_.data();
+    }
+
+    /**
+     * Recompute the world transforms of dirty nodes and their descendants in
+     * a single pass over the nodes.
+     */
+    void
+    update()
+    {
+        for (size_type i = 0; i < size(); ++i) {
+            update_node(i);
+        }
+        clear_dirty();
+    }
+
+    /**
+     * Recompute the world transforms in parallel across independent
+     * subtrees. The node array is split into contiguous ranges, so that a
+     * parent of a node in a range is either in the same range or among the
+     * few top nodes, that are updated first by the calling thread. Each range
+     * is then processed by a single pass as in the sequential update.
+     *
+     * The ranges are found when the structure of the hierarchy changes. A
+     * subtree can be split off only if its nodes are stored contiguously, it
+     * is the case when the nodes are added depth-first or tree by tree.
+     * Ranges are at least config::parallel_min_items nodes long.
+     * @param threads maximum number of threads, 0 means the hardware
+     *                concurrency
+     */
+    void
+    update(size_type threads)
+    {
+        if (threads == 1 || size() < 2 * config::parallel_min_items) {
+            update();
+            return;
+        }
+        if (threads == 0)
+            threads = detail::default_thread_count();
+        build_schedule();
+        for (auto node : top_nodes_) {
+            update_node(node);
+        }
+
+        // Ranges between the cuts of about the same size for each thread
+        size_type const        target = std::max(config::parallel_min_items, size() / threads);
+        std::vector<size_type> bounds{0};
+        while (bounds.back() < size()) {
+            auto next = std::lower_bound(cuts_.begin(), cuts_.end(), bounds.back() + target);
+            bounds.push_back(next == cuts_.end() ? size() : *next);
+        }
+        detail::parallel_for(bounds.size() - 1, 1, threads,
+                             [this, &bounds](size_type begin, size_type end) {
+                                 for (size_type i = bounds[begin]; i < bounds[end]; ++i) {
+                                     if (!top_[i])
+                                         update_node(i);
+                                 }
+                             });
+        clear_dirty();
+    }
+
+private:
+    void
+    update_node(size_type node)
+    {
+        size_type const p = parents_[node];
+        if (p == no_parent) {
+            if (dirty_[node])
+                world_[node] = local_[node];
+        } else {
+            // The parent is processed before, its flag tells if its world
+            // transform changed
+            dirty_[node] |= dirty_[p];
+            if (dirty_[node])
+                detail::compose_world(world_[p], local_[node], world_[node]);
+        }
+    }
+
+    void
+    clear_dirty()
+    {
+        std::fill(dirty_.begin(), dirty_.end(), std::uint8_t{0});
+    }
+
+    /**
+     * Positions where the node array can be split into independent ranges,
+     * when the nodes up to depth top are updated beforehand.
+     * @return the length of the longest range
+     */
+    size_type
+    find_cuts(std::vector<size_type> const& depth, size_type top, std::vector<size_type>& cuts)
+    {
+        // A node blocks the cuts between its parent and itself
+        std::vector<std::ptrdiff_t> blocked(size() + 1, 0);
+        for (size_type i = 0; i < size(); ++i) {
+            if (depth[i] > top) {
+                ++blocked[parents_[i] + 1];
+                --blocked[i + 1];
+            }
+        }
+        cuts.clear();
+        std::ptrdiff_t count   = 0;
+        size_type      longest = 0;
+        size_type      prev    = 0;
+        for (size_type c = 1; c < size(); ++c) {
+            count += blocked[c];
+            if (count == 0) {
+                cuts.push_back(c);
+                longest = std::max(longest, c - prev);
+                prev    = c;
+            }
+        }
+        return std::max(longest, size() - prev);
+    }
+
+    /**
+     * Choose the smallest depth of top nodes, that allows splitting the
+     * nodes into ranges of reasonable length, and find the cuts for it.
+     */
+    void
+    build_schedule()
+    {
+        if (schedule_valid_)
+            return;
+        constexpr size_type    max_top_depth = 8;
+        std::vector<size_type> depth(size());
+        size_type              max_depth = 0;
+        for (size_type i = 0; i < size(); ++i) {
+            depth[i]  = parents_[i] == no_parent ? 0 : depth[parents_[i]] + 1;
+            max_depth = std::max(max_depth, depth[i]);
+        }
+
+        size_type const        enough = std::max(config::parallel_min_items, size() / 16);
+        size_type              top    = 0;
+        size_type              best   = find_cuts(depth, 0, cuts_);
+        std::vector<size_type> cuts;
+        for (size_type d = 1; best > enough && d <= std::min(max_depth, max_top_depth); ++d) {
+            size_type const longest = find_cuts(depth, d, cuts);
+            if (longest < best) {
+                best = longest;
+                top  = d;
+                cuts_.swap(cuts);
+            }
+        }
+
+        top_.resize(size());
+        top_nodes_.clear();
+        for (size_type i = 0; i < size(); ++i) {
+            top_[i] = depth[i] <= top;
+            if (top_[i])
+                top_nodes_.push_back(i);
+        }
+        schedule_valid_ = true;
+    }
+
+    std::vector<size_type>      parents_;
+    std::vector<transform_type> local_;
+    std::vector<transform_type> world_;
+    std::vector<std::uint8_t>   dirty_;
+    // Schedule of the parallel update
+    std::vector<size_type>    cuts_;
+    std::vector<size_type>    top_nodes_;
+    std::vector<std::uint8_t> top_;
+    bool                      schedule_valid_ = false;
+};
+
+}    // namespace math
+}    // namespace psst
+
+#endif /* PSST_MATH_TRANSFORM_HIERARCHY_HPP_ */
@@ -68,7 +68,7 @@ struct vector : expr::vector_expression<vector<T, Size, Components>>,
               typename = math::traits::enable_for_compatible_components<this_type, Expression>>
     constexpr /* implicit */ vector(Expression&& rhs)
         : vector(
-            std::forward<Expression>(rhs),
+            static_cast<expr::expression_argument_t<Expression&&>>(rhs),
             utils::make_min_index_sequence<Size,
                                            math::traits::vector_expression_size_v<Expression>>{})
     {}
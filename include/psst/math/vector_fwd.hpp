@@ -35,6 +35,12 @@ template <typename T, std::size_t Size,
           component_order     = component_order::forward>
 struct vector_view;
 
+/**
+ * A vector of a size known at run time
+ */
+template <typename T>
+struct dynamic_vector;
+
 } /* namespace math */
 } /* namespace psst */
 
@@ -282,17 +282,18 @@ struct memory_vector_view<T*, Size, Components, Order> {
     using pointer_type       = T*;
     using const_pointer_type = T const*;
     using view_type          = vector_view<T*, Size, Components, Order>;
+    using const_view_type    = vector_view<T const*, Size, Components, Order>;
 
     static constexpr std::size_t component_count = Size;
     static constexpr std::size_t element_size    = sizeof(T) * component_count;
 
-    template <typename P>
-    struct base_iterator : std::iterator<std::random_access_iterator_tag, view_type, std::ptrdiff_t,
-                                         view_type, view_type> {
-        using base_type = std::iterator<std::random_access_iterator_tag, view_type, std::ptrdiff_t,
-                                        view_type, view_type>;
-        using difference_type = typename base_type::difference_type;
-        using value_type      = typename base_type::value_type;
+    template <typename P, typename View>
+    struct base_iterator {
+        using iterator_category = std::random_access_iterator_tag;
+        using value_type        = View;
+        using difference_type   = std::ptrdiff_t;
+        using pointer           = View;
+        using reference         = View;
 
         base_iterator(P p) : p_{p} {}
 
@@ -374,8 +375,8 @@ struct memory_vector_view<T*, Size, Components, Order> {
         P p_;
     };
 
-    using iterator       = base_iterator<pointer_type>;
-    using const_iterator = base_iterator<const_pointer_type>;
+    using iterator       = base_iterator<pointer_type, view_type>;
+    using const_iterator = base_iterator<const_pointer_type, const_view_type>;
 
     constexpr memory_vector_view(pointer_type buffer, std::size_t buffer_size)
         : buffer_{buffer}, buffer_size_{buffer_ ? buffer_size : 0}
@@ -406,7 +407,17 @@ struct memory_vector_view<T*, Size, Components, Order> {
 
     constexpr view_type operator[](std::size_t index) const
     {
-        return view_type{buffer_ + index * element_size};
+        return view_type{buffer_ + index * component_count};
+    }
+
+    /**
+     * Pointer to the first scalar of the buffer
+     * @return
+     */
+    constexpr pointer_type
+    data() const
+    {
+        return buffer_;
     }
 
     constexpr iterator
@@ -459,6 +470,24 @@ make_vector_view_impl(U* buffer)
     return vector_view<U*, size, components_type, Order>(buffer);
 }
 
+template <typename T, component_order Order = component_order::forward,
+          typename = traits::enable_if_vector<T>>
+constexpr auto
+make_vector_view(traits::scalar_expression_result_t<T>* buffer)
+{
+    using value_type = traits::scalar_expression_result_t<T>;
+    return make_vector_view_impl<value_type, T, Order>(buffer);
+}
+
+template <typename T, component_order Order = component_order::forward,
+          typename = traits::enable_if_vector<T>>
+constexpr auto
+make_vector_view(traits::scalar_expression_result_t<T> const* buffer)
+{
+    using value_type = traits::scalar_expression_result_t<T>;
+    return make_vector_view_impl<value_type const, T, Order>(buffer);
+}
+
 template <typename T, component_order Order = component_order::forward,
           typename = traits::enable_if_vector<T>>
 constexpr auto
@@ -483,7 +512,8 @@ constexpr auto
 make_vector_view(char const* buffer)
 {
     using value_type = traits::scalar_expression_result_t<T>;
-    return make_vector_view_impl<value_type, T, Order>(reinterpret_cast<value_type const*>(buffer));
+    return make_vector_view_impl<value_type const, T, Order>(
+        reinterpret_cast<value_type const*>(buffer));
 }
 
 template <typename T, component_order Order = component_order::forward,
@@ -492,7 +522,8 @@ constexpr auto
 make_vector_view(unsigned char const* buffer)
 {
     using value_type = traits::scalar_expression_result_t<T>;
-    return make_vector_view_impl<value_type, T, Order>(reinterpret_cast<value_type const*>(buffer));
+    return make_vector_view_impl<value_type const, T, Order>(
+        reinterpret_cast<value_type const*>(buffer));
 }
 
 template <typename U, typename T, component_order Order = component_order::forward,
@@ -507,6 +538,35 @@ make_memory_vector_view_impl(U* val, std::size_t buffer_size)
     return memory_vector_view<U*, size, components_type, Order>(val, buffer_size);
 }
 
+/**
+ * Make a memory_vector_view over a buffer of scalars
+ * @param buffer pointer to the first scalar
+ * @param buffer_size number of scalars in the buffer
+ */
+template <typename T, component_order Order = component_order::forward,
+          typename = traits::enable_if_vector<T>>
+constexpr auto
+make_memory_vector_view(traits::scalar_expression_result_t<T>* buffer, std::size_t buffer_size)
+{
+    using value_type = traits::scalar_expression_result_t<T>;
+    return make_memory_vector_view_impl<value_type, T, Order>(buffer, buffer_size);
+}
+
+template <typename T, component_order Order = component_order::forward,
+          typename = traits::enable_if_vector<T>>
+constexpr auto
+make_memory_vector_view(traits::scalar_expression_result_t<T> const* buffer,
+                        std::size_t                                  buffer_size)
+{
+    using value_type = traits::scalar_expression_result_t<T>;
+    return make_memory_vector_view_impl<value_type const, T, Order>(buffer, buffer_size);
+}
+
+/**
+ * Make a memory_vector_view over a raw memory buffer
+ * @param buffer pointer to the memory
+ * @param buffer_size size of the buffer in bytes
+ */
 template <typename T, component_order Order = component_order::forward,
           typename = traits::enable_if_vector<T>>
 constexpr auto
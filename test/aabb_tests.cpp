@@ -0,0 +1,182 @@
+/**
+ * Copyright 2019 Sergei A. Fedorov
+ * aabb_tests.cpp
+ *
+ *  Created on: Feb 25, 2019
+ *      Author: ser-fedorov
+ */
+
+#include "test_printing.hpp"
+#include <psst/math/aabb.hpp>
+#include <psst/math/affine_transform.hpp>
+
+#include <gtest/gtest.h>
+
+#include <random>
+#include <vector>
+
+namespace psst {
+namespace math {
+
+template <typename T, std::size_t N, typename Components>
+void
+PrintTo(aabb<T, N, Components> const& box, std::ostream* os)
+{
+    *os << "[" << box.min() << " - " << box.max() << "]";
+}
+
+namespace test {
+
+using box3d    = aabb<double, 3>;
+using box2f    = aabb<float, 2>;
+using vector3d = vector<double, 3>;
+using vector2f = vector<float, 2>;
+
+TEST(Aabb, Construction)
+{
+    box3d empty;
+    EXPECT_TRUE(empty.empty());
+
+    box3d point{vector3d{1, 2, 3}};
+    EXPECT_FALSE(point.empty());
+    EXPECT_EQ(point.min(), point.max());
+
+    box3d box{{-1, -2, -3}, {1, 2, 3}};
+    EXPECT_FALSE(box.empty());
+    EXPECT_EQ((vector3d{0, 0, 0}), box.center());
+    EXPECT_EQ((vector3d{2, 4, 6}), box.extents());
+    EXPECT_TRUE((box3d{{1, 0, 0}, {0, 1, 1}}).empty());
+}
+
+TEST(Aabb, Merge)
+{
+    box3d a{{0, 0, 0}, {1, 1, 1}};
+    box3d b{{2, -1, 0.5}, {3, 0, 0.75}};
+    EXPECT_EQ((box3d{{0, -1, 0}, {3, 1, 1}}), merge(a, b));
+    EXPECT_EQ(merge(a, b), merge(b, a));
+    EXPECT_EQ(a, merge(a, box3d{}));
+    EXPECT_EQ(a, merge(box3d{}, a));
+    EXPECT_EQ((box3d{{0, 0, -5}, {1, 1, 1}}), merge(a, vector3d{0.5, 0.5, -5}));
+
+    box3d c;
+    c.expand(vector3d{1, 2, 3}).expand(vector3d{-1, 5, 0});
+    EXPECT_EQ((box3d{{-1, 2, 0}, {1, 5, 3}}), c);
+}
+
+TEST(Aabb, Intersection)
+{
+    box3d a{{0, 0, 0}, {2, 2, 2}};
+    box3d b{{1, 1, 1}, {3, 3, 3}};
+    box3d c{{2, 0, 0}, {3, 1, 1}};
+    box3d d{{2.5, 0, 0}, {3, 1, 1}};
+
+    EXPECT_TRUE(intersects(a, b));
+    EXPECT_EQ((box3d{{1, 1, 1}, {2, 2, 2}}), intersection(a, b));
+    // Touching boxes
+    EXPECT_TRUE(intersects(a, c));
+    EXPECT_FALSE(intersection(a, c).empty());
+    EXPECT_FALSE(intersects(a, d));
+    EXPECT_TRUE(intersection(a, d).empty());
+    EXPECT_FALSE(intersects(a, box3d{}));
+}
+
+TEST(Aabb, Contains)
+{
+    box3d a{{0, 0, 0}, {2, 2, 2}};
+    EXPECT_TRUE(contains(a, vector3d{1, 1, 1}));
+    EXPECT_TRUE(contains(a, vector3d{2, 0, 2}));
+    EXPECT_FALSE(contains(a, vector3d{2, 0, 2.1}));
+    EXPECT_FALSE(contains(box3d{}, vector3d{0, 0, 0}));
+
+    EXPECT_TRUE(contains(a, a));
+    EXPECT_TRUE(contains(a, box3d{{0.5, 0.5, 0.5}, {1, 2, 1}}));
+    EXPECT_FALSE(contains(a, box3d{{0.5, 0.5, 0.5}, {1, 2.5, 1}}));
+    EXPECT_TRUE(contains(a, box3d{}));
+    EXPECT_FALSE(contains(box3d{}, a));
+}
+
+TEST(Aabb, Transform)
+{
+    box3d box{{-1, 0, 1}, {2, 3, 4}};
+    auto  m = make_affine_transform(normalize(quaternion<double>{1, 2, -1, 0.5}),
+                                   vector3d{1, -2, 3}, vector3d{2, 1, 0.5});
+    matrix<double, 4, 4> m4 = convert<matrix<double, 4, 4>>(m);
+
+    // Bounds of the transformed corners
+    box3d expected;
+    for (std::size_t i = 0; i < 8; ++i) {
+        vector3d corner{i & 1 ? box.max()[0] : box.min()[0], i & 2 ? box.max()[1] : box.min()[1],
+                        i & 4 ? box.max()[2] : box.min()[2]};
+        expected.expand(vector3d(transform_point(m, corner)));
+    }
+    auto check = [&expected](box3d const& res) {
+        EXPECT_NEAR(0, magnitude(expected.min() - res.min()), 1e-12);
+        EXPECT_NEAR(0, magnitude(expected.max() - res.max()), 1e-12);
+    };
+    check(transform_bounds(m, box));
+    check(transform_bounds(m4, box));
+    EXPECT_TRUE(transform_bounds(m4, box3d{}).empty());
+
+    std::vector<box3d> boxes{box, box3d{}, box};
+    transform_bounds(m4, boxes.data(), boxes.size(), boxes.data());
+    check(boxes[0]);
+    EXPECT_TRUE(boxes[1].empty());
+    check(boxes[2]);
+}
+
+TEST(Aabb, Build)
+{
+    std::mt19937                          gen{3};
+    std::uniform_real_distribution<float> dist(-100, 100);
+    // Not a multiple of the group size
+    std::vector<vector2f> points(1003);
+    box2f                 expected;
+    for (auto& p : points) {
+        p = vector2f{dist(gen), dist(gen)};
+        expected.expand(p);
+    }
+    EXPECT_EQ(expected, make_aabb(points.data(), points.size()));
+    EXPECT_EQ(expected, make_aabb(points.data(), points.size(), 4));
+    EXPECT_TRUE(make_aabb(points.data(), 0).empty());
+    EXPECT_EQ(box2f{points[0]}, make_aabb(points.data(), 1));
+
+    auto view = make_memory_vector_view<vector2f>(points.front().data(), points.size() * 2);
+    EXPECT_EQ(expected, make_aabb(view));
+    auto rview = make_memory_vector_view<vector2f, component_order::reverse>(
+        points.front().data(), points.size() * 2);
+    box2f const swapped{{expected.min()[1], expected.min()[0]},
+                        {expected.max()[1], expected.max()[0]}};
+    EXPECT_EQ(swapped, make_aabb(rview));
+
+    std::vector<box2f> boxes;
+    for (std::size_t i = 0; i + 1 < points.size(); i += 2) {
+        boxes.push_back(merge(box2f{points[i]}, points[i + 1]));
+    }
+    EXPECT_EQ(expected, make_aabb(boxes.data(), boxes.size()));
+}
+
+TEST(Aabb, ParallelBuild)
+{
+    std::mt19937                           gen{5};
+    std::uniform_real_distribution<double> dist(-1, 1);
+    std::vector<vector3d>                  points(config::parallel_min_items * 4 + 7);
+    box3d                                  expected;
+    for (auto& p : points) {
+        p = vector3d{dist(gen), dist(gen), dist(gen)};
+        expected.expand(p);
+    }
+    EXPECT_EQ(expected, make_aabb(points.data(), points.size(), 4));
+    EXPECT_EQ(expected, make_aabb(points.data(), points.size(), 0));
+    auto view = make_memory_vector_view<vector3d>(points.front().data(), points.size() * 3);
+    EXPECT_EQ(expected, make_aabb(view, 3));
+
+    std::vector<box3d> boxes(points.size());
+    for (std::size_t i = 0; i < points.size(); ++i) {
+        boxes[i] = box3d{points[i]};
+    }
+    EXPECT_EQ(expected, make_aabb(boxes.data(), boxes.size(), 4));
+}
+
+}    // namespace test
+}    // namespace math
+}    // namespace psst
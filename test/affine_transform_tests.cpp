@@ -0,0 +1,195 @@
+/**
+ * Copyright 2019 Sergei A. Fedorov
+ * affine_transform_tests.cpp
+ *
+ *  Created on: Feb 22, 2019
+ *      Author: ser-fedorov
+ */
+
+#include "test_printing.hpp"
+#include "test_utils.hpp"
+#include <psst/math/affine_transform.hpp>
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+namespace psst {
+namespace math {
+namespace test {
+
+using affine_d     = affine_transform<double>;
+using quaternion_d = quaternion<double>;
+using vector3d     = vector<double, 3>;
+using vector4d     = vector<double, 4>;
+using matrix4x4    = matrix<double, 4, 4>;
+
+namespace {
+
+constexpr double tolerance = 1e-12;
+
+double
+distance(affine_d const& lhs, affine_d const& rhs)
+{
+    double res = 0;
+    for (std::size_t i = 0; i < affine_d::size; ++i) {
+        res = std::max(res, std::abs(lhs.data()[i] - rhs.data()[i]));
+    }
+    return res;
+}
+
+vector3d
+apply(matrix4x4 const& m, vector3d const& p, double w)
+{
+    vector4d h = as_vector(m * vector4d{p.x(), p.y(), p.z(), w});
+    return {h[0], h[1], h[2]};
+}
+
+}    // namespace
+
+TEST(Affine, Identity)
+{
+    affine_d i = affine_d::identity();
+    EXPECT_EQ((affine_d{{1, 0, 0, 0}, {0, 1, 0, 0}, {0, 0, 1, 0}}), i);
+    vector3d p{1, 2, 3};
+    EXPECT_EQ(p, vector3d(transform_point(i, p)));
+}
+
+TEST(Affine, Apply)
+{
+    affine_d m{{1, 2, 3, 4}, {5, 6, 7, 8}, {9, 10, 11, 12}};
+    vector3d p{1, -1, 2};
+    EXPECT_EQ((vector3d{1 - 2 + 6 + 4, 5 - 6 + 14 + 8, 9 - 10 + 22 + 12}),
+              vector3d(transform_point(m, p)));
+    EXPECT_EQ((vector3d{1 - 2 + 6, 5 - 6 + 14, 9 - 10 + 22}), vector3d(transform_direction(m, p)));
+
+    matrix4x4 m4 = convert<matrix4x4>(m);
+    EXPECT_EQ(apply(m4, p, 1), vector3d(transform_point(m, p)));
+    EXPECT_EQ(apply(m4, p, 0), vector3d(transform_direction(m, p)));
+}
+
+TEST(Affine, Decomposition)
+{
+    quaternion_d r = make_rotation({1, 2, 3}, 0.7);
+    vector3d     t{1, -2, 0.5};
+    vector3d     s{2, 0.5, 3};
+    vector3d     p{0.25, 3, -1};
+
+    affine_d rt = make_affine_transform(r, t);
+    EXPECT_NEAR(0, magnitude(vector3d(rotate(r, p)) + t - vector3d(transform_point(rt, p))),
+                tolerance);
+
+    affine_d rts = make_affine_transform(r, t, s);
+    vector3d sp{p.x() * s.x(), p.y() * s.y(), p.z() * s.z()};
+    EXPECT_NEAR(0, magnitude(vector3d(rotate(r, sp)) + t - vector3d(transform_point(rts, p))),
+                tolerance);
+}
+
+TEST(Affine, Compose)
+{
+    affine_d a = make_affine_transform(make_rotation({0, 0, 1}, 0.5), vector3d{1, 2, 3},
+                                       vector3d{2, 2, 2});
+    affine_d b = make_affine_transform(make_rotation({1, 1, 0}, -1.2), vector3d{-2, 0, 1},
+                                       vector3d{1, 0.5, 3});
+    vector3d p{0.5, -1, 2};
+
+    // b is applied first
+    affine_d ab       = compose(a, b);
+    vector3d expected = transform_point(a, vector3d(transform_point(b, p)));
+    EXPECT_NEAR(0, magnitude(expected - vector3d(transform_point(ab, p))), tolerance);
+
+    // The same as the product of 4x4 matrices
+    matrix4x4 m4 = convert<matrix4x4>(a) * convert<matrix4x4>(b);
+    EXPECT_NEAR(0, distance(convert<affine_d>(m4), ab), tolerance);
+    EXPECT_EQ((vector4d{0, 0, 0, 1}), convert<matrix4x4>(ab)[3]);
+
+    // Nested expression
+    affine_d abc  = compose(compose(a, b), a);
+    affine_d ab_c = compose(ab, a);
+    EXPECT_NEAR(0, distance(ab_c, abc), tolerance);
+}
+
+TEST(Affine, Inverse)
+{
+    affine_d m = make_affine_transform(make_rotation({1, -1, 2}, 2.1), vector3d{3, 2, 1},
+                                       vector3d{0.5, 2, 4});
+    affine_d i = affine_d::identity();
+    EXPECT_NEAR(0, distance(i, compose(m, inverse(m))), tolerance);
+    EXPECT_NEAR(0, distance(i, compose(inverse(m), m)), tolerance);
+
+    vector3d p{-1, 0.5, 4};
+    affine_d inv  = inverse(m);
+    vector3d back = transform_point(inv, vector3d(transform_point(m, p)));
+    EXPECT_NEAR(0, magnitude(p - back), tolerance);
+
+    affine_d singular{{1, 2, 3, 0}, {2, 4, 6, 0}, {0, 0, 1, 0}};
+    EXPECT_THROW(inverse(singular), std::runtime_error);
+
+    affine_d rigid = make_affine_transform(make_rotation({1, 2, 0}, -0.4), vector3d{5, 6, 7});
+    EXPECT_NEAR(0, distance(inverse(rigid), rigid_inverse(rigid)), tolerance);
+    EXPECT_NEAR(0, distance(i, compose(rigid, rigid_inverse(rigid))), tolerance);
+}
+
+TEST(Affine, Matrix)
+{
+    affine_d  m{{1, 2, 3, 4}, {5, 6, 7, 8}, {9, 10, 11, 12}};
+    matrix4x4 m4 = convert<matrix4x4>(m);
+    EXPECT_EQ((matrix4x4{{1, 2, 3, 4}, {5, 6, 7, 8}, {9, 10, 11, 12}, {0, 0, 0, 1}}), m4);
+    EXPECT_EQ(m, convert<affine_d>(m4));
+    EXPECT_EQ(m, convert<affine_d>(convert<matrix4x4>(m)));
+}
+
+TEST(Affine, BulkCompose)
+{
+    std::vector<affine_d> parents{
+        make_affine_transform(make_rotation({0, 0, 1}, 0.4), vector3d{1, 0, 0}),
+        make_affine_transform(make_rotation({0, 1, 0}, -0.8), vector3d{0, 3, 0}, vector3d{2, 1, 1}),
+        make_affine_transform(make_rotation({1, 0, 0}, 2.5), vector3d{0, 0, -2})};
+    std::vector<affine_d> local{
+        make_affine_transform(make_rotation({1, 1, 1}, 1.0), vector3d{4, 5, 6}),
+        make_affine_transform(make_rotation({0, 1, 1}, 0.1), vector3d{-1, 0, 1}),
+        make_affine_transform(make_rotation({1, 0, 1}, -2.0), vector3d{0, 0, 0},
+                              vector3d{3, 3, 3})};
+    std::vector<affine_d> dst(parents.size());
+
+    compose(parents.data(), local.data(), parents.size(), dst.data());
+    for (std::size_t i = 0; i < parents.size(); ++i) {
+        EXPECT_NEAR(0, distance(compose(parents[i], local[i]), dst[i]), tolerance) << "Index " << i;
+    }
+
+    compose(parents[1], local.data(), local.size(), dst.data());
+    for (std::size_t i = 0; i < local.size(); ++i) {
+        EXPECT_NEAR(0, distance(compose(parents[1], local[i]), dst[i]), tolerance) << "Index " << i;
+    }
+
+    // In place
+    std::vector<affine_d> world = local;
+    compose(parents.data(), world.data(), world.size(), world.data());
+    for (std::size_t i = 0; i < parents.size(); ++i) {
+        EXPECT_NEAR(0, distance(compose(parents[i], local[i]), world[i]), tolerance)
+            << "Index " << i;
+    }
+}
+
+TEST(Affine, BulkTransform)
+{
+    affine_d m = make_affine_transform(make_rotation({1, 0, 1}, 0.9), vector3d{1, 2, 3},
+                                       vector3d{1, 2, 0.5});
+    std::vector<vector3d> src{{1, 0, 0}, {0, 1, 0}, {0, 0, 1}, {1, 2, 3}, {-4, 5, 0.25}};
+    std::vector<vector3d> dst(src.size());
+
+    transform_point(m, src.data(), src.size(), dst.data());
+    for (std::size_t i = 0; i < src.size(); ++i) {
+        EXPECT_NEAR(0, magnitude(vector3d(transform_point(m, src[i])) - dst[i]), tolerance)
+            << "Index " << i;
+    }
+    transform_direction(m, src.data(), src.size(), dst.data());
+    for (std::size_t i = 0; i < src.size(); ++i) {
+        EXPECT_NEAR(0, magnitude(vector3d(transform_direction(m, src[i])) - dst[i]), tolerance)
+            << "Index " << i;
+    }
+}
+
+}    // namespace test
+}    // namespace math
+}    // namespace psst
@@ -0,0 +1,133 @@
+/**
+ * Copyright 2019 Sergei A. Fedorov
+ * allocation_tests.cpp
+ *
+ *  Created on: Mar 5, 2019
+ *      Author: ser-fedorov
+ */
+
+#include "test_printing.hpp"
+#include <psst/math/dynamic_matrix.hpp>
+#include <psst/math/random.hpp>
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <random>
+
+/**
+ * The heap memory of the dynamic storage is allocated aligned. The aligned
+ * allocation functions are replaced for the whole program, so the tests that
+ * count the allocations are built into a program of their own.
+ */
+namespace {
+
+std::atomic<std::size_t> aligned_allocations{0};
+
+}    // namespace
+
+void*
+operator new(std::size_t size, std::align_val_t align)
+{
+    ++aligned_allocations;
+    std::size_t const alignment = static_cast<std::size_t>(align);
+    std::size_t const blocks    = (std::max<std::size_t>(size, 1) + alignment - 1) / alignment;
+    if (void* ptr = std::aligned_alloc(alignment, blocks * alignment))
+        return ptr;
+    throw std::bad_alloc{};
+}
+void
+operator delete(void* ptr, std::align_val_t) noexcept
+{
+    std::free(ptr);
+}
+void
+operator delete(void* ptr, std::size_t, std::align_val_t) noexcept
+{
+    std::free(ptr);
+}
+
+namespace psst {
+namespace math {
+namespace test {
+
+using dynamic_vectord = dynamic_vector<double>;
+using dynamic_matrixd = dynamic_matrix<double>;
+
+namespace {
+
+std::uniform_real_distribution<double> const distribution{-1, 1};
+
+template <typename Function>
+std::size_t
+allocations(Function&& fn)
+{
+    std::size_t const before = aligned_allocations;
+    fn();
+    return aligned_allocations - before;
+}
+
+template <typename Dynamic>
+::testing::AssertionResult
+near(Dynamic const& lhs, Dynamic const& rhs, double eps = 1e-9)
+{
+    if (lhs.size() != rhs.size())
+        return ::testing::AssertionFailure() << "Sizes don't match";
+    for (std::size_t i = 0; i < lhs.size(); ++i) {
+        if (std::abs(lhs.data()[i] - rhs.data()[i]) > eps)
+            return ::testing::AssertionFailure() << "Values at " << i << " differ "
+                                                 << lhs.data()[i] << " != " << rhs.data()[i];
+    }
+    return ::testing::AssertionSuccess();
+}
+
+}    // namespace
+
+TEST(Allocations, AccumulateProduct)
+{
+    // The blocked kernel and the packed kernel
+    for (std::size_t size : {20, 70}) {
+        dynamic_matrixd const a(size, size, random_matrix_data<double>(distribution));
+        dynamic_matrixd const b(size, size, random_matrix_data<double>(distribution));
+        dynamic_vectord const v(size, random_vector_data<double>(distribution));
+        dynamic_matrixd       c(size, size, random_matrix_data<double>(distribution));
+        dynamic_vectord       w(size, random_vector_data<double>(distribution));
+        dynamic_matrixd       d(size, size);
+
+        dynamic_matrixd const copy            = c;
+        dynamic_matrixd const expected        = c + a * b - b * a;
+        dynamic_vectord const expected_vector = w + a * v - b * v;
+        auto const            storage         = c.data();
+        auto const            vector_storage  = w.data();
+
+        // The kernel of a product into the existing storage, the packed
+        // kernel allocates the packed blocks of the operands
+        std::size_t const kernel = allocations([&]() { d.noalias() = a * b; });
+        if (size < config::gemm_min_size) {
+            EXPECT_EQ(0, kernel);
+        }
+
+        // No temporary for the product
+        EXPECT_LE(allocations([&]() { c += a * b; }), kernel) << size;
+        EXPECT_LE(allocations([&]() { c -= b * a; }), kernel) << size;
+        EXPECT_EQ(0, allocations([&]() { w += a * v; })) << size;
+        EXPECT_EQ(0, allocations([&]() { w -= b * v; })) << size;
+        EXPECT_EQ(storage, c.data());
+        EXPECT_EQ(vector_storage, w.data());
+        EXPECT_TRUE(near(expected, c)) << size;
+        EXPECT_TRUE(near(expected_vector, w)) << size;
+
+        EXPECT_LE(allocations([&]() { c.noalias() -= a * b; }), kernel) << size;
+        EXPECT_LE(allocations([&]() { c.noalias() += b * a; }), kernel) << size;
+        EXPECT_EQ(0, allocations([&]() { w.noalias() -= a * v; })) << size;
+        EXPECT_EQ(storage, c.data());
+        EXPECT_EQ(vector_storage, w.data());
+        EXPECT_TRUE(near(copy, c)) << size;
+    }
+}
+
+}    // namespace test
+}    // namespace math
+}    // namespace psst
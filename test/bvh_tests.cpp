@@ -0,0 +1,298 @@
+/**
+ * Copyright 2019 Sergei A. Fedorov
+ * bvh_tests.cpp
+ *
+ *  Created on: Feb 28, 2019
+ *      Author: ser-fedorov
+ */
+
+#include "test_printing.hpp"
+#include <psst/math/bvh.hpp>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+namespace psst {
+namespace math {
+namespace test {
+
+using vector3f = vector<float, 3>;
+using rayf     = ray<float>;
+using box3f    = aabb<float, 3>;
+
+namespace {
+
+/**
+ * Small random triangles, 9 floats per triangle
+ */
+std::vector<float>
+make_mesh(std::size_t count, std::mt19937& gen)
+{
+    std::uniform_real_distribution<float> pos(-10, 10);
+    std::uniform_real_distribution<float> offset(-0.5, 0.5);
+    std::vector<float>                    res;
+    for (std::size_t i = 0; i < count; ++i) {
+        float const c[3] = {pos(gen), pos(gen), pos(gen)};
+        for (std::size_t v = 0; v < 3; ++v) {
+            for (std::size_t k = 0; k < 3; ++k) {
+                res.push_back(c[k] + offset(gen));
+            }
+        }
+    }
+    return res;
+}
+
+std::vector<rayf>
+make_rays(std::size_t count, std::mt19937& gen)
+{
+    std::uniform_real_distribution<float> pos(-12, 12);
+    std::vector<rayf>                     res;
+    for (std::size_t i = 0; i < count; ++i) {
+        vector3f origin{pos(gen), pos(gen), pos(gen)};
+        vector3f target{pos(gen) / 2, pos(gen) / 2, pos(gen) / 2};
+        res.emplace_back(origin, target - origin);
+    }
+    res[0] = rayf{{0.1, 0.2, -20}, {0, 0, 1}};
+    return res;
+}
+
+template <typename View>
+std::size_t
+nearest_triangle(View const& vertices, rayf const& r, triangle_hit<float>& hit)
+{
+    std::size_t res = vertices.size();
+    for (std::size_t i = 0; i < vertices.size() / 3; ++i) {
+        auto v = [&vertices](std::size_t n) {
+            return vector3f{vertices[n][0], vertices[n][1], vertices[n][2]};
+        };
+        if (intersect(r, v(i * 3), v(i * 3 + 1), v(i * 3 + 2), hit))
+            res = i;
+    }
+    return res;
+}
+
+template <typename Tree, typename View>
+void
+check_rays(Tree const& tree, View const& vertices, std::vector<rayf> const& rays)
+{
+    std::size_t hits = 0;
+    for (std::size_t i = 0; i < rays.size(); ++i) {
+        triangle_hit<float> expected;
+        auto const          triangle = nearest_triangle(vertices, rays[i], expected);
+        triangle_hit<float> hit;
+        std::size_t         res = vertices.size();
+        ASSERT_EQ(triangle != vertices.size(), intersect(tree, vertices, rays[i], hit, res))
+            << "Ray " << i;
+        ASSERT_EQ(triangle, res) << "Ray " << i;
+        ASSERT_EQ(expected.t, hit.t) << "Ray " << i;
+        hits += triangle != vertices.size();
+    }
+    EXPECT_LT(0u, hits);
+}
+
+/**
+ * Every primitive is referenced once and the nodes contain the children
+ */
+void
+check_tree(bvh<float> const& tree, std::vector<box3f> const& boxes)
+{
+    auto const&              nodes = tree.nodes();
+    std::vector<std::size_t> refs(boxes.size());
+    for (std::size_t i = 0; i < nodes.size(); ++i) {
+        auto const& n = nodes[i];
+        if (n.leaf()) {
+            ASSERT_GE(config::bvh_max_leaf_size, n.count) << "Node " << i;
+            for (auto k = n.first; k < n.first + n.count; ++k) {
+                auto const p = tree.indices()[k];
+                ++refs[p];
+                ASSERT_TRUE(contains(n.bounds(), boxes[p])) << "Node " << i;
+            }
+        } else {
+            ASSERT_LT(i, n.first);
+            ASSERT_GT(nodes.size(), n.first + 1);
+            ASSERT_EQ(n.bounds(), merge(nodes[n.first].bounds(), nodes[n.first + 1].bounds()))
+                << "Node " << i;
+        }
+    }
+    for (std::size_t i = 0; i < refs.size(); ++i) {
+        ASSERT_EQ(1u, refs[i]) << "Primitive " << i;
+    }
+    EXPECT_EQ(make_aabb(boxes.data(), boxes.size()), tree.bounds());
+}
+
+template <std::size_t Width>
+void
+check_tree(wide_bvh<float, Width> const& tree, std::vector<box3f> const& boxes)
+{
+    using node_type = typename wide_bvh<float, Width>::node_type;
+    auto const&              nodes = tree.nodes();
+    std::vector<std::size_t> refs(boxes.size());
+    for (std::size_t i = 0; i < nodes.size(); ++i) {
+        auto const& n = nodes[i];
+        for (std::size_t j = 0; j < Width; ++j) {
+            if (n.child[j] == node_type::empty) {
+                ASSERT_TRUE(n.bounds(j).empty());
+            } else if (n.count[j] != 0) {
+                for (auto k = n.child[j]; k < n.child[j] + n.count[j]; ++k) {
+                    auto const p = tree.indices()[k];
+                    ++refs[p];
+                    ASSERT_TRUE(contains(n.bounds(j), boxes[p])) << "Node " << i;
+                }
+            } else {
+                ASSERT_LT(i, n.child[j]);
+                ASSERT_EQ(nodes[n.child[j]].bounds(), n.bounds(j)) << "Node " << i;
+            }
+        }
+    }
+    for (std::size_t i = 0; i < refs.size(); ++i) {
+        ASSERT_EQ(1u, refs[i]) << "Primitive " << i;
+    }
+}
+
+}    // namespace
+
+TEST(Bvh, Empty)
+{
+    bvh<float> tree{nullptr, 0};
+    EXPECT_TRUE(tree.empty());
+    EXPECT_TRUE(tree.bounds().empty());
+    float t = 100;
+    EXPECT_FALSE(tree.intersect(rayf{{0, 0, 0}, {1, 0, 0}}, t,
+                                [](std::uint32_t, float&) { return true; }));
+    bool called = false;
+    tree.query(box3f{{-1, -1, -1}, {1, 1, 1}}, [&called](std::uint32_t) { called = true; });
+    EXPECT_FALSE(called);
+    EXPECT_TRUE(bvh4<float>{tree}.empty());
+}
+
+TEST(Bvh, Build)
+{
+    std::mt19937       gen{7};
+    auto const         mesh     = make_mesh(1000, gen);
+    auto const         vertices = make_memory_vector_view<vector3f>(mesh.data(), mesh.size());
+    auto const         boxes    = triangle_bounds(vertices);
+    bvh<float> const   tree{boxes.data(), boxes.size()};
+    check_tree(tree, boxes);
+    check_tree(bvh4<float>{tree}, boxes);
+    check_tree(bvh8<float>{tree}, boxes);
+    EXPECT_GE(2 * boxes.size() - 1, tree.nodes().size());
+
+    // A single primitive is the root leaf
+    bvh<float> const one{boxes.data(), 1};
+    ASSERT_EQ(1u, one.nodes().size());
+    EXPECT_TRUE(one.nodes()[0].leaf());
+    check_tree(bvh8<float>{one}, {boxes[0]});
+
+    // Identical boxes are split at the median
+    std::vector<box3f> const same(100, boxes[0]);
+    bvh<float> const         tree_same{same.data(), same.size()};
+    check_tree(tree_same, same);
+    std::size_t found = 0;
+    tree_same.query(boxes[0], [&found](std::uint32_t) { ++found; });
+    EXPECT_EQ(same.size(), found);
+
+    EXPECT_THROW(triangle_bounds(make_memory_vector_view<vector3f>(mesh.data(), 6)),
+                 std::runtime_error);
+}
+
+TEST(Bvh, Query)
+{
+    std::mt19937     gen{11};
+    auto const       mesh     = make_mesh(2000, gen);
+    auto const       vertices = make_memory_vector_view<vector3f>(mesh.data(), mesh.size());
+    auto const       boxes    = triangle_bounds(vertices);
+    bvh<float> const tree{boxes.data(), boxes.size()};
+    bvh4<float>      tree4{tree};
+
+    std::uniform_real_distribution<float> pos(-10, 10);
+    for (std::size_t q = 0; q < 50; ++q) {
+        vector3f const min{pos(gen), pos(gen), pos(gen)};
+        box3f const    box{min, min + vector3f(3)};
+        std::vector<std::uint32_t> expected;
+        for (std::size_t i = 0; i < boxes.size(); ++i) {
+            if (intersects(box, boxes[i]))
+                expected.push_back(i);
+        }
+        // The query returns the candidates from the leaves
+        auto found = [&boxes, &box](auto const& tree) {
+            std::vector<std::uint32_t> res;
+            tree.query(box, [&](std::uint32_t i) {
+                if (intersects(box, boxes[i]))
+                    res.push_back(i);
+            });
+            std::sort(res.begin(), res.end());
+            return res;
+        };
+        EXPECT_EQ(expected, found(tree));
+        EXPECT_EQ(expected, found(tree4));
+    }
+}
+
+TEST(Bvh, RayTriangles)
+{
+    std::mt19937     gen{13};
+    auto const       mesh     = make_mesh(1000, gen);
+    auto const       vertices = make_memory_vector_view<vector3f>(mesh.data(), mesh.size());
+    auto const       tree     = make_bvh(vertices);
+    auto const       rays     = make_rays(300, gen);
+    check_rays(tree, vertices, rays);
+    check_rays(bvh4<float>{tree}, vertices, rays);
+    check_rays(bvh8<float>{tree}, vertices, rays);
+
+    // The search distance limits the hits
+    triangle_hit<float> hit;
+    std::size_t         triangle = 0;
+    hit.t                        = 0.01;
+    EXPECT_FALSE(intersect(tree, vertices, rays[0], hit, triangle));
+}
+
+TEST(Bvh, ParallelBuild)
+{
+    std::mt19937 gen{17};
+    auto const   mesh     = make_mesh(config::parallel_min_items * 2 + 11, gen);
+    auto const   vertices = make_memory_vector_view<vector3f>(mesh.data(), mesh.size());
+    auto const   boxes    = triangle_bounds(vertices, 4);
+    EXPECT_EQ(triangle_bounds(vertices), boxes);
+
+    bvh<float> const tree{boxes.data(), boxes.size(), 4};
+    check_tree(tree, boxes);
+    check_tree(bvh8<float>{tree}, boxes);
+    auto const rays = make_rays(20, gen);
+    check_rays(tree, vertices, rays);
+    check_rays(bvh8<float>{boxes.data(), boxes.size(), 0}, vertices, rays);
+}
+
+TEST(Bvh, Refit)
+{
+    std::mt19937 gen{19};
+    auto         mesh     = make_mesh(2000, gen);
+    auto const   vertices = make_memory_vector_view<vector3f>(mesh.data(), mesh.size());
+    auto         tree     = make_bvh(vertices);
+    bvh4<float>  tree4{tree};
+
+    // Move a half of the triangles
+    for (std::size_t i = 0; i < mesh.size() / 2; ++i) {
+        mesh[i] = mesh[i] * 0.5f + (i % 3 == 1 ? 4.0f : -1.0f);
+    }
+    auto const boxes = triangle_bounds(vertices);
+    refit(tree, vertices);
+    refit(tree4, vertices);
+    check_tree(tree, boxes);
+    check_tree(tree4, boxes);
+    EXPECT_EQ(tree.bounds(), tree4.bounds());
+
+    auto const rays = make_rays(300, gen);
+    check_rays(tree, vertices, rays);
+    check_rays(tree4, vertices, rays);
+
+    std::vector<float> const less(mesh.begin(), mesh.end() - 9);
+    EXPECT_THROW(refit(tree, make_memory_vector_view<vector3f>(less.data(), less.size())),
+                 std::runtime_error);
+}
+
+}    // namespace test
+}    // namespace math
+}    // namespace psst
@@ -111,7 +111,7 @@ INSTANTIATE_TEST_CASE_P(Colors, HslToRgb,
         std::make_pair(hsla{(float)330_deg, 1, .5, 1},  0xff0080ff_rgba),
         std::make_pair(hsla{(float)345_deg, 1, .5, 1},  0xff0040ff_rgba),
         std::make_pair(hsla{(float)360_deg, 1, .5, 1},  0xff0000ff_rgba)
-    ), /**/);
+    ));
 // clang-format on
 
 class HsvToRgb : public ::testing::TestWithParam<std::pair<hsva, rgba_hex>> {};
@@ -168,7 +168,7 @@ INSTANTIATE_TEST_CASE_P(Colors, HsvToRgb,
         std::make_pair(hsva{(float)330_deg, 1,  1, 1},  0xff0080ff_rgba),
         std::make_pair(hsva{(float)345_deg, 1,  1, 1},  0xff0040ff_rgba),
         std::make_pair(hsva{(float)360_deg, 1,  1, 1},  0xff0000ff_rgba)
-    ), /**/);
+    ));
 // clang-format on
 
 } /* namespace test */
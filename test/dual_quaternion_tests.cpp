@@ -0,0 +1,230 @@
+/**
+ * Copyright 2019 Sergei A. Fedorov
+ * dual_quaternion_tests.cpp
+ *
+ *  Created on: Feb 20, 2019
+ *      Author: ser-fedorov
+ */
+
+#include "test_printing.hpp"
+#include "test_utils.hpp"
+#include <psst/math/dual_quaternion.hpp>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace psst {
+namespace math {
+namespace test {
+
+using quaternion_d      = quaternion<double>;
+using dual_quaternion_d = dual_quaternion<double>;
+using vector3d          = vector<double, 3>;
+using matrix4x4         = matrix<double, 4, 4>;
+
+namespace {
+
+constexpr double tolerance = 1e-12;
+
+/**
+ * Dual quaternions q and -q represent the same transform
+ */
+double
+transform_distance(dual_quaternion_d const& lhs, dual_quaternion_d const& rhs)
+{
+    return std::min<double>(magnitude(lhs - rhs), magnitude(lhs + rhs));
+}
+
+}    // namespace
+
+TEST(DualQuat, Parts)
+{
+    dual_quaternion_d q{1, 2, 3, 4, 5, 6, 7, 8};
+    EXPECT_EQ((quaternion_d{1, 2, 3, 4}), q.real());
+    EXPECT_EQ((quaternion_d{5, 6, 7, 8}), q.dual());
+    EXPECT_EQ((dual_quaternion_d{1, -2, -3, -4, 5, -6, -7, -8}), conjugate(q));
+}
+
+TEST(DualQuat, Transform)
+{
+    quaternion_d      r = make_rotation({1, 2, 3}, 0.7);
+    vector3d          t{1, -2, 0.5};
+    dual_quaternion_d q = make_dual_quaternion(r, t);
+
+    EXPECT_NEAR(0, magnitude(t - vector3d(translation(q))), tolerance);
+    EXPECT_EQ(r, q.real());
+
+    vector3d p{0.25, 3, -1};
+    vector3d expected = vector3d(rotate(r, p)) + t;
+    EXPECT_NEAR(0, magnitude(expected - vector3d(transform_point(q, p))), tolerance);
+
+    // The same as the sandwich product q (1 + εp) q*, where q* negates
+    // the vector part of the real and the scalar part of the dual part
+    dual_quaternion_d pq{1, 0, 0, 0, 0, p.x(), p.y(), p.z()};
+    dual_quaternion_d qc{r.w(), -r.x(), -r.y(), -r.z(), -q[4], q[5], q[6], q[7]};
+    dual_quaternion_d res = q * pq * qc;
+    EXPECT_NEAR(0, magnitude(expected - vector3d{res[5], res[6], res[7]}), tolerance);
+}
+
+TEST(DualQuat, Compose)
+{
+    dual_quaternion_d a = make_dual_quaternion(make_rotation({0, 0, 1}, 0.5), vector3d{1, 2, 3});
+    dual_quaternion_d b = make_dual_quaternion(make_rotation({1, 1, 0}, -1.2), vector3d{-2, 0, 1});
+    vector3d          p{0.5, -1, 2};
+
+    // b is applied first
+    vector3d expected = transform_point(a, vector3d(transform_point(b, p)));
+    EXPECT_NEAR(0, magnitude(expected - vector3d(transform_point(a * b, p))), tolerance);
+
+    dual_quaternion_d ab = a * b;
+    EXPECT_NEAR(1, magnitude(ab.real()), tolerance);
+}
+
+TEST(DualQuat, Inverse)
+{
+    dual_quaternion_d q = make_dual_quaternion(make_rotation({1, -1, 2}, 2.1), vector3d{3, 2, 1});
+    dual_quaternion_d identity{1, 0, 0, 0, 0, 0, 0, 0};
+    EXPECT_NEAR(0, magnitude(identity - dual_quaternion_d(q * inverse(q))), tolerance);
+    EXPECT_NEAR(0, magnitude(identity - dual_quaternion_d(inverse(q) * q)), tolerance);
+
+    vector3d p{-1, 0.5, 4};
+    vector3d back = transform_point(inverse(q), vector3d(transform_point(q, p)));
+    EXPECT_NEAR(0, magnitude(p - back), tolerance);
+
+    // Not normalized
+    dual_quaternion_d s = q * 2.0;
+    EXPECT_NEAR(0, magnitude(identity - dual_quaternion_d(s * inverse(s))), tolerance);
+}
+
+TEST(DualQuat, Normalize)
+{
+    dual_quaternion_d q = make_dual_quaternion(make_rotation({0, 1, 0}, 0.3), vector3d{1, 2, 3});
+    // Scaled and with a dual part that is not orthogonal to the real part
+    dual_quaternion_d s{q[0] * 3, q[1] * 3, q[2] * 3, q[3] * 3, q[4] * 3 + q[0] * 0.1,
+                        q[5] * 3 + q[1] * 0.1, q[6] * 3 + q[2] * 0.1, q[7] * 3 + q[3] * 0.1};
+    dual_quaternion_d n = normalize(s);
+    EXPECT_NEAR(1, magnitude(n.real()), tolerance);
+    EXPECT_NEAR(0, dot_product(n.real(), n.dual()), tolerance);
+    EXPECT_NEAR(0, magnitude(q - n), tolerance) << n;
+}
+
+TEST(DualQuat, ScLERP)
+{
+    quaternion_d      ra = make_rotation({0, 0, 1}, 0.2);
+    quaternion_d      rb = make_rotation({0, 0, 1}, 1.8);
+    dual_quaternion_d a  = make_dual_quaternion(ra, vector3d{1, 0, 0});
+    dual_quaternion_d b  = make_dual_quaternion(rb, vector3d{1, 4, 2});
+
+    EXPECT_NEAR(0, transform_distance(a, sclerp(a, b, 0.0)), tolerance);
+    EXPECT_NEAR(0, transform_distance(b, sclerp(a, b, 1.0)), tolerance);
+    // The other sign of the end is the same transform
+    EXPECT_NEAR(0, transform_distance(b, sclerp(a, b * -1.0, 1.0)), tolerance);
+
+    for (double t = 0; t <= 1; t += 0.125) {
+        dual_quaternion_d q = sclerp(a, b, t);
+        EXPECT_NEAR(1, magnitude(q.real()), tolerance) << "Percent " << t;
+        EXPECT_NEAR(0, dot_product(q.real(), q.dual()), tolerance) << "Percent " << t;
+        // Rotation around Z interpolates the angle, the screw moves along Z
+        // with a constant speed
+        quaternion_d r = slerp(ra, rb, t);
+        EXPECT_NEAR(0, std::min<double>(magnitude(r - q.real()), magnitude(r + q.real())),
+                    1e-9)
+            << "Percent " << t;
+        EXPECT_NEAR(2 * t, vector3d(translation(q)).z(), 1e-9) << "Percent " << t;
+    }
+
+    // Translation only
+    dual_quaternion_d c = make_dual_quaternion(ra, vector3d{5, 6, 7});
+    dual_quaternion_d m = sclerp(a, c, 0.5);
+    EXPECT_NEAR(0, magnitude(vector3d{3, 3, 3.5} - vector3d(translation(m))), tolerance);
+}
+
+TEST(DualQuat, Blend)
+{
+    dual_quaternion_d a = make_dual_quaternion(make_rotation({0, 0, 1}, 0.4), vector3d{1, 0, 0});
+    dual_quaternion_d b = make_dual_quaternion(make_rotation({0, 0, 1}, 0.8), vector3d{3, 0, 0});
+    std::vector<dual_quaternion_d> qs{a, b * -1.0};
+    std::vector<double>            weights{0.5, 0.5};
+
+    dual_quaternion_d q = blend(qs.data(), weights.data(), qs.size());
+    EXPECT_NEAR(1, magnitude(q.real()), tolerance);
+    EXPECT_NEAR(0, dot_product(q.real(), q.dual()), tolerance);
+    // The same rotation axis, the angles are averaged
+    EXPECT_NEAR(0, magnitude(make_rotation({0, 0, 1}, 0.6) - q.real()), tolerance);
+
+    // A single transform is not changed
+    weights = {1, 0};
+    EXPECT_NEAR(0, magnitude(a - blend(qs.data(), weights.data(), qs.size())), tolerance);
+}
+
+TEST(DualQuat, Matrix)
+{
+    quaternion_d      r = make_rotation({1, 2, -1}, 1.1);
+    vector3d          t{4, -5, 6};
+    dual_quaternion_d q = make_dual_quaternion(r, t);
+
+    matrix4x4 m = convert<matrix4x4>(q);
+    vector3d  p{1, 2, 3};
+    vector3d  expected = transform_point(q, p);
+    vector<double, 4> h = as_vector(m * vector<double, 4>{p.x(), p.y(), p.z(), 1});
+    EXPECT_NEAR(0, magnitude(expected - vector3d{h[0], h[1], h[2]}), tolerance);
+    EXPECT_EQ(1, h[3]);
+
+    EXPECT_NEAR(0, transform_distance(q, convert<dual_quaternion_d>(m)), tolerance);
+}
+
+TEST(DualQuat, BulkTransform)
+{
+    dual_quaternion_d q = make_dual_quaternion(make_rotation({1, 0, 1}, 0.9), vector3d{1, 2, 3});
+    std::vector<vector3d> src{{1, 0, 0}, {0, 1, 0}, {0, 0, 1}, {1, 2, 3}, {-4, 5, 0.25}};
+    std::vector<vector3d> dst(src.size());
+
+    transform_point(q, src.data(), src.size(), dst.data());
+    for (std::size_t i = 0; i < src.size(); ++i) {
+        EXPECT_NEAR(0, magnitude(vector3d(transform_point(q, src[i])) - dst[i]), tolerance)
+            << "Index " << i;
+    }
+}
+
+TEST(DualQuat, Skin)
+{
+    std::vector<dual_quaternion_d> palette{
+        make_dual_quaternion(make_rotation({0, 0, 1}, 0.4), vector3d{1, 0, 0}),
+        make_dual_quaternion(make_rotation({0, 1, 0}, -0.8), vector3d{0, 3, 0}),
+        make_dual_quaternion(make_rotation({1, 0, 0}, 2.5), vector3d{0, 0, -2}) * -1.0};
+    // Two influences per vertex
+    std::vector<std::uint16_t> bones{0, 1, 2, 0, 1, 2, 2, 0};
+    std::vector<double>        weights{1, 0, 0.3, 0.7, 0.5, 0.5, 0.9, 0.1};
+    std::vector<vector3d>      positions{{1, 0, 0}, {0, 1, 0}, {0, 0, 1}, {1, 2, 3}};
+    std::vector<vector3d>      normals{{0, 0, 1}, {1, 0, 0}, {0, 1, 0}, {0, 0.6, 0.8}};
+    std::vector<vector3d>      dst(positions.size()), dst_normals(normals.size());
+
+    skin<2>(palette.data(), bones.data(), weights.data(), positions.data(), positions.size(),
+            dst.data());
+    for (std::size_t i = 0; i < positions.size(); ++i) {
+        std::vector<dual_quaternion_d> qs{palette[bones[i * 2]], palette[bones[i * 2 + 1]]};
+        dual_quaternion_d              q = blend(qs.data(), weights.data() + i * 2, 2);
+        EXPECT_NEAR(0, magnitude(vector3d(transform_point(q, positions[i])) - dst[i]), 1e-9)
+            << "Index " << i;
+    }
+    // The first vertex is affected by a single bone
+    EXPECT_NEAR(0, magnitude(vector3d(transform_point(palette[0], positions[0])) - dst[0]),
+                tolerance);
+
+    std::vector<vector3d> dst_positions(positions.size());
+    skin<2>(palette.data(), bones.data(), weights.data(), positions.data(), normals.data(),
+            positions.size(), dst_positions.data(), dst_normals.data());
+    for (std::size_t i = 0; i < positions.size(); ++i) {
+        EXPECT_EQ(dst[i], dst_positions[i]) << "Index " << i;
+        EXPECT_NEAR(1, magnitude(dst_normals[i]), tolerance) << "Index " << i;
+    }
+    EXPECT_NEAR(0, magnitude(vector3d(rotate(palette[0].real(), normals[0])) - dst_normals[0]),
+                tolerance);
+}
+
+}    // namespace test
+}    // namespace math
+}    // namespace psst
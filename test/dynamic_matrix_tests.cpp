@@ -0,0 +1,417 @@
+/**
+ * Copyright 2019 Sergei A. Fedorov
+ * dynamic_matrix_tests.cpp
+ *
+ *  Created on: Mar 4, 2019
+ *      Author: ser-fedorov
+ */
+
+#include "test_printing.hpp"
+#include <psst/math/dynamic_matrix.hpp>
+#include <psst/math/random.hpp>
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <random>
+#include <stdexcept>
+
+namespace psst {
+namespace math {
+namespace test {
+
+using dynamic_vectord = dynamic_vector<double>;
+using dynamic_vectorf = dynamic_vector<float>;
+using dynamic_matrixd = dynamic_matrix<double>;
+using dynamic_matrixf = dynamic_matrix<float>;
+
+using vector3d   = vector<double, 3>;
+using matrix3x3d = matrix<double, 3, 3>;
+using matrix2x3d = matrix<double, 2, 3>;
+
+namespace {
+
+std::uniform_real_distribution<double> const distribution{-1, 1};
+
+dynamic_matrixd
+random_matrix(std::size_t rows, std::size_t cols)
+{
+    return dynamic_matrixd(rows, cols, random_matrix_data<double>(distribution));
+}
+
+dynamic_vectord
+random_vector(std::size_t size)
+{
+    return dynamic_vectord(size, random_vector_data<double>(distribution));
+}
+
+dynamic_matrixd
+naive_multiply(dynamic_matrixd const& lhs, dynamic_matrixd const& rhs)
+{
+    dynamic_matrixd res(lhs.rows(), rhs.cols());
+    for (std::size_t r = 0; r < lhs.rows(); ++r) {
+        for (std::size_t c = 0; c < rhs.cols(); ++c) {
+            for (std::size_t k = 0; k < lhs.cols(); ++k) {
+                res[r][c] += lhs[r][k] * rhs[k][c];
+            }
+        }
+    }
+    return res;
+}
+
+::testing::AssertionResult
+near(dynamic_matrixd const& lhs, dynamic_matrixd const& rhs, double eps = 1e-9)
+{
+    if (lhs.rows() != rhs.rows() || lhs.cols() != rhs.cols())
+        return ::testing::AssertionFailure() << "Sizes don't match";
+    for (std::size_t r = 0; r < lhs.rows(); ++r) {
+        for (std::size_t c = 0; c < lhs.cols(); ++c) {
+            if (std::abs(lhs[r][c] - rhs[r][c]) > eps)
+                return ::testing::AssertionFailure()
+                       << "Values at (" << r << ", " << c << ") differ " << lhs[r][c]
+                       << " != " << rhs[r][c];
+        }
+    }
+    return ::testing::AssertionSuccess();
+}
+
+}    // namespace
+
+TEST(DynamicStorage, SmallBuffer)
+{
+    using storage_type = detail::dynamic_storage<float>;
+    storage_type small{4};
+    EXPECT_TRUE(small.is_inline());
+    EXPECT_EQ(storage_type::inline_capacity, small.capacity());
+
+    storage_type large{storage_type::inline_capacity + 1};
+    EXPECT_FALSE(large.is_inline());
+    EXPECT_EQ(0, reinterpret_cast<std::uintptr_t>(large.data()) % config::dynamic_alignment);
+
+    // Shrinking keeps the memory
+    auto const* p = large.data();
+    large.allocate(2);
+    EXPECT_EQ(p, large.data());
+    EXPECT_EQ(2, large.size());
+}
+
+TEST(DynamicStorage, CopyMove)
+{
+    using storage_type = detail::dynamic_storage<double>;
+    for (std::size_t size : {std::size_t{3}, std::size_t{100}}) {
+        storage_type s{size};
+        for (std::size_t i = 0; i < size; ++i) {
+            s.data()[i] = i;
+        }
+        storage_type c{s};
+        EXPECT_EQ(size, c.size());
+        EXPECT_NE(s.data(), c.data());
+        EXPECT_TRUE(std::equal(s.data(), s.data() + size, c.data()));
+
+        auto const*  p = c.data();
+        storage_type m{std::move(c)};
+        EXPECT_EQ(size, m.size());
+        EXPECT_EQ(0, c.size());
+        EXPECT_EQ(!m.is_inline(), p == m.data());
+        EXPECT_TRUE(std::equal(s.data(), s.data() + size, m.data()));
+
+        storage_type a;
+        a = m;
+        EXPECT_TRUE(std::equal(s.data(), s.data() + size, a.data()));
+        a = std::move(m);
+        EXPECT_EQ(size, a.size());
+        EXPECT_TRUE(std::equal(s.data(), s.data() + size, a.data()));
+    }
+}
+
+TEST(DynamicStorage, Resize)
+{
+    detail::dynamic_storage<int> s{3};
+    std::fill(s.data(), s.data() + 3, 7);
+    s.resize(100);
+    EXPECT_FALSE(s.is_inline());
+    EXPECT_EQ(7, s.data()[2]);
+    EXPECT_EQ(0, s.data()[3]);
+    EXPECT_EQ(0, s.data()[99]);
+}
+
+TEST(DynamicVector, Construct)
+{
+    dynamic_vectord v1;
+    EXPECT_TRUE(v1.empty());
+
+    dynamic_vectord v2(5, 2.0);
+    EXPECT_EQ(5, v2.size());
+    EXPECT_EQ(2.0, v2[4]);
+
+    dynamic_vectord v3{1, 2, 3};
+    EXPECT_EQ(3, v3.size());
+    EXPECT_EQ(3, v3[2]);
+
+    dynamic_vectord v4 = vector3d{1, 2, 3};
+    EXPECT_EQ(v3, v4);
+    EXPECT_EQ(v4, (vector3d{1, 2, 3}));
+
+    v4.resize(100);
+    EXPECT_EQ(100, v4.size());
+    EXPECT_EQ(3, v4[2]);
+    EXPECT_EQ(0, v4[99]);
+
+    auto v5 = random_vector(1000);
+    EXPECT_EQ(1000, v5.size());
+    EXPECT_NE(0, v5.magnitude_square());
+}
+
+TEST(DynamicVector, Expressions)
+{
+    dynamic_vectord a{1, 2, 3, 4};
+    dynamic_vectord b{4, 3, 2, 1};
+
+    EXPECT_EQ((dynamic_vectord{5, 5, 5, 5}), a + b);
+    EXPECT_EQ((dynamic_vectord{-3, -1, 1, 3}), a - b);
+    EXPECT_EQ((dynamic_vectord{-1, -2, -3, -4}), -a);
+    EXPECT_EQ((dynamic_vectord{2, 4, 6, 8}), a * 2);
+    EXPECT_EQ((dynamic_vectord{2, 4, 6, 8}), 2 * a);
+    EXPECT_EQ((dynamic_vectord{0.5, 1, 1.5, 2}), a / 2);
+    EXPECT_EQ((dynamic_vectord{10, 10, 10, 10}), (a + b) * 2 - (a - a));
+    EXPECT_EQ(20, dot_product(a, b));
+    EXPECT_EQ(30, a.dot(a));
+    EXPECT_EQ(30, magnitude_square(a));
+
+    dynamic_vectord c = a + b;
+    c += a;
+    EXPECT_EQ((dynamic_vectord{6, 7, 8, 9}), c);
+    c -= b * 2;
+    EXPECT_EQ((dynamic_vectord{-2, 1, 4, 7}), c);
+    c *= 2;
+    EXPECT_EQ((dynamic_vectord{-4, 2, 8, 14}), c);
+    c /= 2;
+    EXPECT_EQ((dynamic_vectord{-2, 1, 4, 7}), c);
+
+    // Mixed with fixed size vectors
+    dynamic_vectord d{1, 2, 3};
+    vector3d        e{1, 2, 3};
+    EXPECT_EQ((dynamic_vectord{2, 4, 6}), d + e);
+    EXPECT_EQ((dynamic_vectord{0, 0, 0}), e - d);
+    EXPECT_EQ(14, dot_product(d, e));
+
+    // Mixed value types
+    dynamic_vectorf f{1, 2, 3};
+    dynamic_vectord s = d + f;
+    EXPECT_EQ((dynamic_vectord{2, 4, 6}), s);
+
+    EXPECT_THROW(a + d, std::runtime_error);
+    EXPECT_THROW(a + vector3d{}, std::runtime_error);
+    EXPECT_THROW(dot_product(a, d), std::runtime_error);
+    EXPECT_THROW(c += d, std::runtime_error);
+}
+
+TEST(DynamicVector, Segment)
+{
+    dynamic_vectord v(10);
+    v.set_segment(3, vector3d{1, 2, 3} * 2);
+    EXPECT_EQ((vector3d{2, 4, 6}), v.segment<3>(3));
+    EXPECT_EQ(0, v[2]);
+    EXPECT_EQ(0, v[6]);
+}
+
+TEST(DynamicMatrix, Construct)
+{
+    dynamic_matrixd m1;
+    EXPECT_TRUE(m1.empty());
+
+    dynamic_matrixd m2(2, 3, 1.0);
+    EXPECT_EQ(2, m2.rows());
+    EXPECT_EQ(3, m2.cols());
+    EXPECT_EQ(1.0, m2[1][2]);
+
+    dynamic_matrixd m3{{1, 2, 3}, {4, 5, 6}};
+    EXPECT_EQ(2, m3.rows());
+    EXPECT_EQ(3, m3.cols());
+    EXPECT_EQ(6, m3.element(1, 2));
+    EXPECT_EQ((dynamic_vectord{4, 5, 6}), m3.row(1));
+    EXPECT_EQ((dynamic_vectord{3, 6}), m3.col(2));
+
+    dynamic_matrixd m4 = matrix2x3d{{1, 2, 3}, {4, 5, 6}};
+    EXPECT_EQ(m3, m4);
+    EXPECT_EQ(m4, (matrix2x3d{{1, 2, 3}, {4, 5, 6}}));
+
+    EXPECT_THROW((dynamic_matrixd{{1, 2, 3}, {4, 5}}), std::runtime_error);
+
+    auto id = dynamic_matrixd::identity(3);
+    EXPECT_EQ(id, matrix3x3d::identity());
+
+    m4.resize(3, 4);
+    EXPECT_EQ((dynamic_matrixd{{1, 2, 3, 0}, {4, 5, 6, 0}, {0, 0, 0, 0}}), m4);
+    m4.resize(2, 2);
+    EXPECT_EQ((dynamic_matrixd{{1, 2}, {4, 5}}), m4);
+}
+
+TEST(DynamicMatrix, Expressions)
+{
+    dynamic_matrixd a{{1, 2}, {3, 4}};
+    dynamic_matrixd b{{4, 3}, {2, 1}};
+
+    EXPECT_EQ((dynamic_matrixd{{5, 5}, {5, 5}}), a + b);
+    EXPECT_EQ((dynamic_matrixd{{-3, -1}, {1, 3}}), a - b);
+    EXPECT_EQ((dynamic_matrixd{{-1, -2}, {-3, -4}}), -a);
+    EXPECT_EQ((dynamic_matrixd{{2, 4}, {6, 8}}), a * 2);
+    EXPECT_EQ((dynamic_matrixd{{2, 4}, {6, 8}}), 2 * a);
+    EXPECT_EQ((dynamic_matrixd{{0.5, 1}, {1.5, 2}}), a / 2);
+    EXPECT_EQ((dynamic_matrixd{{8, 5}, {20, 13}}), a * b);
+    EXPECT_EQ((dynamic_matrixd{{1, 3}, {2, 4}}), transpose(a));
+    dynamic_vectord v{1, 2};
+    dynamic_matrixd e{{0, 1}, {2, 0}};
+    EXPECT_EQ((dynamic_vectord{5, 11}), a * v);
+    // Products nested into other expressions
+    EXPECT_EQ((dynamic_matrixd{{9, 7}, {20, 17}}), a * b + transpose(a) - e);
+    EXPECT_EQ((dynamic_matrixd{{23, 36}, {59, 92}}), a * b * a);
+    EXPECT_EQ((dynamic_vectord{10, 22}), (a * v) * 2);
+
+    dynamic_matrixd c = a;
+    c += b;
+    EXPECT_EQ((dynamic_matrixd{{5, 5}, {5, 5}}), c);
+    c -= a * b;
+    EXPECT_EQ((dynamic_matrixd{{-3, 0}, {-15, -8}}), c);
+    c *= 2;
+    EXPECT_EQ((dynamic_matrixd{{-6, 0}, {-30, -16}}), c);
+    c /= 2;
+    EXPECT_EQ((dynamic_matrixd{{-3, 0}, {-15, -8}}), c);
+
+    dynamic_matrixd d(3, 2);
+    EXPECT_THROW(a + d, std::runtime_error);
+    EXPECT_THROW(a * dynamic_matrixd(3, 3), std::runtime_error);
+    EXPECT_THROW(a * dynamic_vectord(3), std::runtime_error);
+    EXPECT_THROW(c += d, std::runtime_error);
+}
+
+TEST(DynamicMatrix, FixedSize)
+{
+    dynamic_matrixd a{{1, 2, 3}, {4, 5, 6}, {7, 8, 10}};
+    matrix3x3d      f{{1, 2, 3}, {4, 5, 6}, {7, 8, 10}};
+
+    EXPECT_EQ(f * f, a * f);
+    EXPECT_EQ(f * f, f * a);
+    EXPECT_EQ(f + f, a + f);
+    vector3d        v{1, 2, 3};
+    dynamic_vectord d{1, 2, 3};
+    dynamic_vectord fv{14, 32, 53};
+    EXPECT_EQ(fv, a * v);
+    EXPECT_EQ(fv, a * d);
+
+    dynamic_matrixd b(5, 5);
+    b.set_block(1, 2, f);
+    EXPECT_EQ(f, (b.block<3, 3>(1, 2)));
+    EXPECT_EQ(0, b[0][2]);
+    EXPECT_EQ(0, b[1][1]);
+    EXPECT_EQ(10, b[3][4]);
+}
+
+TEST(DynamicMatrix, Multiply)
+{
+    // Sizes around the block size and the four rows of the vector kernel
+    std::size_t const sizes[][3]
+        = {{1, 1, 1}, {3, 5, 7}, {17, 63, 9}, {64, 64, 64}, {70, 130, 65}, {129, 33, 200}};
+    for (auto const& sz : sizes) {
+        auto const a = random_matrix(sz[0], sz[1]);
+        auto const b = random_matrix(sz[1], sz[2]);
+
+        dynamic_matrixd c = a * b;
+        EXPECT_TRUE(near(naive_multiply(a, b), c)) << sz[0] << "x" << sz[1] << "x" << sz[2];
+
+        auto const      v = random_vector(sz[1]);
+        dynamic_vectord r = a * v;
+        dynamic_matrixd vm(sz[1], 1, v.data());
+        EXPECT_TRUE(near(naive_multiply(a, vm), dynamic_matrixd(sz[0], 1, r.data())));
+
+        dynamic_matrixd t = transpose(a);
+        EXPECT_EQ(a.cols(), t.rows());
+        EXPECT_EQ(a.rows(), t.cols());
+        EXPECT_EQ(a, transpose(t));
+        EXPECT_EQ(a.col(0), t.row(0));
+    }
+}
+
+TEST(DynamicMatrix, PackedMultiply)
+{
+    // Sizes around the register tile and the blocks of the packed kernel, the
+    // last one is large enough to be split between threads
+    std::size_t const sizes[][3] = {{32, 32, 32},  {33, 257, 35},  {97, 64, 1031},
+                                    {200, 40, 50}, {5, 300, 2000}, {64, 512, 9},
+                                    {400, 256, 1024}};
+    for (auto const& sz : sizes) {
+        auto const a = random_matrix(sz[0], sz[1]);
+        auto const b = random_matrix(sz[1], sz[2]);
+        auto const expected = naive_multiply(a, b);
+        for (std::size_t threads : {1, 3, 0}) {
+            dynamic_matrixd c;
+            multiply(a, b, c, threads);
+            EXPECT_TRUE(near(expected, c))
+                << sz[0] << "x" << sz[1] << "x" << sz[2] << " threads " << threads;
+        }
+        dynamic_matrixd c = a * b;
+        EXPECT_TRUE(near(expected, c)) << sz[0] << "x" << sz[1] << "x" << sz[2];
+    }
+
+    auto a = random_matrix(40, 50);
+    auto b = random_matrix(50, 3);
+    EXPECT_THROW(multiply(a, a, b), std::runtime_error);
+    EXPECT_THROW(multiply(a, b, b), std::runtime_error);
+    dynamic_matrixd c(7, 7);
+    multiply(a, b, c, 0);
+    EXPECT_TRUE(near(naive_multiply(a, b), c));
+}
+
+TEST(DynamicMatrix, Aliasing)
+{
+    auto       a    = random_matrix(70, 70);
+    auto const b    = random_matrix(70, 70);
+    auto const copy = a;
+    a               = a * b;
+    EXPECT_TRUE(near(naive_multiply(copy, b), a));
+
+    a = copy;
+    a = transpose(a);
+    EXPECT_EQ(copy, transpose(a));
+
+    auto c = random_matrix(40, 70);
+    c      = transpose(c);
+    EXPECT_EQ(70, c.rows());
+    EXPECT_EQ(40, c.cols());
+
+    a = copy;
+    a += a * b;
+    EXPECT_TRUE(near(copy + naive_multiply(copy, b), a));
+
+    auto v = random_vector(70);
+    auto w = v;
+    v      = copy * v;
+    EXPECT_EQ(dynamic_vectord(copy * w), v);
+
+    // Not referenced by the expression, evaluated into the existing storage
+    dynamic_matrixd d(70, 70);
+    auto const      storage = d.data();
+    d                       = copy * b;
+    EXPECT_EQ(storage, d.data());
+    EXPECT_TRUE(near(naive_multiply(copy, b), d));
+    d = transpose(copy);
+    EXPECT_EQ(storage, d.data());
+    EXPECT_EQ(copy, transpose(d));
+    d.noalias() = b * copy;
+    EXPECT_EQ(storage, d.data());
+    EXPECT_TRUE(near(naive_multiply(b, copy), d));
+    d.noalias() -= b * copy;
+    EXPECT_TRUE(near(dynamic_matrixd(70, 70), d));
+
+    auto const vector_storage = w.data();
+    w                         = copy * v;
+    EXPECT_EQ(vector_storage, w.data());
+    EXPECT_EQ(dynamic_vectord(copy * v), w);
+    w.noalias() = b * v;
+    EXPECT_EQ(vector_storage, w.data());
+    EXPECT_EQ(dynamic_vectord(b * v), w);
+}
+
+}    // namespace test
+}    // namespace math
+}    // namespace psst
@@ -0,0 +1,214 @@
+/**
+ * Copyright 2019 Sergei A. Fedorov
+ * frustum_tests.cpp
+ *
+ *  Created on: Feb 26, 2019
+ *      Author: ser-fedorov
+ */
+
+#include "test_printing.hpp"
+#include <psst/math/affine_transform.hpp>
+#include <psst/math/frustum.hpp>
+
+#include <gtest/gtest.h>
+
+#include <random>
+#include <vector>
+
+namespace psst {
+namespace math {
+namespace test {
+
+using frustumf = frustum<float>;
+using vector3f = vector<float, 3>;
+using matrix4f = matrix<float, 4, 4>;
+using box3f    = aabb<float, 3>;
+
+namespace {
+
+/**
+ * Perspective projection looking along -z with 90 degrees field of view
+ */
+matrix4f
+make_perspective(float z_near, float z_far, clip_depth depth)
+{
+    float const depth_range = z_far - z_near;
+    if (depth == clip_depth::negative_one_to_one) {
+        return {{1, 0, 0, 0},
+                {0, 1, 0, 0},
+                {0, 0, -(z_far + z_near) / depth_range, -2 * z_far * z_near / depth_range},
+                {0, 0, -1, 0}};
+    }
+    return {{1, 0, 0, 0},
+            {0, 1, 0, 0},
+            {0, 0, -z_far / depth_range, -z_far * z_near / depth_range},
+            {0, 0, -1, 0}};
+}
+
+struct spheres {
+    std::vector<vector3f> centers;
+    std::vector<float>    radii;
+    std::vector<float>    x, y, z;
+};
+
+spheres
+make_spheres(std::size_t count, std::mt19937& gen)
+{
+    std::uniform_real_distribution<float> pos(-120, 120);
+    std::uniform_real_distribution<float> radius(0, 10);
+    spheres                               res;
+    for (std::size_t i = 0; i < count; ++i) {
+        res.centers.push_back(vector3f{pos(gen), pos(gen), pos(gen)});
+        res.radii.push_back(radius(gen));
+        res.x.push_back(res.centers.back()[0]);
+        res.y.push_back(res.centers.back()[1]);
+        res.z.push_back(res.centers.back()[2]);
+    }
+    return res;
+}
+
+std::vector<box3f>
+make_boxes(std::size_t count, std::mt19937& gen)
+{
+    std::uniform_real_distribution<float> pos(-120, 120);
+    std::uniform_real_distribution<float> size(0, 10);
+    std::vector<box3f>                    res;
+    for (std::size_t i = 0; i < count; ++i) {
+        vector3f min{pos(gen), pos(gen), pos(gen)};
+        res.push_back(box3f{min, min + vector3f{size(gen), size(gen), size(gen)}});
+    }
+    res[count / 2] = box3f{};
+    return res;
+}
+
+bool
+mask_bit(std::vector<std::uint64_t> const& mask, std::size_t i)
+{
+    return (mask[i / 64] >> (i % 64)) & 1;
+}
+
+}    // namespace
+
+TEST(Frustum, Extract)
+{
+    for (auto depth : {clip_depth::negative_one_to_one, clip_depth::zero_to_one}) {
+        frustumf f = make_frustum(make_perspective(1, 100, depth), depth);
+        EXPECT_NEAR(1, magnitude(vector3f(f.plane(frustumf::left).xyz())), 1e-6);
+        EXPECT_TRUE(contains(f, vector3f{0, 0, -2}));
+        EXPECT_TRUE(contains(f, vector3f{1.9, -1.9, -2}));
+        EXPECT_FALSE(contains(f, vector3f{2.1, 0, -2}));
+        EXPECT_FALSE(contains(f, vector3f{0, 0, -0.5}));
+        EXPECT_FALSE(contains(f, vector3f{0, 0, -101}));
+        EXPECT_FALSE(contains(f, vector3f{0, 0, 2}));
+        // The near and far planes
+        EXPECT_NEAR(-1, f.plane(frustumf::near_plane)[3], 1e-4);
+        EXPECT_NEAR(100, f.plane(frustumf::far_plane)[3], 1e-3);
+    }
+
+    // View-projection moves the planes to the world space
+    auto view = convert<matrix4f>(
+        make_affine_transform(quaternion<float>{1, 0, 0, 0}, vector3f{-10, 0, 0}));
+    frustumf f = make_frustum(matrix4f(make_perspective(1, 100, clip_depth::zero_to_one) * view),
+                              clip_depth::zero_to_one);
+    EXPECT_TRUE(contains(f, vector3f{10, 0, -2}));
+    EXPECT_FALSE(contains(f, vector3f{0, 0, -2}));
+}
+
+TEST(Frustum, Objects)
+{
+    frustumf f = make_frustum(make_perspective(1, 100, clip_depth::negative_one_to_one));
+    EXPECT_TRUE(intersects(f, vector3f{0, 0, -10}, 1.0f));
+    EXPECT_TRUE(intersects(f, vector3f{0, 0, 1}, 2.5f));
+    EXPECT_FALSE(intersects(f, vector3f{0, 0, 1}, 1.5f));
+    EXPECT_FALSE(intersects(f, vector3f{20, 0, -10}, 5.0f));
+
+    EXPECT_TRUE(intersects(f, box3f{{-1, -1, -3}, {1, 1, -2}}));
+    EXPECT_TRUE(intersects(f, box3f{{-100, -100, -50}, {100, 100, 50}}));
+    EXPECT_FALSE(intersects(f, box3f{{5, -1, -3}, {6, 1, -2}}));
+    EXPECT_FALSE(intersects(f, box3f{}));
+}
+
+TEST(Frustum, CullSpheres)
+{
+    std::mt19937 gen{11};
+    frustumf     f = make_frustum(make_perspective(1, 100, clip_depth::negative_one_to_one));
+    // Not a multiple of the block size
+    auto const                 s = make_spheres(1000, gen);
+    std::vector<std::uint64_t> mask((s.radii.size() + 63) / 64);
+    std::vector<std::uint64_t> soa_mask(mask.size());
+    std::vector<std::uint32_t> indices(s.radii.size());
+
+    auto visible = cull_spheres(f, s.centers.data(), s.radii.data(), s.radii.size(), mask.data());
+    EXPECT_EQ(visible, cull_spheres(f, s.x.data(), s.y.data(), s.z.data(), s.radii.data(),
+                                    s.radii.size(), soa_mask.data()));
+    EXPECT_EQ(mask, soa_mask);
+    EXPECT_EQ(visible, visible_spheres(f, s.centers.data(), s.radii.data(), s.radii.size(),
+                                       indices.data()));
+
+    std::size_t expected = 0;
+    for (std::size_t i = 0; i < s.radii.size(); ++i) {
+        bool const v = intersects(f, s.centers[i], s.radii[i]);
+        ASSERT_EQ(v, mask_bit(mask, i)) << "Sphere " << i;
+        if (v) {
+            ASSERT_EQ(i, indices[expected]) << "Sphere " << i;
+            ++expected;
+        }
+    }
+    EXPECT_EQ(expected, visible);
+    EXPECT_LT(0u, visible);
+    EXPECT_GT(s.radii.size(), visible);
+    EXPECT_EQ(0u, mask.back() >> (s.radii.size() % 64));
+    EXPECT_EQ(visible, visible_spheres(f, s.x.data(), s.y.data(), s.z.data(), s.radii.data(),
+                                       s.radii.size(), indices.data()));
+}
+
+TEST(Frustum, CullBoxes)
+{
+    std::mt19937 gen{17};
+    frustumf     f     = make_frustum(make_perspective(1, 100, clip_depth::zero_to_one),
+                                  clip_depth::zero_to_one);
+    auto const   boxes = make_boxes(777, gen);
+
+    std::vector<std::uint64_t> mask((boxes.size() + 63) / 64);
+    std::vector<std::size_t>   indices(boxes.size());
+
+    auto visible = cull_boxes(f, boxes.data(), boxes.size(), mask.data());
+    EXPECT_EQ(visible, visible_boxes(f, boxes.data(), boxes.size(), indices.data()));
+
+    std::size_t expected = 0;
+    for (std::size_t i = 0; i < boxes.size(); ++i) {
+        bool const v = intersects(f, boxes[i]);
+        ASSERT_EQ(v, mask_bit(mask, i)) << "Box " << i;
+        if (v) {
+            ASSERT_EQ(i, indices[expected]) << "Box " << i;
+            ++expected;
+        }
+    }
+    EXPECT_EQ(expected, visible);
+    EXPECT_LT(0u, visible);
+}
+
+TEST(Frustum, ParallelCull)
+{
+    std::mt19937 gen{23};
+    frustumf     f = make_frustum(make_perspective(1, 100, clip_depth::negative_one_to_one));
+    auto const   s = make_spheres(config::parallel_min_items * 4 + 5, gen);
+    std::vector<std::uint64_t> mask((s.radii.size() + 63) / 64);
+    std::vector<std::uint64_t> parallel_mask(mask.size());
+
+    auto visible = cull_spheres(f, s.centers.data(), s.radii.data(), s.radii.size(), mask.data());
+    EXPECT_EQ(visible, cull_spheres(f, s.centers.data(), s.radii.data(), s.radii.size(),
+                                    parallel_mask.data(), 4));
+    EXPECT_EQ(mask, parallel_mask);
+
+    auto const                 boxes = make_boxes(config::parallel_min_items * 3, gen);
+    std::vector<std::uint64_t> box_mask((boxes.size() + 63) / 64);
+    std::vector<std::uint64_t> parallel_box_mask(box_mask.size());
+    EXPECT_EQ(cull_boxes(f, boxes.data(), boxes.size(), box_mask.data()),
+              cull_boxes(f, boxes.data(), boxes.size(), parallel_box_mask.data(), 0));
+    EXPECT_EQ(box_mask, parallel_box_mask);
+}
+
+}    // namespace test
+}    // namespace math
+}    // namespace psst
@@ -0,0 +1,269 @@
+/**
+ * Copyright 2019 Sergei A. Fedorov
+ * kd_tree_tests.cpp
+ *
+ *  Created on: Mar 1, 2019
+ *      Author: ser-fedorov
+ */
+
+#include "test_printing.hpp"
+#include <psst/math/kd_tree.hpp>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+namespace psst {
+namespace math {
+namespace test {
+
+using vector3f = vector<float, 3>;
+using box3f    = aabb<float, 3>;
+using points3f = memory_vector_view<float const*, 3>;
+using tree3f   = kd_tree<points3f>;
+
+namespace {
+
+std::vector<float>
+make_points(std::size_t count, std::mt19937& gen)
+{
+    std::uniform_real_distribution<float> pos(-10, 10);
+    std::vector<float>                    res(count * 3);
+    for (auto& v : res) {
+        v = pos(gen);
+    }
+    return res;
+}
+
+/**
+ * Distances of the k nearest points found by brute force
+ */
+std::vector<float>
+nearest_distances(points3f const& points, vector3f const& q, std::size_t k)
+{
+    std::vector<float> res;
+    for (std::size_t i = 0; i < points.size(); ++i) {
+        res.push_back(distance_square(q, points[i]));
+    }
+    std::sort(res.begin(), res.end());
+    res.resize(std::min(k, res.size()));
+    return res;
+}
+
+std::vector<std::uint32_t>
+within_radius(points3f const& points, vector3f const& q, float radius)
+{
+    std::vector<std::uint32_t> res;
+    for (std::size_t i = 0; i < points.size(); ++i) {
+        if (distance_square(q, points[i]) <= radius * radius)
+            res.push_back(i);
+    }
+    return res;
+}
+
+/**
+ * Every point is referenced once, the points of a leaf are in the cell of
+ * the leaf
+ */
+void
+check_tree(tree3f const& tree)
+{
+    auto const&                nodes = tree.nodes();
+    std::vector<std::uint32_t> refs(tree.points().size());
+    struct cell {
+        std::uint32_t node;
+        box3f         bounds;
+    };
+    float const       inf = std::numeric_limits<float>::max();
+    std::vector<cell> stack{{0, box3f{vector3f(-inf), vector3f(inf)}}};
+    while (!stack.empty()) {
+        auto const c = stack.back();
+        stack.pop_back();
+        auto const& n = nodes[c.node];
+        if (n.leaf()) {
+            ASSERT_GE(config::kd_tree_max_leaf_size, n.count);
+            for (auto i = n.first; i < n.first + n.count; ++i) {
+                auto const p = tree.indices()[i];
+                ++refs[p];
+                ASSERT_TRUE(contains(c.bounds, vector3f(tree.points()[p]))) << "Node " << c.node;
+            }
+        } else {
+            ASSERT_LT(c.node, n.first);
+            ASSERT_GT(nodes.size(), n.first);
+            auto lmax    = c.bounds.max();
+            auto rmin    = c.bounds.min();
+            lmax[n.axis] = n.split;
+            rmin[n.axis] = n.split;
+            stack.push_back({c.node + 1, box3f{c.bounds.min(), lmax}});
+            stack.push_back({n.first, box3f{rmin, c.bounds.max()}});
+        }
+    }
+    for (std::size_t i = 0; i < refs.size(); ++i) {
+        ASSERT_EQ(1u, refs[i]) << "Point " << i;
+    }
+}
+
+std::size_t
+recursive_node_count(std::size_t count)
+{
+    if (count <= config::kd_tree_max_leaf_size)
+        return 1;
+    return 1 + recursive_node_count(count / 2) + recursive_node_count(count - count / 2);
+}
+
+}    // namespace
+
+TEST(KdTree, NodeCount)
+{
+    for (std::size_t count = 0; count < 5000; ++count) {
+        EXPECT_EQ(recursive_node_count(count), detail::kd_tree_node_count(count)) << count;
+    }
+    for (std::size_t count : {65536, 100003, 1 << 20}) {
+        EXPECT_EQ(recursive_node_count(count), detail::kd_tree_node_count(count)) << count;
+    }
+}
+
+TEST(KdTree, Empty)
+{
+    auto const tree = make_kd_tree(points3f{nullptr, 0});
+    EXPECT_TRUE(tree.empty());
+    tree3f::neighbour res;
+    EXPECT_FALSE(tree.nearest(vector3f{0, 0, 0}, res));
+    std::vector<tree3f::neighbour> found;
+    tree.within_radius(vector3f{0, 0, 0}, 100, found);
+    EXPECT_TRUE(found.empty());
+}
+
+TEST(KdTree, Build)
+{
+    std::mt19937 gen{23};
+    auto const   buffer = make_points(1000, gen);
+    points3f     points{buffer.data(), buffer.size()};
+    check_tree(tree3f{points});
+    check_tree(tree3f{points3f{buffer.data(), 3}});
+
+    // Duplicate points
+    std::vector<float> const same(300, 1.0f);
+    check_tree(tree3f{points3f{same.data(), same.size()}});
+}
+
+TEST(KdTree, Nearest)
+{
+    std::mt19937 gen{29};
+    auto const   buffer = make_points(2000, gen);
+    points3f     points{buffer.data(), buffer.size()};
+    auto const   tree = make_kd_tree(points);
+
+    std::uniform_real_distribution<float> pos(-12, 12);
+    for (std::size_t q = 0; q < 100; ++q) {
+        vector3f const query{pos(gen), pos(gen), pos(gen)};
+        for (std::size_t k : {1, 5, 16}) {
+            std::vector<tree3f::neighbour> res(k);
+            ASSERT_EQ(k, tree.nearest(query, k, res.data()));
+            auto const expected = nearest_distances(points, query, k);
+            for (std::size_t i = 0; i < k; ++i) {
+                EXPECT_EQ(expected[i], res[i].distance_square);
+                EXPECT_EQ(expected[i], float(distance_square(query, points[res[i].index])));
+            }
+        }
+        // The maximal distance limits the neighbours
+        auto const                     expected = nearest_distances(points, query, 8);
+        std::vector<tree3f::neighbour> res(8);
+        EXPECT_EQ(4u, tree.nearest(query, 8, res.data(), expected[4]));
+    }
+
+    // More neighbours than points
+    std::vector<tree3f::neighbour> res(10);
+    EXPECT_EQ(3u, make_kd_tree(points3f{buffer.data(), 9}).nearest(vector3f{}, 10, res.data()));
+}
+
+TEST(KdTree, Radius)
+{
+    std::mt19937 gen{31};
+    auto const   buffer = make_points(2000, gen);
+    points3f     points{buffer.data(), buffer.size()};
+    auto const   tree = make_kd_tree(points);
+
+    std::uniform_real_distribution<float> pos(-12, 12);
+    for (std::size_t q = 0; q < 100; ++q) {
+        vector3f const                 query{pos(gen), pos(gen), pos(gen)};
+        std::vector<tree3f::neighbour> found;
+        tree.within_radius(query, 2.5, found);
+        std::vector<std::uint32_t> res;
+        for (auto const& n : found) {
+            res.push_back(n.index);
+        }
+        std::sort(res.begin(), res.end());
+        EXPECT_EQ(within_radius(points, query, 2.5), res);
+    }
+}
+
+TEST(KdTree, Query)
+{
+    std::mt19937 gen{37};
+    auto const   buffer = make_points(2000, gen);
+    points3f     points{buffer.data(), buffer.size()};
+    auto const   tree = make_kd_tree(points);
+
+    std::uniform_real_distribution<float> pos(-12, 12);
+    for (std::size_t q = 0; q < 50; ++q) {
+        vector3f const             min{pos(gen), pos(gen), pos(gen)};
+        box3f const                box{min, min + vector3f(4)};
+        std::vector<std::uint32_t> expected;
+        for (std::size_t i = 0; i < points.size(); ++i) {
+            if (contains(box, vector3f(points[i])))
+                expected.push_back(i);
+        }
+        std::vector<std::uint32_t> res;
+        tree.query(box, [&res](std::uint32_t i) { res.push_back(i); });
+        std::sort(res.begin(), res.end());
+        EXPECT_EQ(expected, res);
+    }
+}
+
+TEST(KdTree, Batch)
+{
+    std::mt19937 gen{41};
+    auto const   buffer = make_points(config::parallel_min_items * 2 + 13, gen);
+    points3f     points{buffer.data(), buffer.size()};
+    tree3f const tree{points, 4};
+    check_tree(tree);
+
+    auto const                     query_buffer = make_points(1000, gen);
+    points3f                       queries{query_buffer.data(), query_buffer.size()};
+    std::size_t const              k = 4;
+    std::vector<tree3f::neighbour> res(queries.size() * k);
+    tree.nearest(queries, k, res.data(), 4);
+    std::vector<std::size_t>       offsets;
+    std::vector<tree3f::neighbour> found;
+    tree.within_radius(queries, 0.5, offsets, found, 4);
+    ASSERT_EQ(queries.size() + 1, offsets.size());
+    ASSERT_EQ(found.size(), offsets.back());
+
+    // Brute force checks of a part of the queries
+    for (std::size_t i = 0; i < queries.size(); i += 50) {
+        vector3f const query    = queries[i];
+        auto const     expected = nearest_distances(points, query, k);
+        for (std::size_t j = 0; j < k; ++j) {
+            EXPECT_EQ(expected[j], res[i * k + j].distance_square) << "Query " << i;
+        }
+        std::vector<std::uint32_t> in_radius;
+        for (auto j = offsets[i]; j < offsets[i + 1]; ++j) {
+            in_radius.push_back(found[j].index);
+        }
+        std::sort(in_radius.begin(), in_radius.end());
+        EXPECT_EQ(within_radius(points, query, 0.5), in_radius) << "Query " << i;
+    }
+
+    // Missing neighbours
+    tree3f const small{points3f{buffer.data(), 6}};
+    small.nearest(queries, k, res.data());
+    EXPECT_EQ(tree3f::npos, res[2].index);
+    EXPECT_EQ(tree3f::npos, res[3].index);
+}
+
+}    // namespace test
+}    // namespace math
+}    // namespace psst
@@ -0,0 +1,180 @@
+/**
+ * Copyright 2019 Sergei A. Fedorov
+ * matrix3_decomposition_tests.cpp
+ *
+ *  Created on: Mar 8, 2019
+ *      Author: ser-fedorov
+ */
+
+#include "test_printing.hpp"
+#include "test_utils.hpp"
+#include <psst/math/matrix3_decomposition.hpp>
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+namespace psst {
+namespace math {
+namespace test {
+
+namespace {
+
+template <typename T>
+std::vector<matrix<T, 3, 3>>
+make_matrices(std::size_t count, unsigned seed)
+{
+    std::mt19937                      gen{seed};
+    std::uniform_real_distribution<T> dist{-2, 2};
+    std::vector<matrix<T, 3, 3>>      res(count);
+    for (auto& m : res) {
+        std::generate(m.begin(), m.end(), [&]() { return dist(gen); });
+    }
+    return res;
+}
+
+template <typename T>
+matrix<T, 3, 3>
+make_symmetric(matrix<T, 3, 3> const& m)
+{
+    return (m + transpose(m)) / 2;
+}
+
+template <typename T>
+matrix<T, 3, 3>
+diagonal(vector<T, 3> const& v)
+{
+    matrix<T, 3, 3> res{};
+    for (std::size_t i = 0; i < 3; ++i) {
+        res[i][i] = v[i];
+    }
+    return res;
+}
+
+template <typename T>
+::testing::AssertionResult
+is_rotation(matrix<T, 3, 3> const& m, T eps)
+{
+    matrix<T, 3, 3> const mmt = m * transpose(m);
+    if (!near(matrix<T, 3, 3>::identity(), mmt, eps))
+        return ::testing::AssertionFailure() << m << " is not orthogonal";
+    if (std::abs(det(m) - 1) > eps)
+        return ::testing::AssertionFailure() << m << " determinant is " << det(m);
+    return ::testing::AssertionSuccess();
+}
+
+template <typename T>
+::testing::AssertionResult
+check_eigen(matrix<T, 3, 3> const& a, symmetric_eigen3<T> const& e, T eps)
+{
+    if (auto res = is_rotation(e.vectors, eps); !res)
+        return res;
+    if (e.values[0] < e.values[1] || e.values[1] < e.values[2])
+        return ::testing::AssertionFailure() << "Eigenvalues are not sorted " << e.values;
+    matrix<T, 3, 3> const vdv = e.vectors * diagonal(e.values) * transpose(e.vectors);
+    return near(a, vdv, eps);
+}
+
+template <typename T>
+::testing::AssertionResult
+check_svd(matrix<T, 3, 3> const& a, svd3<T> const& d, T eps)
+{
+    if (auto res = is_rotation(d.u, eps); !res)
+        return res;
+    if (auto res = is_rotation(d.v, eps); !res)
+        return res;
+    if (std::abs(d.s[0]) + eps < std::abs(d.s[1]) || std::abs(d.s[1]) + eps < std::abs(d.s[2]))
+        return ::testing::AssertionFailure() << "Singular values are not sorted " << d.s;
+    matrix<T, 3, 3> const usv = d.u * diagonal(d.s) * transpose(d.v);
+    return near(a, usv, eps);
+}
+
+}    // namespace
+
+template <typename T>
+class Matrix3Decomposition : public ::testing::Test {};
+
+using matrix3_value_types = ::testing::Types<float, double>;
+TYPED_TEST_SUITE(Matrix3Decomposition, matrix3_value_types, );
+
+TYPED_TEST(Matrix3Decomposition, SymmetricEigen)
+{
+    using value_type     = TypeParam;
+    using matrix_type    = matrix<value_type, 3, 3>;
+    value_type const eps = std::is_same_v<value_type, float> ? 1e-4 : 1e-10;
+
+    for (auto const& m : make_matrices<value_type>(100, 1)) {
+        matrix_type const a = make_symmetric(m);
+        EXPECT_TRUE(check_eigen(a, symmetric_eigen(a), eps)) << a;
+    }
+
+    // Degenerate eigenvalues
+    matrix_type const id = matrix_type::identity();
+    EXPECT_TRUE(check_eigen(id, symmetric_eigen(id), eps));
+    matrix_type const zero{};
+    EXPECT_TRUE(check_eigen(zero, symmetric_eigen(zero), eps));
+    matrix_type const diag{{1, 0, 0}, {0, 3, 0}, {0, 0, 2}};
+    auto const        e = symmetric_eigen(diag);
+    EXPECT_TRUE(check_eigen(diag, e, eps));
+    EXPECT_NEAR(3, e.values[0], eps);
+    EXPECT_NEAR(2, e.values[1], eps);
+    EXPECT_NEAR(1, e.values[2], eps);
+    matrix_type const twice{{2, 1, 1}, {1, 2, 1}, {1, 1, 2}};
+    EXPECT_TRUE(check_eigen(twice, symmetric_eigen(twice), eps));
+}
+
+TYPED_TEST(Matrix3Decomposition, SVD)
+{
+    using value_type     = TypeParam;
+    using matrix_type    = matrix<value_type, 3, 3>;
+    value_type const eps = std::is_same_v<value_type, float> ? 1e-3 : 1e-9;
+
+    for (auto const& a : make_matrices<value_type>(100, 2)) {
+        auto const d = svd(a);
+        EXPECT_TRUE(check_svd(a, d, eps)) << a;
+        // The sign of the determinant is in the last singular value
+        EXPECT_EQ(det(a) < 0, d.s[2] < 0) << a;
+        EXPECT_GE(d.s[1], 0);
+    }
+
+    // Rank deficient
+    matrix_type const zero{};
+    EXPECT_TRUE(check_svd(zero, svd(zero), eps));
+    matrix_type const rank1{{1, 2, 3}, {2, 4, 6}, {-1, -2, -3}};
+    auto const        d = svd(rank1);
+    EXPECT_TRUE(check_svd(rank1, d, eps));
+    EXPECT_NEAR(0, d.s[1], eps);
+    EXPECT_NEAR(0, d.s[2], eps);
+    matrix_type const reflect{{-1, 0, 0}, {0, 1, 0}, {0, 0, 1}};
+    EXPECT_TRUE(check_svd(reflect, svd(reflect), eps));
+}
+
+TYPED_TEST(Matrix3Decomposition, Batch)
+{
+    using value_type        = TypeParam;
+    value_type const  eps   = std::is_same_v<value_type, float> ? 1e-3 : 1e-9;
+    std::size_t const count = config::batch_lanes * 4 + 3;
+    auto const        src   = make_matrices<value_type>(count, 3);
+
+    std::vector<matrix<value_type, 3, 3>> sym(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        sym[i] = make_symmetric(src[i]);
+    }
+
+    for (std::size_t threads : {1, 3}) {
+        std::vector<symmetric_eigen3<value_type>> eigen(count);
+        std::vector<svd3<value_type>>             decomposed(count);
+        symmetric_eigen(sym.data(), count, eigen.data(), threads);
+        svd(src.data(), count, decomposed.data(), threads);
+        for (std::size_t i = 0; i < count; ++i) {
+            EXPECT_TRUE(check_eigen(sym[i], eigen[i], eps)) << "Matrix " << i;
+            EXPECT_TRUE(check_svd(src[i], decomposed[i], eps)) << "Matrix " << i;
+        }
+    }
+}
+
+}    // namespace test
+}    // namespace math
+}    // namespace psst
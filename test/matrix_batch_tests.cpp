@@ -0,0 +1,179 @@
+/**
+ * Copyright 2019 Sergei A. Fedorov
+ * matrix_batch_tests.cpp
+ *
+ *  Created on: Mar 6, 2019
+ *      Author: ser-fedorov
+ */
+
+#include "test_printing.hpp"
+#include "test_utils.hpp"
+#include <psst/math/matrix_batch.hpp>
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+namespace psst {
+namespace math {
+namespace test {
+
+namespace {
+
+template <typename Matrix>
+std::vector<Matrix>
+make_matrices(std::size_t count, unsigned seed)
+{
+    using value_type = typename Matrix::value_type;
+    std::mt19937                               gen{seed};
+    std::uniform_real_distribution<value_type> dist{-1, 1};
+    std::vector<Matrix>                        res(count);
+    for (auto& m : res) {
+        std::generate(m.begin(), m.end(), [&]() { return dist(gen); });
+        // Diagonally dominant, far from singular
+        for (std::size_t i = 0; i < Matrix::rows; ++i) {
+            m[i][i] += Matrix::rows;
+        }
+    }
+    return res;
+}
+
+}    // namespace
+
+template <typename Matrix>
+class MatrixBatch : public ::testing::Test {};
+
+using batch_matrix_types = ::testing::Types<matrix<float, 2, 2>, matrix<float, 3, 3>,
+                                            matrix<double, 3, 3>, matrix<float, 4, 4>,
+                                            matrix<double, 4, 4>>;
+TYPED_TEST_SUITE(MatrixBatch, batch_matrix_types, );
+
+TYPED_TEST(MatrixBatch, Multiply)
+{
+    using matrix_type = TypeParam;
+    // A count that is not a multiple of the packet size
+    std::size_t const count = config::batch_lanes * 5 + 3;
+    auto const        lhs   = make_matrices<matrix_type>(count, 1);
+    auto const        rhs   = make_matrices<matrix_type>(count, 2);
+
+    for (std::size_t threads : {1, 3}) {
+        std::vector<matrix_type> res(count);
+        multiply(lhs.data(), rhs.data(), count, res.data(), threads);
+        for (std::size_t i = 0; i < count; ++i) {
+            matrix_type const expected = lhs[i] * rhs[i];
+            EXPECT_TRUE(near(expected, res[i], 1e-5)) << "Matrix " << i;
+        }
+    }
+
+    // In place
+    auto res = lhs;
+    multiply(res.data(), rhs.data(), count, res.data());
+    for (std::size_t i = 0; i < count; ++i) {
+        matrix_type const expected = lhs[i] * rhs[i];
+        EXPECT_TRUE(near(expected, res[i], 1e-5)) << "Matrix " << i;
+    }
+}
+
+TYPED_TEST(MatrixBatch, Inverse)
+{
+    using matrix_type       = TypeParam;
+    std::size_t const count = config::batch_lanes * 3 + 5;
+    auto const        src   = make_matrices<matrix_type>(count, 3);
+
+    for (std::size_t threads : {1, 3}) {
+        std::vector<matrix_type> res(count);
+        EXPECT_EQ(0, inverse(src.data(), count, res.data(), threads));
+        for (std::size_t i = 0; i < count; ++i) {
+            matrix_type const id = src[i] * res[i];
+            EXPECT_TRUE(near(matrix_type::identity(), id, 1e-5)) << "Matrix " << i;
+        }
+    }
+
+    // Singular matrices are set to zero
+    auto singular = src;
+    singular[1]   = matrix_type{};
+    for (auto& v : singular[count - 1][0]) {
+        v = 0;
+    }
+    auto res = singular;
+    EXPECT_EQ(2, inverse(res.data(), count, res.data()));
+    EXPECT_EQ(matrix_type{}, res[1]);
+    EXPECT_EQ(matrix_type{}, res[count - 1]);
+    matrix_type const id = singular[0] * res[0];
+    EXPECT_TRUE(near(matrix_type::identity(), id, 1e-5));
+}
+
+TYPED_TEST(MatrixBatch, Solve)
+{
+    using matrix_type       = TypeParam;
+    using value_type        = typename matrix_type::value_type;
+    using vector_type       = vector<value_type, matrix_type::rows>;
+    std::size_t const count = config::batch_lanes * 4 + 1;
+    auto const        a     = make_matrices<matrix_type>(count, 4);
+
+    std::vector<vector_type> b(count), x(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        for (std::size_t r = 0; r < vector_type::size; ++r) {
+            b[i][r] = static_cast<value_type>(i % 5) - static_cast<value_type>(r);
+        }
+    }
+    EXPECT_EQ(0, solve(a.data(), b.data(), count, x.data(), 2));
+    for (std::size_t i = 0; i < count; ++i) {
+        matrix<value_type, vector_type::size, 1> const ax = a[i] * x[i];
+        for (std::size_t r = 0; r < vector_type::size; ++r) {
+            EXPECT_NEAR(b[i][r], ax[r][0], 1e-4) << "System " << i;
+        }
+    }
+}
+
+TYPED_TEST(MatrixBatch, Packets)
+{
+    using matrix_type         = TypeParam;
+    using value_type          = typename matrix_type::value_type;
+    constexpr std::size_t N   = matrix_type::rows;
+    constexpr std::size_t L   = config::batch_lanes;
+    using packet_type         = matrix_packet<value_type, N, L>;
+    std::size_t const packets = 5;
+    auto const        lhs     = make_matrices<matrix_type>(packets * L, 6);
+    auto const        rhs     = make_matrices<matrix_type>(packets * L, 7);
+
+    std::vector<packet_type> a(packets), b(packets), res(packets);
+    for (std::size_t p = 0; p < packets; ++p) {
+        a[p].load(lhs.data() + p * L, L);
+        b[p].load(rhs.data() + p * L, L);
+    }
+    multiply(a.data(), b.data(), packets, res.data(), 2);
+    EXPECT_EQ(0, inverse(res.data(), packets, res.data(), 2));
+
+    std::vector<matrix_type> out(packets * L);
+    for (std::size_t p = 0; p < packets; ++p) {
+        res[p].store(out.data() + p * L, L);
+    }
+    for (std::size_t i = 0; i < out.size(); ++i) {
+        matrix_type const id = lhs[i] * rhs[i] * out[i];
+        EXPECT_TRUE(near(matrix_type::identity(), id, 1e-4)) << "Matrix " << i;
+    }
+}
+
+TEST(MatrixPacket, LoadStore)
+{
+    using matrix_type = matrix<float, 3, 3>;
+    auto const src    = make_matrices<matrix_type>(3, 5);
+
+    matrix_packet<float, 3, 4> packet;
+    packet.load(src.data(), 3);
+    EXPECT_EQ(src[1][2][0], packet.element(2, 0)[1]);
+    // The lanes past the count are identity
+    EXPECT_EQ(1, packet.element(1, 1)[3]);
+    EXPECT_EQ(0, packet.element(1, 2)[3]);
+
+    std::vector<matrix_type> dst(3);
+    packet.store(dst.data(), 3);
+    EXPECT_EQ(src, dst);
+}
+
+}    // namespace test
+}    // namespace math
+}    // namespace psst
@@ -0,0 +1,200 @@
+/**
+ * Copyright 2019 Sergei A. Fedorov
+ * matrix_decomposition_tests.cpp
+ *
+ *  Created on: Mar 7, 2019
+ *      Author: ser-fedorov
+ */
+
+#include "test_printing.hpp"
+#include "test_utils.hpp"
+#include <psst/math/matrix_decomposition.hpp>
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <random>
+#include <stdexcept>
+
+namespace psst {
+namespace math {
+namespace test {
+
+namespace {
+
+template <typename Matrix>
+Matrix
+make_matrix(unsigned seed)
+{
+    using value_type = typename Matrix::value_type;
+    std::mt19937                               gen{seed};
+    std::uniform_real_distribution<value_type> dist{-1, 1};
+    Matrix                                     res;
+    std::generate(res.begin(), res.end(), [&]() { return dist(gen); });
+    return res;
+}
+
+template <typename Vector>
+Vector
+make_vector(unsigned seed)
+{
+    using value_type = typename Vector::value_type;
+    std::mt19937                               gen{seed};
+    std::uniform_real_distribution<value_type> dist{-1, 1};
+    Vector                                     res;
+    std::generate(res.begin(), res.end(), [&]() { return dist(gen); });
+    return res;
+}
+
+template <typename Matrix, typename Vector>
+::testing::AssertionResult
+residual_near(Matrix const& a, Vector const& x, Vector const& b, typename Matrix::value_type eps)
+{
+    matrix<typename Matrix::value_type, Matrix::rows, 1> const ax = a * x;
+    for (std::size_t r = 0; r < Matrix::rows; ++r) {
+        if (std::abs(ax[r][0] - b[r]) > eps)
+            return ::testing::AssertionFailure() << "Row " << r << ": " << ax[r][0]
+                                                 << " != " << b[r];
+    }
+    return ::testing::AssertionSuccess();
+}
+
+}    // namespace
+
+template <typename Matrix>
+class MatrixDecomposition : public ::testing::Test {};
+
+using decomposition_matrix_types
+    = ::testing::Types<matrix<float, 3, 3>, matrix<double, 4, 4>, matrix<double, 6, 6>,
+                       matrix<double, 7, 7>>;
+TYPED_TEST_SUITE(MatrixDecomposition, decomposition_matrix_types, );
+
+TYPED_TEST(MatrixDecomposition, LU)
+{
+    using matrix_type       = TypeParam;
+    using value_type        = typename matrix_type::value_type;
+    constexpr std::size_t N = matrix_type::rows;
+    using vector_type       = vector<value_type, N>;
+    value_type const eps    = std::is_same_v<value_type, float> ? 1e-4 : 1e-10;
+
+    auto const a = make_matrix<matrix_type>(1);
+    auto const b = make_vector<vector_type>(2);
+
+    lu_decomposition const lu{a};
+    vector_type const      x = lu.solve(b);
+    EXPECT_TRUE(residual_near(a, x, b, eps));
+    EXPECT_NEAR(det(a), lu.det(), eps);
+
+    matrix_type const id = a * lu.inverse();
+    EXPECT_TRUE(near(matrix_type::identity(), id, eps));
+
+    // Matrix right hand side, solved column by column
+    auto const                     bm = make_matrix<matrix<value_type, N, 2>>(3);
+    matrix<value_type, N, 2> const xm = lu.solve(bm);
+    matrix<value_type, N, 2> const ax = a * xm;
+    EXPECT_TRUE(near(bm, ax, eps));
+
+    // Free function and an expression argument
+    vector_type const y = solve(a * 2, b) * 2;
+    EXPECT_TRUE(residual_near(a, y, b, eps));
+}
+
+TYPED_TEST(MatrixDecomposition, Cholesky)
+{
+    using matrix_type       = TypeParam;
+    using value_type        = typename matrix_type::value_type;
+    constexpr std::size_t N = matrix_type::rows;
+    using vector_type       = vector<value_type, N>;
+    value_type const eps    = std::is_same_v<value_type, float> ? 1e-4 : 1e-10;
+
+    // Symmetric positive definite
+    auto const        m = make_matrix<matrix_type>(4);
+    matrix_type const a = m * transpose(m) + matrix_type::identity();
+    auto const        b = make_vector<vector_type>(5);
+
+    cholesky_decomposition const ch{a};
+    vector_type const            x = ch.solve(b);
+    EXPECT_TRUE(residual_near(a, x, b, eps));
+
+    matrix_type const l  = ch.lower();
+    matrix_type const ll = l * transpose(l);
+    EXPECT_TRUE(near(a, ll, eps));
+    EXPECT_NEAR(det(a), ch.det(), eps * std::abs(ch.det()));
+
+    matrix_type const inv = ch.solve(matrix_type::identity());
+    matrix_type const id  = a * inv;
+    EXPECT_TRUE(near(matrix_type::identity(), id, eps));
+
+    matrix_type const neg = a * -1;
+    EXPECT_THROW(cholesky_decomposition{neg}, std::runtime_error);
+}
+
+TYPED_TEST(MatrixDecomposition, QR)
+{
+    using matrix_type       = TypeParam;
+    using value_type        = typename matrix_type::value_type;
+    constexpr std::size_t N = matrix_type::rows;
+    using vector_type       = vector<value_type, N>;
+    value_type const eps    = std::is_same_v<value_type, float> ? 1e-4 : 1e-10;
+
+    auto const a = make_matrix<matrix_type>(6);
+    auto const b = make_vector<vector_type>(7);
+
+    qr_decomposition const qr{a};
+    vector_type const      x = qr.solve(b);
+    EXPECT_TRUE(residual_near(a, x, b, eps));
+
+    // |det(R)| == |det(A)|
+    EXPECT_NEAR(std::abs(det(a)), std::abs(det(qr.upper())), eps);
+}
+
+TYPED_TEST(MatrixDecomposition, Singular)
+{
+    using matrix_type = TypeParam;
+    auto a            = make_matrix<matrix_type>(8);
+    // Zero column stays exactly zero through the elimination
+    for (std::size_t r = 0; r < matrix_type::rows; ++r) {
+        a[r][1] = 0;
+    }
+    EXPECT_THROW(lu_decomposition{a}, std::runtime_error);
+    EXPECT_THROW(qr_decomposition{a}, std::runtime_error);
+    EXPECT_THROW(cholesky_decomposition{a}, std::runtime_error);
+}
+
+TEST(MatrixSolve, LeastSquares)
+{
+    using matrix_type = matrix<double, 7, 3>;
+    auto const a      = make_matrix<matrix_type>(9);
+    auto const b      = make_vector<vector<double, 7>>(10);
+
+    qr_decomposition const qr{a};
+    vector<double, 3> const x = qr.solve(b);
+
+    // The normal equations transpose(A) * A * x = transpose(A) * b
+    matrix<double, 3, 3> const ata = transpose(a) * a;
+    matrix<double, 3, 1> const atb = transpose(a) * b;
+    matrix<double, 3, 1> const ne  = cholesky_decomposition{ata}.solve(atb);
+    for (std::size_t r = 0; r < 3; ++r) {
+        EXPECT_NEAR(ne[r][0], x[r], 1e-10);
+    }
+
+    matrix<double, 3, 3> const r   = qr.upper();
+    matrix<double, 3, 3> const rtr = transpose(r) * r;
+    EXPECT_TRUE(near(ata, rtr, 1e-10));
+}
+
+TEST(MatrixSolve, Pivoting)
+{
+    // Zero in the top left corner requires a row exchange
+    matrix<double, 3, 3> const a{{0, 1, 2}, {1, 0, 3}, {4, -3, 8}};
+    vector<double, 3> const    b{1, 2, 3};
+
+    lu_decomposition const  lu{a};
+    vector<double, 3> const x = lu.solve(b);
+    EXPECT_TRUE(residual_near(a, x, b, 1e-12));
+    EXPECT_NEAR(-2, lu.det(), 1e-12);
+}
+
+}    // namespace test
+}    // namespace math
+}    // namespace psst
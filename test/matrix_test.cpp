@@ -12,6 +12,7 @@
 #include <gtest/gtest.h>
 
 #include <iostream>
+#include <type_traits>
 
 namespace psst {
 namespace math {
@@ -269,6 +270,99 @@ TEST(Matrix, MatrixMultiply)
     EXPECT_EQ(expected, mul) << "Invalid result " << mul;
 }
 
+TEST(Matrix, AliasedAssignment)
+{
+    // clang-format off
+    matrix3x3 const initial{
+        { 11, 12, 13 },
+        { 21, 22, 23 },
+        { 31, 32, 33 }
+    };
+    // clang-format on
+    matrix3x3 const square = initial * initial;
+    matrix3x3 const twice  = initial * 2;
+
+    // The matrix is an argument of a product
+    matrix3x3 m = initial;
+    m           = m * initial;
+    EXPECT_EQ(square, m);
+    m = initial;
+    m *= initial;
+    EXPECT_EQ(square, m);
+    m = initial;
+    m *= m;
+    EXPECT_EQ(square, m);
+    m = initial;
+    m = transpose(m);
+    EXPECT_EQ(transpose(initial), m);
+
+    // Compound assignment
+    m = initial;
+    m += m;
+    EXPECT_EQ(twice, m);
+    m -= initial;
+    EXPECT_EQ(initial, m);
+    m = m + m;
+    EXPECT_EQ(twice, m);
+    m /= 2;
+    EXPECT_EQ(initial, m);
+    // The scalar is an element of the matrix
+    m *= m[0][0];
+    matrix3x3 const by_element = initial * 11;
+    EXPECT_EQ(by_element, m);
+
+    m = initial;
+    m += m * initial;
+    matrix3x3 const sum = initial + square;
+    EXPECT_EQ(sum, m);
+    m -= transpose(m);
+    EXPECT_EQ(sum - transpose(sum), m);
+
+    matrix3x3 const neg      = -(initial * 2);
+    matrix3x3 const expected = initial * -2;
+    EXPECT_EQ(expected, neg);
+    m = initial;
+    m = -m;
+    EXPECT_EQ(initial * -1, m);
+}
+
+TEST(Matrix, LargeMatrixMultiply)
+{
+    // The products of matrices this large are evaluated by the packed kernel
+    using lhs_type = matrix<double, 40, 36>;
+    using rhs_type = matrix<float, 36, 48>;
+    using res_type = matrix<double, 40, 48>;
+    static_assert(std::is_same_v<res_type, std::decay_t<decltype(lhs_type{} * rhs_type{})>>);
+
+    lhs_type lhs;
+    rhs_type rhs;
+    for (std::size_t r = 0; r < lhs_type::rows; ++r) {
+        for (std::size_t c = 0; c < lhs_type::cols; ++c) {
+            lhs[r][c] = (r * 3 + c) % 7;
+        }
+    }
+    for (std::size_t r = 0; r < rhs_type::rows; ++r) {
+        for (std::size_t c = 0; c < rhs_type::cols; ++c) {
+            rhs[r][c] = (r + c * 5) % 11;
+        }
+    }
+    res_type expected;
+    for (std::size_t r = 0; r < res_type::rows; ++r) {
+        for (std::size_t c = 0; c < res_type::cols; ++c) {
+            expected[r][c] = 0;
+            for (std::size_t k = 0; k < lhs_type::cols; ++k) {
+                expected[r][c] += lhs[r][k] * rhs[k][c];
+            }
+        }
+    }
+    res_type res = lhs * rhs;
+    EXPECT_EQ(expected, res);
+    res = lhs * rhs * 2;
+    EXPECT_EQ(expected * 2, res);
+    res = lhs * transpose(transpose(rhs)) + expected;
+    EXPECT_EQ(expected * 2, res);
+}
+
 TEST(Matrix, RectMatrixAdd)
 {
     // clang-format off
@@ -286,6 +380,21 @@ TEST(Matrix, RectMatrixAdd)
     EXPECT_EQ(expected, initial + initial);
 }
 
+TEST(Matrix, RectIdentity)
+{
+    // The identity of the 3x4 affine transform doesn't depend on its header
+    static_assert(traits::has_identity_v<3, 4>, "3x4 matrix must have an identity");
+    static_assert(!traits::has_identity_v<4, 3>, "4x3 matrix must not have an identity");
+    // clang-format off
+    matrix3x4 expected{
+        { 1, 0, 0, 0 },
+        { 0, 1, 0, 0 },
+        { 0, 0, 1, 0 }
+    };
+    // clang-format on
+    EXPECT_EQ(expected, matrix3x4::identity());
+}
+
 TEST(Matrix, Minor)
 {
     // clang-format off
@@ -321,6 +430,56 @@ TEST(Matrix, Determinant)
         // clang-format on
         EXPECT_EQ(0, det(m));
     }
+    {
+        // clang-format off
+        matrix<double, 4, 4> m{
+            { 0, 2, 1, 3 },
+            { 1, 0, 2, 1 },
+            { 4, 1, 0, 2 },
+            { 3, 2, 1, 0 }
+        };
+        // clang-format on
+        EXPECT_NEAR(-60, det(m), 1e-9);
+        EXPECT_NEAR(-60, det(expr::transpose(m)), 1e-9);
+        matrix<double, 4, 4> singular{{1, 2, 3, 4}, {2, 4, 6, 8}, {0, 1, 0, 1}, {5, 6, 7, 8}};
+        EXPECT_EQ(0, det(singular));
+    }
+    {
+        // Zero leading pivot requires a row swap
+        // clang-format off
+        matrix<int, 5, 5> m{
+            { 0, 1, 0, 0, 0 },
+            { 2, 0, 0, 0, 0 },
+            { 0, 0, 3, 1, 0 },
+            { 0, 0, 1, 3, 0 },
+            { 0, 0, 0, 0, 5 }
+        };
+        // clang-format on
+        EXPECT_EQ(-80, det(m));
+        EXPECT_EQ(1, det(expr::identity<matrix<int, 10, 10>>()));
+    }
+}
+
+TEST(Matrix, Compare)
+{
+    // clang-format off
+    matrix<int, 4, 4> a{
+        {  1,  2,  3,  4 },
+        {  5,  6,  7,  8 },
+        {  9, 10, 11, 12 },
+        { 13, 14, 15, 16 }
+    };
+    // clang-format on
+    auto b = a;
+    EXPECT_EQ(a, b);
+    EXPECT_FALSE(a < b);
+    b[3][3] = 17;
+    EXPECT_NE(a, b);
+    EXPECT_TRUE(a < b);
+    EXPECT_GT(0, cmp(a, b));
+    b[0][1] = 1;
+    EXPECT_TRUE(b < a);
+    EXPECT_LT(0, cmp(a, b));
 }
 
 TEST(Matrix, Mutate)
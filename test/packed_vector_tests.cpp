@@ -0,0 +1,240 @@
+/**
+ * Copyright 2019 Sergei A. Fedorov
+ * packed_vector_tests.cpp
+ *
+ *  Created on: Feb 2, 2019
+ *      Author: ser-fedorov
+ */
+
+#include "test_printing.hpp"
+#include <psst/math/packed_vector.hpp>
+
+#include <gtest/gtest.h>
+
+#include <limits>
+#include <vector>
+
+namespace psst {
+namespace math {
+namespace test {
+
+using vector3f = vector<float, 3>;
+using vector4f = vector<float, 4>;
+
+namespace {
+
+/**
+ * snorm16 encoding that counts the decoded values
+ */
+struct counting_snorm16 : encoding::snorm16 {
+    static std::size_t decoded;
+
+    static value_type
+    decode(storage_type val)
+    {
+        ++decoded;
+        return encoding::snorm16::decode(val);
+    }
+};
+std::size_t counting_snorm16::decoded = 0;
+
+}    // namespace
+
+TEST(Packed, HalfEncoding)
+{
+    using encoding::half;
+    EXPECT_EQ(0x0000, half::encode(0.0f));
+    EXPECT_EQ(0x8000, half::encode(-0.0f));
+    EXPECT_EQ(0x3c00, half::encode(1.0f));
+    EXPECT_EQ(0xc000, half::encode(-2.0f));
+    EXPECT_EQ(0x7bff, half::encode(65504.0f));
+    EXPECT_EQ(0x7c00, half::encode(1e6f));
+    EXPECT_EQ(0xfc00, half::encode(-std::numeric_limits<float>::infinity()));
+    EXPECT_EQ(0x0001, half::encode(5.960464477539063e-8f));
+    EXPECT_EQ(0x3555, half::encode(1.0f / 3));
+    EXPECT_EQ(0x7e00, half::encode(std::numeric_limits<float>::quiet_NaN()));
+
+    EXPECT_EQ(1.0f, half::decode(0x3c00));
+    EXPECT_EQ(-2.0f, half::decode(0xc000));
+    EXPECT_EQ(65504.0f, half::decode(0x7bff));
+    EXPECT_EQ(5.960464477539063e-8f, half::decode(0x0001));
+    EXPECT_EQ(std::numeric_limits<float>::infinity(), half::decode(0x7c00));
+
+    // All finite halves survive a round trip
+    for (std::uint32_t i = 0; i < 0x10000; ++i) {
+        auto h = static_cast<std::uint16_t>(i);
+        if ((h & 0x7c00) == 0x7c00)
+            continue;
+        EXPECT_EQ(h, half::encode(half::decode(h))) << "Half value " << std::hex << i;
+    }
+}
+
+TEST(Packed, NormEncoding)
+{
+    EXPECT_EQ(127, encoding::snorm8::encode(1.0f));
+    EXPECT_EQ(-127, encoding::snorm8::encode(-1.0f));
+    EXPECT_EQ(-127, encoding::snorm8::encode(-3.0f));
+    EXPECT_EQ(0, encoding::snorm8::encode(0.0f));
+    EXPECT_EQ(-1.0f, encoding::snorm8::decode(-128));
+    EXPECT_EQ(-1.0f, encoding::snorm8::decode(-127));
+    EXPECT_EQ(32767, encoding::snorm16::encode(2.0f));
+
+    EXPECT_EQ(255, encoding::unorm8::encode(1.0f));
+    EXPECT_EQ(0, encoding::unorm8::encode(-1.0f));
+    EXPECT_EQ(128, encoding::unorm8::encode(0.5f));
+    EXPECT_EQ(1.0f, encoding::unorm16::decode(65535));
+    EXPECT_EQ(0.0f, encoding::unorm16::decode(0));
+}
+
+TEST(Packed, PackedVector)
+{
+    using half3 = half_vector<3>;
+    static_assert(sizeof(half3) == 3 * sizeof(std::uint16_t), "");
+    static_assert(traits::is_vector_expression_v<half3>, "");
+
+    half3 h = vector3f{1, -2, 0.5};
+    EXPECT_EQ(1.0f, h.x());
+    EXPECT_EQ(-2.0f, h.y());
+    EXPECT_EQ(0.5f, h.z());
+    EXPECT_EQ(-2.0f, h[1]);
+
+    vector3f v = h * 2;
+    EXPECT_EQ((vector3f{2, -4, 1}), v);
+    EXPECT_EQ(-0.5f, dot_product(h, vector3f{1, 1, 1}));
+
+    h.set<2>(4);
+    EXPECT_EQ(4.0f, h.z());
+
+    unorm8_vector<4> c{0.0f, 0.5f, 1.0f};
+    EXPECT_EQ(0, c.data()[0]);
+    EXPECT_EQ(128, c.data()[1]);
+    EXPECT_EQ(255, c.data()[2]);
+    EXPECT_EQ(0, c.data()[3]);
+}
+
+TEST(Packed, Packed1010102)
+{
+    using unorm_t = unorm_10_10_10_2<>;
+    using snorm_t = snorm_10_10_10_2<>;
+    static_assert(sizeof(unorm_t) == sizeof(std::uint32_t), "");
+
+    unorm_t u = vector4f{1, 0, 0.5, 1};
+    EXPECT_EQ(0xe00003ffu, u.raw());
+    EXPECT_EQ(1.0f, u.x());
+    EXPECT_EQ(0.0f, u.y());
+    EXPECT_NEAR(0.5f, u.z(), 1.0f / 1023);
+    EXPECT_EQ(1.0f, u.w());
+
+    snorm_t s = vector4f{-1, 1, 0, -1};
+    EXPECT_EQ(-1.0f, s.x());
+    EXPECT_EQ(1.0f, s.y());
+    EXPECT_EQ(0.0f, s.z());
+    EXPECT_EQ(-1.0f, s.w());
+    EXPECT_EQ(-1.0f, s[3]);
+
+    s = vector4f{0.25, -0.25, 0.75, 1};
+    EXPECT_NEAR(0.25f, s.x(), 1.0f / 511);
+    EXPECT_NEAR(-0.25f, s.y(), 1.0f / 511);
+    EXPECT_NEAR(0.75f, s.z(), 1.0f / 511);
+    EXPECT_EQ(1.0f, s.w());
+}
+
+TEST(Packed, Octahedral)
+{
+    using normal_t = octahedral_normal<>;
+    static_assert(sizeof(normal_t) == 2 * sizeof(std::int16_t), "");
+
+    std::vector<vector3f> dirs{{1, 0, 0},   {0, 1, 0},          {0, 0, 1},       {-1, 0, 0},
+                               {0, -1, 0},  {0, 0, -1},         {1, 1, 1},       {-1, 2, -3},
+                               {3, -1, -1}, {-0.2, -0.3, -0.9}, {0.01, 0.01, -1}};
+    for (auto const& d : dirs) {
+        auto     n = normalize(d);
+        normal_t o = n;
+        vector3f r = o;
+        EXPECT_EQ(o.decoded(), r);
+        EXPECT_NEAR(1.0f, magnitude(r), 1e-5);
+        EXPECT_NEAR(n.x(), r.x(), 1e-3) << d;
+        EXPECT_NEAR(n.y(), r.y(), 1e-3) << d;
+        EXPECT_NEAR(n.z(), r.z(), 1e-3) << d;
+    }
+}
+
+TEST(Packed, OctahedralDecodedOnce)
+{
+    // An octahedral normal decodes two values
+    using normal_t = octahedral_normal<counting_snorm16>;
+    normal_t const o = normalize(vector3f{1, -2, 3});
+    vector3f const v{1, 1, 1};
+    vector3f const r = o.decoded();
+
+    counting_snorm16::decoded = 0;
+    vector3f const c          = o;
+    EXPECT_EQ(2, counting_snorm16::decoded);
+    EXPECT_EQ(r, c);
+
+    counting_snorm16::decoded = 0;
+    EXPECT_FLOAT_EQ(dot_product(r, v), dot_product(o, v));
+    EXPECT_EQ(2, counting_snorm16::decoded);
+
+    // The decoded value is a part of the expression
+    counting_snorm16::decoded = 0;
+    auto const     sum        = o + v;
+    vector3f const s          = sum;
+    EXPECT_EQ(2, counting_snorm16::decoded);
+    EXPECT_EQ(vector3f(r + v), s);
+
+    counting_snorm16::decoded = 0;
+    EXPECT_FLOAT_EQ(magnitude(r), magnitude(o));
+    EXPECT_EQ(2, counting_snorm16::decoded);
+}
+
+TEST(Packed, BulkPackUnpack)
+{
+    constexpr std::size_t count = 37;
+    std::vector<vector3f> src(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        src[i] = vector3f{i * 0.5f, -(i * 0.25f), 1.0f / (i + 1)};
+    }
+
+    std::vector<half_vector<3>> packed(count);
+    pack(src.data(), count, packed.data());
+    std::vector<vector3f> dst(count);
+    unpack(packed.data(), count, dst.data());
+    for (std::size_t i = 0; i < count; ++i) {
+        EXPECT_EQ(vector3f{packed[i]}, dst[i]);
+        EXPECT_NEAR(src[i].x(), dst[i].x(), 1e-2);
+        EXPECT_NEAR(src[i].y(), dst[i].y(), 1e-2);
+        EXPECT_NEAR(src[i].z(), dst[i].z(), 1e-3);
+    }
+
+    std::vector<vector3f> normals(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        normals[i]
+            = normalize(vector3f{std::cos(i * 0.7f), std::sin(i * 1.3f), std::cos(i * 0.3f)});
+    }
+    std::vector<octahedral_normal<>> oct(count);
+    pack(normals.data(), count, oct.data());
+    unpack(oct.data(), count, dst.data());
+    for (std::size_t i = 0; i < count; ++i) {
+        EXPECT_NEAR(1.0f, dot_product(normals[i], dst[i]), 1e-5);
+    }
+
+    std::vector<vector4f> colors(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        colors[i] = vector4f{i / float(count), 1 - i / float(count), 0.5f, (i % 4) / 3.0f};
+    }
+    std::vector<unorm_10_10_10_2<>> packed_colors(count);
+    pack(colors.data(), count, packed_colors.data());
+    std::vector<vector4f> unpacked_colors(count);
+    unpack(packed_colors.data(), count, unpacked_colors.data());
+    for (std::size_t i = 0; i < count; ++i) {
+        EXPECT_NEAR(colors[i].x(), unpacked_colors[i].x(), 1.0f / 1023);
+        EXPECT_NEAR(colors[i].y(), unpacked_colors[i].y(), 1.0f / 1023);
+        EXPECT_NEAR(colors[i].z(), unpacked_colors[i].z(), 1.0f / 1023);
+        EXPECT_NEAR(colors[i].w(), unpacked_colors[i].w(), 1e-6);
+    }
+}
+
+}    // namespace test
+}    // namespace math
+}    // namespace psst
@@ -11,7 +11,10 @@
 
 #include <gtest/gtest.h>
 
+#include <algorithm>
+#include <cmath>
 #include <sstream>
+#include <vector>
 
 namespace psst {
 namespace math {
@@ -79,6 +82,146 @@ TEST(Quat, Conjugate)
     EXPECT_EQ(q, conjugate(conjugate(q)));
 }
 
+TEST(Quat, Rotate)
+{
+    double const s = std::sqrt(0.5);
+    // 90 degrees around z
+    quaternion_d q{s, 0, 0, s};
+    EXPECT_EQ((vector3d{0, 1, 0}), rotate(q, vector3d{1, 0, 0}));
+    EXPECT_EQ((vector3d{-1, 0, 0}), rotate(q, vector3d{0, 1, 0}));
+    EXPECT_EQ((vector3d{0, 0, 1}), rotate(q, vector3d{0, 0, 1}));
+
+    // Same as the sandwich product for an arbitrary unit quaternion
+    quaternion_d r = normalize(quaternion_d{1, 2, 3, 4});
+    vector3d     v{0.5, -2, 3};
+    quaternion_d p{0, v.x(), v.y(), v.z()};
+    quaternion_d expected = r * p * inverse(r);
+    EXPECT_EQ(expected.vector_part(), rotate(r, v));
+    vector3d back = rotate(conjugate(r), vector3d(rotate(r, v)));
+    EXPECT_NEAR(0, magnitude(v - back), 1e-12) << back;
+
+    // Nested arguments and the rotation of a vector in place
+    vector3d const rotated = rotate(r, v);
+    EXPECT_EQ(rotated, rotate(normalize(quaternion_d{1, 2, 3, 4}), v));
+    v = rotate(r, v);
+    EXPECT_EQ(rotated, v);
+}
+
+TEST(Quat, BulkRotate)
+{
+    quaternion_d          q = normalize(quaternion_d{1, -2, 3, 0.5});
+    std::vector<vector3d> src{{1, 0, 0}, {0, 1, 0}, {0, 0, 1}, {1, 2, 3}, {-4, 5, 0.25}};
+    std::vector<vector3d> dst(src.size());
+
+    rotate(q, src.data(), src.size(), dst.data());
+    for (std::size_t i = 0; i < src.size(); ++i) {
+        EXPECT_EQ(vector3d(rotate(q, src[i])), dst[i]) << "Index " << i;
+    }
+
+    std::vector<quaternion_d> qs{q, conjugate(q), normalize(quaternion_d{0, 1, 1, 0}), q, q};
+    rotate(qs.data(), src.data(), src.size(), dst.data());
+    for (std::size_t i = 0; i < src.size(); ++i) {
+        EXPECT_EQ(vector3d(rotate(qs[i], src[i])), dst[i]) << "Index " << i;
+    }
+
+    // In place
+    auto copy = src;
+    rotate(q, copy.data(), copy.size(), copy.data());
+    for (std::size_t i = 0; i < src.size(); ++i) {
+        EXPECT_EQ(vector3d(rotate(q, src[i])), copy[i]) << "Index " << i;
+    }
+}
+
+namespace {
+
+// Reference slerp with the trigonometric functions
+quaternion_d
+exact_slerp(quaternion_d const& start, quaternion_d end, double percent)
+{
+    double dot = dot_product(start, end);
+    if (dot < 0) {
+        end = -end;
+        dot = -dot;
+    }
+    double const theta = std::acos(std::min(dot, 1.0));
+    if (theta < 1e-9)
+        return start;
+    double const s = std::sin(theta);
+    return start * (std::sin((1 - percent) * theta) / s) + end * (std::sin(percent * theta) / s);
+}
+
+}    // namespace
+
+TEST(Quat, Nlerp)
+{
+    quaternion_d a = normalize(quaternion_d{1, 0.5, -0.25, 0.1});
+    quaternion_d b = normalize(quaternion_d{0.2, -1, 0.3, 0.7});
+
+    EXPECT_NEAR(0, magnitude(a - nlerp(a, b, 0.0)), 1e-12);
+    // The end is reached up to the sign, a and b are in the opposite hemispheres
+    EXPECT_NEAR(0, magnitude(b + nlerp(a, b, 1.0)), 1e-12);
+    for (double t = 0; t <= 1; t += 0.125) {
+        quaternion_d q = nlerp(a, b, t);
+        EXPECT_NEAR(1, magnitude(q), 1e-12) << "Percent " << t;
+        // -b is the same rotation, the shortest path doesn't change
+        EXPECT_NEAR(0, magnitude(q - nlerp(a, -b, t)), 1e-12) << "Percent " << t;
+    }
+}
+
+TEST(Quat, FastSlerp)
+{
+    std::vector<quaternion_d> qs{normalize(quaternion_d{1, 0.5, -0.25, 0.1}),
+                                 normalize(quaternion_d{0.2, -1, 0.3, 0.7}),
+                                 normalize(quaternion_d{-0.3, 0.1, 0.9, -0.2}),
+                                 quaternion_d{1, 0, 0, 0},
+                                 quaternion_d{0, 1, 0, 0}};
+    for (auto const& a : qs) {
+        for (auto const& b : qs) {
+            for (double t = 0; t <= 1; t += 0.0625) {
+                quaternion_d expected = exact_slerp(a, b, t);
+                quaternion_d q        = fast_slerp(a, b, t);
+                for (std::size_t i = 0; i < 4; ++i) {
+                    EXPECT_NEAR(expected[i], q[i], 5e-5) << a << " " << b << " " << t;
+                }
+            }
+        }
+    }
+    // Works for float too
+    quaternion<float> a{1, 0, 0, 0}, b = normalize(quaternion<float>{0, 1, 1, 0});
+    quaternion<float> q = fast_slerp(a, b, 0.5f);
+    EXPECT_NEAR(1, magnitude(q), 1e-4);
+}
+
+TEST(Quat, BulkInterpolate)
+{
+    std::vector<quaternion_d> start{normalize(quaternion_d{1, 0.5, -0.25, 0.1}),
+                                    normalize(quaternion_d{-0.3, 0.1, 0.9, -0.2}),
+                                    quaternion_d{1, 0, 0, 0}};
+    std::vector<quaternion_d> end{normalize(quaternion_d{0.2, -1, 0.3, 0.7}),
+                                  normalize(quaternion_d{0.3, -0.1, -0.9, 0.25}),
+                                  quaternion_d{0, 0, 1, 0}};
+    std::vector<double>       percent{0.25, 0.5, 0.75};
+    std::vector<quaternion_d> dst(start.size());
+
+    nlerp(start.data(), end.data(), 0.3, start.size(), dst.data());
+    for (std::size_t i = 0; i < start.size(); ++i) {
+        EXPECT_EQ(quaternion_d(nlerp(start[i], end[i], 0.3)), dst[i]) << "Index " << i;
+    }
+    nlerp(start.data(), end.data(), percent.data(), start.size(), dst.data());
+    for (std::size_t i = 0; i < start.size(); ++i) {
+        EXPECT_EQ(quaternion_d(nlerp(start[i], end[i], percent[i])), dst[i]) << "Index " << i;
+    }
+    fast_slerp(start.data(), end.data(), 0.3, start.size(), dst.data());
+    for (std::size_t i = 0; i < start.size(); ++i) {
+        EXPECT_EQ(quaternion_d(fast_slerp(start[i], end[i], 0.3)), dst[i]) << "Index " << i;
+    }
+    fast_slerp(start.data(), end.data(), percent.data(), start.size(), dst.data());
+    for (std::size_t i = 0; i < start.size(); ++i) {
+        EXPECT_EQ(quaternion_d(fast_slerp(start[i], end[i], percent[i])), dst[i])
+            << "Index " << i;
+    }
+}
+
 }    // namespace test
 }    // namespace math
 }    // namespace psst
@@ -0,0 +1,188 @@
+/**
+ * Copyright 2019 Sergei A. Fedorov
+ * ray_tests.cpp
+ *
+ *  Created on: Feb 27, 2019
+ *      Author: ser-fedorov
+ */
+
+#include "test_printing.hpp"
+#include <psst/math/ray.hpp>
+
+#include <gtest/gtest.h>
+
+#include <random>
+#include <vector>
+
+namespace psst {
+namespace math {
+namespace test {
+
+using vector3f = vector<float, 3>;
+using rayf     = ray<float>;
+using box3f    = aabb<float, 3>;
+
+namespace {
+
+constexpr float tolerance = 1e-5;
+
+std::vector<rayf>
+make_rays(std::size_t count, std::mt19937& gen)
+{
+    std::uniform_real_distribution<float> pos(-3, 3);
+    std::vector<rayf>                     res;
+    for (std::size_t i = 0; i < count; ++i) {
+        vector3f origin{pos(gen), pos(gen), pos(gen)};
+        vector3f target{pos(gen) / 3, pos(gen) / 3, pos(gen) / 3};
+        res.emplace_back(origin, target - origin);
+    }
+    // Rays parallel to the axes
+    res[1] = rayf{{0.2, 0.3, -5}, {0, 0, 1}};
+    res[2] = rayf{{-5, 0.5, 0.5}, {1, 0, 0}};
+    res[3] = rayf{{2, 2, 2}, {0, 1, 0}};
+    return res;
+}
+
+}    // namespace
+
+TEST(Ray, Triangle)
+{
+    vector3f v0{0, 0, 0}, v1{1, 0, 0}, v2{0, 1, 0};
+
+    triangle_hit<float> hit;
+    EXPECT_TRUE(intersect(rayf{{0.25, 0.5, 1}, {0, 0, -1}}, v0, v1, v2, hit));
+    EXPECT_NEAR(1, hit.t, tolerance);
+    EXPECT_NEAR(0.25, hit.u, tolerance);
+    EXPECT_NEAR(0.5, hit.v, tolerance);
+
+    // The back side, a direction of a different length
+    hit = triangle_hit<float>{};
+    EXPECT_TRUE(intersect(rayf{{0.25, 0.25, -2}, {0, 0, 4}}, v0, v1, v2, hit));
+    EXPECT_NEAR(0.5, hit.t, tolerance);
+
+    // A closer hit is kept
+    EXPECT_FALSE(intersect(rayf{{0.25, 0.25, -2}, {0, 0, 1}}, v0, v1, v2, hit));
+    EXPECT_NEAR(0.5, hit.t, tolerance);
+
+    hit = triangle_hit<float>{};
+    // Outside the triangle, behind the origin and parallel
+    EXPECT_FALSE(intersect(rayf{{0.75, 0.5, 1}, {0, 0, -1}}, v0, v1, v2, hit));
+    EXPECT_FALSE(intersect(rayf{{0.25, 0.25, 1}, {0, 0, 1}}, v0, v1, v2, hit));
+    EXPECT_FALSE(intersect(rayf{{0.25, 0.25, 1}, {1, 0, 0}}, v0, v1, v2, hit));
+
+    auto r = rayf{{0.1, 0.2, 3}, {0.1, 0.1, -1}};
+    EXPECT_TRUE(intersect(r, v0, v1, v2, hit));
+    vector3f p = r.point_at(hit.t);
+    EXPECT_NEAR(0, magnitude(p - (v0 * (1 - hit.u - hit.v) + v1 * hit.u + v2 * hit.v)),
+                tolerance);
+}
+
+TEST(Ray, Box)
+{
+    box3f box{{-1, -1, -1}, {1, 1, 1}};
+    float t = -1;
+    EXPECT_TRUE(intersect(rayf{{-3, 0, 0}, {1, 0, 0}}, box, 100.0f, t));
+    EXPECT_NEAR(2, t, tolerance);
+    // The origin inside
+    EXPECT_TRUE(intersect(rayf{{0, 0, 0}, {1, 1, 0}}, box, 100.0f, t));
+    EXPECT_EQ(0, t);
+    // Too far, behind and missing
+    t = -1;
+    EXPECT_FALSE(intersect(rayf{{-3, 0, 0}, {1, 0, 0}}, box, 1.5f, t));
+    EXPECT_FALSE(intersect(rayf{{-3, 0, 0}, {-1, 0, 0}}, box, 100.0f, t));
+    EXPECT_FALSE(intersect(rayf{{-3, 2, 0}, {1, 0, 0}}, box, 100.0f, t));
+    EXPECT_EQ(-1, t);
+    // Parallel to a face, origin on the slab boundary
+    EXPECT_TRUE(intersect(rayf{{-3, 1, 0}, {1, 0, 0}}, box, 100.0f, t));
+    EXPECT_FALSE(intersect(rayf{{-3, 1.5, 0}, {1, 0, 0}}, box, 100.0f, t));
+    // An empty box is never hit
+    t = -1;
+    EXPECT_FALSE(intersect(rayf{{-3, 0, 0}, {1, 0, 0}}, box3f{}, 100.0f, t));
+    EXPECT_FALSE(intersect(rayf{{0, 0, 0}, {1, 1, 1}}, box3f{}, 100.0f, t));
+    EXPECT_FALSE(intersect(rayf{{-3, 0, 0}, {1, 0, 0}}, box3f{{-1, 1, -1}, {1, -1, 1}}, 100.0f, t));
+    EXPECT_EQ(-1, t);
+}
+
+TEST(Ray, Sphere)
+{
+    vector3f center{0, 0, 5};
+    float    t = 100;
+    EXPECT_TRUE(intersect(rayf{{0, 0, 0}, {0, 0, 1}}, center, 2.0f, t));
+    EXPECT_NEAR(3, t, tolerance);
+    t = 100;
+    EXPECT_TRUE(intersect(rayf{{0, 0, 0}, {0, 0, 2}}, center, 2.0f, t));
+    EXPECT_NEAR(1.5, t, tolerance);
+    // The origin inside, the exit point
+    t = 100;
+    EXPECT_TRUE(intersect(rayf{{0, 0, 5}, {1, 0, 0}}, center, 2.0f, t));
+    EXPECT_NEAR(2, t, tolerance);
+    // Missing, behind, too far
+    t = 100;
+    EXPECT_FALSE(intersect(rayf{{0, 3, 0}, {0, 0, 1}}, center, 2.0f, t));
+    EXPECT_FALSE(intersect(rayf{{0, 0, 0}, {0, 0, -1}}, center, 2.0f, t));
+    t = 2;
+    EXPECT_FALSE(intersect(rayf{{0, 0, 0}, {0, 0, 1}}, center, 2.0f, t));
+    EXPECT_EQ(2, t);
+}
+
+template <typename Packet>
+class RayPacket : public ::testing::Test {};
+
+using packet_types = ::testing::Types<ray_packet<float, 4>, ray_packet<float, 8>,
+                                      ray_packet<float, 16>>;
+TYPED_TEST_SUITE(RayPacket, packet_types, );
+
+TYPED_TEST(RayPacket, MatchesSingle)
+{
+    constexpr std::size_t N = TypeParam::size;
+    std::mt19937          gen{31};
+    auto const            rays = make_rays(N * 16, gen);
+
+    vector3f v0{-1, -1, 0}, v1{1, -0.5, 0.5}, v2{0, 1, -0.25};
+    box3f    box{{-1, -0.5, -0.75}, {0.5, 1, 1}};
+    vector3f center{0.25, -0.25, 0};
+
+    std::size_t hits = 0;
+    for (std::size_t first = 0; first < rays.size(); first += N) {
+        TypeParam packet{rays.data() + first};
+
+        triangle_hit_packet<float, N> tri_hits{10};
+        float                         t_max[N], t_near[N], t_sphere[N];
+        std::fill(t_max, t_max + N, 10.0f);
+        std::fill(t_near, t_near + N, -1.0f);
+        std::fill(t_sphere, t_sphere + N, 10.0f);
+
+        auto const tri_mask    = intersect(packet, v0, v1, v2, tri_hits);
+        auto const box_mask    = intersect(packet, box, t_max, t_near);
+        auto const sphere_mask = intersect(packet, center, 0.75f, t_sphere);
+        EXPECT_EQ(0u, intersect(packet, box3f{}, t_max, t_sphere));
+
+        for (std::size_t i = 0; i < N; ++i) {
+            auto const& r = rays[first + i];
+
+            triangle_hit<float> hit;
+            hit.t = 10;
+            ASSERT_EQ(intersect(r, v0, v1, v2, hit), bool((tri_mask >> i) & 1)) << first + i;
+            // The operations are in a different order
+            EXPECT_NEAR(hit.t, tri_hits.t[i], tolerance);
+            EXPECT_NEAR(hit.u, tri_hits.u[i], tolerance);
+            EXPECT_NEAR(hit.v, tri_hits.v[i], tolerance);
+
+            float t = -1;
+            ASSERT_EQ(intersect(r, box, 10.0f, t), bool((box_mask >> i) & 1)) << first + i;
+            EXPECT_NEAR(t, t_near[i], tolerance);
+
+            t = 10;
+            ASSERT_EQ(intersect(r, center, 0.75f, t), bool((sphere_mask >> i) & 1))
+                << first + i;
+            // The distance of a nearly tangent ray is sensitive to rounding
+            EXPECT_NEAR(t, t_sphere[i], 1e-4);
+        }
+        hits += tri_mask != 0;
+    }
+    EXPECT_LT(0u, hits);
+}
+
+}    // namespace test
+}    // namespace math
+}    // namespace psst
@@ -0,0 +1,165 @@
+/**
+ * Copyright 2019 Sergei A. Fedorov
+ * rotation_tests.cpp
+ *
+ *  Created on: Feb 12, 2019
+ *      Author: ser-fedorov
+ */
+
+#include "test_printing.hpp"
+#include <psst/math/rotation.hpp>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace psst {
+namespace math {
+namespace test {
+
+using quaternion_d = quaternion<double>;
+using vector3d     = vector<double, 3>;
+using matrix3x3    = matrix<double, 3, 3>;
+using matrix4x4    = matrix<double, 4, 4>;
+using axis_angle_d = axis_angle<double>;
+using euler_d      = euler_angles<double>;
+
+namespace {
+
+constexpr double tolerance = 1e-12;
+
+/**
+ * Quaternions q and -q represent the same rotation
+ */
+double
+quaternion_distance(quaternion_d const& lhs, quaternion_d const& rhs)
+{
+    return std::min<double>(magnitude(lhs - rhs), magnitude(lhs + rhs));
+}
+
+std::vector<quaternion_d>
+test_orientations()
+{
+    return {
+        {1, 0, 0, 0},
+        normalize(quaternion_d{1, 2, 3, 4}),
+        normalize(quaternion_d{-0.3, 0.1, -0.7, 0.2}),
+        // 180 degrees around each axis, the trace of the matrix is -1
+        {0, 1, 0, 0},
+        {0, 0, 1, 0},
+        {0, 0, 0, 1},
+        normalize(quaternion_d{1e-4, 0.6, -0.8, 0.1}),
+    };
+}
+
+}    // namespace
+
+TEST(Rotation, QuaternionToMatrix)
+{
+    for (auto const& q : test_orientations()) {
+        matrix3x3 m = convert<matrix3x3>(q);
+        for (auto const& v : {vector3d{1, 0, 0}, vector3d{0, 1, 0}, vector3d{1, -2, 3}}) {
+            vector3d expected = rotate(q, v);
+            vector3d actual   = as_vector(m * v);
+            EXPECT_NEAR(0, magnitude(expected - actual), tolerance) << q << " " << v;
+        }
+        EXPECT_NEAR(1, det(m), tolerance);
+
+        matrix4x4 m4 = convert<matrix4x4>(q);
+        EXPECT_EQ(m, (expr::minor<3, 3>(m4)));
+        EXPECT_EQ((vector<double, 4>{0, 0, 0, 1}), m4[3]);
+        EXPECT_EQ(0, m4[0][3]);
+        EXPECT_EQ(0, m4[1][3]);
+        EXPECT_EQ(0, m4[2][3]);
+    }
+    // A quaternion that is not normalized gives the same rotation
+    EXPECT_EQ(convert<matrix3x3>(normalize(quaternion_d{1, 2, 3, 4})),
+              convert<matrix3x3>(quaternion_d{1, 2, 3, 4}));
+}
+
+TEST(Rotation, MatrixToQuaternion)
+{
+    for (auto const& q : test_orientations()) {
+        quaternion_d from3 = convert<quaternion_d>(convert<matrix3x3>(q));
+        quaternion_d from4 = convert<quaternion_d>(convert<matrix4x4>(q));
+        EXPECT_NEAR(0, quaternion_distance(q, from3), tolerance) << q << " " << from3;
+        EXPECT_NEAR(0, quaternion_distance(q, from4), tolerance) << q << " " << from4;
+        EXPECT_NEAR(1, magnitude(from3), tolerance);
+    }
+}
+
+TEST(Rotation, AxisAngle)
+{
+    double const half_pi = std::acos(0.0);
+    // 90 degrees around Z, the axis is normalized on conversion
+    quaternion_d q = convert<quaternion_d>(axis_angle_d{0, 0, 2, half_pi});
+    EXPECT_NEAR(0, magnitude(vector3d{0, 1, 0} - vector3d(rotate(q, vector3d{1, 0, 0}))),
+                tolerance);
+
+    axis_angle_d aa = convert<axis_angle_d>(q);
+    EXPECT_NEAR(0, aa.x(), tolerance);
+    EXPECT_NEAR(0, aa.y(), tolerance);
+    EXPECT_NEAR(1, aa.z(), tolerance);
+    EXPECT_NEAR(half_pi, aa.angle(), tolerance);
+
+    for (auto const& orig : test_orientations()) {
+        quaternion_d back = convert<quaternion_d>(convert<axis_angle_d>(orig));
+        EXPECT_NEAR(0, quaternion_distance(orig, back), tolerance) << orig << " " << back;
+    }
+
+    EXPECT_EQ((quaternion_d{1, 0, 0, 0}), convert<quaternion_d>(axis_angle_d{0, 0, 0, 1}));
+    EXPECT_EQ(0, convert<axis_angle_d>(quaternion_d{1, 0, 0, 0}).angle());
+}
+
+TEST(Rotation, EulerAngles)
+{
+    double const half_pi = std::acos(0.0);
+    // Yaw rotates around Z
+    quaternion_d q = convert<quaternion_d>(euler_d{0, 0, half_pi});
+    EXPECT_NEAR(0, magnitude(vector3d{0, 1, 0} - vector3d(rotate(q, vector3d{1, 0, 0}))),
+                tolerance);
+    // Roll, then pitch, then yaw
+    euler_d      e{0.3, -0.5, 1.2};
+    quaternion_d roll  = convert<quaternion_d>(axis_angle_d{1, 0, 0, e.roll()});
+    quaternion_d pitch = convert<quaternion_d>(axis_angle_d{0, 1, 0, e.pitch()});
+    quaternion_d yaw   = convert<quaternion_d>(axis_angle_d{0, 0, 1, e.yaw()});
+    quaternion_d expected = yaw * pitch * roll;
+    EXPECT_NEAR(0, quaternion_distance(expected, convert<quaternion_d>(e)), tolerance);
+
+    euler_d back = convert<euler_d>(convert<quaternion_d>(e));
+    EXPECT_NEAR(e.roll(), back.roll(), tolerance);
+    EXPECT_NEAR(e.pitch(), back.pitch(), tolerance);
+    EXPECT_NEAR(e.yaw(), back.yaw(), tolerance);
+
+    // Gimbal lock doesn't produce NaN
+    euler_d lock = convert<euler_d>(convert<quaternion_d>(euler_d{0, half_pi, 0}));
+    EXPECT_NEAR(half_pi, lock.pitch(), 1e-6);
+    EXPECT_FALSE(std::isnan(lock.roll()));
+    EXPECT_FALSE(std::isnan(lock.yaw()));
+}
+
+TEST(Rotation, BulkConvert)
+{
+    auto const             src = test_orientations();
+    std::vector<matrix3x3> m3(src.size());
+    std::vector<matrix4x4> m4(src.size());
+    convert(src.data(), src.size(), m3.data());
+    convert(src.data(), src.size(), m4.data());
+
+    std::vector<quaternion_d> from3(src.size()), from4(src.size());
+    convert(m3.data(), m3.size(), from3.data());
+    convert(m4.data(), m4.size(), from4.data());
+
+    for (std::size_t i = 0; i < src.size(); ++i) {
+        EXPECT_EQ(convert<matrix3x3>(src[i]), m3[i]) << "Index " << i;
+        EXPECT_EQ(convert<matrix4x4>(src[i]), m4[i]) << "Index " << i;
+        EXPECT_EQ(convert<quaternion_d>(m3[i]), from3[i]) << "Index " << i;
+        EXPECT_EQ(convert<quaternion_d>(m4[i]), from4[i]) << "Index " << i;
+    }
+}
+
+}    // namespace test
+}    // namespace math
+}    // namespace psst
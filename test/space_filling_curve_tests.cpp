@@ -0,0 +1,240 @@
+/**
+ * Copyright 2019 Sergei A. Fedorov
+ * space_filling_curve_tests.cpp
+ *
+ *  Created on: Mar 3, 2019
+ *      Author: ser-fedorov
+ */
+
+#include "test_printing.hpp"
+#include <psst/math/radix_sort.hpp>
+#include <psst/math/space_filling_curve.hpp>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <numeric>
+#include <random>
+#include <vector>
+
+namespace psst {
+namespace math {
+namespace test {
+
+using vector2f = vector<float, 2>;
+using vector3f = vector<float, 3>;
+
+namespace {
+
+/**
+ * Morton code by bits, the bit b of the axis k goes to the bit b * N + k
+ */
+template <typename Key, std::size_t N>
+Key
+slow_morton(Key const (&coords)[N])
+{
+    Key res = 0;
+    for (std::size_t b = 0; b < curve_bits<Key, N>; ++b) {
+        for (std::size_t k = 0; k < N; ++k) {
+            res |= ((coords[k] >> b) & 1) << (b * N + k);
+        }
+    }
+    return res;
+}
+
+}    // namespace
+
+TEST(SpaceFillingCurve, Morton)
+{
+    EXPECT_EQ(0u, morton_encode(0u, 0u));
+    EXPECT_EQ(0b101u, morton_encode(0b11u, 0u));
+    EXPECT_EQ(0b1010u, morton_encode(0u, 0b11u));
+    EXPECT_EQ(0b1001u, morton_encode(0b11u, 0u, 0u));
+    EXPECT_EQ(0b100100u, morton_encode(0u, 0u, 0b11u));
+    EXPECT_EQ(0xffffffffu, morton_encode(0xffffu, 0xffffu));
+    EXPECT_EQ(0x3fffffffu, morton_encode(0x3ffu, 0x3ffu, 0x3ffu));
+    EXPECT_EQ(0x7fffffffffffffffull,
+              morton_encode<std::uint64_t>(0x1fffff, 0x1fffff, 0x1fffff));
+
+    std::mt19937 gen{61};
+    for (std::size_t i = 0; i < 1000; ++i) {
+        std::uint32_t const x32 = gen(), y32 = gen(), z32 = gen();
+        std::uint64_t const x64 = gen(), y64 = gen(), z64 = gen();
+        std::uint32_t const c2[] = {x32 & 0xffff, y32 & 0xffff};
+        std::uint32_t const c3[] = {x32 & 0x3ff, y32 & 0x3ff, z32 & 0x3ff};
+        std::uint64_t const w2[] = {x64, y64};
+        std::uint64_t const w3[] = {x64 & 0x1fffff, y64 & 0x1fffff, z64 & 0x1fffff};
+        std::uint32_t const m2   = morton_encode(x32, y32);
+        std::uint32_t const m3   = morton_encode(x32, y32, z32);
+        std::uint64_t const n2   = morton_encode(x64, y64);
+        std::uint64_t const n3   = morton_encode(x64, y64, z64);
+        ASSERT_EQ(slow_morton(c2), m2);
+        ASSERT_EQ(slow_morton(c3), m3);
+        ASSERT_EQ(slow_morton(w2), n2);
+        ASSERT_EQ(slow_morton(w3), n3);
+        ASSERT_EQ((vector<std::uint32_t, 2>{c2[0], c2[1]}), morton_decode<2>(m2));
+        ASSERT_EQ((vector<std::uint32_t, 3>{c3[0], c3[1], c3[2]}), morton_decode<3>(m3));
+        ASSERT_EQ((vector<std::uint64_t, 2>{w2[0], w2[1]}), morton_decode<2>(n2));
+        ASSERT_EQ((vector<std::uint64_t, 3>{w3[0], w3[1], w3[2]}), morton_decode<3>(n3));
+    }
+}
+
+TEST(SpaceFillingCurve, Hilbert)
+{
+    // The first cells of the 2D curve
+    EXPECT_EQ(0u, hilbert_encode(0u, 0u));
+    EXPECT_EQ(1u, hilbert_encode(1u, 0u));
+    EXPECT_EQ(2u, hilbert_encode(1u, 1u));
+    EXPECT_EQ(3u, hilbert_encode(0u, 1u));
+
+    // The curve visits every cell once and the neighbours on the curve are
+    // neighbours in space
+    auto check = [](std::size_t n, auto encode, std::size_t dims) {
+        std::size_t const          cells = std::size_t{1} << (n * dims);
+        std::vector<std::uint32_t> x(cells, 0), y(cells, 0), z(cells, 0);
+        std::vector<bool>          seen(cells, false);
+        std::size_t const          side = std::size_t{1} << n;
+        for (std::uint32_t i = 0; i < side; ++i) {
+            for (std::uint32_t j = 0; j < side; ++j) {
+                for (std::uint32_t k = 0; k < (dims == 3 ? side : 1); ++k) {
+                    // The codes of a smaller grid are the low bits of the code
+                    std::uint32_t const code = encode(i, j, k) & (cells - 1);
+                    ASSERT_FALSE(seen[code]);
+                    seen[code] = true;
+                    x[code]    = i;
+                    y[code]    = j;
+                    z[code]    = k;
+                }
+            }
+        }
+        for (std::size_t c = 1; c < cells; ++c) {
+            auto const d = std::abs(int(x[c]) - int(x[c - 1])) + std::abs(int(y[c]) - int(y[c - 1]))
+                           + std::abs(int(z[c]) - int(z[c - 1]));
+            ASSERT_EQ(1, d) << "Code " << c;
+        }
+    };
+    // The highest bits of a coordinate select the biggest cells, a small
+    // grid is placed at the origin of the full curve
+    check(4, [](std::uint32_t x, std::uint32_t y, std::uint32_t) { return hilbert_encode(x, y); },
+          2);
+    check(3,
+          [](std::uint32_t x, std::uint32_t y, std::uint32_t z) {
+              return hilbert_encode(x, y, z);
+          },
+          3);
+    check(3,
+          [](std::uint32_t x, std::uint32_t y, std::uint32_t z) {
+              return static_cast<std::uint32_t>(hilbert_encode<std::uint64_t>(x, y, z));
+          },
+          3);
+}
+
+TEST(SpaceFillingCurve, Points)
+{
+    aabb<float, 3> const box{vector3f{-1, -1, -1}, vector3f{1, 1, 1}};
+    EXPECT_EQ(0u, morton_code(vector3f{-1, -1, -1}, box));
+    EXPECT_EQ(0x3fffffffu, morton_code(vector3f{1, 1, 1}, box));
+    // Points outside of the box are clamped
+    EXPECT_EQ(0u, morton_code(vector3f{-5, -5, -5}, box));
+    EXPECT_EQ(0x3fffffffu, morton_code(vector3f{5, 5, 5}, box));
+    EXPECT_EQ(morton_encode(512u, 512u, 512u), morton_code(vector3f{0, 0, 0}, box));
+    EXPECT_EQ(morton_encode<std::uint64_t>(1 << 20, 1 << 20, 1 << 20),
+              morton_code<std::uint64_t>(vector3f{0, 0, 0}, box));
+    EXPECT_EQ(hilbert_encode(512u, 512u, 512u), hilbert_code(vector3f{0, 0, 0}, box));
+
+    aabb<float, 2> const box2{vector2f{0, 0}, vector2f{4, 4}};
+    EXPECT_EQ(morton_encode(0x4000u, 0xc000u), morton_code(vector2f{1, 3}, box2));
+    EXPECT_EQ(morton_encode<std::uint64_t>(0x40000000, 0xc0000000),
+              morton_code<std::uint64_t>(vector2f{1, 3}, box2));
+
+    // Batch versions give the same codes
+    std::mt19937                          gen{67};
+    std::uniform_real_distribution<float> pos(-1, 1);
+    std::vector<vector3f>                 points;
+    for (std::size_t i = 0; i < config::parallel_min_items * 2 + 5; ++i) {
+        points.push_back(vector3f{pos(gen), pos(gen), pos(gen)});
+    }
+    std::vector<std::uint32_t> morton(points.size()), hilbert(points.size());
+    std::vector<std::uint64_t> morton64(points.size());
+    morton_codes(points.data(), points.size(), box, morton.data(), 4);
+    hilbert_codes(points.data(), points.size(), box, hilbert.data(), 4);
+    morton_codes(points.data(), points.size(), box, morton64.data());
+    for (std::size_t i = 0; i < points.size(); i += 97) {
+        ASSERT_EQ(morton_code(points[i], box), morton[i]);
+        ASSERT_EQ(hilbert_code(points[i], box), hilbert[i]);
+        ASSERT_EQ(morton_code<std::uint64_t>(points[i], box), morton64[i]);
+    }
+}
+
+TEST(RadixSort, Sort)
+{
+    std::mt19937 gen{71};
+    for (std::size_t count : {0ul, 1ul, 1000ul, config::parallel_min_items * 3 + 1}) {
+        std::vector<std::uint64_t> keys(count);
+        for (auto& k : keys) {
+            k = (std::uint64_t{gen()} << 32) | gen();
+        }
+        // Few different keys to check the stability
+        std::vector<std::uint32_t> small(count);
+        for (auto& k : small) {
+            k = gen() % 100;
+        }
+        for (std::size_t threads : {1, 4}) {
+            auto                       sorted = keys;
+            std::vector<std::uint32_t> order(count);
+            radix_sort(sorted.data(), order.data(), count, threads);
+            ASSERT_TRUE(std::is_sorted(sorted.begin(), sorted.end()));
+            for (std::size_t i = 0; i < count; ++i) {
+                ASSERT_EQ(keys[order[i]], sorted[i]);
+            }
+
+            auto sorted_small = small;
+            radix_sort(sorted_small.data(), order.data(), count, threads);
+            std::vector<std::uint32_t> expected(count);
+            std::iota(expected.begin(), expected.end(), 0);
+            std::stable_sort(expected.begin(), expected.end(),
+                             [&small](std::uint32_t a, std::uint32_t b) {
+                                 return small[a] < small[b];
+                             });
+            ASSERT_EQ(expected, order);
+        }
+    }
+
+    // Equal keys keep the order
+    std::vector<std::uint32_t> same(10, 5), order(10);
+    radix_sort(same.data(), order.data(), same.size());
+    for (std::uint32_t i = 0; i < order.size(); ++i) {
+        EXPECT_EQ(i, order[i]);
+    }
+}
+
+TEST(RadixSort, SortByKeys)
+{
+    std::mt19937                          gen{73};
+    std::uniform_real_distribution<float> pos(-1, 1);
+    std::size_t const                     count = 5000;
+    std::vector<vector3f>                 positions, velocities;
+    std::vector<std::uint32_t>            ids(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        positions.push_back(vector3f{pos(gen), pos(gen), pos(gen)});
+        velocities.push_back(positions.back() * 2.0f);
+        ids[i] = i;
+    }
+    auto const                 box = make_aabb(positions.data(), count);
+    std::vector<std::uint32_t> keys(count);
+    morton_codes(positions.data(), count, box, keys.data());
+    auto const original = positions;
+    sort_by_keys(keys.data(), count, 0, positions.data(), velocities.data(), ids.data());
+
+    ASSERT_TRUE(std::is_sorted(keys.begin(), keys.end()));
+    for (std::size_t i = 0; i < count; ++i) {
+        ASSERT_EQ(original[ids[i]], positions[i]);
+        ASSERT_EQ(positions[i] * 2.0f, velocities[i]);
+        ASSERT_EQ(morton_code(positions[i], box), keys[i]);
+    }
+}
+
+}    // namespace test
+}    // namespace math
+}    // namespace psst
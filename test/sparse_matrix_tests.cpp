@@ -0,0 +1,259 @@
+/**
+ * Copyright 2019 Sergei A. Fedorov
+ * sparse_matrix_tests.cpp
+ *
+ *  Created on: Mar 9, 2019
+ *      Author: ser-fedorov
+ */
+
+#include "test_printing.hpp"
+#include <psst/math/sparse_matrix.hpp>
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+namespace psst {
+namespace math {
+namespace test {
+
+namespace {
+
+template <typename T, std::size_t B>
+typename sparse_matrix<T, B>::block_type
+make_block(std::mt19937& gen)
+{
+    std::uniform_real_distribution<T> dist{-1, 1};
+    if constexpr (B == 1) {
+        return dist(gen);
+    } else {
+        matrix<T, B, B> res;
+        std::generate(res.begin(), res.end(), [&]() { return dist(gen); });
+        return res;
+    }
+}
+
+template <typename T, std::size_t B>
+sparse_matrix<T, B>
+make_sparse(std::size_t rows, std::size_t cols, std::size_t per_row, unsigned seed)
+{
+    std::mt19937                                          gen{seed};
+    std::uniform_int_distribution<std::size_t>            col{0, cols - 1};
+    std::vector<typename sparse_matrix<T, B>::entry_type> entries;
+    for (std::size_t r = 0; r < rows; ++r) {
+        // Duplicates are likely, they must be summed
+        for (std::size_t i = 0; i < per_row; ++i) {
+            entries.push_back({r, col(gen), make_block<T, B>(gen)});
+        }
+    }
+    return {rows, cols, std::move(entries)};
+}
+
+template <typename T>
+dynamic_vector<T>
+make_vector(std::size_t size, unsigned seed)
+{
+    std::mt19937                      gen{seed};
+    std::uniform_real_distribution<T> dist{-1, 1};
+    dynamic_vector<T>                 res(size);
+    std::generate(res.begin(), res.end(), [&]() { return dist(gen); });
+    return res;
+}
+
+template <typename T>
+dynamic_vector<T>
+dense_product(dynamic_matrix<T> const& a, dynamic_vector<T> const& x)
+{
+    dynamic_vector<T> res(a.rows());
+    for (std::size_t r = 0; r < a.rows(); ++r) {
+        for (std::size_t c = 0; c < a.cols(); ++c) {
+            res[r] += a[r][c] * x[c];
+        }
+    }
+    return res;
+}
+
+template <typename T>
+::testing::AssertionResult
+near(dynamic_vector<T> const& lhs, dynamic_vector<T> const& rhs, T eps)
+{
+    if (lhs.size() != rhs.size())
+        return ::testing::AssertionFailure() << lhs.size() << " != " << rhs.size();
+    for (std::size_t i = 0; i < lhs.size(); ++i) {
+        if (std::abs(lhs[i] - rhs[i]) > eps)
+            return ::testing::AssertionFailure() << "Element " << i << ": " << lhs[i]
+                                                 << " != " << rhs[i];
+    }
+    return ::testing::AssertionSuccess();
+}
+
+/**
+ * Stiffness matrix of a chain of 3D springs with unit stiffness along the
+ * axis of each spring, plus the mass on the diagonal
+ */
+template <typename T>
+block_sparse_matrix3<T>
+make_spring_chain(std::size_t nodes)
+{
+    using block_type = matrix<T, 3, 3>;
+    std::vector<sparse_entry<block_type>> entries;
+    for (std::size_t i = 0; i < nodes; ++i) {
+        entries.push_back({i, i, block_type::identity()});
+    }
+    for (std::size_t i = 0; i + 1 < nodes; ++i) {
+        vector<T, 3> const axis = normalize(vector<T, 3>{1, T(i % 3), T(i % 5)});
+        block_type         k;
+        for (std::size_t r = 0; r < 3; ++r) {
+            for (std::size_t c = 0; c < 3; ++c) {
+                k[r][c] = axis[r] * axis[c];
+            }
+        }
+        entries.push_back({i, i, k});
+        entries.push_back({i + 1, i + 1, k});
+        entries.push_back({i, i + 1, k * -1});
+        entries.push_back({i + 1, i, k * -1});
+    }
+    return {nodes, nodes, std::move(entries)};
+}
+
+}    // namespace
+
+template <typename T>
+class SparseMatrix : public ::testing::Test {};
+
+using sparse_value_types = ::testing::Types<float, double>;
+TYPED_TEST_SUITE(SparseMatrix, sparse_value_types, );
+
+TYPED_TEST(SparseMatrix, Construct)
+{
+    using value_type = TypeParam;
+    using entry_type = sparse_entry<value_type>;
+
+    std::vector<entry_type> const entries{{2, 1, 3}, {0, 0, 1}, {2, 1, 4}, {0, 3, 2}, {1, 2, 5}};
+    sparse_matrix<value_type> const a{3, 4, entries};
+    EXPECT_EQ(3, a.rows());
+    EXPECT_EQ(4, a.cols());
+    EXPECT_EQ(4, a.non_zeros());
+    ASSERT_NE(nullptr, a.find(2, 1));
+    EXPECT_EQ(7, *a.find(2, 1));
+    EXPECT_EQ(nullptr, a.find(2, 2));
+
+    dynamic_vector<value_type> const diag = a.diagonal();
+    dynamic_vector<value_type> const expected{1, 0, 0};
+    EXPECT_TRUE(near(expected, diag, value_type{0}));
+
+    std::vector<entry_type> const out_of_range{{3, 0, 1}};
+    EXPECT_THROW((sparse_matrix<value_type>{3, 4, out_of_range}), std::runtime_error);
+}
+
+TYPED_TEST(SparseMatrix, Multiply)
+{
+    using value_type     = TypeParam;
+    value_type const eps = std::is_same_v<value_type, float> ? 1e-4 : 1e-12;
+
+    auto const a     = make_sparse<value_type, 1>(50, 70, 4, 1);
+    auto const dense = a.dense();
+    auto const x     = make_vector<value_type>(70, 2);
+
+    dynamic_vector<value_type> const y        = a * x;
+    dynamic_vector<value_type> const expected = dense_product(dense, x);
+    EXPECT_TRUE(near(expected, y, eps));
+
+    dynamic_matrix<value_type> const dense_t = transpose(dense);
+    dynamic_vector<value_type> const z       = make_vector<value_type>(50, 3);
+    dynamic_vector<value_type> const tz      = dense_product(dense_t, z);
+    for (std::size_t threads : {1, 3}) {
+        dynamic_vector<value_type> res;
+        multiply(a, x, res, threads);
+        EXPECT_TRUE(near(expected, res, eps));
+        multiply_transposed(a, z, res, threads);
+        EXPECT_TRUE(near(tz, res, eps));
+    }
+
+    EXPECT_THROW(a * z, std::runtime_error);
+}
+
+TYPED_TEST(SparseMatrix, MultiplyBlocks)
+{
+    using value_type     = TypeParam;
+    value_type const eps = std::is_same_v<value_type, float> ? 1e-4 : 1e-12;
+
+    auto const a     = make_sparse<value_type, 3>(20, 30, 3, 4);
+    auto const dense = a.dense();
+    EXPECT_EQ(60, a.rows());
+    EXPECT_EQ(90, a.cols());
+
+    dynamic_matrix<value_type> const dense_t  = transpose(dense);
+    auto const                       x        = make_vector<value_type>(90, 5);
+    dynamic_vector<value_type> const expected = dense_product(dense, x);
+    auto const                       z        = make_vector<value_type>(60, 6);
+    dynamic_vector<value_type> const tz       = dense_product(dense_t, z);
+    for (std::size_t threads : {1, 3}) {
+        dynamic_vector<value_type> res;
+        multiply(a, x, res, threads);
+        EXPECT_TRUE(near(expected, res, eps));
+        multiply_transposed(a, z, res, threads);
+        EXPECT_TRUE(near(tz, res, eps));
+    }
+}
+
+TYPED_TEST(SparseMatrix, ConjugateGradient)
+{
+    using value_type           = TypeParam;
+    value_type const tolerance = std::is_same_v<value_type, float> ? 1e-5 : 1e-10;
+
+    auto const a = make_spring_chain<value_type>(100);
+    auto const b = make_vector<value_type>(a.rows(), 7);
+
+    for (std::size_t threads : {1, 3}) {
+        dynamic_vector<value_type> x;
+        auto const                 res = conjugate_gradient(a, b, x, tolerance, 0, threads);
+        EXPECT_TRUE(res.converged) << res.iterations << " iterations, residual " << res.residual;
+        EXPECT_LE(res.residual, tolerance);
+        dynamic_vector<value_type> const ax = a * x;
+        EXPECT_TRUE(near(b, ax, tolerance * 100));
+    }
+
+    // The exact initial guess is the solution
+    dynamic_vector<value_type> x;
+    conjugate_gradient(a, b, x, tolerance);
+    auto const res = conjugate_gradient(a, b, x, tolerance);
+    EXPECT_EQ(0, res.iterations);
+
+    // Zero right hand side
+    dynamic_vector<value_type> const zero(a.rows());
+    EXPECT_TRUE(conjugate_gradient(a, zero, x, tolerance).converged);
+    EXPECT_TRUE(near(zero, x, value_type{0}));
+
+    auto const rect = make_sparse<value_type, 1>(10, 12, 2, 8);
+    EXPECT_THROW(conjugate_gradient(rect, b, x, tolerance), std::runtime_error);
+}
+
+TYPED_TEST(SparseMatrix, ConjugateGradientBreakdown)
+{
+    using value_type = TypeParam;
+    using entry_type = typename sparse_matrix<value_type>::entry_type;
+
+    // Indefinite, the first direction is conjugate to itself
+    sparse_matrix<value_type> const  indefinite{2, 2, {entry_type{0, 0, 1}, {1, 1, -1}}};
+    dynamic_vector<value_type> const b(2, value_type{1});
+    dynamic_vector<value_type>       x;
+    auto res = conjugate_gradient(indefinite, b, x, value_type{1e-5});
+    EXPECT_FALSE(res.converged);
+    EXPECT_EQ(0, res.iterations);
+    EXPECT_TRUE(std::isfinite(x[0]) && std::isfinite(x[1]));
+
+    // Negative definite
+    sparse_matrix<value_type> const negative{2, 2, {entry_type{0, 0, -1}, {1, 1, -2}}};
+    x   = dynamic_vector<value_type>{};
+    res = conjugate_gradient(negative, b, x, value_type{1e-5});
+    EXPECT_FALSE(res.converged);
+    EXPECT_EQ(0, res.iterations);
+}
+
+}    // namespace test
+}    // namespace math
+}    // namespace psst
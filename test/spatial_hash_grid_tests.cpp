@@ -0,0 +1,154 @@
+/**
+ * Copyright 2019 Sergei A. Fedorov
+ * spatial_hash_grid_tests.cpp
+ *
+ *  Created on: Mar 2, 2019
+ *      Author: ser-fedorov
+ */
+
+#include "test_printing.hpp"
+#include <psst/math/spatial_hash_grid.hpp>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <mutex>
+#include <random>
+#include <utility>
+#include <vector>
+
+namespace psst {
+namespace math {
+namespace test {
+
+using vector3f = vector<float, 3>;
+using grid3f   = spatial_hash_grid<float>;
+
+namespace {
+
+std::vector<vector3f>
+make_particles(std::size_t count, float size, std::mt19937& gen)
+{
+    std::uniform_real_distribution<float> pos(-size, size);
+    std::vector<vector3f>                 res;
+    for (std::size_t i = 0; i < count; ++i) {
+        res.push_back(vector3f{pos(gen), pos(gen), pos(gen)});
+    }
+    return res;
+}
+
+using pair_list = std::vector<std::pair<std::uint32_t, std::uint32_t>>;
+
+pair_list
+brute_force_pairs(std::vector<vector3f> const& particles, float radius)
+{
+    pair_list res;
+    for (std::uint32_t i = 0; i < particles.size(); ++i) {
+        for (std::uint32_t j = i + 1; j < particles.size(); ++j) {
+            if (distance_square(particles[i], particles[j]) <= radius * radius)
+                res.emplace_back(i, j);
+        }
+    }
+    return res;
+}
+
+pair_list
+grid_pairs(grid3f const& grid, float radius, std::size_t threads)
+{
+    pair_list  res;
+    std::mutex mutex;
+    grid.for_each_pair(
+        radius,
+        [&](std::uint32_t i, std::uint32_t j, float) {
+            std::lock_guard<std::mutex> lock{mutex};
+            res.emplace_back(std::min(i, j), std::max(i, j));
+        },
+        threads);
+    std::sort(res.begin(), res.end());
+    return res;
+}
+
+}    // namespace
+
+TEST(SpatialHashGrid, Build)
+{
+    EXPECT_THROW(grid3f{0}, std::runtime_error);
+    grid3f grid{0.5};
+    EXPECT_TRUE(grid.empty());
+    bool called = false;
+    grid.for_each_neighbour(vector3f{}, 1, [&called](std::uint32_t, float) { called = true; });
+    EXPECT_FALSE(called);
+
+    std::mt19937 gen{43};
+    auto const   particles = make_particles(1000, 5, gen);
+    grid.build(particles.data(), particles.size());
+    ASSERT_EQ(particles.size(), grid.size());
+    // The sorted points are a permutation of the particles
+    std::vector<std::uint32_t> refs(particles.size());
+    for (std::size_t i = 0; i < grid.size(); ++i) {
+        auto const index = grid.indices()[i];
+        ++refs[index];
+        EXPECT_EQ(particles[index], grid.points()[i]);
+    }
+    for (auto r : refs) {
+        EXPECT_EQ(1u, r);
+    }
+    EXPECT_EQ((grid3f::cell_type{-1, 0, 2}), grid.cell(vector3f{-0.1, 0.2, 1.4}));
+
+    // Rebuild with less points
+    grid.build(particles.data(), 10);
+    EXPECT_EQ(10u, grid.size());
+}
+
+TEST(SpatialHashGrid, Neighbours)
+{
+    std::mt19937 gen{47};
+    auto const   particles = make_particles(2000, 5, gen);
+    grid3f const grid{particles.data(), particles.size(), 0.5};
+
+    std::uniform_real_distribution<float> pos(-6, 6);
+    for (std::size_t q = 0; q < 100; ++q) {
+        vector3f const point{pos(gen), pos(gen), pos(gen)};
+        // Radius less and greater than the cell size
+        for (float radius : {0.4f, 0.5f, 1.3f}) {
+            std::vector<std::uint32_t> expected;
+            for (std::uint32_t i = 0; i < particles.size(); ++i) {
+                if (distance_square(point, particles[i]) <= radius * radius)
+                    expected.push_back(i);
+            }
+            std::vector<std::uint32_t> found;
+            grid.for_each_neighbour(point, radius, [&](std::uint32_t i, float d) {
+                EXPECT_EQ(d, float(distance_square(point, particles[i])));
+                found.push_back(i);
+            });
+            std::sort(found.begin(), found.end());
+            EXPECT_EQ(expected, found) << "Radius " << radius;
+        }
+    }
+}
+
+TEST(SpatialHashGrid, Pairs)
+{
+    std::mt19937 gen{53};
+    auto const   particles = make_particles(1500, 4, gen);
+    grid3f const grid{particles.data(), particles.size(), 0.5};
+    auto const   expected = brute_force_pairs(particles, 0.5);
+    EXPECT_LT(0u, expected.size());
+    EXPECT_EQ(expected, grid_pairs(grid, 0.5, 1));
+    EXPECT_EQ(expected, grid_pairs(grid, 0.5, 4));
+    EXPECT_EQ(brute_force_pairs(particles, 0.7), grid_pairs(grid, 0.7, 1));
+}
+
+TEST(SpatialHashGrid, ParallelBuild)
+{
+    std::mt19937 gen{59};
+    auto const   particles = make_particles(config::parallel_min_items * 2 + 7, 20, gen);
+    grid3f const serial{particles.data(), particles.size(), 0.5};
+    grid3f const parallel{particles.data(), particles.size(), 0.5, 4};
+    EXPECT_EQ(serial.indices(), parallel.indices());
+    EXPECT_EQ(grid_pairs(serial, 0.5, 1), grid_pairs(parallel, 0.5, 0));
+}
+
+}    // namespace test
+}    // namespace math
+}    // namespace psst
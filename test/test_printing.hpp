@@ -8,6 +8,7 @@
 #ifndef TEST_PRINTING_HPP_
 #define TEST_PRINTING_HPP_
 
+#include <psst/math/dynamic_matrix.hpp>
 #include <psst/math/matrix_io.hpp>
 #include <psst/math/vector_io.hpp>
 
@@ -38,6 +39,28 @@ PrintTo(matrix_expression<E, R> const& mtx, std::ostream* os)
 }    // namespace m
 
 }    // namespace expr
+
+template <typename T>
+void
+PrintTo(dynamic_vector<T> const& vec, std::ostream* os)
+{
+    *os << "{";
+    for (std::size_t i = 0; i < vec.size(); ++i) {
+        *os << (i ? ", " : "") << vec[i];
+    }
+    *os << "}";
+}
+
+template <typename T>
+void
+PrintTo(dynamic_matrix<T> const& mtx, std::ostream* os)
+{
+    for (std::size_t r = 0; r < mtx.rows(); ++r) {
+        *os << "\n";
+        PrintTo(mtx.row(r), os);
+    }
+}
+
 }    // namespace math
 }    // namespace psst
 
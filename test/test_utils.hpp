@@ -0,0 +1,51 @@
+/*
+ * test_utils.hpp
+ *
+ *  Created on: Mar 6, 2019
+ *      Author: ser-fedorov
+ */
+
+#ifndef TEST_UTILS_HPP_
+#define TEST_UTILS_HPP_
+
+#include <psst/math/matrix_io.hpp>
+#include <psst/math/rotation.hpp>
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+
+namespace psst {
+namespace math {
+namespace test {
+
+/**
+ * Element-wise comparison of fixed size matrices
+ */
+template <typename Matrix>
+::testing::AssertionResult
+near(Matrix const& lhs, Matrix const& rhs, typename Matrix::value_type eps)
+{
+    for (std::size_t r = 0; r < Matrix::rows; ++r) {
+        for (std::size_t c = 0; c < Matrix::cols; ++c) {
+            if (std::abs(lhs[r][c] - rhs[r][c]) > eps)
+                return ::testing::AssertionFailure() << lhs << " != " << rhs;
+        }
+    }
+    return ::testing::AssertionSuccess();
+}
+
+/**
+ * Rotation by an angle around an axis
+ */
+inline quaternion<double>
+make_rotation(vector<double, 3> const& axis, double angle)
+{
+    return convert<quaternion<double>>(axis_angle<double>{axis.x(), axis.y(), axis.z(), angle});
+}
+
+}    // namespace test
+}    // namespace math
+}    // namespace psst
+
+#endif /* TEST_UTILS_HPP_ */
@@ -0,0 +1,196 @@
+/**
+ * Copyright 2019 Sergei A. Fedorov
+ * transform_hierarchy_tests.cpp
+ *
+ *  Created on: Feb 24, 2019
+ *      Author: ser-fedorov
+ */
+
+#include "test_printing.hpp"
+#include <psst/math/transform_hierarchy.hpp>
+
+#include <gtest/gtest.h>
+
+#include <random>
+#include <vector>
+
+namespace psst {
+namespace math {
+namespace test {
+
+namespace {
+
+constexpr double tolerance = 1e-9;
+
+template <typename Transform>
+Transform
+make_transform(std::mt19937& gen)
+{
+    using value_type = typename Transform::value_type;
+    std::uniform_real_distribution<value_type> dist(-1, 1);
+    quaternion<value_type> r{dist(gen), dist(gen), dist(gen), dist(gen)};
+    auto m = make_affine_transform(r, vector<value_type, 3>{dist(gen), dist(gen), dist(gen)});
+    if constexpr (Transform::rows == 4) {
+        return convert<Transform>(m);
+    } else {
+        return m;
+    }
+}
+
+/**
+ * Build a forest of random trees of 200 nodes, a parent is chosen among the
+ * last added nodes of the tree to get a deep enough hierarchy
+ */
+template <typename Transform>
+transform_hierarchy<Transform>
+make_hierarchy(std::size_t size, std::mt19937& gen)
+{
+    transform_hierarchy<Transform> h;
+    h.reserve(size);
+    std::size_t root = 0;
+    for (std::size_t i = 0; i < size; ++i) {
+        if (i % 200 == 0) {
+            root = h.add_node(make_transform<Transform>(gen));
+        } else {
+            std::size_t const first = i > root + 8 ? i - 8 : root;
+            std::uniform_int_distribution<std::size_t> parent(first, i - 1);
+            h.add_node(parent(gen), make_transform<Transform>(gen));
+        }
+    }
+    return h;
+}
+
+/**
+ * World transform computed by walking up to the root
+ */
+template <typename Transform>
+Transform
+expected_world(transform_hierarchy<Transform> const& h, std::size_t node)
+{
+    Transform res = h.local(node);
+    for (auto p = h.parent(node); p != h.no_parent; p = h.parent(p)) {
+        if constexpr (Transform::rows == 4) {
+            res = h.local(p) * res;
+        } else {
+            res = compose(h.local(p), res);
+        }
+    }
+    return res;
+}
+
+template <typename Transform>
+double
+distance(Transform const& lhs, Transform const& rhs)
+{
+    double res = 0;
+    for (std::size_t i = 0; i < Transform::size; ++i) {
+        res = std::max<double>(res, std::abs(lhs.data()[i] - rhs.data()[i]));
+    }
+    return res;
+}
+
+/**
+ * @param step check every step-th node, walking up the tree is slow
+ */
+template <typename Transform>
+void
+check_world(transform_hierarchy<Transform> const& h, std::size_t step = 1)
+{
+    for (std::size_t i = 0; i < h.size(); ++i) {
+        ASSERT_FALSE(h.dirty(i)) << "Node " << i;
+    }
+    for (std::size_t i = 0; i < h.size(); i += step) {
+        ASSERT_NEAR(0, distance(expected_world(h, i), h.world(i)), tolerance) << "Node " << i;
+    }
+    ASSERT_NEAR(0, distance(expected_world(h, h.size() - 1), h.world(h.size() - 1)), tolerance);
+}
+
+}    // namespace
+
+template <typename Transform>
+class TransformHierarchy : public ::testing::Test {};
+
+using transform_types = ::testing::Types<matrix<double, 4, 4>, affine_transform<double>>;
+TYPED_TEST_SUITE(TransformHierarchy, transform_types, );
+
+TYPED_TEST(TransformHierarchy, Build)
+{
+    transform_hierarchy<TypeParam> h;
+    std::mt19937                   gen{42};
+    auto                           root  = h.add_node(make_transform<TypeParam>(gen));
+    auto                           child = h.add_node(root, make_transform<TypeParam>(gen));
+    EXPECT_EQ(2u, h.size());
+    EXPECT_EQ(h.no_parent, h.parent(root));
+    EXPECT_EQ(root, h.parent(child));
+    EXPECT_TRUE(h.dirty(child));
+    EXPECT_THROW(h.add_node(5, make_transform<TypeParam>(gen)), std::out_of_range);
+
+    h.update();
+    check_world(h);
+    EXPECT_EQ(h.local(root), h.world(root));
+}
+
+TYPED_TEST(TransformHierarchy, Update)
+{
+    std::mt19937 gen{7};
+    auto         h = make_hierarchy<TypeParam>(5000, gen);
+    h.update();
+    check_world(h);
+
+    // Change a node in the middle, its subtree is updated
+    h.set_local(1234, make_transform<TypeParam>(gen));
+    h.set_local(10, make_transform<TypeParam>(gen));
+    EXPECT_TRUE(h.dirty(1234));
+    h.update();
+    check_world(h);
+
+    // Nodes that are not marked dirty keep the world transforms
+    std::vector<TypeParam> before(h.world_data(), h.world_data() + h.size());
+    h.update();
+    for (std::size_t i = 0; i < h.size(); ++i) {
+        ASSERT_EQ(before[i], h.world(i)) << "Node " << i;
+    }
+}
+
+TYPED_TEST(TransformHierarchy, ParallelUpdate)
+{
+    std::mt19937 gen{13};
+    // Large enough for the trees to be split between threads
+    auto h = make_hierarchy<TypeParam>(config::parallel_min_items * 8, gen);
+    h.update(4);
+    check_world(h, 101);
+
+    for (std::size_t i = 0; i < h.size(); i += 97) {
+        h.set_local(i, make_transform<TypeParam>(gen));
+    }
+    h.update(0);
+    check_world(h, 101);
+
+    // Adding nodes rebuilds the schedule
+    h.add_node(h.size() - 1, make_transform<TypeParam>(gen));
+    h.add_node(make_transform<TypeParam>(gen));
+    h.update(3);
+    check_world(h, 101);
+}
+
+TEST(Parallel, For)
+{
+    std::vector<int> v(100000, 0);
+    detail::parallel_for(v.size(), 1000, 4, [&v](std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end; ++i) {
+            ++v[i];
+        }
+    });
+    EXPECT_EQ(v.size(), static_cast<std::size_t>(std::count(v.begin(), v.end(), 1)));
+
+    EXPECT_THROW(detail::parallel_for(v.size(), 1000, 4,
+                                      [](std::size_t begin, std::size_t) {
+                                          if (begin > 0)
+                                              throw std::runtime_error("Test");
+                                      }),
+                 std::runtime_error);
+}
+
+}    // namespace test
+}    // namespace math
+}    // namespace psst
@@ -171,6 +171,20 @@ TEST(VectorView, AccessBuffers)
     }
 }
 
+TEST(VectorView, IndexBuffers)
+{
+    std::vector<vector3f> vectors{{1, 2, 3}, {4, 5, 6}, {7, 8, 9}};
+    auto mem_view = make_memory_vector_view<vector3f>(vectors.data()->data(), 3 * vectors.size());
+    for (std::size_t i = 0; i < vectors.size(); ++i) {
+        EXPECT_EQ(vectors[i], mem_view[i]);
+    }
+    mem_view[2] = vector3f{1, 1, 1};
+    EXPECT_EQ((vector3f{1, 1, 1}), vectors[2]);
+
+    EXPECT_EQ(3, mem_view.end() - mem_view.begin());
+    EXPECT_EQ(vectors[1], *(mem_view.cbegin() + 1));
+}
+
 }    // namespace test
 }    // namespace math
 }    // namespace psst